@@ -25,6 +25,7 @@
 #include "include/cam_output.h"
 #include "include/cam_readwrite.h"
 #include "include/cam_streaming.h"
+#include "include/cam_replay.h"
 #include "include/cam_format_selector.h"
 
 /*! \defgroup webcam Webcam
@@ -50,6 +51,9 @@ select_mode(Wg_camera *cam, CAM_MODE mode);
 WG_PRIVATE CAM_MODE
 get_fallback_mode(CAM_MODE mode);
 
+WG_PRIVATE cam_status
+open_replay(Wg_camera *cam, wg_uint flags);
+
 /**
  * @brief Initialize a webcam
  *
@@ -75,7 +79,8 @@ cam_init(Wg_camera *cam, const wg_char* dev_path)
         return CAM_FAILURE;
     }
 
-    if (!S_ISCHR (st.st_mode)) {
+    /* regular files are recordings to replay */
+    if (!S_ISCHR (st.st_mode) && !S_ISREG (st.st_mode)) {
         WG_LOG("%s is no a device\n", cam->dev_path);
         return CAM_FAILURE;
     }
@@ -93,7 +98,8 @@ cam_init(Wg_camera *cam, const wg_char* dev_path)
 /**
  * @brief Open a webcam
  *
- * If mode == 0 a driver selects the most efficient mode.
+ * If mode == 0 a driver selects the most efficient mode. Recording files
+* are always opened in CAM_MODE_REPLAY.
  *
  * @param cam webcam instance
  * @param mode mode to open camera in.
@@ -118,6 +124,10 @@ cam_open(Wg_camera *cam, CAM_MODE mode, wg_uint flags)
         return CAM_FAILURE;
     }
 
+    /* streaming falls back to MMAP if driver refuses user buffers */
+    cam->memory = IS_FLAG_SET(flags, ENABLE_USERPTR) ? 
+        V4L2_MEMORY_USERPTR : V4L2_MEMORY_MMAP;
+
 
     if (-1 == stat (cam->dev_path, &st)) {
         WG_LOG("Cannot identify '%s': errno(%d), %s\n",
@@ -125,6 +135,10 @@ cam_open(Wg_camera *cam, CAM_MODE mode, wg_uint flags)
         return CAM_FAILURE;
     }
 
+    if (S_ISREG (st.st_mode)) {
+        return open_replay(cam, flags);
+    }
+
     if (!S_ISCHR (st.st_mode)) {
         WG_LOG("%s is no device\n", cam->dev_path);
         return CAM_FAILURE;
@@ -231,6 +245,9 @@ cam_close(Wg_camera *cam)
     case CAM_STATE_START:
         cam_stop(cam);
     case CAM_STATE_STOP:
+        if (NULL != cam->cam_ops.close){
+            cam->cam_ops.close(cam);
+        }
         close(cam->fd_cam);
         cam->state = CAM_STATE_UNINIT;
         status = CAM_SUCCESS;
@@ -491,6 +508,105 @@ cam_get_resolution(Wg_camera *cam, wg_uint *width, wg_uint *height)
     return CAM_SUCCESS;
 }
 
+/** 
+* @brief Set number of streaming buffers
+*
+* Fewer buffers means older frames can't pile up in the driver. Must be 
+* called before cam_start().
+* 
+* @param cam  webcam instance
+* @param num  number of buffers, 0 for DEFAULT_BUFFER_NUM
+* 
+* @retval CAM_SUCCESS
+* @retval CAM_FAILURE
+*/
+cam_status
+cam_set_buffer_num(Wg_camera *cam, wg_uint num)
+{
+    CHECK_FOR_NULL_PARAM(cam);
+
+    if ((0 != num) && (num < MIN_BUFFER_NUM)){
+        WG_ERROR("At least %u buffers needed\n", MIN_BUFFER_NUM);
+        return CAM_FAILURE;
+    }
+
+    if (CAM_STATE_START == cam->state){
+        WG_ERROR("Can't change buffers of started camera\n");
+        return CAM_FAILURE;
+    }
+
+    cam->buf_request = num;
+
+    return CAM_SUCCESS;
+}
+
+/** 
+* @brief Read only the newest frame
+*
+* In streaming mode cam_read() dequeues all frames which are ready, 
+* returns the newest one and gives the others back to the driver. 
+* Skipped frames are counted, see cam_get_dropped_frames().
+* 
+* @param cam     webcam instance
+* @param enable  WG_TRUE for the newest frame, WG_FALSE for FIFO order
+* 
+* @retval CAM_SUCCESS
+* @retval CAM_FAILURE
+*/
+cam_status
+cam_set_newest_frame(Wg_camera *cam, wg_boolean enable)
+{
+    CHECK_FOR_NULL_PARAM(cam);
+
+    cam->newest_frame = enable;
+
+    return CAM_SUCCESS;
+}
+
+/** 
+* @brief Get number of frames skipped to deliver the newest one
+* 
+* @param cam      webcam instance
+* @param dropped  memory to store number of frames
+* 
+* @retval CAM_SUCCESS
+* @retval CAM_FAILURE
+*/
+cam_status
+cam_get_dropped_frames(Wg_camera *cam, wg_uint *dropped)
+{
+    CHECK_FOR_NULL_PARAM(cam);
+    CHECK_FOR_NULL_PARAM(dropped);
+
+    *dropped = cam->dropped;
+
+    return CAM_SUCCESS;
+}
+
+/** 
+* @brief Set how a recording is replayed
+*
+* Real time pacing delivers frames at intervals they were captured at,
+* fast pacing as soon as they are asked for. Has no effect on devices.
+* 
+* @param cam    webcam instance
+* @param pace   pacing of frames
+* @param loop   WG_TRUE to start again at the end of the recording
+* 
+* @retval CAM_SUCCESS
+* @retval CAM_FAILURE
+*/
+cam_status
+cam_set_replay_pace(Wg_camera *cam, Cam_replay_pace pace, wg_boolean loop)
+{
+    CHECK_FOR_NULL_PARAM(cam);
+
+    cam->replay_pace = pace;
+    cam->replay_loop = loop;
+
+    return CAM_SUCCESS;
+}
+
 
 /** 
 * @brief Set camera resolution
@@ -512,6 +628,16 @@ cam_set_resolution(Wg_camera *cam, wg_uint width, wg_uint height)
     
     capture = cam->fmt[CAM_FMT_CAPTURE]; 
 
+    /* recording keeps the resolution it was captured in */
+    if (CAM_MODE_REPLAY == cam->mode){
+        if (capture.fmt.pix.width != width || 
+                capture.fmt.pix.height != height){
+            WG_LOG("%s: Replaying in w:%u h:%u\n", cam->dev_path,
+                    capture.fmt.pix.width, capture.fmt.pix.height);
+        }
+        return CAM_SUCCESS;
+    }
+
     if (capture.fmt.pix.width != width || capture.fmt.pix.height != height){
         capture.fmt.pix.width  = width;
         capture.fmt.pix.height = height;
@@ -535,7 +661,8 @@ get_fallback_mode(CAM_MODE mode)
     static const CAM_MODE fallback_mode[] = {
         [CAM_MODE_INVALID]   = CAM_MODE_READWRITE,
         [CAM_MODE_STREAMING] = CAM_MODE_READWRITE,
-        [CAM_MODE_READWRITE] = CAM_MODE_UNKNOWN
+        [CAM_MODE_READWRITE] = CAM_MODE_UNKNOWN,
+        [CAM_MODE_REPLAY]    = CAM_MODE_UNKNOWN
     };
     CAM_MODE new_mode = CAM_MODE_UNKNOWN;
 
@@ -570,4 +697,42 @@ select_mode(Wg_camera *cam, CAM_MODE mode)
     return status;
 }
 
+/**
+ * @brief Open a recording file for replay
+ *
+ * @param cam    webcam instance
+ * @param flags  options 
+ *
+ * @retval CAM_SUCCESS
+ * @retval CAM_FAILURE
+ */
+WG_PRIVATE cam_status
+open_replay(Wg_camera *cam, wg_uint flags)
+{
+    cam_status status = CAM_FAILURE;
+
+    cam_replay_init(cam);
+
+    status = cam->cam_ops.open(cam);
+    if (CAM_SUCCESS != status){
+        return status;
+    }
+
+    if (IS_FLAG_SET(flags, ENABLE_DECOMPRESSOR)){
+        status = cam_get_decompressor(
+                cam->fmt[CAM_FMT_CAPTURE].fmt.pix.pixelformat, &cam->dcomp);
+        if (CAM_SUCCESS != status){
+            cam->cam_ops.close(cam);
+            close(cam->fd_cam);
+            cam->fd_cam = -1;
+            WG_LOG("Can't find a decompressor for the recording\n");
+            return status;
+        }
+    }
+
+    cam->state = CAM_STATE_STOP;
+
+    return CAM_SUCCESS;
+}
+
 /*! @} */
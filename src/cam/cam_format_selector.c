@@ -35,9 +35,17 @@ typedef wg_char u32str[sizeof (__u32) + 1];
 * @brief Supported decompressors
 */
 WG_STATIC Fmt_decomp supported_formats[] = {
-    {v4l2_fourcc('Y', 'U', 'Y', 'V'), {img_yuyv_2_rgb24}},
-    {v4l2_fourcc('M', 'J', 'P', 'G'), {img_jpeg_decompress}},
-    {v4l2_fourcc('J', 'P', 'E', 'G'), {img_jpeg_decompress}}
+    {v4l2_fourcc('Y', 'U', 'Y', 'V'), 
+        {img_yuyv_2_rgb24, img_yuyv_2_rgb24_noalloc, 
+            img_yuyv_2_bgrx_noalloc, img_yuyv_2_ycbcr_noalloc}},
+    {v4l2_fourcc('M', 'J', 'P', 'G'), 
+        {img_jpeg_decompress, img_jpeg_decompress_noalloc,
+            img_jpeg_decompress_bgrx_noalloc, 
+            img_jpeg_decompress_ycbcr_noalloc}},
+    {v4l2_fourcc('J', 'P', 'E', 'G'), 
+        {img_jpeg_decompress, img_jpeg_decompress_noalloc,
+            img_jpeg_decompress_bgrx_noalloc, 
+            img_jpeg_decompress_ycbcr_noalloc}}
 };
 
 WG_PRIVATE void
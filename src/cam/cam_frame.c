@@ -40,4 +40,44 @@ cam_frame_init(Wg_frame *frame)
     return CAM_SUCCESS;
 }
 
+/**
+ * @brief Get a frame as an image without copying
+ *
+ * Works for streaming buffers of YUYV and GREY formats whose rows are not
+ * padded by the driver. Image points into the buffer so it is valid until
+ * cam_discard_frame() is called for the frame. Image must not be released
+ * by the caller.
+ *
+ * @param cam    camera instance
+ * @param frame  full frame read by cam_read()
+ * @param img    memory to store image
+ *
+ * @retval CAM_SUCCESS
+ * @retval CAM_NO_SUPPORT frame can't be seen as an image
+ */
+cam_status
+cam_frame_image(Wg_camera *cam, const Wg_frame *frame, Wg_image *img)
+{
+    Wg_cam_buf *buffer = NULL;
+
+    CHECK_FOR_NULL_PARAM(cam);
+    CHECK_FOR_NULL_PARAM(frame);
+    CHECK_FOR_NULL_PARAM(img);
+
+    if ((WG_FRAME_FULL != frame->state) || (NULL == cam->buffers) ||
+            (frame->stream_buf.index >= cam->buf_num)){
+        return CAM_NO_SUPPORT;
+    }
+
+    buffer = &cam->buffers[frame->stream_buf.index];
+    if (NULL == buffer->image.rows){
+        return CAM_NO_SUPPORT;
+    }
+
+    *img       = buffer->image;
+    img->stamp = frame->stamp;
+
+    return CAM_SUCCESS;
+}
+
 /*! @} */
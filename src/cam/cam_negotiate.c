@@ -0,0 +1,609 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <sys/types.h>
+#include <sys/ioctl.h>
+
+#include <linux/videodev2.h>
+
+#include <wgtypes.h>
+#include <wg.h>
+#include <wgmacros.h>
+#include <wg_linked_list.h>
+#include <wg_iterator.h>
+#include <img.h>
+#include <cam.h>
+
+#include "include/cam_format_selector.h"
+#include "include/cam_output.h"
+#include "include/cam_negotiate.h"
+
+/*! @defgroup webcam_negotiate Format Negotiation
+ * @ingroup webcam
+ */
+
+/*! @{ */
+
+/*! Width of the frame decoded to measure decoder speed */
+#define PROBE_WIDTH      320
+
+/*! Height of the frame decoded to measure decoder speed */
+#define PROBE_HEIGHT     240
+
+/*! Number of measured decodes, the fastest one is used */
+#define PROBE_RUNS       5
+
+/*! Quality of the JPEG frame used for measurement */
+#define PROBE_QUALITY    80
+
+/*! Largest number of pixel formats measured */
+#define PROBE_FORMAT_MAX 8
+
+/**
+ * @brief Frame size
+ */
+typedef struct Cam_size{
+    wg_uint width;    /*!< width in pixels  */
+    wg_uint height;   /*!< height in pixels */
+}Cam_size;
+
+/**
+ * @brief Decode speed of a pixel format
+ */
+typedef struct Cam_decode_cost{
+    __u32 pixelformat;   /*!< pixel format                  */
+    wg_uint ps;          /*!< decode time of a pixel in ps  */
+    cam_status status;   /*!< CAM_SUCCESS if ps is known    */
+}Cam_decode_cost;
+
+/**
+ * @brief Sizes tried on cameras reporting a range of frame sizes
+ */
+WG_STATIC const Cam_size std_sizes[] = {
+    { 160,  120},
+    { 320,  240},
+    { 352,  288},
+    { 640,  480},
+    { 800,  600},
+    {1024,  768},
+    {1280,  720},
+    {1280,  960},
+    {1920, 1080}
+};
+
+WG_PRIVATE cam_status
+list_sizes(Wg_camera *cam, __u32 pixelformat, Cam_mode modes[],
+        wg_uint max_num, wg_uint *num);
+
+WG_PRIVATE void
+add_mode(Wg_camera *cam, __u32 pixelformat, wg_uint width, wg_uint height,
+        Cam_mode modes[], wg_uint max_num, wg_uint *num);
+
+WG_PRIVATE wg_uint
+max_fps(Wg_camera *cam, __u32 pixelformat, wg_uint width, wg_uint height);
+
+WG_PRIVATE cam_status
+decode_cost(Cam_decode_cost costs[], wg_uint *cost_num, __u32 pixelformat,
+        wg_uint *ps);
+
+WG_PRIVATE cam_status
+measure_decode(__u32 pixelformat, wg_uint *ps);
+
+WG_PRIVATE wg_boolean
+better_mode(const Cam_mode *mode, const Cam_mode *best, wg_uint target_fps);
+
+WG_PRIVATE wg_uint
+mode_fps(const Cam_mode *mode);
+
+WG_PRIVATE cam_status
+apply_mode(Wg_camera *cam, const Cam_mode *mode);
+
+/**
+ * @brief List capture modes a camera offers
+ *
+ * Only formats with a decompressor are listed. Frame sizes and intervals
+ * are read from the driver, for drivers reporting a range of sizes
+ * common sizes within the range are listed.
+ *
+ * @param cam      webcam instance
+ * @param modes    memory to store modes
+ * @param max_num  number of elements in modes
+ * @param num      memory to store number of modes found
+ *
+ * @retval CAM_SUCCESS
+ * @retval CAM_FAILURE
+ */
+cam_status
+cam_mode_list(Wg_camera *cam, Cam_mode modes[], wg_uint max_num,
+        wg_uint *num)
+{
+    List_head head;
+    Iterator itr;
+    Wg_cam_format_description *fmt = NULL;
+    cam_status status = CAM_FAILURE;
+
+    CHECK_FOR_NULL_PARAM(cam);
+    CHECK_FOR_NULL_PARAM(modes);
+    CHECK_FOR_NULL_PARAM(num);
+
+    *num = 0;
+
+    status = cam_output_format_description_list(cam,
+            CAM_OUT_VIDEO_CAPTURE, &head);
+    if (CAM_SUCCESS != status){
+        return status;
+    }
+
+    iterator_list_init(&itr, &head,
+            GET_OFFSET(Wg_cam_format_description, list));
+
+    while ((fmt = iterator_list_next(&itr)) != NULL){
+        if (cam_is_format_supported(fmt->desc.pixelformat) == WG_TRUE){
+            list_sizes(cam, fmt->desc.pixelformat, modes, max_num, num);
+        }
+    }
+
+    cam_output_format_description_list_cleanup(&head);
+
+    return (0 != *num) ? CAM_SUCCESS : CAM_FAILURE;
+}
+
+/**
+ * @brief Select capture mode the CPU can process at a target frame rate
+ *
+ * Decoder speed of every format is measured on this machine decoding full
+ * size frames to BGRX, the cost of a mode is its pixel count times decode
+ * and pipeline time of a pixel.
+ * The largest mode delivering and processing target_fps frames per second
+ * wins, on equal size the cheaper one. If no mode keeps up the fastest
+ * one is used. Formats whose decoding can't be measured are skipped.
+ * Selected format, size and frame interval are set on the camera together
+ * with a matching decompressor.
+ *
+ * Camera must be opened and not started.
+ *
+ * @param cam    webcam instance
+ * @param param  negotiation constraints
+ * @param mode   memory to store selected mode, may be NULL
+ *
+ * @retval CAM_SUCCESS
+ * @retval CAM_NO_SUPPORT  mode can't be changed, recording is replayed
+ * @retval CAM_FAILURE
+ */
+cam_status
+cam_negotiate(Wg_camera *cam, const Cam_negotiate_param *param,
+        Cam_mode *mode)
+{
+    Cam_mode modes[CAM_MODE_LIST_MAX];
+    Cam_decode_cost costs[PROBE_FORMAT_MAX];
+    wg_uint cost_num = 0;
+    wg_uint num = 0;
+    wg_uint ps = 0;
+    wg_int best = -1;
+    wg_int i = 0;
+    cam_status status = CAM_FAILURE;
+
+    CHECK_FOR_NULL_PARAM(cam);
+    CHECK_FOR_NULL_PARAM(param);
+    CHECK_FOR_COND(0 != param->target_fps);
+
+    if (CAM_MODE_REPLAY == cam->mode){
+        return CAM_NO_SUPPORT;
+    }
+
+    status = cam_mode_list(cam, modes, ELEMNUM(modes), &num);
+    if (CAM_SUCCESS != status){
+        WG_LOG("%s: No capture modes reported\n", cam->dev_path);
+        return status;
+    }
+
+    for (i = 0; i < num; ++i){
+        if (((0 != param->max_width) && (modes[i].width > param->max_width))
+                || ((0 != param->max_height) &&
+                    (modes[i].height > param->max_height))){
+            continue;
+        }
+
+        /* a format the probe can't decode is not ranked */
+        if (decode_cost(costs, &cost_num, modes[i].pixelformat, &ps)
+                != CAM_SUCCESS){
+            WG_DEBUG("Mode %.4s %ux%u skipped, decode cost unknown\n",
+                    (char*)&modes[i].pixelformat, modes[i].width,
+                    modes[i].height);
+            continue;
+        }
+
+        modes[i].cost_usec =
+            ((wg_uint64)modes[i].width * modes[i].height *
+             (ps + (wg_uint64)param->pipeline_ns * 1000)) / 1000000;
+
+        WG_DEBUG("Mode %.4s %ux%u fps:%u cost:%uus\n",
+                (char*)&modes[i].pixelformat, modes[i].width,
+                modes[i].height, modes[i].fps, modes[i].cost_usec);
+
+        if ((-1 == best) ||
+                (better_mode(&modes[i], &modes[best], param->target_fps)
+                 == WG_TRUE)){
+            best = i;
+        }
+    }
+
+    if (-1 == best){
+        WG_LOG("%s: No decodable capture mode within %ux%u\n", 
+                cam->dev_path, param->max_width, param->max_height);
+        return CAM_FAILURE;
+    }
+
+    status = apply_mode(cam, &modes[best]);
+    if (CAM_SUCCESS != status){
+        return status;
+    }
+
+    WG_LOG("%s: Selected %.4s %ux%u, expected %u fps\n", cam->dev_path,
+            (char*)&modes[best].pixelformat, modes[best].width,
+            modes[best].height, mode_fps(&modes[best]));
+
+    if (NULL != mode){
+        *mode = modes[best];
+    }
+
+    return CAM_SUCCESS;
+}
+
+/**
+ * @brief Add frame sizes of a pixel format to the mode list
+ */
+WG_PRIVATE cam_status
+list_sizes(Wg_camera *cam, __u32 pixelformat, Cam_mode modes[],
+        wg_uint max_num, wg_uint *num)
+{
+    struct v4l2_frmsizeenum size;
+    const struct v4l2_pix_format *pix = NULL;
+    wg_uint found = *num;
+    wg_int i = 0;
+
+    memset(&size, '\0', sizeof (struct v4l2_frmsizeenum));
+    size.pixel_format = pixelformat;
+
+    while (ioctl(cam->fd_cam, VIDIOC_ENUM_FRAMESIZES, &size) != -1){
+        if (V4L2_FRMSIZE_TYPE_DISCRETE == size.type){
+            add_mode(cam, pixelformat, size.discrete.width,
+                    size.discrete.height, modes, max_num, num);
+            ++size.index;
+            continue;
+        }
+
+        /* continuous and stepwise ranges are reported once */
+        for (i = 0; i < ELEMNUM(std_sizes); ++i){
+            if ((std_sizes[i].width  < size.stepwise.min_width)  ||
+                (std_sizes[i].width  > size.stepwise.max_width)  ||
+                (std_sizes[i].height < size.stepwise.min_height) ||
+                (std_sizes[i].height > size.stepwise.max_height)){
+                continue;
+            }
+            if ((0 != size.stepwise.step_width) &&
+                    ((std_sizes[i].width - size.stepwise.min_width) %
+                     size.stepwise.step_width != 0)){
+                continue;
+            }
+            if ((0 != size.stepwise.step_height) &&
+                    ((std_sizes[i].height - size.stepwise.min_height) %
+                     size.stepwise.step_height != 0)){
+                continue;
+            }
+            add_mode(cam, pixelformat, std_sizes[i].width,
+                    std_sizes[i].height, modes, max_num, num);
+        }
+        add_mode(cam, pixelformat, size.stepwise.max_width,
+                size.stepwise.max_height, modes, max_num, num);
+        break;
+    }
+
+    /* driver can't enumerate sizes, only the current one is known */
+    if (found == *num){
+        pix = &cam->fmt[CAM_FMT_CAPTURE].fmt.pix;
+        if (pix->pixelformat == pixelformat){
+            add_mode(cam, pixelformat, pix->width, pix->height,
+                    modes, max_num, num);
+        }
+    }
+
+    return CAM_SUCCESS;
+}
+
+/**
+ * @brief Append a mode to the list if it is not there already
+ */
+WG_PRIVATE void
+add_mode(Wg_camera *cam, __u32 pixelformat, wg_uint width, wg_uint height,
+        Cam_mode modes[], wg_uint max_num, wg_uint *num)
+{
+    wg_int i = 0;
+
+    if ((0 == width) || (0 == height) || (*num >= max_num)){
+        return;
+    }
+
+    for (i = 0; i < *num; ++i){
+        if ((modes[i].pixelformat == pixelformat) &&
+                (modes[i].width == width) && (modes[i].height == height)){
+            return;
+        }
+    }
+
+    modes[*num].pixelformat = pixelformat;
+    modes[*num].width       = width;
+    modes[*num].height      = height;
+    modes[*num].fps         = max_fps(cam, pixelformat, width, height);
+    modes[*num].cost_usec   = 0;
+    ++*num;
+
+    return;
+}
+
+/**
+ * @brief Get highest frame rate of a mode
+ *
+ * @return frames per second, 0 if driver does not report intervals
+ */
+WG_PRIVATE wg_uint
+max_fps(Wg_camera *cam, __u32 pixelformat, wg_uint width, wg_uint height)
+{
+    struct v4l2_frmivalenum ival;
+    const struct v4l2_fract *fract = NULL;
+    wg_uint fps = 0;
+
+    memset(&ival, '\0', sizeof (struct v4l2_frmivalenum));
+    ival.pixel_format = pixelformat;
+    ival.width        = width;
+    ival.height       = height;
+
+    while (ioctl(cam->fd_cam, VIDIOC_ENUM_FRAMEINTERVALS, &ival) != -1){
+        /* ranges are reported once, shortest interval first */
+        fract = (V4L2_FRMIVAL_TYPE_DISCRETE == ival.type) ?
+            &ival.discrete : &ival.stepwise.min;
+
+        if ((0 != fract->numerator) &&
+                (fract->denominator / fract->numerator > fps)){
+            fps = fract->denominator / fract->numerator;
+        }
+
+        if (V4L2_FRMIVAL_TYPE_DISCRETE != ival.type){
+            break;
+        }
+        ++ival.index;
+    }
+
+    return fps;
+}
+
+/**
+ * @brief Get decode time of a pixel in picoseconds, formats are measured once
+ *
+ * @retval CAM_SUCCESS
+ * @retval CAM_FAILURE  format could not be measured, ps is not set
+ */
+WG_PRIVATE cam_status
+decode_cost(Cam_decode_cost costs[], wg_uint *cost_num, __u32 pixelformat,
+        wg_uint *ps)
+{
+    wg_int i = 0;
+    cam_status status = CAM_FAILURE;
+
+    for (i = 0; i < *cost_num; ++i){
+        if (costs[i].pixelformat == pixelformat){
+            *ps = costs[i].ps;
+            return costs[i].status;
+        }
+    }
+
+    status = measure_decode(pixelformat, ps);
+    if (*cost_num < PROBE_FORMAT_MAX){
+        costs[*cost_num].pixelformat = pixelformat;
+        costs[*cost_num].ps          = *ps;
+        costs[*cost_num].status      = status;
+        ++*cost_num;
+    }
+
+    return status;
+}
+
+/**
+ * @brief Measure decode time of a pixel on a synthetic frame
+ *
+ * Frame is noisy so JPEG compresses it about as well as a camera picture.
+ * Only full size decoding to BGRX is timed, an approximation for the other
+ * colour spaces and the DCT downscaling a sensor may use. It ranks formats
+ * rather than predicting the frame time.
+ *
+ * @param pixelformat  measured format
+ * @param ps           memory to store time of a pixel in picoseconds
+ *
+ * @retval CAM_SUCCESS
+ * @retval CAM_FAILURE  format could not be decoded
+ */
+WG_PRIVATE cam_status
+measure_decode(__u32 pixelformat, wg_uint *ps)
+{
+    Wg_cam_decompressor decomp;
+    Wg_image rgb;
+    Wg_image bgrx;
+    wg_uchar *data = NULL;
+    wg_uchar *pixel = NULL;
+    wg_size size = 0;
+    wg_uint seed = 1;
+    wg_uint row = 0;
+    wg_uint col = 0;
+    wg_uint64 start = 0;
+    wg_uint64 best = ~(wg_uint64)0;
+    wg_int i = 0;
+    wg_status status = WG_FAILURE;
+    cam_status c_status = CAM_SUCCESS;
+
+    *ps = 0;
+
+    if (cam_get_decompressor(pixelformat, &decomp) != CAM_SUCCESS){
+        return CAM_FAILURE;
+    }
+
+    status = img_fill(PROBE_WIDTH, PROBE_HEIGHT, RGB24_COMPONENT_NUM,
+            IMG_RGB, &rgb);
+    if (WG_SUCCESS != status){
+        return CAM_FAILURE;
+    }
+
+    for (row = 0; row < PROBE_HEIGHT; ++row){
+        img_get_row(&rgb, row, &pixel);
+        for (col = 0; col < PROBE_WIDTH * RGB24_COMPONENT_NUM; ++col){
+            seed = seed * 1103515245 + 12345;
+            pixel[col] = (row + col + ((seed >> 16) & 0x1f)) & 0xff;
+        }
+    }
+
+    switch (pixelformat){
+    case V4L2_PIX_FMT_YUYV:
+        /* any bytes are valid YUYV */
+        size = PROBE_WIDTH * PROBE_HEIGHT * YUYV_COMPONENT_NUM / 2;
+        data = malloc(size);
+        if (NULL != data){
+            memcpy(data, rgb.image, size);
+        }
+        break;
+    case V4L2_PIX_FMT_MJPEG:
+    case V4L2_PIX_FMT_JPEG:
+        if (img_jpeg_compress(&rgb, PROBE_QUALITY, &data, &size)
+                != WG_SUCCESS){
+            data = NULL;
+        }
+        break;
+    default:
+        break;
+    }
+
+    img_cleanup(&rgb);
+
+    if ((NULL == data) || (img_fill(PROBE_WIDTH, PROBE_HEIGHT,
+                    BGRX_COMPONENT_NUM, IMG_BGRX, &bgrx) != WG_SUCCESS)){
+        free(data);
+        return CAM_FAILURE;
+    }
+
+    for (i = 0; i < PROBE_RUNS; ++i){
+        start = wg_time_now();
+        if (invoke_decompressor_bgrx(&decomp, data, size,
+                    PROBE_WIDTH, PROBE_HEIGHT, &bgrx) != CAM_SUCCESS){
+            c_status = CAM_FAILURE;
+            break;
+        }
+        best = WG_MIN(best, wg_time_now() - start);
+    }
+
+    img_cleanup(&bgrx);
+
+    /* libjpeg allocates with malloc(), YUYV frame does the same */
+    free(data);
+
+    if (CAM_SUCCESS == c_status){
+        *ps = (best * 1000000) / (PROBE_WIDTH * PROBE_HEIGHT);
+    }
+
+    return c_status;
+}
+
+/**
+ * @brief Check if a mode is a better choice than the best one so far
+ */
+WG_PRIVATE wg_boolean
+better_mode(const Cam_mode *mode, const Cam_mode *best, wg_uint target_fps)
+{
+    wg_uint fps = mode_fps(mode);
+    wg_uint best_fps = mode_fps(best);
+    wg_uint pixels = mode->width * mode->height;
+    wg_uint best_pixels = best->width * best->height;
+    wg_boolean fits = (fps >= target_fps);
+    wg_boolean best_fits = (best_fps >= target_fps);
+
+    if (fits != best_fits){
+        return fits;
+    }
+
+    /* nothing keeps up, get as close to the target as possible */
+    if (WG_FALSE == fits){
+        return (fps > best_fps) ||
+            ((fps == best_fps) && (pixels > best_pixels));
+    }
+
+    return (pixels > best_pixels) ||
+        ((pixels == best_pixels) && (mode->cost_usec < best->cost_usec));
+}
+
+/**
+ * @brief Get frame rate limited by the camera and by the CPU
+ */
+WG_PRIVATE wg_uint
+mode_fps(const Cam_mode *mode)
+{
+    wg_uint fps = (0 != mode->cost_usec) ?
+        1000000 / mode->cost_usec : ~0u;
+
+    /* unknown camera rate does not limit the mode */
+    if (0 != mode->fps){
+        fps = WG_MIN(fps, mode->fps);
+    }
+
+    return fps;
+}
+
+/**
+ * @brief Set format, size and frame interval of a mode on a camera
+ */
+WG_PRIVATE cam_status
+apply_mode(Wg_camera *cam, const Cam_mode *mode)
+{
+    struct v4l2_format format;
+    struct v4l2_streamparm parm;
+    Wg_cam_decompressor decomp;
+    cam_status status = CAM_FAILURE;
+
+    status = cam_get_decompressor(mode->pixelformat, &decomp);
+    if (CAM_SUCCESS != status){
+        return status;
+    }
+
+    format = cam->fmt[CAM_FMT_CAPTURE];
+    format.fmt.pix.pixelformat = mode->pixelformat;
+    format.fmt.pix.width       = mode->width;
+    format.fmt.pix.height      = mode->height;
+
+    status = cam_output_format_set(cam, &format);
+    if (CAM_SUCCESS != status){
+        WG_LOG("%s: Can't set %.4s %ux%u\n", cam->dev_path,
+                (char*)&mode->pixelformat, mode->width, mode->height);
+        return status;
+    }
+
+    /* driver may adjust size, keep what it chose */
+    cam->fmt[CAM_FMT_CAPTURE] = format;
+    cam->dcomp = decomp;
+
+    if (0 == mode->fps){
+        return CAM_SUCCESS;
+    }
+
+    memset(&parm, '\0', sizeof (struct v4l2_streamparm));
+    parm.type = V4L2_BUF_TYPE_VIDEO_CAPTURE;
+
+    if ((ioctl(cam->fd_cam, VIDIOC_G_PARM, &parm) != -1) &&
+            (parm.parm.capture.capability & V4L2_CAP_TIMEPERFRAME)){
+        parm.parm.capture.timeperframe.numerator   = 1;
+        parm.parm.capture.timeperframe.denominator = mode->fps;
+        if (ioctl(cam->fd_cam, VIDIOC_S_PARM, &parm) == -1){
+            WG_LOG("%s: Can't set %u fps\n", cam->dev_path, mode->fps);
+        }
+    }
+
+    return CAM_SUCCESS;
+}
+
+/*! @} */
@@ -32,6 +32,9 @@
 
 #define POLL_FLAGS (POLLIN | POLLPRI)
 
+/* set in revents only, a broken camera is ready for a failing read */
+#define POLL_ERROR_FLAGS (POLLERR | POLLHUP | POLLNVAL)
+
 WG_PRIVATE cam_status
 read_frame(Wg_camera *cam, Wg_frame *frame);
 
@@ -177,6 +180,10 @@ read_frame(Wg_camera *cam, Wg_frame *frame)
         }
     }
 
+    /* read() gives no capture time, take it as soon as data arrived */
+    frame->stamp.usec     = wg_time_now();
+    frame->stamp.sequence = cam->sequence++;
+
     return CAM_SUCCESS;
 }
 
@@ -214,17 +221,20 @@ alloc_frame_buffer(Wg_camera *cam, Wg_frame *frame)
  *
  * This function takes an array of cameras and waits until data is available to
  * read. Cameras which can be read are returned in retval array. WG_TRUE means
- * that the camera can be read.
+ * that the camera can be read. A camera reporting an error or hang up is
+ * returned as ready too, so the caller's read fails instead of waiting.
  *
  * @param num         number of cameras
  * @param cameras[]   cameras
  * @param retval[]    memory to store returned events
  * @param timeout_ms  timeout in ms if < 0 infinity
  *
- * @return 
+ * @retval CAM_SUCCESS
+ * @retval CAM_TIMEOUT
+ * @retval CAM_FAILURE
  */
 cam_status
-select_frame(wg_uint num, Wg_camera *cameras[], wg_boolean retval[],
+cam_frame_select(wg_uint num, Wg_camera *cameras[], wg_boolean retval[],
         wg_int timeout_ms)
 {
     struct pollfd *fds = NULL;
@@ -251,7 +261,8 @@ select_frame(wg_uint num, Wg_camera *cameras[], wg_boolean retval[],
             break;
         default:
             for (i = 0; i < num; ++i){
-                retval[i] = ((fds[i].revents & POLL_FLAGS) != 0) ?
+                retval[i] = ((fds[i].revents & 
+                            (POLL_FLAGS | POLL_ERROR_FLAGS)) != 0) ?
                     WG_TRUE : WG_FALSE;
             }
             cam_status = CAM_SUCCESS;
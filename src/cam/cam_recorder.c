@@ -0,0 +1,371 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <pthread.h>
+#include <sys/mman.h>
+
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+
+#include <wgtypes.h>
+#include <wg.h>
+#include <wgmacros.h>
+#include <wg_linked_list.h>
+#include <img.h>
+#include <cam.h>
+
+#include "include/cam_frame.h"
+#include "include/cam_replay.h"
+#include "include/cam_recorder.h"
+
+/*! @defgroup webcam_recorder Frame Recorder
+ * @ingroup webcam
+ */
+
+/*! @{ */
+
+WG_PRIVATE void*
+recorder_thread(void *data);
+
+WG_PRIVATE void
+ring_write(Wg_cam_recorder *rec, const Cam_rec_slot *slot);
+
+WG_PRIVATE wg_uint64
+ring_next(const Wg_cam_recorder *rec, wg_uint64 offset);
+
+/**
+ * @brief Start recording frames of a camera into a ring file
+ *
+ * File is created with size bytes of frame area and replayed by opening it
+ * as a camera. When the area is full the oldest frames are overwritten so
+ * the file keeps the most recent part of the session. Camera must be
+ * opened, frames are recorded in its capture format.
+ *
+ * @param rec   memory to store recorder instance
+ * @param path  recording file
+ * @param size  size of the frame area in bytes
+ * @param cam   camera frames come from
+ *
+ * @retval CAM_SUCCESS
+ * @retval CAM_FAILURE
+ */
+cam_status
+cam_recorder_open(Wg_cam_recorder *rec, const wg_char *path, wg_size size,
+        const Wg_camera *cam)
+{
+    const struct v4l2_pix_format *pix = NULL;
+    void *map = NULL;
+    int fd = -1;
+
+    CHECK_FOR_NULL_PARAM(rec);
+    CHECK_FOR_NULL_PARAM(path);
+    CHECK_FOR_NULL_PARAM(cam);
+
+    memset(rec, '\0', sizeof (Wg_cam_recorder));
+
+    size &= ~((wg_size)CAM_REC_ALIGN - 1);
+    if (0 == size){
+        return CAM_FAILURE;
+    }
+
+    fd = open(path, O_RDWR | O_CREAT | O_TRUNC, 0644);
+    if (-1 == fd){
+        WG_ERROR("%s: %s\n", path, strerror(errno));
+        return CAM_FAILURE;
+    }
+
+    if (-1 == ftruncate(fd, sizeof (Cam_rec_header) + size)){
+        WG_ERROR("%s: %s\n", path, strerror(errno));
+        close(fd);
+        return CAM_FAILURE;
+    }
+
+    map = mmap(NULL, sizeof (Cam_rec_header) + size,
+            PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    if (MAP_FAILED == map){
+        WG_ERROR("%s: %s\n", path, strerror(errno));
+        close(fd);
+        return CAM_FAILURE;
+    }
+
+    pix = &cam->fmt[CAM_FMT_CAPTURE].fmt.pix;
+
+    rec->fd       = fd;
+    rec->map_size = sizeof (Cam_rec_header) + size;
+    rec->header   = (Cam_rec_header*)map;
+    rec->area     = (wg_uchar*)map + sizeof (Cam_rec_header);
+
+    rec->header->magic       = CAM_REC_MAGIC;
+    rec->header->version     = CAM_REC_VERSION;
+    rec->header->pixelformat = pix->pixelformat;
+    rec->header->width       = pix->width;
+    rec->header->height      = pix->height;
+    rec->header->data_size   = size;
+    rec->header->start       = 0;
+    rec->header->end         = 0;
+
+    pthread_mutex_init(&rec->lock, NULL);
+    pthread_cond_init(&rec->ready, NULL);
+
+    if (0 != pthread_create(&rec->thread, NULL, recorder_thread, rec)){
+        pthread_cond_destroy(&rec->ready);
+        pthread_mutex_destroy(&rec->lock);
+        munmap(map, rec->map_size);
+        close(fd);
+        memset(rec, '\0', sizeof (Wg_cam_recorder));
+        return CAM_FAILURE;
+    }
+
+    return CAM_SUCCESS;
+}
+
+/**
+ * @brief Queue a frame for recording
+ *
+ * Frame data is copied so the frame can be given back to the camera right
+ * after this call. If the recorder thread is behind the frame is dropped.
+ *
+ * @param rec    recorder instance
+ * @param frame  frame read from the camera
+ *
+ * @retval CAM_SUCCESS
+ * @retval CAM_BUSY     frame dropped
+ * @retval CAM_FAILURE
+ */
+cam_status
+cam_recorder_write(Wg_cam_recorder *rec, const Wg_frame *frame)
+{
+    Cam_rec_slot *slot = NULL;
+
+    CHECK_FOR_NULL_PARAM(rec);
+    CHECK_FOR_NULL_PARAM(frame);
+
+    pthread_mutex_lock(&rec->lock);
+    if (CAM_RECORDER_SLOT_NUM == rec->count){
+        ++rec->dropped;
+        pthread_mutex_unlock(&rec->lock);
+        return CAM_BUSY;
+    }
+    slot = &rec->slot[rec->head];
+    pthread_mutex_unlock(&rec->lock);
+
+    /* only this thread touches the slot until it is queued, old content 
+     * is not needed
+     */
+    if (frame->size > slot->capacity){
+        WG_FREE(slot->data);
+        slot->capacity = 0;
+        slot->data = WG_MALLOC(frame->size);
+        if (NULL == slot->data){
+            return CAM_FAILURE;
+        }
+        slot->capacity = frame->size;
+    }
+
+    memcpy(slot->data, frame->start, frame->size);
+    slot->record.usec     = frame->stamp.usec;
+    slot->record.sequence = frame->stamp.sequence;
+    slot->record.size     = frame->size;
+
+    pthread_mutex_lock(&rec->lock);
+    rec->head = (rec->head + 1) % CAM_RECORDER_SLOT_NUM;
+    ++rec->count;
+    pthread_cond_signal(&rec->ready);
+    pthread_mutex_unlock(&rec->lock);
+
+    return CAM_SUCCESS;
+}
+
+/**
+ * @brief Get number of frames which were not recorded
+ *
+ * @param rec      recorder instance
+ * @param dropped  memory to store number of frames
+ *
+ * @retval CAM_SUCCESS
+ * @retval CAM_FAILURE
+ */
+cam_status
+cam_recorder_get_dropped(Wg_cam_recorder *rec, wg_uint *dropped)
+{
+    CHECK_FOR_NULL_PARAM(rec);
+    CHECK_FOR_NULL_PARAM(dropped);
+
+    pthread_mutex_lock(&rec->lock);
+    *dropped = rec->dropped;
+    pthread_mutex_unlock(&rec->lock);
+
+    return CAM_SUCCESS;
+}
+
+/**
+ * @brief Write queued frames and close the recording
+ *
+ * @param rec  recorder instance
+ *
+ * @retval CAM_SUCCESS
+ * @retval CAM_FAILURE
+ */
+cam_status
+cam_recorder_close(Wg_cam_recorder *rec)
+{
+    wg_uint i = 0;
+
+    CHECK_FOR_NULL_PARAM(rec);
+
+    if (NULL == rec->header){
+        return CAM_FAILURE;
+    }
+
+    pthread_mutex_lock(&rec->lock);
+    rec->stop = WG_TRUE;
+    pthread_cond_signal(&rec->ready);
+    pthread_mutex_unlock(&rec->lock);
+
+    pthread_join(rec->thread, NULL);
+
+    if (0 != rec->dropped){
+        WG_LOG("Recorder dropped %u frames\n", rec->dropped);
+    }
+
+    msync(rec->header, rec->map_size, MS_ASYNC);
+    munmap(rec->header, rec->map_size);
+    close(rec->fd);
+
+    for (i = 0; i < CAM_RECORDER_SLOT_NUM; ++i){
+        WG_FREE(rec->slot[i].data);
+    }
+
+    pthread_cond_destroy(&rec->ready);
+    pthread_mutex_destroy(&rec->lock);
+
+    memset(rec, '\0', sizeof (Wg_cam_recorder));
+
+    return CAM_SUCCESS;
+}
+
+/**
+ * @brief Write queued frames until asked to stop
+ *
+ * @param data  recorder instance
+ *
+ * @return NULL
+ */
+WG_PRIVATE void*
+recorder_thread(void *data)
+{
+    Wg_cam_recorder *rec = (Wg_cam_recorder*)data;
+    Cam_rec_slot *slot = NULL;
+
+    pthread_mutex_lock(&rec->lock);
+    for (;;){
+        while ((0 == rec->count) && (WG_FALSE == rec->stop)){
+            pthread_cond_wait(&rec->ready, &rec->lock);
+        }
+
+        /* queued frames are written before finishing */
+        if (0 == rec->count){
+            break;
+        }
+
+        slot = &rec->slot[rec->tail];
+        pthread_mutex_unlock(&rec->lock);
+
+        ring_write(rec, slot);
+
+        pthread_mutex_lock(&rec->lock);
+        rec->tail = (rec->tail + 1) % CAM_RECORDER_SLOT_NUM;
+        --rec->count;
+    }
+    pthread_mutex_unlock(&rec->lock);
+
+    return NULL;
+}
+
+/**
+ * @brief Append a frame record to the ring, dropping the oldest ones
+ *
+ * Header start is moved before old records are overwritten and end after
+ * the new record is complete, so a file left by a crash is always readable.
+ * Start never catches up with end, equal offsets mean an empty ring.
+ *
+ * @param rec   recorder instance
+ * @param slot  frame to write
+ */
+WG_PRIVATE void
+ring_write(Wg_cam_recorder *rec, const Cam_rec_slot *slot)
+{
+    Cam_rec_header *header = rec->header;
+    wg_uint64 need = CAM_REC_SIZE(slot->record.size);
+    wg_uint64 start = header->start;
+    wg_uint64 live_end = header->end;
+    wg_uint64 end = header->end;
+    wg_uint64 marker = header->data_size;
+    wg_boolean empty = (start == end);
+
+    if (need + CAM_REC_ALIGN > header->data_size){
+        return;
+    }
+
+    /* records behind end are lost, the ring continues from 0 */
+    if (end + need > header->data_size){
+        if (start > end){
+            start = 0;
+        }
+        marker = end;
+        end    = 0;
+    }
+
+    if (start == live_end){
+        empty = WG_TRUE;
+    }
+
+    /* drop records the new one overwrites */
+    while ((WG_FALSE == empty) && (start >= end) && (start <= end + need)){
+        start = ring_next(rec, start);
+        if (start == live_end){
+            empty = WG_TRUE;
+        }
+    }
+
+    header->start = (WG_TRUE == empty) ? end : start;
+    __sync_synchronize();
+
+    if (marker + sizeof (Cam_rec_frame) <= header->data_size){
+        memset(rec->area + marker, '\0', sizeof (Cam_rec_frame));
+    }
+
+    memcpy(rec->area + end, &slot->record, sizeof (Cam_rec_frame));
+    memcpy(rec->area + end + sizeof (Cam_rec_frame), slot->data, 
+            slot->record.size);
+    __sync_synchronize();
+
+    header->end = end + need;
+
+    return;
+}
+
+/**
+ * @brief Get offset of the record following the one at offset
+ */
+WG_PRIVATE wg_uint64
+ring_next(const Wg_cam_recorder *rec, wg_uint64 offset)
+{
+    const Cam_rec_frame *record = NULL;
+
+    if (offset + sizeof (Cam_rec_frame) > rec->header->data_size){
+        return 0;
+    }
+
+    record = (const Cam_rec_frame*)(rec->area + offset);
+    if (0 == record->size){
+        return 0;
+    }
+
+    return offset + CAM_REC_SIZE(record->size);
+}
+
+/*! @} */
@@ -0,0 +1,421 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <time.h>
+#include <sys/mman.h>
+
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+
+#include <wgtypes.h>
+#include <wg.h>
+#include <wgmacros.h>
+#include <wg_linked_list.h>
+#include <img.h>
+#include <cam.h>
+
+#include "include/cam_frame.h"
+#include "include/cam_replay.h"
+
+/*! @defgroup webcam_replay Replay Mode
+ * @ingroup webcam
+ */
+
+/*! @{ */
+
+/**
+ * @brief State of a replayed recording
+ */
+struct Wg_cam_replay{
+    wg_uchar *map;                 /*!< mapped recording file             */
+    wg_size   map_size;            /*!< size of the mapping               */
+    const Cam_rec_header *header;  /*!< header of the recording           */
+    wg_uchar *area;                /*!< frame area                        */
+    wg_uint64 offset;              /*!< next record in the frame area     */
+    wg_boolean started;            /*!< first frame of a pass was read    */
+    wg_uint64 first_usec;          /*!< recorded time of the first frame  */
+    wg_uint64 start_usec;          /*!< time the first frame was replayed */
+    wg_uint32 first_seq;           /*!< recorded sequence of first frame  */
+    wg_uint32 seq_base;            /*!< sequence added by previous passes */
+    wg_uint32 last_seq;            /*!< sequence of the last frame        */
+};
+
+WG_PRIVATE cam_status
+open_replay(Wg_camera *cam);
+
+WG_PRIVATE cam_status
+close_replay(Wg_camera *cam);
+
+WG_PRIVATE cam_status
+start_replay(Wg_camera *cam);
+
+WG_PRIVATE cam_status
+stop_replay(Wg_camera *cam);
+
+WG_PRIVATE cam_status
+read_replay(Wg_camera *cam, Wg_frame *frame);
+
+WG_PRIVATE cam_status
+release_frame(Wg_camera *cam, Wg_frame *frame);
+
+WG_PRIVATE wg_boolean
+next_record(Wg_cam_replay *replay, const Cam_rec_frame **record);
+
+WG_PRIVATE wg_uint64
+record_due(const Wg_cam_replay *replay, const Cam_rec_frame *record);
+
+WG_PRIVATE void
+sleep_until(wg_uint64 usec);
+
+/**
+ * @brief Switch camera into replay mode.
+ *
+ * Frames are read from a recording file instead of a device.
+ *
+ * @param cam webcam instance
+ *
+ * @retval CAM_SUCCESS
+ * @retval CAM_FAILURE
+ */
+cam_status
+cam_replay_init(Wg_camera *cam)
+{
+    CHECK_FOR_NULL_PARAM(cam);
+
+    cam->cam_ops.read          = read_replay;
+    cam->cam_ops.cleanup_frame = release_frame;
+    cam->cam_ops.empty_frame   = release_frame;
+    cam->cam_ops.close         = close_replay;
+    cam->cam_ops.open          = open_replay;
+    cam->cam_ops.start         = start_replay;
+    cam->cam_ops.stop          = stop_replay;
+
+    cam->mode = CAM_MODE_REPLAY;
+
+    return CAM_SUCCESS;
+}
+
+/**
+ * @brief Map the recording and take capture format from its header
+ *
+ * @param cam webcam instance
+ *
+ * @retval CAM_SUCCESS
+ * @retval CAM_FAILURE
+ */
+WG_PRIVATE cam_status
+open_replay(Wg_camera *cam)
+{
+    struct v4l2_pix_format *pix = NULL;
+    const Cam_rec_header *header = NULL;
+    const Cam_rec_frame *record = NULL;
+    Wg_cam_replay *replay = NULL;
+    struct stat st;
+    void *map = NULL;
+    int fd = -1;
+
+    CHECK_FOR_NULL_PARAM(cam);
+
+    fd = open(cam->dev_path, O_RDONLY);
+    if (-1 == fd){
+        WG_ERROR("%s: %s\n", cam->dev_path, strerror(errno));
+        return CAM_FAILURE;
+    }
+
+    if ((-1 == fstat(fd, &st)) || (st.st_size < sizeof (Cam_rec_header))){
+        WG_LOG("%s is not a recording\n", cam->dev_path);
+        close(fd);
+        return CAM_FAILURE;
+    }
+
+    map = mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    if (MAP_FAILED == map){
+        WG_ERROR("%s: %s\n", cam->dev_path, strerror(errno));
+        close(fd);
+        return CAM_FAILURE;
+    }
+
+    header = (const Cam_rec_header*)map;
+    if ((CAM_REC_MAGIC != header->magic) ||
+            (CAM_REC_VERSION != header->version) ||
+            (header->data_size > st.st_size - sizeof (Cam_rec_header)) ||
+            (header->start > header->data_size) ||
+            (header->end > header->data_size)){
+        WG_LOG("%s is not a recording\n", cam->dev_path);
+        munmap(map, st.st_size);
+        close(fd);
+        return CAM_FAILURE;
+    }
+
+    replay = WG_CALLOC(1, sizeof (Wg_cam_replay));
+    if (NULL == replay){
+        munmap(map, st.st_size);
+        close(fd);
+        return CAM_FAILURE;
+    }
+
+    /* frames are read once, in order */
+    madvise(map, st.st_size, MADV_SEQUENTIAL);
+
+    replay->map      = map;
+    replay->map_size = st.st_size;
+    replay->header   = header;
+    replay->area     = replay->map + sizeof (Cam_rec_header);
+    replay->offset   = header->start;
+
+    /* replayed sequence counts from the oldest frame of the ring */
+    if (WG_TRUE == next_record(replay, &record)){
+        replay->first_seq = record->sequence;
+    }
+    replay->offset = header->start;
+
+    memset(&cam->fmt[CAM_FMT_CAPTURE], '\0', sizeof (struct v4l2_format));
+    cam->fmt[CAM_FMT_CAPTURE].type = V4L2_BUF_TYPE_VIDEO_CAPTURE;
+
+    pix = &cam->fmt[CAM_FMT_CAPTURE].fmt.pix;
+    pix->width       = header->width;
+    pix->height      = header->height;
+    pix->pixelformat = header->pixelformat;
+    pix->field       = V4L2_FIELD_NONE;
+    if (V4L2_PIX_FMT_YUYV == header->pixelformat){
+        pix->bytesperline = header->width * YUYV_COMPONENT_NUM / 2;
+        pix->sizeimage    = pix->bytesperline * header->height;
+    }
+
+    cam->replay = replay;
+    cam->fd_cam = fd;
+
+    return CAM_SUCCESS;
+}
+
+/**
+ * @brief Unmap the recording, file is closed by cam_close()
+ *
+ * @param cam webcam instance
+ *
+ * @retval CAM_SUCCESS
+ * @retval CAM_FAILURE
+ */
+WG_PRIVATE cam_status
+close_replay(Wg_camera *cam)
+{
+    CHECK_FOR_NULL_PARAM(cam);
+
+    if (NULL != cam->replay){
+        munmap(cam->replay->map, cam->replay->map_size);
+        WG_FREE(cam->replay);
+        cam->replay = NULL;
+    }
+
+    return CAM_SUCCESS;
+}
+
+/**
+ * @brief Rewind the recording to its oldest frame
+ *
+ * @param cam webcam instance
+ *
+ * @retval CAM_SUCCESS
+ * @retval CAM_FAILURE
+ */
+WG_PRIVATE cam_status
+start_replay(Wg_camera *cam)
+{
+    Wg_cam_replay *replay = NULL;
+
+    CHECK_FOR_NULL_PARAM(cam);
+    CHECK_FOR_NULL_PARAM(cam->replay);
+
+    replay = cam->replay;
+
+    replay->offset   = replay->header->start;
+    replay->started  = WG_FALSE;
+    replay->seq_base = 0;
+    replay->last_seq = 0;
+
+    cam->dropped = 0;
+
+    return CAM_SUCCESS;
+}
+
+WG_PRIVATE cam_status
+stop_replay(Wg_camera *cam)
+{
+    return CAM_SUCCESS;
+}
+
+/**
+ * @brief Get the next frame of the recording
+ *
+ * Frame points into the mapped file, nothing is copied. In real time
+ * pacing the call sleeps until the frame is due and frame time is the
+ * time it was due, so processing delays show up as latency just like with
+ * a camera.
+ *
+ * @param cam   webcam instance
+ * @param frame memory to store the frame
+ *
+ * @retval CAM_SUCCESS
+ * @retval CAM_IO       end of the recording
+ */
+WG_PRIVATE cam_status
+read_replay(Wg_camera *cam, Wg_frame *frame)
+{
+    const Cam_rec_frame *record = NULL;
+    const Cam_rec_frame *next = NULL;
+    struct v4l2_pix_format *pix = NULL;
+    Wg_cam_replay *replay = NULL;
+    wg_uint64 offset = 0;
+    wg_uint64 due = 0;
+
+    CHECK_FOR_NULL_PARAM(cam);
+    CHECK_FOR_NULL_PARAM(cam->replay);
+    CHECK_FOR_NULL_PARAM(frame);
+
+    replay = cam->replay;
+
+    if (WG_FALSE == next_record(replay, &record)){
+        if ((WG_FALSE == cam->replay_loop) || (WG_FALSE == replay->started)){
+            WG_LOG("%s: end of recording\n", cam->dev_path);
+            return CAM_IO;
+        }
+
+        /* next pass continues sequence numbers of the previous one */
+        replay->offset   = replay->header->start;
+        replay->started  = WG_FALSE;
+        replay->seq_base = replay->last_seq + 1;
+
+        if (WG_FALSE == next_record(replay, &record)){
+            return CAM_IO;
+        }
+    }
+
+    if (WG_FALSE == replay->started){
+        replay->first_usec = record->usec;
+        replay->start_usec = wg_time_now();
+        replay->started    = WG_TRUE;
+    }
+
+    if (CAM_REPLAY_REALTIME == cam->replay_pace){
+        /* skip frames a camera would have replaced already */
+        if (WG_TRUE == cam->newest_frame){
+            offset = replay->offset;
+            while ((WG_TRUE == next_record(replay, &next)) &&
+                    (record_due(replay, next) <= wg_time_now())){
+                record = next;
+                offset = replay->offset;
+                ++cam->dropped;
+            }
+            replay->offset = offset;
+        }
+
+        due = record_due(replay, record);
+        sleep_until(due);
+    }else{
+        due = wg_time_now();
+    }
+
+    replay->last_seq = replay->seq_base + 
+        (record->sequence - replay->first_seq);
+
+    pix = &cam->fmt[CAM_FMT_CAPTURE].fmt.pix;
+
+    frame->start          = (wg_uchar*)(record + 1);
+    frame->size           = record->size;
+    frame->width          = pix->width;
+    frame->height         = pix->height;
+    frame->pixelformat    = pix->pixelformat;
+    frame->stamp.usec     = due;
+    frame->stamp.sequence = replay->last_seq;
+
+    return CAM_SUCCESS;
+}
+
+/**
+ * @brief Frames point into the mapped file, nothing to release
+ */
+WG_PRIVATE cam_status
+release_frame(Wg_camera *cam, Wg_frame *frame)
+{
+    return CAM_SUCCESS;
+}
+
+/**
+ * @brief Step to the next frame record
+ *
+ * @param replay  replay state
+ * @param record  memory to store the record
+ *
+ * @retval WG_TRUE   record found
+ * @retval WG_FALSE  no more records or the recording is damaged
+ */
+WG_PRIVATE wg_boolean
+next_record(Wg_cam_replay *replay, const Cam_rec_frame **record)
+{
+    const Cam_rec_frame *rec = NULL;
+    wg_uint64 data_size = replay->header->data_size;
+    wg_boolean wrapped = WG_FALSE;
+
+    for (;;){
+        if (replay->offset == replay->header->end){
+            return WG_FALSE;
+        }
+
+        rec = (const Cam_rec_frame*)(replay->area + replay->offset);
+
+        /* frames continue from the beginning of the ring */
+        if ((replay->offset + sizeof (Cam_rec_frame) > data_size) ||
+                (0 == rec->size)){
+            if (WG_TRUE == wrapped){
+                return WG_FALSE;
+            }
+            wrapped = WG_TRUE;
+            replay->offset = 0;
+            continue;
+        }
+
+        if (replay->offset + CAM_REC_SIZE(rec->size) > data_size){
+            WG_LOG("Damaged frame record at %llu\n",
+                    (unsigned long long)replay->offset);
+            return WG_FALSE;
+        }
+
+        replay->offset += CAM_REC_SIZE(rec->size);
+        *record = rec;
+
+        return WG_TRUE;
+    }
+}
+
+/**
+ * @brief Get time a frame is due in real time pacing
+ */
+WG_PRIVATE wg_uint64
+record_due(const Wg_cam_replay *replay, const Cam_rec_frame *record)
+{
+    /* recorded clock never goes back, but a damaged file may */
+    if (record->usec < replay->first_usec){
+        return replay->start_usec;
+    }
+
+    return replay->start_usec + (record->usec - replay->first_usec);
+}
+
+WG_PRIVATE void
+sleep_until(wg_uint64 usec)
+{
+    struct timespec ts;
+
+    ts.tv_sec  = usec / 1000000;
+    ts.tv_nsec = (usec % 1000000) * 1000;
+
+    while (clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &ts, NULL)
+            == EINTR);
+
+    return;
+}
+
+/*! @} */
@@ -42,9 +42,21 @@ cam_allocate_buffers(Wg_camera *cam, wg_uint bufnum);
 WG_PRIVATE cam_status
 cam_put_buffer(Wg_camera *cam, Wg_frame *frame);
 
+WG_PRIVATE cam_status
+cam_map_buffer(Wg_camera *cam, wg_uint index);
+
+WG_PRIVATE cam_status
+cam_user_buffer(Wg_camera *cam, wg_uint index);
+
+WG_PRIVATE void
+cam_wrap_buffer(Wg_camera *cam, Wg_cam_buf *buffer);
+
 WG_PRIVATE cam_status
 cam_pop_buffer(Wg_camera *cam, Wg_frame *frame);
 
+WG_PRIVATE void
+cam_pop_newest(Wg_camera *cam, struct v4l2_buffer *buffer);
+
 WG_PRIVATE cam_status
 cam_cleanup_frame(Wg_camera *cam, Wg_frame *frame);
 
@@ -113,10 +125,21 @@ WG_PRIVATE cam_status
 cam_start_capturing(Wg_camera *cam)
 {
     cam_status status = CAM_FAILURE;
+    wg_uint bufnum = 0;
 
     CHECK_FOR_NULL_PARAM(cam);
 
-    status = cam_allocate_buffers(cam, DEFAULT_BUFFER_NUM);
+    bufnum = (0 != cam->buf_request) ? cam->buf_request : DEFAULT_BUFFER_NUM;
+    cam->dropped = 0;
+
+    status = cam_allocate_buffers(cam, bufnum);
+    if ((CAM_NO_SUPPORT == status) && (V4L2_MEMORY_USERPTR == cam->memory)){
+        WG_LOG("%s: user buffers not supported, using MMAP\n", 
+                cam->dev_path);
+        cam->memory = V4L2_MEMORY_MMAP;
+        status = cam_allocate_buffers(cam, bufnum);
+    }
+
     if (CAM_SUCCESS != status){
         return CAM_FAILURE;
     }
@@ -156,8 +179,10 @@ cam_pop_buffer(Wg_camera *cam, Wg_frame *frame)
     Wg_cam_buf *cam_buffer = NULL;
     int status = -1;
 
+    memset(&buffer, '\0', sizeof (struct v4l2_buffer));
+
     buffer.type   = V4L2_BUF_TYPE_VIDEO_CAPTURE;
-    buffer.memory = V4L2_MEMORY_MMAP;
+    buffer.memory = cam->memory;
 
     status = ioctl(cam->fd_cam, VIDIOC_DQBUF, &buffer);
     if (-1 == status){
@@ -165,6 +190,10 @@ cam_pop_buffer(Wg_camera *cam, Wg_frame *frame)
         return CAM_FAILURE;
     }
 
+    if (WG_TRUE == cam->newest_frame){
+        cam_pop_newest(cam, &buffer);
+    }
+
     if (buffer.index >= cam->buf_num){
         return CAM_INVAL;
     }
@@ -181,9 +210,56 @@ cam_pop_buffer(Wg_camera *cam, Wg_frame *frame)
     frame->height      = fmt->height;
     frame->pixelformat = fmt->pixelformat;
 
+    /* drivers may stamp with wall clock, keep only monotonic time */
+    if ((buffer.flags & V4L2_BUF_FLAG_TIMESTAMP_MASK) == 
+            V4L2_BUF_FLAG_TIMESTAMP_MONOTONIC){
+        frame->stamp.usec = wg_time_from_timeval(&buffer.timestamp);
+    }else{
+        frame->stamp.usec = wg_time_now();
+    }
+    frame->stamp.sequence = buffer.sequence;
+
     return CAM_SUCCESS;
 }
 
+WG_PRIVATE void
+cam_pop_newest(Wg_camera *cam, struct v4l2_buffer *buffer)
+{
+    struct v4l2_buffer next;
+    struct pollfd fds;
+
+    /* dequeue while the driver has frames ready, poll with no timeout 
+     * keeps VIDIOC_DQBUF from blocking
+     */
+    for (;;){
+        fds.fd      = cam->fd_cam;
+        fds.events  = POLL_FLAGS;
+        fds.revents = 0;
+
+        if ((poll(&fds, 1, 0) <= 0) || !(fds.revents & POLLIN)){
+            break;
+        }
+
+        memset(&next, '\0', sizeof (struct v4l2_buffer));
+        next.type   = V4L2_BUF_TYPE_VIDEO_CAPTURE;
+        next.memory = cam->memory;
+
+        if (-1 == ioctl(cam->fd_cam, VIDIOC_DQBUF, &next)){
+            break;
+        }
+
+        /* older frame goes back to the driver */
+        if (-1 == ioctl(cam->fd_cam, VIDIOC_QBUF, buffer)){
+            WG_ERROR("%s: can't requeue skipped frame\n", cam->dev_path);
+        }
+
+        *buffer = next;
+        ++cam->dropped;
+    }
+
+    return;
+}
+
 WG_PRIVATE cam_status
 cam_put_buffer(Wg_camera *cam, Wg_frame *frame)
 {
@@ -215,9 +291,14 @@ cam_start_streaming(Wg_camera *cam)
         memset(&buffer, '\0', sizeof (struct v4l2_buffer));
 
         buffer.type   = V4L2_BUF_TYPE_VIDEO_CAPTURE;
-        buffer.memory = V4L2_MEMORY_MMAP;
+        buffer.memory = cam->memory;
         buffer.index  = index;
 
+        if (V4L2_MEMORY_USERPTR == cam->memory){
+            buffer.m.userptr = (unsigned long)cam->buffers[index].start;
+            buffer.length    = cam->buffers[index].length;
+        }
+
         status = ioctl(cam->fd_cam, VIDIOC_QBUF, &buffer);
         if (-1 == status){
             return CAM_FAILURE;
@@ -254,14 +335,13 @@ cam_allocate_buffers(Wg_camera *cam, wg_uint bufnum)
     int status = -1;
     wg_int index = 0;
     Wg_cam_buf *buffers = NULL;
-    struct v4l2_buffer buffer;
 
     CHECK_FOR_NULL_PARAM(cam);
 
     memset(&requested_buffers, '\0', sizeof (struct v4l2_requestbuffers));
 
     requested_buffers.type   = V4L2_BUF_TYPE_VIDEO_CAPTURE;
-    requested_buffers.memory = V4L2_MEMORY_MMAP;
+    requested_buffers.memory = cam->memory;
     requested_buffers.count  = bufnum;
 
     status = ioctl(cam->fd_cam, VIDIOC_REQBUFS, &requested_buffers);
@@ -286,35 +366,113 @@ cam_allocate_buffers(Wg_camera *cam, wg_uint bufnum)
     cam->buf_num = 0;
 
     for (index = 0; index < requested_buffers.count; ++index){
-        memset(&buffer, '\0', sizeof (struct v4l2_buffer));
-        buffer.type   = requested_buffers.type;
-        buffer.memory = V4L2_MEMORY_MMAP;
-        buffer.index  = index;
-
-        status = ioctl(cam->fd_cam, VIDIOC_QUERYBUF, &buffer);
-        if (-1 == status){
-            WG_FREE(cam->buffers);
-            return CAM_FAILURE;
+        if (V4L2_MEMORY_USERPTR == cam->memory){
+            status = cam_user_buffer(cam, index);
+        }else{
+            status = cam_map_buffer(cam, index);
         }
 
-        cam->buffers[index].length = buffer.length;
-
-        cam->buffers[index].start = mmap(NULL, buffer.length, 
-                PROT_READ | PROT_WRITE, MAP_SHARED,
-                cam->fd_cam, buffer.m.offset);
-
-        if (MAP_FAILED == buffers[index].start){
+        if (CAM_SUCCESS != status){
             cam_unmap_buffers(cam);
-            WG_FREE(cam->buffers);
             return CAM_FAILURE;
         }
 
+        cam_wrap_buffer(cam, &cam->buffers[index]);
+
         ++cam->buf_num;
     }
 
     return CAM_SUCCESS;
 }
 
+WG_PRIVATE cam_status
+cam_map_buffer(Wg_camera *cam, wg_uint index)
+{
+    struct v4l2_buffer buffer;
+    Wg_cam_buf *cam_buffer = &cam->buffers[index];
+    int status = -1;
+
+    memset(&buffer, '\0', sizeof (struct v4l2_buffer));
+    buffer.type   = V4L2_BUF_TYPE_VIDEO_CAPTURE;
+    buffer.memory = V4L2_MEMORY_MMAP;
+    buffer.index  = index;
+
+    status = ioctl(cam->fd_cam, VIDIOC_QUERYBUF, &buffer);
+    if (-1 == status){
+        return CAM_FAILURE;
+    }
+
+    cam_buffer->length = buffer.length;
+
+    cam_buffer->start = mmap(NULL, buffer.length, 
+            PROT_READ | PROT_WRITE, MAP_SHARED,
+            cam->fd_cam, buffer.m.offset);
+
+    if (MAP_FAILED == cam_buffer->start){
+        cam_buffer->start = NULL;
+        return CAM_FAILURE;
+    }
+
+    return CAM_SUCCESS;
+}
+
+WG_PRIVATE cam_status
+cam_user_buffer(Wg_camera *cam, wg_uint index)
+{
+    Wg_cam_buf *cam_buffer = &cam->buffers[index];
+    size_t page = sysconf(_SC_PAGESIZE);
+    size_t length = 0;
+    void *start = NULL;
+
+    /* page aligned memory, the driver may DMA straight into it */
+    length = cam->fmt[CAM_FMT_CAPTURE].fmt.pix.sizeimage;
+    length = (length + page - 1) & ~(page - 1);
+
+    if (posix_memalign(&start, page, length) != 0){
+        return CAM_FAILURE;
+    }
+
+    cam_buffer->start  = start;
+    cam_buffer->length = length;
+
+    return CAM_SUCCESS;
+}
+
+WG_PRIVATE void
+cam_wrap_buffer(Wg_camera *cam, Wg_cam_buf *buffer)
+{
+    struct v4l2_pix_format *fmt = &(cam->fmt[CAM_FMT_CAPTURE].fmt.pix);
+    wg_uint comp_num = 0;
+    img_type type = IMG_YUYV;
+
+    /* uncompressed frames are used in place, others need decoding */
+    switch (fmt->pixelformat){
+    case V4L2_PIX_FMT_YUYV:
+        comp_num = YUYV_COMPONENT_NUM / 2;
+        type     = IMG_YUYV;
+        break;
+    case V4L2_PIX_FMT_GREY:
+        comp_num = GS_COMPONENT_NUM;
+        type     = IMG_GS;
+        break;
+    default:
+        return;
+    }
+
+    /* image kernels expect packed rows, padded ones go through 
+     * the decoder copy 
+     */
+    if (fmt->bytesperline != fmt->width * comp_num){
+        WG_DEBUG("%s: %u bytes per line, frames are copied\n", 
+                cam->dev_path, fmt->bytesperline);
+        return;
+    }
+
+    img_attach(buffer->start, fmt->width, fmt->height, comp_num, type, 
+            &buffer->image);
+
+    return;
+}
 
 WG_PRIVATE cam_status
 cam_unmap_buffers(Wg_camera *cam)
@@ -324,15 +482,28 @@ cam_unmap_buffers(Wg_camera *cam)
 
     CHECK_FOR_NULL_PARAM(cam);
 
+    if (NULL == cam->buffers){
+        return CAM_SUCCESS;
+    }
+
     for (index = 0; index < cam->buf_num; ++index){
         buffer = &(cam->buffers[index]);
-        if (NULL != buffer){
-            munmap(buffer->start, buffer->length);
-            memset(buffer, '\0', sizeof (Wg_cam_buf));
+        if (NULL != buffer->start){
+            if (V4L2_MEMORY_USERPTR == cam->memory){
+                free(buffer->start);
+            }else{
+                munmap(buffer->start, buffer->length);
+            }
         }
+        if (NULL != buffer->image.rows){
+            img_detach(&buffer->image);
+        }
+        memset(buffer, '\0', sizeof (Wg_cam_buf));
     }
 
     WG_FREE(cam->buffers);
+    cam->buffers = NULL;
+    cam->buf_num = 0;
 
     return CAM_SUCCESS;
 }
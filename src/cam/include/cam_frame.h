@@ -26,6 +26,8 @@ struct Wg_frame{
     /*!< Pixel format       */
     struct v4l2_buffer stream_buf;
     /*!< Stream buffer associated with this frame */
+    Wg_timestamp stamp;     
+    /*!< Capture time and sequence number */
 };
 
 
@@ -0,0 +1,36 @@
+#ifndef _CAM_NEGOTIATE_H
+#define _CAM_NEGOTIATE_H
+
+/*! Largest number of capture modes considered during negotiation */
+#define CAM_MODE_LIST_MAX   64
+
+/**
+ * @brief Capture mode offered by a camera
+ */
+typedef struct Cam_mode{
+    __u32 pixelformat;   /*!< V4L2 pixel format                           */
+    wg_uint width;       /*!< width in pixels                             */
+    wg_uint height;      /*!< height in pixels                            */
+    wg_uint fps;         /*!< highest frame rate, 0 if not reported       */
+    wg_uint cost_usec;   /*!< estimated decode and processing time        */
+}Cam_mode;
+
+/**
+ * @brief Constraints of a format negotiation
+ */
+typedef struct Cam_negotiate_param{
+    wg_uint target_fps;   /*!< frame rate the pipeline has to keep up with */
+    wg_uint max_width;    /*!< largest width, 0 no limit                   */
+    wg_uint max_height;   /*!< largest height, 0 no limit                  */
+    wg_uint pipeline_ns;  /*!< processing time per pixel after decoding    */
+}Cam_negotiate_param;
+
+WG_PUBLIC cam_status
+cam_mode_list(Wg_camera *cam, Cam_mode modes[], wg_uint max_num,
+        wg_uint *num);
+
+WG_PUBLIC cam_status
+cam_negotiate(Wg_camera *cam, const Cam_negotiate_param *param,
+        Cam_mode *mode);
+
+#endif
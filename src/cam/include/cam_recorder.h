@@ -0,0 +1,52 @@
+#ifndef _CAM_RECORDER_H
+#define _CAM_RECORDER_H
+
+/*! Number of frames waiting for the recorder thread */
+#define CAM_RECORDER_SLOT_NUM   4
+
+/**
+ * @brief Frame waiting to be written
+ */
+typedef struct Cam_rec_slot{
+    Cam_rec_frame record;   /*!< record header                    */
+    wg_uchar *data;         /*!< copy of frame data               */
+    wg_size   capacity;     /*!< size of data buffer              */
+}Cam_rec_slot;
+
+/**
+ * @brief Recorder of camera frames into a ring file
+ *
+ * Frames are copied to a slot by the capture thread and written to the
+ * mapped file by the recorder thread. When all slots are busy frames are
+ * not recorded, capture never waits for the disk.
+ */
+typedef struct Wg_cam_recorder{
+    Cam_rec_header *header;                  /*!< mapped file header      */
+    wg_uchar *area;                          /*!< mapped frame area       */
+    wg_size map_size;                        /*!< size of the mapping     */
+    int fd;                                  /*!< recording file          */
+    pthread_t thread;                        /*!< recorder thread         */
+    pthread_mutex_t lock;                    /*!< protects slot queue     */
+    pthread_cond_t ready;                    /*!< slot queued or stop     */
+    Cam_rec_slot slot[CAM_RECORDER_SLOT_NUM];/*!< frames to write         */
+    wg_uint head;                            /*!< next slot to fill       */
+    wg_uint tail;                            /*!< next slot to write      */
+    wg_uint count;                           /*!< queued slots            */
+    wg_uint dropped;                         /*!< frames not recorded     */
+    wg_boolean stop;                         /*!< thread asked to finish  */
+}Wg_cam_recorder;
+
+WG_PUBLIC cam_status
+cam_recorder_open(Wg_cam_recorder *rec, const wg_char *path, wg_size size,
+        const Wg_camera *cam);
+
+WG_PUBLIC cam_status
+cam_recorder_write(Wg_cam_recorder *rec, const Wg_frame *frame);
+
+WG_PUBLIC cam_status
+cam_recorder_get_dropped(Wg_cam_recorder *rec, wg_uint *dropped);
+
+WG_PUBLIC cam_status
+cam_recorder_close(Wg_cam_recorder *rec);
+
+#endif
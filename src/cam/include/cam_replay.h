@@ -0,0 +1,52 @@
+#ifndef _CAM_REPLAY_H
+#define _CAM_REPLAY_H
+
+/*! Magic number of a recording file */
+#define CAM_REC_MAGIC    v4l2_fourcc('W', 'G', 'R', 'C')
+
+/*! Version of a recording file */
+#define CAM_REC_VERSION  1
+
+/*! Frame records start at multiples of this value */
+#define CAM_REC_ALIGN    8
+
+/*! Size of a frame record holding size bytes of data */
+#define CAM_REC_SIZE(size)                                                 \
+    ((sizeof (Cam_rec_frame) + (size) + CAM_REC_ALIGN - 1) &               \
+     ~((wg_uint64)CAM_REC_ALIGN - 1))
+
+/**
+ * @brief Recording file header
+ *
+ * Header is followed by a frame area of data_size bytes. Frames are stored
+ * from start to end exactly as the camera delivered them, raw YUYV or
+ * compressed MJPEG. If end is below start the area is used as a ring and
+ * frames continue from the beginning of the area at a record of size 0 or
+ * when no record fits before the end of the area. All fields are in host
+ * byte order.
+ */
+typedef struct Cam_rec_header{
+    wg_uint32 magic;        /*!< CAM_REC_MAGIC                              */
+    wg_uint32 version;      /*!< CAM_REC_VERSION                            */
+    wg_uint32 pixelformat;  /*!< V4L2 pixel format of frames                */
+    wg_uint32 width;        /*!< width in pixels                            */
+    wg_uint32 height;       /*!< height in pixels                           */
+    wg_uint32 reserved;     /*!< keeps the header aligned                   */
+    wg_uint64 data_size;    /*!< size of the frame area                     */
+    wg_uint64 start;        /*!< offset of the oldest frame in the area     */
+    wg_uint64 end;          /*!< offset behind the newest frame in the area */
+}Cam_rec_header;
+
+/**
+ * @brief Frame record header, followed by size bytes of frame data
+ */
+typedef struct Cam_rec_frame{
+    wg_uint64 usec;         /*!< capture time in microseconds               */
+    wg_uint32 sequence;     /*!< driver sequence number                     */
+    wg_uint32 size;         /*!< number of data bytes, 0 marks the wrap     */
+}Cam_rec_frame;
+
+WG_PUBLIC cam_status
+cam_replay_init(Wg_camera *cam);
+
+#endif
@@ -2,6 +2,7 @@
 #include <sys/types.h>
 #include <string.h>
 #include <setjmp.h>
+#include <pthread.h>
 
 #include <wgtypes.h>
 #include <wg.h>
@@ -29,12 +30,22 @@ typedef JSAMPLE* JSAMPROW;
 WG_PRIVATE void
 xfree_cb(guchar *pixels, gpointer data);
 
+WG_PRIVATE wg_status
+copy_2_pixbuf(Wg_image *img, GdkPixbuf **pixbuf);
+
+/** @brief Selected instruction set, -1 until detected */
+WG_STATIC wg_int simd_level = -1;
+
+WG_PRIVATE Img_simd
+simd_detect(void);
+
 /** 
 * @brief Create new image instance
 *  
 * @param width     width in pixels
 * @param height    height in pixels
-* @param comp_num  number of components per pixel
+* @param comp_num  number of components per pixel, BITMASK_COMPONENT_NUM
+*                  for IMG_BITMASK
 * @param type  type of the image
 * @param img       memory to store image instance
 * 
@@ -60,11 +71,15 @@ img_fill(wg_uint width, wg_uint height, wg_uint comp_num, img_type type,
     }
 
     /* calculate size of a row                      */
-    row_size = width * comp_num * sizeof (JSAMPLE);
+    if (IMG_BITMASK == type){
+        row_size = BITMASK_ROW_SIZE(width);
+    }else{
+        row_size = width * comp_num * sizeof (JSAMPLE);
+    }
 
     /* allocate memory for decompressed image       */
     raw_data = WG_CALLOC(height, row_size);
-    if (NULL == row_array){
+    if (NULL == raw_data){
         WG_FREE(row_array);
         return WG_FAILURE;
     }
@@ -90,6 +105,78 @@ img_fill(wg_uint width, wg_uint height, wg_uint comp_num, img_type type,
     return WG_SUCCESS;
 }
 
+/** 
+* @brief Create image instance over memory owned by the caller
+*
+* Only the array of rows is allocated, pixels are not copied. Image must
+* be released by img_detach().
+*  
+* @param data      first pixel
+* @param width     width in pixels
+* @param height    height in pixels
+* @param comp_num  number of bytes per pixel
+* @param type      type of the image
+* @param img       memory to store image instance
+* 
+* @retval WG_SUCCESS
+* @retval WG_FAILURE
+*/
+wg_status
+img_attach(wg_uchar *data, wg_uint width, wg_uint height, wg_uint comp_num, 
+        img_type type, Wg_image *img)
+{
+    wg_uchar **row_array = NULL;
+    wg_uint row_size = 0;
+    wg_uint i = 0;
+
+    CHECK_FOR_NULL_PARAM(data);
+    CHECK_FOR_NULL_PARAM(img);
+
+    row_array = WG_CALLOC(height, sizeof (wg_uchar*));
+    if (NULL == row_array){
+        return WG_FAILURE;
+    }
+
+    row_size = width * comp_num;
+
+    for (i = 0; i < height; ++i){
+        row_array[i] = data + i * row_size;
+    }
+
+    img->image                = data;
+    img->width                = width;
+    img->height               = height;
+    img->size                 = height * row_size;
+    img->components_per_pixel = comp_num;
+    img->rows                 = row_array;
+    img->row_distance         = row_size;
+    img->type                 = type;
+
+    return WG_SUCCESS;
+}
+
+/** 
+* @brief Release image created by img_attach()
+*
+* Pixels stay untouched, they belong to the caller.
+* 
+* @param img  image instance
+* 
+* @retval WG_SUCCESS
+* @retval WG_FAILURE
+*/
+wg_status
+img_detach(Wg_image *img)
+{
+    CHECK_FOR_NULL_PARAM(img);
+
+    WG_FREE(img->rows);
+
+    memset(img, '\0', sizeof (Wg_image));
+
+    return WG_SUCCESS;
+}
+
 /** 
 * @brief Clean all resources allocated by img_fill()
 * 
@@ -151,6 +238,71 @@ img_get_subimage(Wg_image *img_src, wg_uint x, wg_uint y,
     return WG_SUCCESS;
 }
 
+/** 
+* @brief Get the subimage of an image without copying pixels
+*
+* Rows of img_view point into rows of img_src, pixels must not be released 
+* before the view. Row pointers are stored in row_array of the caller, so 
+* a view allocates nothing and is not released. The window is checked
+* in release builds too, the view is read without bounds checks.
+* 
+* @param img_src    source image instance
+* @param x          x position in source
+* @param y          y position in source image
+* @param width      width of the subimage
+* @param height     height of the subimage
+* @param row_array  memory for height row pointers, used by the view
+* @param img_view   subimage
+* 
+* @retval WG_SUCCESS
+* @retval WG_FAILURE
+*/
+wg_status
+img_get_subimage_view(const Wg_image *img_src, wg_uint x, wg_uint y, 
+        wg_uint width, wg_uint height, wg_uchar **row_array, 
+        Wg_image *img_view)
+{
+    wg_uint x_off = 0;
+    wg_uint i = 0;
+
+    CHECK_FOR_NULL_PARAM(img_src);
+    CHECK_FOR_NULL_PARAM(row_array);
+    CHECK_FOR_NULL_PARAM(img_view);
+
+    if ((0 == width) || (0 == height) || 
+        (x > img_src->width) || (width > img_src->width - x) ||
+        (y > img_src->height) || (height > img_src->height - y)){
+        WG_ERROR("Window %ux%u at %u,%u is out of image %ux%u\n", 
+                width, height, x, y, img_src->width, img_src->height);
+        return WG_FAILURE;
+    }
+
+    /* pixels of a bit mask row do not start on a byte */
+    if (img_src->type == IMG_BITMASK){
+        WG_ERROR("Invalig image format! Passed %d\n", img_src->type);
+        return WG_FAILURE;
+    }
+
+    x_off = img_src->components_per_pixel * x;
+
+    for (i = 0; i < height; ++i){
+        row_array[i] = img_src->rows[y + i] + x_off;
+    }
+
+    img_view->image                = row_array[0];
+    img_view->width                = width;
+    img_view->height               = height;
+    img_view->size                 = (height - 1) * img_src->row_distance +
+                                        width * img_src->components_per_pixel;
+    img_view->components_per_pixel = img_src->components_per_pixel;
+    img_view->rows                 = row_array;
+    img_view->row_distance         = img_src->row_distance;
+    img_view->type                 = img_src->type;
+    img_view->stamp                = img_src->stamp;
+
+    return WG_SUCCESS;
+}
+
 /** 
 * @brief Copy image
 * 
@@ -169,9 +321,194 @@ img_copy(Wg_image *src, Wg_image *dest)
     img_fill(src->width, src->height, src->components_per_pixel, src->type,
             dest);
 
+    dest->stamp = src->stamp;
+
     return img_get_subimage(src, 0, 0, dest);
 }
 
+/** 
+* @brief Get instruction set used by image kernels
+*
+* CPU is checked on the first call.
+* 
+* @return best instruction set supported by the CPU or the one set by
+*         img_simd_set_level()
+*/
+Img_simd
+img_simd_level(void)
+{
+    if (simd_level < 0){
+        simd_level = simd_detect();
+    }
+
+    return simd_level;
+}
+
+/** 
+* @brief Limit instruction set used by image kernels
+*
+* Level is lowered to what the CPU supports. Mostly useful to compare 
+* results of vector kernels against the portable ones.
+* 
+* @param level requested instruction set
+* 
+* @return instruction set which will be used
+*/
+Img_simd
+img_simd_set_level(Img_simd level)
+{
+    simd_level = WG_MIN(level, simd_detect());
+
+    return simd_level;
+}
+
+/** 
+* @brief Initialize image pool
+*
+* Pool keeps images released by img_pool_release() and hands them back to
+* img_pool_acquire() when dimensions match, so a loop processing frames of 
+* the same size allocates memory only during first iterations.
+* 
+* @param pool      pool instance
+* @param capacity  maximum number of images kept by the pool
+* 
+* @retval WG_SUCCESS
+* @retval WG_FAILURE
+*/
+wg_status
+img_pool_init(Img_pool *pool, wg_uint capacity)
+{
+    CHECK_FOR_NULL_PARAM(pool);
+    CHECK_FOR_COND(capacity > 0);
+
+    pool->image = WG_CALLOC(capacity, sizeof (Wg_image));
+    if (NULL == pool->image){
+        return WG_FAILURE;
+    }
+
+    pool->num      = 0;
+    pool->capacity = capacity;
+
+    pthread_mutex_init(&pool->lock, NULL);
+
+    return WG_SUCCESS;
+}
+
+/** 
+* @brief Release all images kept by the pool
+* 
+* @param pool pool instance
+*/
+void
+img_pool_cleanup(Img_pool *pool)
+{
+    wg_uint i = 0;
+
+    if (NULL == pool->image){
+        return;
+    }
+
+    for (i = 0; i < pool->num; ++i){
+        img_cleanup(&pool->image[i]);
+    }
+
+    WG_FREE(pool->image);
+
+    pthread_mutex_destroy(&pool->lock);
+
+    memset(pool, '\0', sizeof (Img_pool));
+
+    return;
+}
+
+/** 
+* @brief Get image from the pool
+*
+* Works like img_fill() but reuses a free image with the same geometry if 
+* there is one. Content of a reused image is not cleared.
+* 
+* @param pool      pool instance
+* @param width     width in pixels
+* @param height    height in pixels
+* @param comp_num  number of components per pixel
+* @param type      type of the image
+* @param img       memory to store image instance
+* 
+* @retval WG_SUCCESS
+* @retval WG_FAILURE
+*/
+wg_status
+img_pool_acquire(Img_pool *pool, wg_uint width, wg_uint height, 
+        wg_uint comp_num, img_type type, Wg_image *img)
+{
+    Wg_image *free_img = NULL;
+    wg_uint i = 0;
+
+    CHECK_FOR_NULL_PARAM(pool);
+    CHECK_FOR_NULL_PARAM(img);
+
+    pthread_mutex_lock(&pool->lock);
+
+    for (i = 0; i < pool->num; ++i){
+        free_img = &pool->image[i];
+        if ((free_img->width == width) && (free_img->height == height) &&
+            (free_img->components_per_pixel == comp_num)){
+            *img = *free_img;
+            img->type = type;
+
+            /* keep free images packed at the beginning of the array */
+            *free_img = pool->image[--pool->num];
+            memset(&pool->image[pool->num], '\0', sizeof (Wg_image));
+
+            pthread_mutex_unlock(&pool->lock);
+            return WG_SUCCESS;
+        }
+    }
+
+    pthread_mutex_unlock(&pool->lock);
+
+    return img_fill(width, height, comp_num, type, img);
+}
+
+/** 
+* @brief Return image to the pool
+*
+* If the pool is full the image is released. Image can't be used after
+* this call. Empty images are ignored.
+* 
+* @param pool  pool instance
+* @param img   image instance
+* 
+* @retval WG_SUCCESS
+* @retval WG_FAILURE
+*/
+wg_status
+img_pool_release(Img_pool *pool, Wg_image *img)
+{
+    CHECK_FOR_NULL_PARAM(pool);
+    CHECK_FOR_NULL_PARAM(img);
+
+    if (NULL == img->image){
+        return WG_SUCCESS;
+    }
+
+    pthread_mutex_lock(&pool->lock);
+
+    if (pool->num < pool->capacity){
+        pool->image[pool->num++] = *img;
+        memset(img, '\0', sizeof (Wg_image));
+    }
+
+    pthread_mutex_unlock(&pool->lock);
+
+    /* pool is full */
+    if (NULL != img->image){
+        img_cleanup(img);
+    }
+
+    return WG_SUCCESS;
+}
+
 /** 
 * @brief Convert Wg_image instance into GdkPixbuf
 *
@@ -179,7 +516,7 @@ img_copy(Wg_image *src, Wg_image *dest)
 *    should not be used. Before pixbuf is released a free callback is called to
 *    free all resources allocated by img. If free_cb is NULL then a default
 *    callback is used which assumes that Wg_image was allocated using
-*    WG_MALLOC/WG_CALLOC.
+*    WG_MALLOC/WG_CALLOC. BGRX, YCbCr and YUYV images are converted to RGB.
 * 
 * @param img        source image
 * @param pixbuf     memory to store GdkPixbuf object
@@ -195,8 +532,13 @@ img_convert_to_pixbuf(Wg_image *img, GdkPixbuf **pixbuf,
     GdkPixbuf *pix = NULL;
     GdkPixbuf *pix_dest = NULL;
 
+    if ((IMG_BGRX == img->type) || (IMG_YCBCR == img->type) ||
+            (IMG_YUYV == img->type)){
+        return copy_2_pixbuf(img, pixbuf);
+    }
+
     if (IMG_RGB != img->type){
-        WG_LOG("Only RGB24 supported\n");
+        WG_LOG("Only RGB24, BGRX, YCbCr and YUYV supported\n");
         return WG_FAILURE;
     }
 
@@ -222,6 +564,63 @@ img_convert_to_pixbuf(Wg_image *img, GdkPixbuf **pixbuf,
     return WG_SUCCESS;
 }
 
+WG_PRIVATE wg_status
+copy_2_pixbuf(Wg_image *img, GdkPixbuf **pixbuf)
+{
+    GdkPixbuf *pix = NULL;
+    bgrx_pixel *bgrx_pix = NULL;
+    wg_uchar *ycbcr = NULL;
+    guchar *pixels = NULL;
+    guchar *rgb = NULL;
+    wg_uint rowstride = 0;
+    wg_uint row = 0;
+    wg_uint col = 0;
+
+    pix = gdk_pixbuf_new(GDK_COLORSPACE_RGB, FALSE, 8, 
+            img->width, img->height);
+    if (NULL == pix){
+        WG_LOG("Wg_image -> GdkPixbuf conversion error\n");
+        return WG_FAILURE;
+    }
+
+    pixels    = gdk_pixbuf_get_pixels(pix);
+    rowstride = gdk_pixbuf_get_rowstride(pix);
+
+    /* convert while copying, pixbuf has no BGRX, YCbCr nor YUYV layout */
+    for (row = 0; row < img->height; ++row){
+        rgb = pixels + row * rowstride;
+        if (IMG_YUYV == img->type){
+            img_get_row(img, row, &ycbcr);
+            for (col = 0; col < img->width; ++col){
+                yuyv_2_rgb(ycbcr[(col & 1) ? POS_Y1 : POS_Y0], 
+                        ycbcr[POS_U], ycbcr[POS_V], rgb);
+                if (col & 1){
+                    ycbcr += YUYV_COMPONENT_NUM;
+                }
+                rgb += RGB24_COMPONENT_NUM;
+            }
+        }else if (IMG_YCBCR == img->type){
+            img_get_row(img, row, &ycbcr);
+            for (col = 0; col < img->width; ++col){
+                ycbcr_2_rgb(ycbcr[YCBCR_Y], ycbcr[YCBCR_CB], 
+                        ycbcr[YCBCR_CR], rgb);
+                ycbcr += YCBCR_COMPONENT_NUM;
+                rgb   += RGB24_COMPONENT_NUM;
+            }
+        }else{
+            img_get_row(img, row, (wg_uchar**)&bgrx_pix);
+            for (col = 0; col < img->width; ++col, ++bgrx_pix){
+                bgrx_2_rgb(*bgrx_pix, rgb);
+                rgb += RGB24_COMPONENT_NUM;
+            }
+        }
+    }
+
+    *pixbuf = pix;
+
+    return WG_SUCCESS;
+}
+
 WG_PRIVATE void
 xfree_cb(guchar *pixels, gpointer data)
 {
@@ -230,6 +629,24 @@ xfree_cb(guchar *pixels, gpointer data)
     WG_FREE(data);
 }
 
+WG_PRIVATE Img_simd
+simd_detect(void)
+{
+#if defined(__x86_64__) || defined(__i386__)
+    __builtin_cpu_init();
+
+    if (__builtin_cpu_supports("avx2")){
+        return IMG_SIMD_AVX2;
+    }
+
+    if (__builtin_cpu_supports("sse2")){
+        return IMG_SIMD_SSE2;
+    }
+#endif
+
+    return IMG_SIMD_NONE;
+}
+
 
 #ifdef __i386__
 
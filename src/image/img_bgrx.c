@@ -5,11 +5,8 @@
 #include <wgtypes.h>
 #include <wg.h>
 #include <wgmacros.h>
-#include <wg_sort.h>
 #include <img.h>
 
-#define BGRX_COMPONENT_NUM    4
-
 /*! @defgroup image_bgrx BGRX manipulation
  * @ingroup image
  */
@@ -28,6 +25,37 @@
  */
 wg_status
 img_rgb_2_bgrx(Wg_image *rgb_img, Wg_image *bgrx_img)
+{
+    wg_status status = WG_FAILURE;
+
+    CHECK_FOR_NULL_PARAM(rgb_img);
+    CHECK_FOR_NULL_PARAM(bgrx_img);
+
+    status = img_fill(rgb_img->width, rgb_img->height, BGRX_COMPONENT_NUM, 
+            IMG_BGRX, bgrx_img);
+    if (WG_SUCCESS != status){
+        return WG_FAILURE;
+    }
+
+    status = img_rgb_2_bgrx_noalloc(rgb_img, bgrx_img);
+    if (WG_SUCCESS != status){
+        img_cleanup(bgrx_img);
+    }
+
+    return status;
+}
+
+/**
+ * @brief Convert RGB24 to BGRX format without allocating memory
+ *
+ * @param rgb_img     RGB24 image
+ * @param bgrx_img    BGRX image of the same size as rgb_img
+ *
+ * @retval WG_SUCCESS
+ * @retval WG_SUCCESS
+ */
+wg_status
+img_rgb_2_bgrx_noalloc(Wg_image *rgb_img, Wg_image *bgrx_img)
 {
     wg_status status = WG_FAILURE;
     wg_uint32 *bgrx_pixel = NULL;
@@ -49,11 +77,13 @@ img_rgb_2_bgrx(Wg_image *rgb_img, Wg_image *bgrx_img)
     img_get_width(rgb_img, &width);
     img_get_height(rgb_img, &height);
 
-    status = img_fill(width, height, BGRX_COMPONENT_NUM, IMG_BGRX,
-            bgrx_img);
+    status = img_check_geometry(bgrx_img, width, height, BGRX_COMPONENT_NUM);
     if (WG_SUCCESS != status){
         return WG_FAILURE;
     }
+
+    bgrx_img->type = IMG_BGRX;
+
     for (row = 0; row < height; ++row){
         img_get_row(rgb_img, row, (wg_uchar**)&rgb_pixel);
         img_get_row(bgrx_img, row, (wg_uchar**)&bgrx_pixel);
@@ -81,21 +111,76 @@ img_rgb_2_bgrx(Wg_image *rgb_img, Wg_image *bgrx_img)
 wg_status
 img_bgrx_median_filter(Wg_image *img, Wg_image *new_img)
 {
-    register bgrx_pixel *pixel = NULL;
-    bgrx_pixel *new_pixel = NULL;
-    bgrx_pixel *tmp_pixel = NULL;
+    wg_status status = WG_FAILURE;
+
+    CHECK_FOR_NULL_PARAM(img);
+    CHECK_FOR_NULL_PARAM(new_img);
+
+    status = img_fill(img->width - 2, img->height - 2, 
+            img->components_per_pixel, img->type, new_img);
+    if (WG_SUCCESS != status){
+        return WG_FAILURE;
+    }
+
+    status = img_bgrx_median_filter_noalloc(img, new_img);
+    if (WG_SUCCESS != status){
+        img_cleanup(new_img);
+    }
+
+    return status;
+}
+
+/** 
+* @brief Use median filter on the image without allocating memory
+* 
+* @param[in]  img       source image instance
+* @param[out] new_img   image smaller by 2 pixels in each dimension
+* 
+* @retval WG_SUCCESS
+* @retval WG_FAILURE
+*/
+wg_status
+img_bgrx_median_filter_noalloc(Wg_image *img, Wg_image *new_img)
+{
+    CHECK_FOR_NULL_PARAM(img);
+    CHECK_FOR_NULL_PARAM(new_img);
+
+    if (img->type != IMG_BGRX){
+        WG_ERROR("Invalig image format! Passed %d expect %d\n", 
+                img->type, IMG_BGRX);
+        return WG_FAILURE;
+    }
+
+    return img_median_filter_noalloc(img, new_img);
+}
+
+/**
+ * @brief Build a mask of pixels using RGB565 classification table
+ *
+ * Low bits of each component are dropped and the color is looked up,
+ * one table load per pixel.
+ *
+ * @param img   BGRX image
+ * @param mask  grayscale image of the same size as img
+ * @param lut   table built by img_hsv_range_rgb565_lut()
+ *
+ * @retval WG_SUCCESS
+ * @retval WG_FAILURE
+ */
+wg_status
+img_bgrx_lut_mask_noalloc(const Wg_image *img, Wg_image *mask, 
+        const gray_pixel *lut)
+{
+    const bgrx_pixel *bgrx_pix = NULL;
+    gray_pixel *gs_pixel = NULL;
     wg_uint width = 0;
     wg_uint height = 0;
     wg_uint row = 0;
     wg_uint col = 0;
-    wg_int rd = 0;
-    wg_int rd2 = 0;
-    wg_uint data_red[9];
-    wg_uint data_green[9];
-    wg_uint data_blue[9];
-    bgrx_pixel pix_val = 0;
 
     CHECK_FOR_NULL_PARAM(img);
+    CHECK_FOR_NULL_PARAM(mask);
+    CHECK_FOR_NULL_PARAM(lut);
 
     if (img->type != IMG_BGRX){
         WG_ERROR("Invalig image format! Passed %d expect %d\n", 
@@ -106,70 +191,83 @@ img_bgrx_median_filter(Wg_image *img, Wg_image *new_img)
     img_get_width(img, &width);
     img_get_height(img, &height);
 
-    height -= 2;
-    width  -= 2;
+    if (img_check_geometry(mask, width, height, GS_COMPONENT_NUM) 
+            != WG_SUCCESS){
+        return WG_FAILURE;
+    }
 
-    img_fill(width, height, img->components_per_pixel, img->type,
-            new_img);
+    mask->type = IMG_GS;
 
-    rd = img->width;
-    rd2 = rd + rd;
+    for (row = 0; row < height; ++row){
+        img_get_row(img, row, (wg_uchar**)&bgrx_pix);
+        img_get_row(mask, row, (wg_uchar**)&gs_pixel);
+        for (col = 0; col < width; ++col){
+            gs_pixel[col] = lut[BGRX_2_RGB565(bgrx_pix[col])];
+        }
+    }
+
+    return WG_SUCCESS;
+}
+
+/**
+ * @brief Build a bit mask of pixels using RGB565 classification table
+ *
+ * Same classification as img_bgrx_lut_mask_noalloc(), pixels with non zero
+ * table entry are set.
+ *
+ * @param img   BGRX image
+ * @param mask  IMG_BITMASK image of the same size as img
+ * @param lut   table built by img_hsv_range_rgb565_lut()
+ *
+ * @retval WG_SUCCESS
+ * @retval WG_FAILURE
+ */
+wg_status
+img_bgrx_lut_bitmask_noalloc(const Wg_image *img, Wg_image *mask, 
+        const gray_pixel *lut)
+{
+    const bgrx_pixel *bgrx_pix = NULL;
+    bitmask_word *word = NULL;
+    bitmask_word bits = 0;
+    wg_uint width = 0;
+    wg_uint height = 0;
+    wg_uint row = 0;
+    wg_uint col = 0;
+
+    CHECK_FOR_NULL_PARAM(img);
+    CHECK_FOR_NULL_PARAM(mask);
+    CHECK_FOR_NULL_PARAM(lut);
+
+    if (img->type != IMG_BGRX){
+        WG_ERROR("Invalig image format! Passed %d expect %d\n", 
+                img->type, IMG_BGRX);
+        return WG_FAILURE;
+    }
+
+    img_get_width(img, &width);
+    img_get_height(img, &height);
+
+    if (img_check_geometry(mask, width, height, BITMASK_COMPONENT_NUM) 
+            != WG_SUCCESS){
+        return WG_FAILURE;
+    }
+
+    mask->type = IMG_BITMASK;
 
     for (row = 0; row < height; ++row){
-        img_get_row(img, row, (wg_uchar**)&tmp_pixel);
-        pixel = tmp_pixel;
-        img_get_row(new_img, row, (wg_uchar**)&new_pixel);
-        for (col = 0; col < width; ++col, ++pixel, ++new_pixel){
-            pix_val = pixel[1];
-            data_red[0]   = BGRX_R(pix_val);
-            data_green[0] = BGRX_G(pix_val);
-            data_blue[0]  = BGRX_B(pix_val);
-
-            pix_val = pixel[0];
-            data_red[5]   = BGRX_R(pix_val);
-            data_green[5] = BGRX_G(pix_val);
-            data_blue[5]  = BGRX_B(pix_val);
-
-            pix_val = pixel[2];
-            data_red[6]   = BGRX_R(pix_val);
-            data_green[6] = BGRX_G(pix_val);
-            data_blue[6]  = BGRX_B(pix_val);
-
-            pix_val = pixel[rd + 0];
-            data_red[1]   = BGRX_R(pix_val);
-            data_green[1] = BGRX_G(pix_val);
-            data_blue[1]  = BGRX_B(pix_val);
-
-            pix_val = pixel[rd + 1];
-            data_red[2]   = BGRX_R(pix_val);
-            data_green[2] = BGRX_G(pix_val);
-            data_blue[2]  = BGRX_B(pix_val);
-
-            pix_val = pixel[rd + 2];
-            data_red[3]   = BGRX_R(pix_val);
-            data_green[3] = BGRX_G(pix_val);
-            data_blue[3]  = BGRX_B(pix_val);
-
-            pix_val = pixel[rd2 + 1];
-            data_red[4]   = BGRX_R(pix_val);
-            data_green[4] = BGRX_G(pix_val);
-            data_blue[4]  = BGRX_B(pix_val);
-
-            pix_val = pixel[rd2 + 0];
-            data_red[7]   = BGRX_R(pix_val);
-            data_green[7] = BGRX_G(pix_val);
-            data_blue[7]  = BGRX_B(pix_val);
-
-            pix_val = pixel[rd2 + 2];
-            data_red[8]   = BGRX_R(pix_val);
-            data_green[8] = BGRX_G(pix_val);
-            data_blue[8]  = BGRX_B(pix_val);
-
-            wg_sort_uint_insert(data_red,   ELEMNUM(data_red));
-            wg_sort_uint_insert(data_green, ELEMNUM(data_green));
-            wg_sort_uint_insert(data_blue,  ELEMNUM(data_blue));
-
-            *new_pixel = RGB_2_BGRX(data_red[4], data_green[4], data_blue[4]);
+        img_get_row(img, row, (wg_uchar**)&bgrx_pix);
+        img_get_row(mask, row, (wg_uchar**)&word);
+        bits = 0;
+        for (col = 0; col < width; ++col){
+            bits |= (bitmask_word)(lut[BGRX_2_RGB565(bgrx_pix[col])] != 0) <<
+                (col % BITMASK_WORD_BITS);
+            if (BITMASK_WORD_BITS - 1 == col % BITMASK_WORD_BITS){
+                *word++ = bits;
+                bits    = 0;
+            }
+        }
+        if (0 != col % BITMASK_WORD_BITS){
+            *word = bits;
         }
     }
 
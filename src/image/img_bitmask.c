@@ -0,0 +1,494 @@
+#include <stdio.h>
+#include <sys/types.h>
+#include <string.h>
+
+#include <wgtypes.h>
+#include <wg.h>
+#include <wgmacros.h>
+
+#include <img.h>
+
+/*! @defgroup image_bitmask Bit mask manipulation
+ * @ingroup image
+ *
+ * IMG_BITMASK images keep one bit per pixel in 64 bit words, rows start
+ * at word boundaries and bits behind the last pixel of a row are 0.
+ * Filters work on whole words, a word covers 64 pixels of a row.
+ * @{
+ */
+
+/** Number of bit planes of the smooth window counter, counts up to 31 */
+#define SMOOTH_PLANES     5
+
+/** Side of the smooth window */
+#define SMOOTH_SIDE       5
+
+/** Pixels set in the smooth window needed to keep a pixel, as ef_smooth() */
+#define SMOOTH_MIN        12
+
+WG_PRIVATE wg_status
+check_bitmask(const Wg_image *img, const Wg_image *new_img,
+        wg_uint width, wg_uint height);
+
+WG_PRIVATE bitmask_word
+row_and3(const bitmask_word *row, wg_uint i, wg_uint words);
+
+WG_PRIVATE bitmask_word
+row_or3(const bitmask_word *row, wg_uint i, wg_uint words);
+
+/**
+* @brief Pack a binary grayscale image into a bit mask
+*
+* Non zero pixels are set.
+*
+* @param gs_img  grayscale image
+* @param mask    IMG_BITMASK image of the same size
+*
+* @retval WG_SUCCESS
+* @retval WG_FAILURE
+*/
+wg_status
+img_bitmask_from_gs_noalloc(const Wg_image *gs_img, Wg_image *mask)
+{
+    const gray_pixel *gs_pixel = NULL;
+    bitmask_word *word = NULL;
+    bitmask_word bits = 0;
+    wg_uint row = 0;
+    wg_uint col = 0;
+
+    CHECK_FOR_NULL_PARAM(gs_img);
+    CHECK_FOR_NULL_PARAM(mask);
+
+    if (gs_img->type != IMG_GS){
+        WG_ERROR("Invalig image format! Passed %d expect %d\n",
+                gs_img->type, IMG_GS);
+        return WG_FAILURE;
+    }
+
+    if (img_check_geometry(mask, gs_img->width, gs_img->height,
+                BITMASK_COMPONENT_NUM) != WG_SUCCESS){
+        return WG_FAILURE;
+    }
+
+    mask->type = IMG_BITMASK;
+
+    for (row = 0; row < gs_img->height; ++row){
+        gs_pixel = gs_img->rows[row];
+        word     = (bitmask_word*)mask->rows[row];
+        bits     = 0;
+        for (col = 0; col < gs_img->width; ++col){
+            bits |= (bitmask_word)(gs_pixel[col] != 0) <<
+                (col % BITMASK_WORD_BITS);
+            if (BITMASK_WORD_BITS - 1 == col % BITMASK_WORD_BITS){
+                *word++ = bits;
+                bits    = 0;
+            }
+        }
+        if (0 != col % BITMASK_WORD_BITS){
+            *word = bits;
+        }
+    }
+
+    return WG_SUCCESS;
+}
+
+/**
+* @brief Unpack a bit mask into a grayscale image
+*
+* Set pixels become 255, others 0.
+*
+* @param mask    IMG_BITMASK image
+* @param gs_img  grayscale image of the same size
+*
+* @retval WG_SUCCESS
+* @retval WG_FAILURE
+*/
+wg_status
+img_bitmask_2_gs_noalloc(const Wg_image *mask, Wg_image *gs_img)
+{
+    gray_pixel *gs_pixel = NULL;
+    const bitmask_word *word = NULL;
+    wg_uint row = 0;
+    wg_uint col = 0;
+
+    CHECK_FOR_NULL_PARAM(mask);
+    CHECK_FOR_NULL_PARAM(gs_img);
+
+    if (mask->type != IMG_BITMASK){
+        WG_ERROR("Invalig image format! Passed %d expect %d\n",
+                mask->type, IMG_BITMASK);
+        return WG_FAILURE;
+    }
+
+    if (img_check_geometry(gs_img, mask->width, mask->height,
+                GS_COMPONENT_NUM) != WG_SUCCESS){
+        return WG_FAILURE;
+    }
+
+    gs_img->type = IMG_GS;
+
+    for (row = 0; row < mask->height; ++row){
+        word     = (const bitmask_word*)mask->rows[row];
+        gs_pixel = gs_img->rows[row];
+        for (col = 0; col < mask->width; ++col){
+            gs_pixel[col] = ((word[col / BITMASK_WORD_BITS] >>
+                        (col % BITMASK_WORD_BITS)) & 1) ? 255 : 0;
+        }
+    }
+
+    return WG_SUCCESS;
+}
+
+/**
+* @brief Erode a bit mask with a 3x3 square
+*
+* A pixel stays set if all its neighbours are set, pixels outside the
+* image count as not set.
+*
+* @param img      IMG_BITMASK image
+* @param new_img  IMG_BITMASK image of the same size
+*
+* @retval WG_SUCCESS
+* @retval WG_FAILURE
+*/
+wg_status
+img_bitmask_erode_noalloc(const Wg_image *img, Wg_image *new_img)
+{
+    const bitmask_word *up = NULL;
+    const bitmask_word *mid = NULL;
+    const bitmask_word *down = NULL;
+    bitmask_word *out = NULL;
+    wg_uint words = 0;
+    wg_uint row = 0;
+    wg_uint i = 0;
+
+    if (check_bitmask(img, new_img, img->width, img->height) != WG_SUCCESS){
+        return WG_FAILURE;
+    }
+
+    words = BITMASK_ROW_WORDS(img->width);
+
+    for (row = 0; row < img->height; ++row){
+        out = (bitmask_word*)new_img->rows[row];
+        if ((0 == row) || (img->height - 1 == row)){
+            memset(out, '\0', words * sizeof (bitmask_word));
+            continue;
+        }
+
+        up   = (const bitmask_word*)img->rows[row - 1];
+        mid  = (const bitmask_word*)img->rows[row];
+        down = (const bitmask_word*)img->rows[row + 1];
+        for (i = 0; i < words; ++i){
+            out[i] = row_and3(up, i, words) & row_and3(mid, i, words) &
+                row_and3(down, i, words);
+        }
+    }
+
+    return WG_SUCCESS;
+}
+
+/**
+* @brief Dilate a bit mask with a 3x3 square
+*
+* A pixel is set if any of its neighbours is set.
+*
+* @param img      IMG_BITMASK image
+* @param new_img  IMG_BITMASK image of the same size
+*
+* @retval WG_SUCCESS
+* @retval WG_FAILURE
+*/
+wg_status
+img_bitmask_dilate_noalloc(const Wg_image *img, Wg_image *new_img)
+{
+    const bitmask_word *word = NULL;
+    bitmask_word *out = NULL;
+    bitmask_word tail = 0;
+    wg_uint words = 0;
+    wg_uint row = 0;
+    wg_uint r = 0;
+    wg_uint i = 0;
+
+    if (check_bitmask(img, new_img, img->width, img->height) != WG_SUCCESS){
+        return WG_FAILURE;
+    }
+
+    words = BITMASK_ROW_WORDS(img->width);
+    tail  = bitmask_tail(img->width);
+
+    for (row = 0; row < img->height; ++row){
+        out = (bitmask_word*)new_img->rows[row];
+        memset(out, '\0', words * sizeof (bitmask_word));
+
+        for (r = WG_MAX(row, 1) - 1;
+                (r <= row + 1) && (r < img->height); ++r){
+            word = (const bitmask_word*)img->rows[r];
+            for (i = 0; i < words; ++i){
+                out[i] |= row_or3(word, i, words);
+            }
+        }
+
+        /* growing right must not leak behind the last pixel */
+        out[words - 1] &= tail;
+    }
+
+    return WG_SUCCESS;
+}
+
+/**
+* @brief Extract boundary of bit mask regions
+*
+* Boundary pixels are set pixels with at least one neighbour not set,
+* the mask minus its erosion.
+*
+* @param img      IMG_BITMASK image
+* @param new_img  IMG_BITMASK image of the same size
+*
+* @retval WG_SUCCESS
+* @retval WG_FAILURE
+*/
+wg_status
+img_bitmask_boundary_noalloc(const Wg_image *img, Wg_image *new_img)
+{
+    bitmask_word *out = NULL;
+    const bitmask_word *mid = NULL;
+    wg_uint words = 0;
+    wg_uint row = 0;
+    wg_uint i = 0;
+
+    if (img_bitmask_erode_noalloc(img, new_img) != WG_SUCCESS){
+        return WG_FAILURE;
+    }
+
+    words = BITMASK_ROW_WORDS(img->width);
+
+    for (row = 0; row < img->height; ++row){
+        mid = (const bitmask_word*)img->rows[row];
+        out = (bitmask_word*)new_img->rows[row];
+        for (i = 0; i < words; ++i){
+            out[i] = mid[i] & ~out[i];
+        }
+    }
+
+    return WG_SUCCESS;
+}
+
+/**
+* @brief Smooth a bit mask
+*
+* Same filter as ef_smooth(), a pixel is set when at least 12 pixels of
+* the 5x5 window are set. Window counts are kept in bit planes so 64
+* pixels are counted at once.
+*
+* @param img      IMG_BITMASK image
+* @param new_img  IMG_BITMASK image smaller by 4 pixels in each dimension
+*
+* @retval WG_SUCCESS
+* @retval WG_FAILURE
+*/
+wg_status
+img_bitmask_smooth_noalloc(const Wg_image *img, Wg_image *new_img)
+{
+    const bitmask_word *word = NULL;
+    bitmask_word *out = NULL;
+    bitmask_word count[SMOOTH_PLANES];
+    bitmask_word carry = 0;
+    bitmask_word tmp = 0;
+    bitmask_word ge = 0;
+    bitmask_word eq = 0;
+    wg_uint words = 0;
+    wg_uint new_words = 0;
+    wg_uint row = 0;
+    wg_uint r = 0;
+    wg_uint s = 0;
+    wg_uint p = 0;
+    wg_uint i = 0;
+
+    CHECK_FOR_NULL_PARAM(img);
+    CHECK_FOR_COND((img->width >= SMOOTH_SIDE) &&
+            (img->height >= SMOOTH_SIDE));
+
+    if (check_bitmask(img, new_img, img->width - (SMOOTH_SIDE - 1),
+                img->height - (SMOOTH_SIDE - 1)) != WG_SUCCESS){
+        return WG_FAILURE;
+    }
+
+    words     = BITMASK_ROW_WORDS(img->width);
+    new_words = BITMASK_ROW_WORDS(new_img->width);
+
+    for (row = 0; row < new_img->height; ++row){
+        out = (bitmask_word*)new_img->rows[row];
+        for (i = 0; i < new_words; ++i){
+            memset(count, '\0', sizeof (count));
+
+            /* bit b of each plane counts the window of pixel b */
+            for (r = row; r < row + SMOOTH_SIDE; ++r){
+                word = (const bitmask_word*)img->rows[r];
+                for (s = 0; s < SMOOTH_SIDE; ++s){
+                    carry = bitmask_word_at(word, i, words, s);
+                    for (p = 0; (p < SMOOTH_PLANES) && (0 != carry); ++p){
+                        tmp      = count[p] & carry;
+                        count[p] ^= carry;
+                        carry    = tmp;
+                    }
+                }
+            }
+
+            /* count >= SMOOTH_MIN, compared from the highest plane */
+            ge = 0;
+            eq = ~(bitmask_word)0;
+            for (p = SMOOTH_PLANES; p-- > 0; ){
+                if ((SMOOTH_MIN >> p) & 1){
+                    eq &= count[p];
+                }else{
+                    ge |= eq & count[p];
+                    eq &= ~count[p];
+                }
+            }
+            out[i] = ge | eq;
+        }
+        out[new_words - 1] &= bitmask_tail(new_img->width);
+    }
+
+    return WG_SUCCESS;
+}
+
+/**
+* @brief Get center of set pixels
+*
+* Set pixels of a word are counted with popcount, columns are summed
+* from the counts of 6 bit planes of the column index.
+*
+* @param[in]  img  IMG_BITMASK image
+* @param[out] y    row of the center, 0 if nothing is set
+* @param[out] x    column of the center, 0 if nothing is set
+* @param[out] num  number of set pixels, may be NULL
+*
+* @retval WG_SUCCESS
+* @retval WG_FAILURE
+*/
+wg_status
+img_bitmask_center(const Wg_image *img, wg_uint *y, wg_uint *x,
+        wg_uint *num)
+{
+    static const bitmask_word col_bit[] = {
+        0xaaaaaaaaaaaaaaaaULL, 0xccccccccccccccccULL, 0xf0f0f0f0f0f0f0f0ULL,
+        0xff00ff00ff00ff00ULL, 0xffff0000ffff0000ULL, 0xffffffff00000000ULL
+    };
+    const bitmask_word *word = NULL;
+    wg_uint64 sum_x = 0;
+    wg_uint64 sum_y = 0;
+    wg_uint64 pix_num = 0;
+    wg_uint words = 0;
+    wg_uint row = 0;
+    wg_uint n = 0;
+    wg_uint i = 0;
+    wg_uint b = 0;
+
+    CHECK_FOR_NULL_PARAM(img);
+    CHECK_FOR_NULL_PARAM(y);
+    CHECK_FOR_NULL_PARAM(x);
+
+    if (img->type != IMG_BITMASK){
+        WG_ERROR("Invalig image format! Passed %d expect %d\n",
+                img->type, IMG_BITMASK);
+        return WG_FAILURE;
+    }
+
+    words = BITMASK_ROW_WORDS(img->width);
+
+    for (row = 0; row < img->height; ++row){
+        word = (const bitmask_word*)img->rows[row];
+        for (i = 0; i < words; ++i){
+            if (0 == word[i]){
+                continue;
+            }
+
+            n = __builtin_popcountll(word[i]);
+            pix_num += n;
+            sum_y   += (wg_uint64)row * n;
+            sum_x   += (wg_uint64)i * BITMASK_WORD_BITS * n;
+            for (b = 0; b < ELEMNUM(col_bit); ++b){
+                sum_x += (wg_uint64)__builtin_popcountll(word[i] & col_bit[b])
+                    << b;
+            }
+        }
+    }
+
+    if (pix_num != 0){
+        *x = sum_x / pix_num;
+        *y = sum_y / pix_num;
+    }else{
+        *x = 0;
+        *y = 0;
+    }
+
+    if (NULL != num){
+        *num = pix_num;
+    }
+
+    return WG_SUCCESS;
+}
+
+/*! @} */
+
+WG_PRIVATE wg_status
+check_bitmask(const Wg_image *img, const Wg_image *new_img,
+        wg_uint width, wg_uint height)
+{
+    CHECK_FOR_NULL_PARAM(img);
+    CHECK_FOR_NULL_PARAM(new_img);
+
+    if (img->type != IMG_BITMASK){
+        WG_ERROR("Invalig image format! Passed %d expect %d\n",
+                img->type, IMG_BITMASK);
+        return WG_FAILURE;
+    }
+
+    if (img_check_geometry(new_img, width, height, BITMASK_COMPONENT_NUM)
+            != WG_SUCCESS){
+        return WG_FAILURE;
+    }
+
+    ((Wg_image*)new_img)->type = IMG_BITMASK;
+
+    return WG_SUCCESS;
+}
+
+/**
+* @brief Pixels whose left and right neighbours in the row are set too
+*/
+WG_PRIVATE bitmask_word
+row_and3(const bitmask_word *row, wg_uint i, wg_uint words)
+{
+    bitmask_word left  = row[i] << 1;
+    bitmask_word right = row[i] >> 1;
+
+    if (i > 0){
+        left |= row[i - 1] >> (BITMASK_WORD_BITS - 1);
+    }
+    if (i + 1 < words){
+        right |= row[i + 1] << (BITMASK_WORD_BITS - 1);
+    }
+
+    return row[i] & left & right;
+}
+
+/**
+* @brief Pixels with a set pixel next to them in the row
+*/
+WG_PRIVATE bitmask_word
+row_or3(const bitmask_word *row, wg_uint i, wg_uint words)
+{
+    bitmask_word left  = row[i] << 1;
+    bitmask_word right = row[i] >> 1;
+
+    if (i > 0){
+        left |= row[i - 1] >> (BITMASK_WORD_BITS - 1);
+    }
+    if (i + 1 < words){
+        right |= row[i + 1] << (BITMASK_WORD_BITS - 1);
+    }
+
+    return row[i] | left | right;
+}
@@ -305,3 +305,59 @@ img_gs_sub(Wg_image *img_1, Wg_image *img_2)
     return WG_SUCCESS;
 }
 
+
+/** 
+* @brief Use 3x3 median filter on the grayscale image.
+* 
+* @param[in]  img       source image instance
+* @param[out] new_img   memory for filtered image instance
+* 
+* @retval WG_SUCCESS
+* @retval WG_FAILURE
+*/
+wg_status
+img_gs_median_filter(Wg_image *img, Wg_image *new_img)
+{
+    wg_status status = WG_FAILURE;
+
+    CHECK_FOR_NULL_PARAM(img);
+    CHECK_FOR_NULL_PARAM(new_img);
+
+    status = img_fill(img->width - 2, img->height - 2, 
+            GS_COMPONENT_NUM, IMG_GS, new_img);
+    if (WG_SUCCESS != status){
+        return WG_FAILURE;
+    }
+
+    status = img_gs_median_filter_noalloc(img, new_img);
+    if (WG_SUCCESS != status){
+        img_cleanup(new_img);
+    }
+
+    return status;
+}
+
+/** 
+* @brief Use 3x3 median filter on the grayscale image without allocating 
+*        memory
+* 
+* @param[in]  img       source image instance
+* @param[out] new_img   image smaller by 2 pixels in each dimension
+* 
+* @retval WG_SUCCESS
+* @retval WG_FAILURE
+*/
+wg_status
+img_gs_median_filter_noalloc(Wg_image *img, Wg_image *new_img)
+{
+    CHECK_FOR_NULL_PARAM(img);
+    CHECK_FOR_NULL_PARAM(new_img);
+
+    if (img->type != IMG_GS){
+        WG_ERROR("Invalig image format! Passed %d expect %d\n", 
+                img->type, IMG_GS);
+        return WG_FAILURE;
+    }
+
+    return img_median_filter_noalloc(img, new_img);
+}
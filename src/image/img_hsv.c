@@ -10,7 +10,6 @@
 #include <wg.h>
 #include <wgmacros.h>
 
-#include <wg_sort.h>
 
 #include <img.h>
 
@@ -28,11 +27,90 @@
 
 WG_PRIVATE float atan2_fast(float y, float x);
 
+/** 
+* @brief Color range used by the fused mask kernels
+*/
+typedef struct Hsv_range{
+    const Hsv *top;              /*!< range top                         */
+    const Hsv *bottom;           /*!< range bottom                      */
+    wg_double unit[256];         /*!< component value scaled to [0, 1]  */
+    wg_boolean val_in[256];      /*!< value of max component in range   */
+}Hsv_range;
+
+WG_PRIVATE void
+hsv_range_init(Hsv_range *range, const Hsv *top, const Hsv *bottom);
+
 /*! @defgroup image_hsv HSV manipulation
  * @ingroup image
  * @{ 
  */
 
+/** 
+* @brief Check if RGB color is in HSV range
+*
+* Follows gtk_rgb_to_hsv() step by step so the result is the same as 
+* filtering an image converted by img_rgb_2_hsv_gtk(). Hue is calculated
+* only for pixels which passed value and saturation tests.
+* 
+* @param range  color range
+* @param r      red component
+* @param g      green component
+* @param b      blue component
+* 
+* @return 255 if color is in range, 0 otherwise
+*/
+WG_INLINE gray_pixel
+hsv_range_test(const Hsv_range *range, wg_uint r, wg_uint g, wg_uint b)
+{
+    wg_uint max = 0;
+    wg_uint min = 0;
+    wg_double red = 0.0;
+    wg_double green = 0.0;
+    wg_double blue = 0.0;
+    wg_double sat = 0.0;
+    wg_double hue = 0.0;
+    wg_double delta = 0.0;
+
+    if (range->val_in[max = MAX3(r, g, b)] == WG_FALSE){
+        return 0;
+    }
+
+    min = MIN3(r, g, b);
+
+    if (max != 0){
+        sat = (range->unit[max] - range->unit[min]) / range->unit[max];
+    }
+
+    if ((sat < range->bottom->sat) || (sat >= range->top->sat)){
+        return 0;
+    }
+
+    if (sat != 0.0){
+        red   = range->unit[r];
+        green = range->unit[g];
+        blue  = range->unit[b];
+
+        delta = range->unit[max] - range->unit[min];
+        if (r == max){
+            hue = (green - blue) / delta;
+        }else if (g == max){
+            hue = 2 + (blue - red) / delta;
+        }else{
+            hue = 4 + (red - green) / delta;
+        }
+
+        hue /= 6.0;
+
+        if (hue < 0.0){
+            hue += 1.0;
+        }else if (hue > 1.0){
+            hue -= 1.0;
+        }
+    }
+
+    return ((hue >= range->bottom->hue) && (hue < range->top->hue)) ? 255 : 0;
+}
+
 
 /** 
 * @brief Get histogram
@@ -177,8 +255,13 @@ img_hsv_normalize(Wg_image *img)
 }
 
 /** 
-* @brief Use median filter on the image
+* @brief Use 3x3 median filter on the image
+* 
+* Hue is filtered, saturation and value are copied from the center pixel.
+* Hue is quantized to 256 levels.
 * 
+* @see img_hue_median_filter()
+*
 * @param img      source image
 * @param new_img  memory for filtered image instance
 * 
@@ -188,59 +271,7 @@ img_hsv_normalize(Wg_image *img)
 wg_status
 img_hsv_median_filter(Wg_image *img, Wg_image *new_img)
 {
-    Hsv *hsv_pixel = NULL;
-    Hsv *hsv_new_pixel = NULL;
-    wg_uint width = 0;
-    wg_uint height = 0;
-    wg_uint row = 0;
-    wg_uint col = 0;
-    wg_int rd = 0;
-    wg_int rd2 = 0;
-    wg_double data[9];
-
-    CHECK_FOR_NULL_PARAM(img);
-
-    if (img->type != IMG_HSV){
-        WG_ERROR("Invalig image format! Passed %d expect %d\n", 
-                img->type, IMG_HSV);
-        return WG_FAILURE;
-    }
-
-    img_get_width(img, &width);
-    img_get_height(img, &height);
-
-    width  -= 2;
-    height -= 2;
-
-    img_fill(width, height, img->components_per_pixel, img->type, new_img);
-
-    rd = img->width;
-    rd2 = rd + rd;
-
-    for (row = 0; row < height; ++row){
-        img_get_row(img, row, (wg_uchar**)&hsv_pixel);
-        img_get_row(new_img, row, (wg_uchar**)&hsv_new_pixel);
-        for (col = 0; col < width; ++col, ++hsv_pixel, ++hsv_new_pixel){
-                 data[0] = hsv_pixel[0].hue;
-                 data[1] = hsv_pixel[1].hue;
-                 data[2] = hsv_pixel[2].hue;
-                 /* 2nd row */
-                 data[3] = hsv_pixel[rd + 0].hue;
-                 data[4] = hsv_pixel[rd + 1].hue;
-                 data[5] = hsv_pixel[rd + 2].hue;
-                 /* 3rd row */
-                 data[6] = hsv_pixel[rd2 + 0].hue;
-                 data[7] = hsv_pixel[rd2 + 1].hue;
-                 data[8] = hsv_pixel[rd2 + 2].hue;
-
-                 wg_sort_double(data, 9);
-
-                 hsv_new_pixel->hue = data[4];
-        }
-    }
-
-    return WG_SUCCESS;
-
+    return img_hue_median_filter(img, new_img, 1, 1);
 }
 
 /**
@@ -358,6 +389,37 @@ img_rgb_2_hsv(Wg_image *rgb_img, Wg_image *hsv_img)
  */
 wg_status
 img_rgb_2_hsv_gtk(Wg_image *rgb_img, Wg_image *hsv_img)
+{
+    wg_status status = WG_FAILURE;
+
+    CHECK_FOR_NULL_PARAM(rgb_img);
+    CHECK_FOR_NULL_PARAM(hsv_img);
+
+    status = img_fill(rgb_img->width, rgb_img->height, sizeof (Hsv), IMG_HSV,
+            hsv_img);
+    if (WG_SUCCESS != status){
+        return status;
+    }
+
+    status = img_rgb_2_hsv_gtk_noalloc(rgb_img, hsv_img);
+    if (WG_SUCCESS != status){
+        img_cleanup(hsv_img);
+    }
+
+    return status;
+}
+
+/**
+ * @brief Convert RGB24 to HSV without allocating memory
+ *
+ * @param rgb_img   RGB24 image
+ * @param hsv_img   HSV image of the same size as rgb_img
+ *
+ * @retval WG_SUCCESS
+ * @retval WG_FAILURE
+ */
+wg_status
+img_rgb_2_hsv_gtk_noalloc(Wg_image *rgb_img, Wg_image *hsv_img)
 {
     wg_status status = WG_FAILURE;
     register rgb24_pixel  *rgb_pixel = NULL;
@@ -383,11 +445,13 @@ img_rgb_2_hsv_gtk(Wg_image *rgb_img, Wg_image *hsv_img)
     img_get_width(rgb_img, &width);
     img_get_height(rgb_img, &height);
 
-    status = img_fill(width, height, sizeof (Hsv), IMG_HSV, hsv_img);
+    status = img_check_geometry(hsv_img, width, height, sizeof (Hsv));
     if (WG_SUCCESS != status){
         return status;
     }
 
+    hsv_img->type = IMG_HSV;
+
     for (row = 0; row < height; ++row){
         img_get_row(rgb_img, row, &tmp_ptr);
         rgb_pixel = (rgb24_pixel*)tmp_ptr;
@@ -425,6 +489,39 @@ img_rgb_2_hsv_gtk(Wg_image *rgb_img, Wg_image *hsv_img)
 */
 wg_status
 img_hsv_filter(const Wg_image *img, Wg_image *filtered_img, va_list args)
+{
+    wg_status status = WG_FAILURE;
+
+    CHECK_FOR_NULL_PARAM(img);
+    CHECK_FOR_NULL_PARAM(filtered_img);
+
+    status = img_fill(img->width, img->height, GS_COMPONENT_NUM, IMG_GS, 
+            filtered_img);
+    if (WG_SUCCESS != status){
+        return status;
+    }
+
+    status = img_hsv_filter_noalloc(img, filtered_img, args);
+    if (WG_SUCCESS != status){
+        img_cleanup(filtered_img);
+    }
+
+    return status;
+}
+
+/** 
+* @brief Filter image into a preallocated bw image
+* 
+* @param img  Image to filter
+* @param filtered_img Grayscale image of the same size as img
+* @param args  arguments (const Hsv* top , const Hsv* bottom)
+* 
+* @retval WG_SUCCESS
+* @retval WG_FAILURE
+*/
+wg_status
+img_hsv_filter_noalloc(const Wg_image *img, Wg_image *filtered_img, 
+        va_list args)
 {
     register Hsv *hsv_pixel = NULL;
     wg_uchar *tmp_ptr = NULL;
@@ -452,11 +549,13 @@ img_hsv_filter(const Wg_image *img, Wg_image *filtered_img, va_list args)
     img_get_width(img, &width);
     img_get_height(img, &height);
 
-    status = img_fill(width, height, GS_COMPONENT_NUM, IMG_GS, filtered_img);
+    status = img_check_geometry(filtered_img, width, height, GS_COMPONENT_NUM);
     if (WG_SUCCESS != status){
         return status;
     }
 
+    filtered_img->type = IMG_GS;
+
     for (row = 0; row < height; ++row){
         img_get_row(img, row, &tmp_ptr);
         hsv_pixel = (Hsv*)tmp_ptr;
@@ -648,6 +747,233 @@ img_bgrx_2_hsv_fast(Wg_image *bgrx_img, Wg_image *hsv_img)
     return WG_SUCCESS;
 }
 
+/** 
+* @brief Build a mask of pixels which color is in HSV range
+*
+* Works like img_rgb_2_hsv_gtk() followed by img_hsv_filter() but HSV 
+* image is never created. Accepted formats are IMG_RGB, IMG_BGRX and 
+* IMG_YUYV.
+* 
+* @param img     source image
+* @param mask    memory to store grayscale mask
+* @param top     range top
+* @param bottom  range bottom
+* 
+* @retval WG_SUCCESS
+* @retval WG_FAILURE
+*/
+wg_status
+img_hsv_range_mask(const Wg_image *img, Wg_image *mask, 
+        const Hsv *top, const Hsv *bottom)
+{
+    wg_status status = WG_FAILURE;
+
+    CHECK_FOR_NULL_PARAM(img);
+    CHECK_FOR_NULL_PARAM(mask);
+
+    status = img_fill(img->width, img->height, GS_COMPONENT_NUM, IMG_GS, 
+            mask);
+    if (WG_SUCCESS != status){
+        return status;
+    }
+
+    status = img_hsv_range_mask_noalloc(img, mask, top, bottom);
+    if (WG_SUCCESS != status){
+        img_cleanup(mask);
+    }
+
+    return status;
+}
+
+/** 
+* @brief Build a mask of pixels which color is in HSV range into 
+*        a preallocated image
+* 
+* @param img     source image
+* @param mask    grayscale image of the same size as img
+* @param top     range top
+* @param bottom  range bottom
+* 
+* @retval WG_SUCCESS
+* @retval WG_FAILURE
+*/
+wg_status
+img_hsv_range_mask_noalloc(const Wg_image *img, Wg_image *mask, 
+        const Hsv *top, const Hsv *bottom)
+{
+    Hsv_range range;
+    gray_pixel *gs_pixel = NULL;
+    wg_uchar *pixel = NULL;
+    bgrx_pixel *bgrx_pix = NULL;
+    rgb24_pixel rgb;
+    wg_uint row = 0;
+    wg_uint col = 0;
+    wg_uint width = 0;
+    wg_uint height = 0;
+    wg_status status = WG_FAILURE;
+
+    CHECK_FOR_NULL_PARAM(img);
+    CHECK_FOR_NULL_PARAM(mask);
+    CHECK_FOR_NULL_PARAM(top);
+    CHECK_FOR_NULL_PARAM(bottom);
+
+    img_get_width(img, &width);
+    img_get_height(img, &height);
+
+    status = img_check_geometry(mask, width, height, GS_COMPONENT_NUM);
+    if (WG_SUCCESS != status){
+        return status;
+    }
+
+    mask->type = IMG_GS;
+
+    hsv_range_init(&range, top, bottom);
+
+    switch (img->type){
+    case IMG_RGB:
+        for (row = 0; row < height; ++row){
+            img_get_row(img, row, &pixel);
+            img_get_row(mask, row, (wg_uchar**)&gs_pixel);
+            for (col = 0; col < width; ++col, ++gs_pixel){
+                *gs_pixel = hsv_range_test(&range, 
+                        pixel[RGB24_R], pixel[RGB24_G], pixel[RGB24_B]);
+                pixel += RGB24_COMPONENT_NUM;
+            }
+        }
+        break;
+    case IMG_BGRX:
+        for (row = 0; row < height; ++row){
+            img_get_row(img, row, (wg_uchar**)&bgrx_pix);
+            img_get_row(mask, row, (wg_uchar**)&gs_pixel);
+            for (col = 0; col < width; ++col, ++gs_pixel, ++bgrx_pix){
+                *gs_pixel = hsv_range_test(&range, BGRX_R(*bgrx_pix), 
+                        BGRX_G(*bgrx_pix), BGRX_B(*bgrx_pix));
+            }
+        }
+        break;
+    case IMG_YUYV:
+        for (row = 0; row < height; ++row){
+            img_get_row(img, row, &pixel);
+            img_get_row(mask, row, (wg_uchar**)&gs_pixel);
+            for (col = 0; col < width; ++col, ++gs_pixel){
+                /* two pixels share U and V */
+                yuyv_2_rgb(pixel[(col & 1) ? POS_Y1 : POS_Y0], 
+                        pixel[POS_U], pixel[POS_V], rgb);
+                *gs_pixel = hsv_range_test(&range, 
+                        rgb[RGB24_R], rgb[RGB24_G], rgb[RGB24_B]);
+                if (col & 1){
+                    pixel += YUYV_COMPONENT_NUM;
+                }
+            }
+        }
+        break;
+    default:
+        WG_ERROR("Invalig image format! Passed %d\n", img->type);
+        return WG_FAILURE;
+    }
+
+    return WG_SUCCESS;
+}
+
+/** 
+* @brief Build YCbCr classification table of HSV range
+*
+* Entry IMG_YCBCR_LUT_INDEX(y, cb, cr) is 255 when the center of the 
+* quantization cell is in range. Table is used by img_ycbcr_lut_mask().
+* 
+* @param top     range top
+* @param bottom  range bottom
+* @param lut     memory to store IMG_YCBCR_LUT_SIZE entries
+* 
+* @retval WG_SUCCESS
+* @retval WG_FAILURE
+*/
+wg_status
+img_hsv_range_ycbcr_lut(const Hsv *top, const Hsv *bottom, gray_pixel *lut)
+{
+    Hsv_range range;
+    rgb24_pixel rgb;
+    wg_uint y = 0;
+    wg_uint cb = 0;
+    wg_uint cr = 0;
+
+    CHECK_FOR_NULL_PARAM(top);
+    CHECK_FOR_NULL_PARAM(bottom);
+    CHECK_FOR_NULL_PARAM(lut);
+
+    hsv_range_init(&range, top, bottom);
+
+    for (y = 8; y < 256; y += 16){
+        for (cb = 2; cb < 256; cb += 4){
+            for (cr = 2; cr < 256; cr += 4){
+                ycbcr_2_rgb(y, cb, cr, rgb);
+                lut[IMG_YCBCR_LUT_INDEX(y, cb, cr)] = hsv_range_test(&range,
+                        rgb[RGB24_R], rgb[RGB24_G], rgb[RGB24_B]);
+            }
+        }
+    }
+
+    return WG_SUCCESS;
+}
+
+/** 
+* @brief Build RGB565 classification table of HSV range
+*
+* Entry BGRX_2_RGB565(pixel) is 255 when the center of the quantization 
+* cell is in range. Table is used by img_bgrx_lut_mask_noalloc().
+* 
+* @param top     range top
+* @param bottom  range bottom
+* @param lut     memory to store IMG_RGB565_LUT_SIZE entries
+* 
+* @retval WG_SUCCESS
+* @retval WG_FAILURE
+*/
+wg_status
+img_hsv_range_rgb565_lut(const Hsv *top, const Hsv *bottom, gray_pixel *lut)
+{
+    Hsv_range range;
+    wg_uint r = 0;
+    wg_uint g = 0;
+    wg_uint b = 0;
+
+    CHECK_FOR_NULL_PARAM(top);
+    CHECK_FOR_NULL_PARAM(bottom);
+    CHECK_FOR_NULL_PARAM(lut);
+
+    hsv_range_init(&range, top, bottom);
+
+    for (r = 4; r < 256; r += 8){
+        for (g = 2; g < 256; g += 4){
+            for (b = 4; b < 256; b += 8){
+                lut[BGRX_2_RGB565(RGB_2_BGRX(r, g, b))] = 
+                    hsv_range_test(&range, r, g, b);
+            }
+        }
+    }
+
+    return WG_SUCCESS;
+}
+
+WG_PRIVATE void
+hsv_range_init(Hsv_range *range, const Hsv *top, const Hsv *bottom)
+{
+    wg_double val = 0.0;
+    wg_uint i = 0;
+
+    range->top    = top;
+    range->bottom = bottom;
+
+    /* use the same scaling as img_rgb_2_hsv_gtk() */
+    for (i = 0; i < ELEMNUM(range->unit); ++i){
+        val = i / 255.0;
+        range->unit[i]   = val;
+        range->val_in[i] = (val >= bottom->val) && (val < top->val);
+    }
+
+    return;
+}
+
 WG_PRIVATE wg_float 
 atan2_fast(wg_float y, wg_float x)
 {
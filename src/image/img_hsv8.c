@@ -0,0 +1,560 @@
+#include <stdio.h>
+#include <sys/types.h>
+#include <string.h>
+#include <math.h>
+#include <stdarg.h>
+
+#include <wgtypes.h>
+#include <wg.h>
+#include <wgmacros.h>
+
+
+#include <img.h>
+
+#define MAX3(r, g, b) WG_MAX(b , WG_MAX(r, g))
+#define MIN3(r, g, b) WG_MIN(b , WG_MIN(r, g))
+
+/** @brief Scale of a packed component */
+#define HSV8_MAX  255
+
+/**
+* @brief Color range scaled to packed components
+*/
+typedef struct Hsv8_range{
+    wg_uint hue[2];     /*!< hue bottom, top          */
+    wg_uint sat[2];     /*!< saturation bottom, top   */
+    wg_uint val[2];     /*!< value bottom, top        */
+}Hsv8_range;
+
+WG_PRIVATE wg_status
+fill_hsv8(Wg_image *img, Wg_image *hsv_img, img_type type);
+
+WG_PRIVATE wg_status
+convert_2_hsv8(Wg_image *img, Wg_image *hsv_img, img_type type);
+
+WG_PRIVATE wg_uint
+scale_bound(wg_double value);
+
+/*! @defgroup image_hsv8 Packed HSV manipulation
+ * @ingroup image
+ * @{
+ */
+
+/**
+* @brief Convert RGB color to packed HSV
+*
+* Integer version of gtk_rgb_to_hsv(). Components are rounded to the
+* nearest packed value.
+*
+* @param r      red component
+* @param g      green component
+* @param b      blue component
+* @param pixel  memory to store HSV pixel
+*/
+WG_INLINE void
+rgb_2_hsv8(wg_int r, wg_int g, wg_int b, Hsv8 *pixel)
+{
+    wg_int max = MAX3(r, g, b);
+    wg_int min = MIN3(r, g, b);
+    wg_int delta = max - min;
+    wg_int hue = 0;
+
+    pixel->val = max;
+    pixel->pad = 0;
+
+    if (delta == 0){
+        pixel->sat = 0;
+        pixel->hue = 0;
+        return;
+    }
+
+    pixel->sat = (HSV8_MAX * delta + (max >> 1)) / max;
+
+    /* hue in units of delta, full circle is 6 * delta */
+    if (r == max){
+        hue = g - b;
+    }else if (g == max){
+        hue = (delta << 1) + b - r;
+    }else{
+        hue = (delta << 2) + r - g;
+    }
+
+    if (hue < 0){
+        hue += 6 * delta;
+    }
+
+    pixel->hue = (HSV8_MAX * hue + 3 * delta) / (6 * delta);
+
+    return;
+}
+
+/**
+ * @brief Convert RGB24 to packed HSV
+ *
+ * @param rgb_img    RGB24 image
+ * @param hsv_img    memory to store HSV image
+ *
+ * @retval WG_SUCCESS
+ * @retval WG_FAILURE
+ */
+wg_status
+img_rgb_2_hsv8(Wg_image *rgb_img, Wg_image *hsv_img)
+{
+    return fill_hsv8(rgb_img, hsv_img, IMG_RGB);
+}
+
+/**
+ * @brief Convert RGB24 to packed HSV without allocating memory
+ *
+ * @param rgb_img    RGB24 image
+ * @param hsv_img    HSV8 image of the same size as rgb_img
+ *
+ * @retval WG_SUCCESS
+ * @retval WG_FAILURE
+ */
+wg_status
+img_rgb_2_hsv8_noalloc(Wg_image *rgb_img, Wg_image *hsv_img)
+{
+    return convert_2_hsv8(rgb_img, hsv_img, IMG_RGB);
+}
+
+/**
+ * @brief Convert BGRX to packed HSV
+ *
+ * @param bgrx_img   BGRX image
+ * @param hsv_img    memory to store HSV image
+ *
+ * @retval WG_SUCCESS
+ * @retval WG_FAILURE
+ */
+wg_status
+img_bgrx_2_hsv8(Wg_image *bgrx_img, Wg_image *hsv_img)
+{
+    return fill_hsv8(bgrx_img, hsv_img, IMG_BGRX);
+}
+
+/**
+ * @brief Convert BGRX to packed HSV without allocating memory
+ *
+ * @param bgrx_img   BGRX image
+ * @param hsv_img    HSV8 image of the same size as bgrx_img
+ *
+ * @retval WG_SUCCESS
+ * @retval WG_FAILURE
+ */
+wg_status
+img_bgrx_2_hsv8_noalloc(Wg_image *bgrx_img, Wg_image *hsv_img)
+{
+    return convert_2_hsv8(bgrx_img, hsv_img, IMG_BGRX);
+}
+
+/**
+ * @brief Convert YUYV to packed HSV
+ *
+ * @param yuyv_img   YUYV image
+ * @param hsv_img    memory to store HSV image
+ *
+ * @retval WG_SUCCESS
+ * @retval WG_FAILURE
+ */
+wg_status
+img_yuyv_2_hsv8(Wg_image *yuyv_img, Wg_image *hsv_img)
+{
+    return fill_hsv8(yuyv_img, hsv_img, IMG_YUYV);
+}
+
+/**
+ * @brief Convert YUYV to packed HSV without allocating memory
+ *
+ * @param yuyv_img   YUYV image
+ * @param hsv_img    HSV8 image of the same size as yuyv_img
+ *
+ * @retval WG_SUCCESS
+ * @retval WG_FAILURE
+ */
+wg_status
+img_yuyv_2_hsv8_noalloc(Wg_image *yuyv_img, Wg_image *hsv_img)
+{
+    return convert_2_hsv8(yuyv_img, hsv_img, IMG_YUYV);
+}
+
+/**
+* @brief Filter image and return bw image
+*
+* Range is passed as for img_hsv_filter() and scaled to packed values.
+*
+* @param img  Image to filter
+* @param filtered_img Grayscale output image
+* @param args  arguments (const Hsv* top , const Hsv* bottom)
+*
+* @retval WG_SUCCESS
+* @retval WG_FAILURE
+*/
+wg_status
+img_hsv8_filter(const Wg_image *img, Wg_image *filtered_img, va_list args)
+{
+    wg_status status = WG_FAILURE;
+
+    CHECK_FOR_NULL_PARAM(img);
+    CHECK_FOR_NULL_PARAM(filtered_img);
+
+    status = img_fill(img->width, img->height, GS_COMPONENT_NUM, IMG_GS,
+            filtered_img);
+    if (WG_SUCCESS != status){
+        return status;
+    }
+
+    status = img_hsv8_filter_noalloc(img, filtered_img, args);
+    if (WG_SUCCESS != status){
+        img_cleanup(filtered_img);
+    }
+
+    return status;
+}
+
+/**
+* @brief Filter image into a preallocated bw image
+*
+* @param img  Image to filter
+* @param filtered_img Grayscale image of the same size as img
+* @param args  arguments (const Hsv* top , const Hsv* bottom)
+*
+* @retval WG_SUCCESS
+* @retval WG_FAILURE
+*/
+wg_status
+img_hsv8_filter_noalloc(const Wg_image *img, Wg_image *filtered_img,
+        va_list args)
+{
+    Hsv8 *hsv_pixel = NULL;
+    gray_pixel *gs_pixel = NULL;
+    wg_uint row = 0;
+    wg_uint col = 0;
+    wg_uint width = 0;
+    wg_uint height = 0;
+    wg_status status = WG_FAILURE;
+    const Hsv *bottom = NULL;
+    const Hsv *top = NULL;
+    Hsv8_range range;
+
+    CHECK_FOR_NULL_PARAM(img);
+    CHECK_FOR_NULL_PARAM(filtered_img);
+
+    if (img->type != IMG_HSV8){
+        WG_ERROR("Invalig image format! Passed %d expect %d\n",
+                img->type, IMG_HSV8);
+        return WG_FAILURE;
+    }
+
+    top = va_arg(args, const Hsv*);
+    bottom = va_arg(args, const Hsv*);
+
+    img_get_width(img, &width);
+    img_get_height(img, &height);
+
+    status = img_check_geometry(filtered_img, width, height, GS_COMPONENT_NUM);
+    if (WG_SUCCESS != status){
+        return status;
+    }
+
+    filtered_img->type = IMG_GS;
+
+    range.hue[0] = scale_bound(bottom->hue);
+    range.hue[1] = scale_bound(top->hue);
+    range.sat[0] = scale_bound(bottom->sat);
+    range.sat[1] = scale_bound(top->sat);
+    range.val[0] = scale_bound(bottom->val);
+    range.val[1] = scale_bound(top->val);
+
+    for (row = 0; row < height; ++row){
+        img_get_row(img, row, (wg_uchar**)&hsv_pixel);
+        img_get_row(filtered_img, row, (wg_uchar**)&gs_pixel);
+        for (col = 0; col < width; ++col, ++hsv_pixel, ++gs_pixel){
+            *gs_pixel =  (
+                    (hsv_pixel->sat >= range.sat[0]) &&
+                    (hsv_pixel->sat < range.sat[1])  &&
+                    (hsv_pixel->val >= range.val[0]) &&
+                    (hsv_pixel->val < range.val[1])  &&
+                    (hsv_pixel->hue >= range.hue[0]) &&
+                    (hsv_pixel->hue < range.hue[1])) ? 255 : 0;
+        }
+    }
+
+    return WG_SUCCESS;
+}
+
+/**
+* @brief Get histogram
+*
+* Each histogram has HSV8_HIST_NUM bins.
+*
+* @param img image instance
+* @param[out] h   memory for hue values
+* @param[out] s   memory for saturation
+* @param[out] v   memorry for value
+* @param[out] hs  number of elements in h array
+* @param[out] ss  number of elements in s array
+* @param[out] vs  number of elements in v array
+*
+* @retval WG_SUCCESS
+* @retval WG_FAILURE
+*/
+wg_status
+img_hsv8_hist(Wg_image *img, wg_uint **h, wg_uint **s, wg_uint **v,
+                  wg_size *hs, wg_size *ss, wg_size *vs)
+{
+    Hsv8 *pixel   = NULL;
+    wg_uint *hue = NULL;
+    wg_uint *val = NULL;
+    wg_uint *sat = NULL;
+    wg_uint width  = 0;
+    wg_uint height = 0;
+    wg_uint row    = 0;
+    wg_uint col    = 0;
+
+    CHECK_FOR_NULL_PARAM(img);
+    CHECK_FOR_NULL_PARAM(hs);
+    CHECK_FOR_NULL_PARAM(ss);
+    CHECK_FOR_NULL_PARAM(vs);
+
+    if (img->type != IMG_HSV8){
+        WG_ERROR("Invalig image format! Passed %d expect %d\n",
+                img->type, IMG_HSV8);
+        return WG_FAILURE;
+    }
+
+    sat = WG_CALLOC(HSV8_HIST_NUM, sizeof (*sat));
+    hue = WG_CALLOC(HSV8_HIST_NUM, sizeof (*hue));
+    val = WG_CALLOC(HSV8_HIST_NUM, sizeof (*val));
+
+    if ((sat == NULL) || (hue == NULL) || (val == NULL)){
+        WG_FREE(sat);
+        WG_FREE(val);
+        WG_FREE(hue);
+
+        return WG_FAILURE;
+    }
+
+    img_get_width(img, &width);
+    img_get_height(img, &height);
+
+    for (row = 0; row < height; ++row){
+        img_get_row(img, row, (wg_uchar**)&pixel);
+        for (col = 0; col < width; ++col, ++pixel){
+            ++hue[pixel->hue];
+            ++sat[pixel->sat];
+            ++val[pixel->val];
+        }
+    }
+
+    if (NULL != v){
+        *v = val;
+        *vs = HSV8_HIST_NUM;
+    }else{
+        WG_FREE(val);
+    }
+
+    if (NULL != s){
+        *s = sat;
+        *ss = HSV8_HIST_NUM;
+    }else{
+        WG_FREE(sat);
+    }
+
+    if (NULL != h){
+        *h = hue;
+        *hs = HSV8_HIST_NUM;
+    }else{
+        WG_FREE(hue);
+    }
+
+    return WG_SUCCESS;
+}
+
+/**
+* @brief Normalize value
+*
+* Stretches value to the full [0, 255] range.
+*
+* @param img image to normalize
+*
+* @retval WG_SUCCESS
+* @retval WG_FAILURE
+*/
+wg_status
+img_hsv8_normalize(Wg_image *img)
+{
+    Hsv8 *hsv_pixel = NULL;
+    wg_uint width = 0;
+    wg_uint height = 0;
+    wg_uint row = 0;
+    wg_uint col = 0;
+    wg_uint val_max = 0;
+    wg_uint val_min = HSV8_MAX;
+    wg_uint val = 0;
+    wg_uint8 lut[HSV8_MAX + 1];
+
+    CHECK_FOR_NULL_PARAM(img);
+
+    if (img->type != IMG_HSV8){
+        WG_ERROR("Invalig image format! Passed %d expect %d\n",
+                img->type, IMG_HSV8);
+        return WG_FAILURE;
+    }
+
+    img_get_width(img, &width);
+    img_get_height(img, &height);
+
+    for (row = 0; row < height; ++row){
+        img_get_row(img, row, (wg_uchar**)&hsv_pixel);
+        for (col = 0; col < width; ++col, ++hsv_pixel){
+            val_max = WG_MAX(val_max, hsv_pixel->val);
+            val_min = WG_MIN(val_min, hsv_pixel->val);
+        }
+    }
+
+    /* nothing to stretch */
+    if (val_max <= val_min){
+        return WG_SUCCESS;
+    }
+
+    val = val_max - val_min;
+    for (col = val_min; col <= val_max; ++col){
+        lut[col] = (HSV8_MAX * (col - val_min) + (val >> 1)) / val;
+    }
+
+    for (row = 0; row < height; ++row){
+        img_get_row(img, row, (wg_uchar**)&hsv_pixel);
+        for (col = 0; col < width; ++col, ++hsv_pixel){
+            hsv_pixel->val = lut[hsv_pixel->val];
+        }
+    }
+
+    return WG_SUCCESS;
+}
+
+/** 
+* @brief Use 3x3 median filter on the image
+* 
+* Hue is filtered, saturation and value are copied from the center pixel.
+* 
+* @see img_hue_median_filter()
+*
+* @param img      source image
+* @param new_img  memory for filtered image instance
+* 
+* @retval WG_SUCCESS
+* @retval WG_FAILURE
+*/
+wg_status
+img_hsv8_median_filter(Wg_image *img, Wg_image *new_img)
+{
+    return img_hue_median_filter(img, new_img, 1, 1);
+}
+
+/*! @} */
+
+WG_PRIVATE wg_status
+fill_hsv8(Wg_image *img, Wg_image *hsv_img, img_type type)
+{
+    wg_status status = WG_FAILURE;
+
+    CHECK_FOR_NULL_PARAM(img);
+    CHECK_FOR_NULL_PARAM(hsv_img);
+
+    status = img_fill(img->width, img->height, HSV8_COMPONENT_NUM, IMG_HSV8,
+            hsv_img);
+    if (WG_SUCCESS != status){
+        return status;
+    }
+
+    status = convert_2_hsv8(img, hsv_img, type);
+    if (WG_SUCCESS != status){
+        img_cleanup(hsv_img);
+    }
+
+    return status;
+}
+
+WG_PRIVATE wg_status
+convert_2_hsv8(Wg_image *img, Wg_image *hsv_img, img_type type)
+{
+    Hsv8 *hsv_pixel = NULL;
+    wg_uchar *pixel = NULL;
+    bgrx_pixel *bgrx_pix = NULL;
+    rgb24_pixel rgb;
+    wg_uint width = 0;
+    wg_uint height = 0;
+    wg_uint row = 0;
+    wg_uint col = 0;
+    wg_status status = WG_FAILURE;
+
+    CHECK_FOR_NULL_PARAM(img);
+    CHECK_FOR_NULL_PARAM(hsv_img);
+
+    if (img->type != type){
+        WG_ERROR("Invalig image format! Passed %d expect %d\n",
+                img->type, type);
+        return WG_FAILURE;
+    }
+
+    img_get_width(img, &width);
+    img_get_height(img, &height);
+
+    status = img_check_geometry(hsv_img, width, height, HSV8_COMPONENT_NUM);
+    if (WG_SUCCESS != status){
+        return status;
+    }
+
+    hsv_img->type = IMG_HSV8;
+
+    for (row = 0; row < height; ++row){
+        img_get_row(hsv_img, row, (wg_uchar**)&hsv_pixel);
+        img_get_row(img, row, &pixel);
+        bgrx_pix = (bgrx_pixel*)pixel;
+
+        switch (type){
+        case IMG_RGB:
+            for (col = 0; col < width; ++col, ++hsv_pixel){
+                rgb_2_hsv8(pixel[RGB24_R], pixel[RGB24_G], pixel[RGB24_B],
+                        hsv_pixel);
+                pixel += RGB24_COMPONENT_NUM;
+            }
+            break;
+        case IMG_BGRX:
+            for (col = 0; col < width; ++col, ++hsv_pixel, ++bgrx_pix){
+                rgb_2_hsv8(BGRX_R(*bgrx_pix), BGRX_G(*bgrx_pix),
+                        BGRX_B(*bgrx_pix), hsv_pixel);
+            }
+            break;
+        case IMG_YUYV:
+            for (col = 0; col < width; ++col, ++hsv_pixel){
+                /* two pixels share U and V */
+                yuyv_2_rgb(pixel[(col & 1) ? POS_Y1 : POS_Y0],
+                        pixel[POS_U], pixel[POS_V], rgb);
+                rgb_2_hsv8(rgb[RGB24_R], rgb[RGB24_G], rgb[RGB24_B],
+                        hsv_pixel);
+                if (col & 1){
+                    pixel += YUYV_COMPONENT_NUM;
+                }
+            }
+            break;
+        default:
+            WG_ERROR("Invalig image format! Passed %d\n", type);
+            return WG_FAILURE;
+        }
+    }
+
+    return WG_SUCCESS;
+}
+
+/* smallest packed value which scaled back is not less than value */
+WG_PRIVATE wg_uint
+scale_bound(wg_double value)
+{
+    if (value <= 0.0){
+        return 0;
+    }
+
+    return (wg_uint)ceil(value * HSV8_MAX);
+}
@@ -0,0 +1,519 @@
+#include <stdio.h>
+#include <sys/types.h>
+#include <string.h>
+#include <pthread.h>
+
+#include <wgtypes.h>
+#include <wg.h>
+#include <wgmacros.h>
+
+#include <img.h>
+
+/*! @defgroup image_hue_median Histogram Hue Median Filter
+ * @ingroup image
+ */
+
+/*! @{ */
+
+/* 
+ * Perreault & Hebert constant time median. Every column keeps a histogram of
+ * the 2r+1 hue values around the current row. Moving down one row updates
+ * each column histogram with one removal and one addition. The window
+ * histogram is the sum of 2r+1 column histograms and moving right by one 
+ * pixel adds one column histogram and subtracts another. Cost per pixel 
+ * does not depend on the radius.
+ *
+ * Histograms are kept in two levels, 16 coarse bins of 16 fine bins, so the
+ * median search scans at most 32 bins and only the fine segment holding the
+ * median has to be brought up to date.
+ */
+
+/** @brief Number of fine bins */
+#define HUE_BINS         256
+
+/** @brief Number of coarse bins */
+#define HUE_COARSE       16
+
+/** @brief Fine bins per coarse bin, log2 */
+#define HUE_COARSE_SHIFT 4
+
+/** 
+* @brief Column histogram
+*/
+typedef struct Hue_hist{
+    wg_uint16 coarse[HUE_COARSE];  /*!< coarse bins          */
+    wg_uint16 fine[HUE_BINS];      /*!< fine bins            */
+}Hue_hist;
+
+/** 
+* @brief Work of one row band
+*/
+typedef struct Hue_band{
+    const Wg_image *img;    /*!< source image                          */
+    Wg_image *new_img;      /*!< filtered image                        */
+    const wg_uchar *hue;    /*!< quantized hue plane of the source     */
+    Hue_hist *column;       /*!< column histograms, one per source col */
+    wg_uint radius;         /*!< window radius                         */
+    wg_uint row_start;      /*!< first output row                      */
+    wg_uint row_end;        /*!< one past the last output row          */
+    pthread_t thread;       /*!< band worker                           */
+}Hue_band;
+
+WG_PRIVATE wg_status
+median_reserve(Img_hue_median *median, wg_uint width, wg_uint height,
+        wg_uint bands);
+
+WG_PRIVATE void
+quantize_hue(const Wg_image *img, wg_uchar *hue);
+
+WG_PRIVATE void*
+filter_band(void *data);
+
+WG_PRIVATE void
+store_pixel(const Wg_image *img, Wg_image *new_img, wg_uint row, wg_uint col,
+        wg_uint radius, wg_uint hue);
+
+WG_INLINE void
+hist_add(Hue_hist *hist, wg_uint hue)
+{
+    ++hist->coarse[hue >> HUE_COARSE_SHIFT];
+    ++hist->fine[hue];
+}
+
+WG_INLINE void
+hist_sub(Hue_hist *hist, wg_uint hue)
+{
+    --hist->coarse[hue >> HUE_COARSE_SHIFT];
+    --hist->fine[hue];
+}
+
+/** 
+* @brief Window of the current pixel
+*
+* Coarse bins are updated on every step. A fine segment is brought up to 
+* date only when the median falls into it, Perreault's lazy update.
+*/
+typedef struct Hue_window{
+    wg_uint16 coarse[HUE_COARSE];                    /*!< coarse bins      */
+    wg_uint16 fine[HUE_COARSE][HUE_BINS / HUE_COARSE];/*!< fine segments   */
+    wg_int    fine_col[HUE_COARSE]; /*!< first column of each fine segment */
+}Hue_window;
+
+/** 
+* @brief Bring fine segment of the window to the window at given column
+*
+* @param window    window
+* @param column    column histograms
+* @param seg       fine segment (coarse bin)
+* @param col       first column of the window
+* @param diameter  window diameter
+*/
+WG_INLINE void
+window_update_fine(Hue_window *restrict window, 
+        const Hue_hist *restrict column, wg_uint seg, wg_int col, 
+        wg_uint diameter)
+{
+    wg_uint16 *fine = window->fine[seg];
+    wg_uint first = seg << HUE_COARSE_SHIFT;
+    const wg_uint16 *add = NULL;
+    const wg_uint16 *sub = NULL;
+    wg_int c = 0;
+    wg_uint i = 0;
+
+    if ((window->fine_col[seg] < 0) || 
+        (col - window->fine_col[seg] >= (wg_int)diameter)){
+        /* too far behind, rebuild the segment */
+        memset(fine, '\0', sizeof (window->fine[0]));
+        for (c = col; c < col + (wg_int)diameter; ++c){
+            add = &column[c].fine[first];
+            for (i = 0; i < ELEMNUM(window->fine[0]); ++i){
+                fine[i] += add[i];
+            }
+        }
+    }else{
+        for (c = window->fine_col[seg]; c < col; ++c){
+            add = &column[c + diameter].fine[first];
+            sub = &column[c].fine[first];
+            for (i = 0; i < ELEMNUM(window->fine[0]); ++i){
+                fine[i] += add[i] - sub[i];
+            }
+        }
+    }
+
+    window->fine_col[seg] = col;
+
+    return;
+}
+
+/** 
+* @brief Find a bin holding a value of given rank
+*
+* @param window    window
+* @param column    column histograms
+* @param col       first column of the window
+* @param diameter  window diameter
+* @param rank      rank counted from 1
+*
+* @return bin
+*/
+WG_INLINE wg_uint
+window_rank(Hue_window *window, const Hue_hist *column, wg_int col,
+        wg_uint diameter, wg_uint rank)
+{
+    const wg_uint16 *fine = NULL;
+    wg_uint sum = 0;
+    wg_uint seg = 0;
+    wg_uint bin = 0;
+
+    for (seg = 0; sum + window->coarse[seg] < rank; ++seg){
+        sum += window->coarse[seg];
+    }
+
+    window_update_fine(window, column, seg, col, diameter);
+
+    fine = window->fine[seg];
+    for (bin = 0; sum + fine[bin] < rank; ++bin){
+        sum += fine[bin];
+    }
+
+    return (seg << HUE_COARSE_SHIFT) + bin;
+}
+
+/** 
+* @brief Histogram median filter of hue
+*
+* Hue is filtered in a (2 * radius + 1) square window, saturation and value 
+* are copied from the center pixel. Hue is quantized to 256 levels, which
+* is exact for IMG_HSV8. Output image is smaller by 2 * radius pixels in
+* each dimension.
+*
+* If bands is greater than 1 output rows are split into bands filtered by
+* separate threads.
+* 
+* @param[in]  img       IMG_HSV or IMG_HSV8 image
+* @param[out] new_img   memory for filtered image instance
+* @param[in]  radius    window radius, 1 .. IMG_HUE_MEDIAN_RADIUS_MAX
+* @param[in]  bands     number of row bands filtered in parallel
+* 
+* @retval WG_SUCCESS
+* @retval WG_FAILURE
+*/
+wg_status
+img_hue_median_filter(const Wg_image *img, Wg_image *new_img, 
+        wg_uint radius, wg_uint bands)
+{
+    Img_hue_median median;
+    wg_status status = WG_FAILURE;
+
+    CHECK_FOR_NULL_PARAM(img);
+    CHECK_FOR_NULL_PARAM(new_img);
+
+    if ((img->width <= (radius << 1)) || (img->height <= (radius << 1))){
+        WG_ERROR("Image %ux%u too small for radius %u\n", 
+                img->width, img->height, radius);
+        return WG_FAILURE;
+    }
+
+    status = img_fill(img->width - (radius << 1), img->height - (radius << 1),
+            img->components_per_pixel, img->type, new_img);
+    if (WG_SUCCESS != status){
+        return WG_FAILURE;
+    }
+
+    img_hue_median_init(&median);
+
+    status = img_hue_median_filter_noalloc(img, new_img, radius, bands, 
+            &median);
+    if (WG_SUCCESS != status){
+        img_cleanup(new_img);
+    }
+
+    img_hue_median_cleanup(&median);
+
+    return status;
+}
+
+/** 
+* @brief Initialize work memory of the hue median filter
+* 
+* @param median  work memory
+*/
+void
+img_hue_median_init(Img_hue_median *median)
+{
+    memset(median, '\0', sizeof (Img_hue_median));
+
+    return;
+}
+
+/** 
+* @brief Release work memory of the hue median filter
+* 
+* @param median  work memory
+*/
+void
+img_hue_median_cleanup(Img_hue_median *median)
+{
+    WG_FREE(median->hue);
+    WG_FREE(median->band);
+    WG_FREE(median->column);
+
+    memset(median, '\0', sizeof (Img_hue_median));
+
+    return;
+}
+
+/** 
+* @brief Histogram median filter of hue without allocating output image
+*
+* Work memory is taken from median and grows only when the image or the 
+* number of bands grows.
+*
+* @see img_hue_median_filter()
+* 
+* @param[in]  img       IMG_HSV or IMG_HSV8 image
+* @param[out] new_img   image smaller by 2 * radius pixels in each dimension
+* @param[in]  radius    window radius, 1 .. IMG_HUE_MEDIAN_RADIUS_MAX
+* @param[in]  bands     number of row bands filtered in parallel
+* @param[in]  median    work memory initialized by img_hue_median_init()
+* 
+* @retval WG_SUCCESS
+* @retval WG_FAILURE
+*/
+wg_status
+img_hue_median_filter_noalloc(const Wg_image *img, Wg_image *new_img, 
+        wg_uint radius, wg_uint bands, Img_hue_median *median)
+{
+    Hue_band *band = NULL;
+    wg_uchar *hue = NULL;
+    wg_uint width = 0;
+    wg_uint height = 0;
+    wg_uint rows = 0;
+    wg_uint i = 0;
+    wg_status status = WG_FAILURE;
+
+    CHECK_FOR_NULL_PARAM(img);
+    CHECK_FOR_NULL_PARAM(new_img);
+    CHECK_FOR_NULL_PARAM(median);
+
+    if ((img->type != IMG_HSV) && (img->type != IMG_HSV8)){
+        WG_ERROR("Invalig image format! Passed %d expect %d or %d\n", 
+                img->type, IMG_HSV, IMG_HSV8);
+        return WG_FAILURE;
+    }
+
+    if ((radius == 0) || (radius > IMG_HUE_MEDIAN_RADIUS_MAX) ||
+        (img->width <= (radius << 1)) || (img->height <= (radius << 1))){
+        WG_ERROR("Invalid radius %u\n", radius);
+        return WG_FAILURE;
+    }
+
+    width  = img->width - (radius << 1);
+    height = img->height - (radius << 1);
+
+    status = img_check_geometry(new_img, width, height, 
+            img->components_per_pixel);
+    if (WG_SUCCESS != status){
+        return WG_FAILURE;
+    }
+
+    new_img->type = img->type;
+
+    bands = WG_MAX(WG_MIN(bands, height), 1);
+
+    /* memory is reserved here, workers only compute */
+    if (median_reserve(median, img->width, img->height, bands) 
+            != WG_SUCCESS){
+        return WG_FAILURE;
+    }
+
+    hue  = median->hue;
+    band = median->band;
+
+    quantize_hue(img, hue);
+
+    for (i = 0; i < bands; ++i){
+        rows = (height + bands - 1 - i) / bands;
+
+        band[i].column    = median->column + i * img->width;
+        band[i].img       = img;
+        band[i].new_img   = new_img;
+        band[i].hue       = hue;
+        band[i].radius    = radius;
+        band[i].row_start = (i == 0) ? 0 : band[i - 1].row_end;
+        band[i].row_end   = band[i].row_start + rows;
+    }
+
+    /* first band runs in the calling thread */
+    for (i = 1; i < bands; ++i){
+        if (pthread_create(&band[i].thread, NULL, filter_band, &band[i]) 
+                != 0){
+            filter_band(&band[i]);
+            band[i].thread = pthread_self();
+        }
+    }
+
+    filter_band(&band[0]);
+
+    for (i = 1; i < bands; ++i){
+        if (!pthread_equal(band[i].thread, pthread_self())){
+            pthread_join(band[i].thread, NULL);
+        }
+    }
+
+    return WG_SUCCESS;
+}
+
+/** 
+* @brief Grow work memory to an image and number of bands
+*
+* Smaller buffers are replaced, their content is not kept.
+*/
+WG_PRIVATE wg_status
+median_reserve(Img_hue_median *median, wg_uint width, wg_uint height,
+        wg_uint bands)
+{
+    wg_size hue_size = (wg_size)width * height;
+    wg_size column_num = (wg_size)width * bands;
+
+    if (median->hue_size < hue_size){
+        WG_FREE(median->hue);
+        median->hue_size = 0;
+        median->hue = WG_MALLOC(hue_size);
+        if (NULL == median->hue){
+            return WG_FAILURE;
+        }
+        median->hue_size = hue_size;
+    }
+
+    if (median->band_capacity < bands){
+        WG_FREE(median->band);
+        median->band_capacity = 0;
+        median->band = WG_CALLOC(bands, sizeof (Hue_band));
+        if (NULL == median->band){
+            return WG_FAILURE;
+        }
+        median->band_capacity = bands;
+    }
+
+    if (median->column_capacity < column_num){
+        WG_FREE(median->column);
+        median->column_capacity = 0;
+        median->column = WG_MALLOC(column_num * sizeof (Hue_hist));
+        if (NULL == median->column){
+            return WG_FAILURE;
+        }
+        median->column_capacity = column_num;
+    }
+
+    return WG_SUCCESS;
+}
+
+WG_PRIVATE void
+quantize_hue(const Wg_image *img, wg_uchar *hue)
+{
+    Hsv  *hsv_pixel  = NULL;
+    Hsv8 *hsv8_pixel = NULL;
+    wg_uint row = 0;
+    wg_uint col = 0;
+    wg_double val = 0.0;
+
+    for (row = 0; row < img->height; ++row){
+        if (img->type == IMG_HSV8){
+            img_get_row(img, row, (wg_uchar**)&hsv8_pixel);
+            for (col = 0; col < img->width; ++col, ++hsv8_pixel){
+                *hue++ = hsv8_pixel->hue;
+            }
+        }else{
+            img_get_row(img, row, (wg_uchar**)&hsv_pixel);
+            for (col = 0; col < img->width; ++col, ++hsv_pixel){
+                val = hsv_pixel->hue * (HUE_BINS - 1) + 0.5;
+                *hue++ = (val < 0.0) ? 0 : 
+                    (val >= HUE_BINS - 1) ? HUE_BINS - 1 : (wg_uchar)val;
+            }
+        }
+    }
+
+    return;
+}
+
+WG_PRIVATE void*
+filter_band(void *data)
+{
+    Hue_band *band = data;
+    Hue_hist *column = band->column;
+    Hue_window window;
+    const wg_uchar *hue = band->hue;
+    wg_uint in_width = band->img->width;
+    wg_uint diameter = (band->radius << 1) + 1;
+    wg_uint rank = ((diameter * diameter) >> 1) + 1;
+    wg_uint width = in_width - diameter + 1;
+    wg_uint row = 0;
+    wg_uint col = 0;
+    wg_uint i = 0;
+    const wg_uchar *remove = NULL;
+    const wg_uchar *add = NULL;
+
+    /* column histograms of the first window */
+    memset(column, '\0', in_width * sizeof (Hue_hist));
+    for (row = band->row_start; row < band->row_start + diameter; ++row){
+        for (col = 0; col < in_width; ++col){
+            hist_add(&column[col], hue[row * in_width + col]);
+        }
+    }
+
+    for (row = band->row_start; row < band->row_end; ++row){
+        if (row > band->row_start){
+            remove = &hue[(row - 1) * in_width];
+            add    = &hue[(row + diameter - 1) * in_width];
+            for (col = 0; col < in_width; ++col){
+                hist_sub(&column[col], remove[col]);
+                hist_add(&column[col], add[col]);
+            }
+        }
+
+        memset(&window, '\0', sizeof (Hue_window));
+        memset(window.fine_col, 0xff, sizeof (window.fine_col));
+        for (col = 0; col < diameter; ++col){
+            for (i = 0; i < HUE_COARSE; ++i){
+                window.coarse[i] += column[col].coarse[i];
+            }
+        }
+
+        for (col = 0; col < width; ++col){
+            store_pixel(band->img, band->new_img, row, col, band->radius,
+                    window_rank(&window, column, col, diameter, rank));
+
+            if (col + 1 < width){
+                for (i = 0; i < HUE_COARSE; ++i){
+                    window.coarse[i] += column[col + diameter].coarse[i] - 
+                        column[col].coarse[i];
+                }
+            }
+        }
+    }
+
+    return NULL;
+}
+
+WG_PRIVATE void
+store_pixel(const Wg_image *img, Wg_image *new_img, wg_uint row, wg_uint col,
+        wg_uint radius, wg_uint hue)
+{
+    Hsv  *hsv_pixel  = NULL;
+    Hsv8 *hsv8_pixel = NULL;
+
+    if (img->type == IMG_HSV8){
+        hsv8_pixel  = (Hsv8*)new_img->rows[row] + col;
+        *hsv8_pixel = ((Hsv8*)img->rows[row + radius])[col + radius];
+        hsv8_pixel->hue = hue;
+    }else{
+        hsv_pixel  = (Hsv*)new_img->rows[row] + col;
+        *hsv_pixel = ((Hsv*)img->rows[row + radius])[col + radius];
+        hsv_pixel->hue = (wg_double)hue / (HUE_BINS - 1);
+    }
+
+    return;
+}
+
+/*! @} */
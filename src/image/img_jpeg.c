@@ -13,6 +13,11 @@
 
 #define LINES_PER_READ 32
 
+/* libjpeg-turbo writes B,G,R,X bytes which is bgrx_pixel on little endian */
+#if defined(JCS_EXTENSIONS) && (__BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__)
+#define JPEG_NATIVE_BGRX
+#endif
+
 /*! @defgroup image_jpeg JPEG Conversion Functions
  *  @ingroup image
  */
@@ -43,6 +48,18 @@ typedef struct Wg_src_err{
     jmp_buf exit_point;                 /*!< exit point in case of error */
 }Wg_src_err;
 
+/**
+ * @brief Decoder kept between frames
+ *
+ * libjpeg object is created once, every frame only reads a new header.
+ */
+struct Img_jpeg_decoder{
+    struct jpeg_decompress_struct jdecomp; /*!< libjpeg decompressor    */
+    Wg_src_mgr mgr;                        /*!< memory source           */
+    Wg_src_err jerror;                     /*!< error handler           */
+    wg_uint scale;                         /*!< scale denominator       */
+};
+
 WG_PRIVATE wg_status
 set_source_manager(struct jpeg_decompress_struct *jdecomp, Wg_src_mgr* mgr);
 
@@ -57,6 +74,20 @@ alloc_jrows(struct jpeg_decompress_struct *jdecomp, Wg_image *img);
 WG_PRIVATE wg_status
 set_options(struct jpeg_decompress_struct *jdecomp);
 
+WG_PRIVATE wg_status
+decompress(wg_uchar *in_buffer, wg_ssize in_size, Wg_image *img,
+        wg_boolean alloc, img_type type);
+
+WG_PRIVATE void
+decoder_setup(Img_jpeg_decoder *decoder);
+
+WG_PRIVATE wg_status
+decode(Img_jpeg_decoder *decoder, wg_uchar *in_buffer, wg_ssize in_size, 
+        Wg_image *img, wg_boolean alloc, img_type type);
+
+WG_PRIVATE wg_status
+read_bgrx_rows(struct jpeg_decompress_struct *jdecomp, Wg_image *img);
+
 WG_PRIVATE void init_source (j_decompress_ptr cinfo);
 WG_PRIVATE boolean fill_input_buffer (j_decompress_ptr cinfo);
 WG_PRIVATE void skip_input_data (j_decompress_ptr cinfo, long num_bytes);
@@ -81,70 +112,440 @@ wg_status
 img_jpeg_decompress(wg_uchar *in_buffer, wg_ssize in_size, 
         wg_uint width, wg_uint height, Wg_image *img)
 {
-    Wg_src_mgr mgr;
-    int status = 0;
-    struct jpeg_decompress_struct jdecomp;
-    struct Wg_src_err         jerror;
-    wg_uint index = 0;
-    JDIMENSION readed_lines = 0;
+    return decompress(in_buffer, in_size, img, WG_TRUE, IMG_RGB);
+}
+
+/**
+ * @brief Decompress jpeg image into a preallocated image
+ *
+ * Dimensions of the decompressed image must match img.
+ *
+ * @param in_buffer  input buffer
+ * @param in_size    size of the buffer
+ * @param width      width of the image
+ * @param height     haight of the image
+ * @param img        RGB24 image to store decomressed image
+ *
+ * @retval WG_SUCCESS
+ * @retval WG_FAILURE
+ */
+wg_status
+img_jpeg_decompress_noalloc(wg_uchar *in_buffer, wg_ssize in_size, 
+        wg_uint width, wg_uint height, Wg_image *img)
+{
+    return decompress(in_buffer, in_size, img, WG_FALSE, IMG_RGB);
+}
+
+/**
+ * @brief Decompress jpeg image into a preallocated BGRX image
+ *
+ * Dimensions of the decompressed image must match img. Pixels are written
+ * in BGRX layout directly so no separate RGB -> BGRX pass is needed.
+ *
+ * @param in_buffer  input buffer
+ * @param in_size    size of the buffer
+ * @param width      width of the image
+ * @param height     haight of the image
+ * @param img        BGRX image to store decomressed image
+ *
+ * @retval WG_SUCCESS
+ * @retval WG_FAILURE
+ */
+wg_status
+img_jpeg_decompress_bgrx_noalloc(wg_uchar *in_buffer, wg_ssize in_size, 
+        wg_uint width, wg_uint height, Wg_image *img)
+{
+    return decompress(in_buffer, in_size, img, WG_FALSE, IMG_BGRX);
+}
+
+/**
+ * @brief Decompress jpeg image into a preallocated YCbCr image
+ *
+ * Color conversion is skipped, libjpeg returns components it decoded.
+ *
+ * @param in_buffer  input buffer
+ * @param in_size    size of the buffer
+ * @param width      width of the image
+ * @param height     haight of the image
+ * @param img        YCbCr image to store decomressed image
+ *
+ * @retval WG_SUCCESS
+ * @retval WG_FAILURE
+ */
+wg_status
+img_jpeg_decompress_ycbcr_noalloc(wg_uchar *in_buffer, wg_ssize in_size, 
+        wg_uint width, wg_uint height, Wg_image *img)
+{
+    return decompress(in_buffer, in_size, img, WG_FALSE, IMG_YCBCR);
+}
+
+/**
+ * @brief Create a decoder reused for many images
+ *
+ * @param decoder  memory to store decoder
+ *
+ * @retval WG_SUCCESS
+ * @retval WG_FAILURE
+ */
+wg_status
+img_jpeg_decoder_init(Img_jpeg_decoder **decoder)
+{
+    Img_jpeg_decoder *new_decoder = NULL;
+
+    CHECK_FOR_NULL_PARAM(decoder);
+
+    new_decoder = WG_CALLOC(1, sizeof (Img_jpeg_decoder));
+    if (NULL == new_decoder){
+        return WG_FAILURE;
+    }
+
+    decoder_setup(new_decoder);
+
+    *decoder = new_decoder;
+
+    return WG_SUCCESS;
+}
+
+/**
+ * @brief Release decoder
+ *
+ * @param decoder  decoder instance
+ */
+void
+img_jpeg_decoder_cleanup(Img_jpeg_decoder *decoder)
+{
+    if (NULL != decoder){
+        jpeg_destroy_decompress(&decoder->jdecomp);
+        WG_FREE(decoder);
+    }
+
+    return;
+}
+
+/**
+ * @brief Set scaling done in DCT domain
+ *
+ * Decoded image is 1/scale of the encoded one, IDCT cost drops accordingly.
+ *
+ * @param decoder  decoder instance
+ * @param scale    scale denominator, 1, 2, 4 or 8
+ *
+ * @retval WG_SUCCESS
+ * @retval WG_FAILURE
+ */
+wg_status
+img_jpeg_decoder_set_scale(Img_jpeg_decoder *decoder, wg_uint scale)
+{
+    CHECK_FOR_NULL_PARAM(decoder);
+
+    if ((scale != 1) && (scale != 2) && (scale != 4) && (scale != 8)){
+        WG_ERROR("Unsupported scale 1/%u\n", scale);
+        return WG_FAILURE;
+    }
+
+    decoder->scale = scale;
+
+    return WG_SUCCESS;
+}
+
+/**
+ * @brief Get size of a decoded image
+ *
+ * @param decoder  decoder instance
+ * @param width    width of the encoded image
+ * @param height   height of the encoded image
+ * @param out_width   memory to store width of the decoded image
+ * @param out_height  memory to store height of the decoded image
+ *
+ * @retval WG_SUCCESS
+ * @retval WG_FAILURE
+ */
+wg_status
+img_jpeg_decoder_get_size(const Img_jpeg_decoder *decoder, 
+        wg_uint width, wg_uint height, 
+        wg_uint *out_width, wg_uint *out_height)
+{
+    CHECK_FOR_NULL_PARAM(decoder);
+    CHECK_FOR_NULL_PARAM(out_width);
+    CHECK_FOR_NULL_PARAM(out_height);
+
+    /* libjpeg rounds scaled size up */
+    *out_width  = (width + decoder->scale - 1) / decoder->scale;
+    *out_height = (height + decoder->scale - 1) / decoder->scale;
+
+    return WG_SUCCESS;
+}
+
+/**
+ * @brief Decompress jpeg image into a preallocated image
+ *
+ * Size of img must match img_jpeg_decoder_get_size().
+ *
+ * @param decoder    decoder instance
+ * @param in_buffer  input buffer
+ * @param in_size    size of the buffer
+ * @param img        image to store decomressed image
+ * @param type       IMG_RGB, IMG_BGRX or IMG_YCBCR
+ *
+ * @retval WG_SUCCESS
+ * @retval WG_FAILURE
+ */
+wg_status
+img_jpeg_decoder_run(Img_jpeg_decoder *decoder, wg_uchar *in_buffer, 
+        wg_ssize in_size, Wg_image *img, img_type type)
+{
+    CHECK_FOR_NULL_PARAM(decoder);
+
+    if ((IMG_RGB != type) && (IMG_BGRX != type) && (IMG_YCBCR != type)){
+        WG_ERROR("Invalig image format! Passed %d expect %d, %d or %d\n", 
+                type, IMG_RGB, IMG_BGRX, IMG_YCBCR);
+        return WG_FAILURE;
+    }
+
+    return decode(decoder, in_buffer, in_size, img, WG_FALSE, type);
+}
+
+/**
+* @brief Compress RGB image to JPEG
+*
+* Output buffer is allocated by libjpeg and must be released by free().
+*
+* @param img         RGB image
+* @param quality     quality from 0 to 100
+* @param out_buffer  memory to store compressed image
+* @param out_size    memory to store number of bytes in out_buffer
+*
+* @retval WG_SUCCESS
+* @retval WG_FAILURE
+*/
+wg_status
+img_jpeg_compress(const Wg_image *img, wg_uint quality, 
+        wg_uchar **out_buffer, wg_size *out_size)
+{
+    struct jpeg_compress_struct jcomp;
+    Wg_src_err jerror;
+    unsigned long size = 0;
+    JSAMPROW row = NULL;
 
-    CHECK_FOR_NULL_PARAM(in_buffer);
     CHECK_FOR_NULL_PARAM(img);
+    CHECK_FOR_NULL_PARAM(out_buffer);
+    CHECK_FOR_NULL_PARAM(out_size);
+
+    if (img->type != IMG_RGB){
+        WG_ERROR("Invalig image format! Passed %d expect %d\n", 
+                img->type, IMG_RGB);
+        return WG_FAILURE;
+    }
 
-    jdecomp.err = jpeg_std_error(&jerror.parent_err);
+    *out_buffer = NULL;
+
+    jcomp.err = jpeg_std_error(&jerror.parent_err);
     jerror.parent_err.error_exit = error_exit;
 
     if (setjmp(jerror.exit_point)){
-        jpeg_destroy_decompress(&jdecomp);
+        jpeg_destroy_compress(&jcomp);
+        free(*out_buffer);
+        *out_buffer = NULL;
         return WG_FAILURE;
     }
 
-    /* initialize custom data manager            */
-    init_source_manager(&mgr, in_buffer, in_size);
+    jpeg_create_compress(&jcomp);
+    jpeg_mem_dest(&jcomp, out_buffer, &size);
+
+    jcomp.image_width      = img->width;
+    jcomp.image_height     = img->height;
+    jcomp.input_components = RGB24_COMPONENT_NUM;
+    jcomp.in_color_space   = JCS_RGB;
+
+    jpeg_set_defaults(&jcomp);
+    jpeg_set_quality(&jcomp, quality, TRUE);
+
+    jpeg_start_compress(&jcomp, TRUE);
+
+    while (jcomp.next_scanline < jcomp.image_height){
+        row = img->rows[jcomp.next_scanline];
+        jpeg_write_scanlines(&jcomp, &row, 1);
+    }
+
+    jpeg_finish_compress(&jcomp);
+    jpeg_destroy_compress(&jcomp);
+
+    *out_size = size;
+
+    return WG_SUCCESS;
+}
+
+WG_PRIVATE wg_status
+decompress(wg_uchar *in_buffer, wg_ssize in_size, Wg_image *img,
+        wg_boolean alloc, img_type type)
+{
+    Img_jpeg_decoder decoder;
+    wg_status status = WG_FAILURE;
+
+    memset(&decoder, '\0', sizeof (Img_jpeg_decoder));
+
+    decoder_setup(&decoder);
+
+    status = decode(&decoder, in_buffer, in_size, img, alloc, type);
+
+    jpeg_destroy_decompress(&decoder.jdecomp);
+
+    return status;
+}
+
+WG_PRIVATE void
+decoder_setup(Img_jpeg_decoder *decoder)
+{
+    decoder->jdecomp.err = jpeg_std_error(&decoder->jerror.parent_err);
+    decoder->jerror.parent_err.error_exit = error_exit;
+    decoder->scale = 1;
 
     /* create a decompression session            */
-    jpeg_create_decompress(&jdecomp);
+    jpeg_create_decompress(&decoder->jdecomp);
 
     /* set custom source data manager            */
-    set_source_manager(&jdecomp, &mgr);
+    set_source_manager(&decoder->jdecomp, &decoder->mgr);
+
+    return;
+}
+
+WG_PRIVATE wg_status
+decode(Img_jpeg_decoder *decoder, wg_uchar *in_buffer, wg_ssize in_size, 
+        Wg_image *img, wg_boolean alloc, img_type type)
+{
+    struct jpeg_decompress_struct *jdecomp = &decoder->jdecomp;
+    int status = 0;
+    wg_uint index = 0;
+    wg_uint components = 0;
+    JDIMENSION readed_lines = 0;
+
+    CHECK_FOR_NULL_PARAM(in_buffer);
+    CHECK_FOR_NULL_PARAM(img);
+
+    /* error keeps the decompressor, only the image is dropped */
+    if (setjmp(decoder->jerror.exit_point)){
+        jpeg_abort_decompress(jdecomp);
+        return WG_FAILURE;
+    }
+
+    /* initialize custom data manager            */
+    init_source_manager(&decoder->mgr, in_buffer, in_size);
 
     /* read headed of the jpeg image             */
-    status = jpeg_read_header(&jdecomp, FALSE);
+    status = jpeg_read_header(jdecomp, FALSE);
     if (status !=  JPEG_HEADER_OK){
-        jpeg_destroy_decompress(&jdecomp);
+        jpeg_abort_decompress(jdecomp);
         return WG_FAILURE;
     }
 
-    set_options(&jdecomp);
+    set_options(jdecomp);
+
+    jdecomp->scale_num   = 1;
+    jdecomp->scale_denom = decoder->scale;
+
+#ifdef JPEG_NATIVE_BGRX
+    if (IMG_BGRX == type){
+        jdecomp->out_color_space = JCS_EXT_BGRX;
+    }
+#endif
+
+    if (IMG_YCBCR == type){
+        jdecomp->out_color_space = JCS_YCbCr;
+    }
 
     /* decompress image                           */
-    if (FALSE == jpeg_start_decompress(&jdecomp)){
-        jpeg_destroy_decompress(&jdecomp);
+    if (FALSE == jpeg_start_decompress(jdecomp)){
+        jpeg_abort_decompress(jdecomp);
         return WG_FAILURE;
     }
 
+    components = (IMG_BGRX == type) ? BGRX_COMPONENT_NUM : 
+        jdecomp->output_components;
+
     /* allocate memory to store decomressed image */
 #if 0
-    alloc_jrows(&jdecomp, img);
+    alloc_jrows(jdecomp, img);
 #endif
-    img_fill(jdecomp.output_width ,jdecomp.output_height, 
-            jdecomp.output_components, IMG_RGB, img);
+    if (WG_TRUE == alloc){
+        img_fill(jdecomp->output_width ,jdecomp->output_height, 
+                components, type, img);
+    }else{
+        if (img_check_geometry(img, jdecomp->output_width, 
+                    jdecomp->output_height, components) 
+                != WG_SUCCESS){
+            jpeg_abort_decompress(jdecomp);
+            return WG_FAILURE;
+        }
+        img->type = type;
+    }
+
+    /* decoder returns RGB, expand it row by row  */
+    if (jdecomp->output_components != components){
+        if (read_bgrx_rows(jdecomp, img) != WG_SUCCESS){
+            jpeg_abort_decompress(jdecomp);
+            if (WG_TRUE == alloc){
+                img_cleanup(img);
+            }
+            return WG_FAILURE;
+        }
+    }
 
     /* read decompressed lines                    */
-    for (index = 0; jdecomp.output_scanline < jdecomp.output_height;){
-        readed_lines = jpeg_read_scanlines(&jdecomp, &(img->rows[index]),
+    for (index = 0; jdecomp->output_scanline < jdecomp->output_height;){
+        readed_lines = jpeg_read_scanlines(jdecomp, &(img->rows[index]),
                 LINES_PER_READ);
         if (readed_lines == 0){
-            jpeg_destroy_decompress(&jdecomp);
-            img_cleanup(img);
+            jpeg_abort_decompress(jdecomp);
+            if (WG_TRUE == alloc){
+                img_cleanup(img);
+            }
             return WG_FAILURE;
         }
         index += readed_lines;
     }
 
     /* cleanup */
-    jpeg_finish_decompress(&jdecomp);
-    jpeg_destroy_decompress(&jdecomp);
+    jpeg_finish_decompress(jdecomp);
+
+    return WG_SUCCESS;
+}
+
+WG_PRIVATE wg_status
+read_bgrx_rows(struct jpeg_decompress_struct *jdecomp, Wg_image *img)
+{
+    JSAMPARRAY buffer = NULL;
+    JSAMPLE   *rgb = NULL;
+    bgrx_pixel *bgrx = NULL;
+    JDIMENSION readed_lines = 0;
+    wg_uint line = 0;
+    wg_uint col = 0;
+    wg_uint index = 0;
+
+    if (jdecomp->output_components != RGB24_COMPONENT_NUM){
+        WG_ERROR("Invalig number of components! Passed %d expect %d\n", 
+                jdecomp->output_components, RGB24_COMPONENT_NUM);
+        return WG_FAILURE;
+    }
+
+    /* released together with the decompressor */
+    buffer = jdecomp->mem->alloc_sarray((j_common_ptr)jdecomp, JPOOL_IMAGE,
+            jdecomp->output_width * RGB24_COMPONENT_NUM, LINES_PER_READ);
+
+    for (index = 0; jdecomp->output_scanline < jdecomp->output_height;){
+        readed_lines = jpeg_read_scanlines(jdecomp, buffer, LINES_PER_READ);
+        if (readed_lines == 0){
+            return WG_FAILURE;
+        }
+        for (line = 0; line < readed_lines; ++line, ++index){
+            rgb  = buffer[line];
+            bgrx = (bgrx_pixel*)img->rows[index];
+            for (col = 0; col < jdecomp->output_width; ++col){
+                bgrx[col] = RGB_2_BGRX(rgb[RGB24_R], rgb[RGB24_G], 
+                        rgb[RGB24_B]);
+                rgb += RGB24_COMPONENT_NUM;
+            }
+        }
+    }
 
     return WG_SUCCESS;
 }
@@ -0,0 +1,235 @@
+#include <stdio.h>
+#include <sys/types.h>
+#include <string.h>
+
+#include <wgtypes.h>
+#include <wg.h>
+#include <wgmacros.h>
+
+#include <img.h>
+
+#include "include/img_simd.h"
+
+/*! @defgroup image_median 3x3 Median Filter
+ * @ingroup image
+ */
+
+/*! @{ */
+
+/* 
+ * Median of 9 is computed with a min/max network. Each of the three columns
+ * of the window is sorted, then the median is the median of: the largest of
+ * the column minimums, the median of the column medians and the smallest of
+ * the column maximums. The network has no branches so the same code works
+ * on a single byte and on 16 or 32 bytes in a vector register.
+ *
+ * Every byte is filtered on its own and neighbours are step bytes away, so
+ * one kernel serves all packed 8 bit formats (GS, RGB, BGRX).
+ */
+
+/** @brief order a and b */
+#define SORT2(a, b, t)   { t = min_u8(a, b); b = max_u8(a, b); a = t; }
+
+/** @brief median of 3 built from min/max only */
+#define MED3(a, b, c)    max_u8(min_u8(a, b), min_u8(max_u8(a, b), c))
+
+WG_INLINE wg_uchar
+min_u8(wg_uchar a, wg_uchar b)
+{
+    return (a < b) ? a : b;
+}
+
+WG_INLINE wg_uchar
+max_u8(wg_uchar a, wg_uchar b)
+{
+    return (a > b) ? a : b;
+}
+
+/** 
+* @brief Filter a run of bytes
+*
+* @param r0    first row of the window
+* @param r1    second row of the window
+* @param r2    third row of the window
+* @param out   output row
+* @param num   number of output bytes
+* @param step  distance in bytes between horizontal neighbours
+*/
+typedef void (*Median_run)(const wg_uchar *r0, const wg_uchar *r1,
+        const wg_uchar *r2, wg_uchar *out, wg_uint num, wg_uint step);
+
+WG_PRIVATE void
+median_run_c(const wg_uchar *r0, const wg_uchar *r1, const wg_uchar *r2,
+        wg_uchar *out, wg_uint num, wg_uint step);
+
+#ifdef IMG_X86_SIMD
+WG_PRIVATE void
+median_run_sse2(const wg_uchar *r0, const wg_uchar *r1, const wg_uchar *r2,
+        wg_uchar *out, wg_uint num, wg_uint step);
+
+WG_PRIVATE void
+median_run_avx2(const wg_uchar *r0, const wg_uchar *r1, const wg_uchar *r2,
+        wg_uchar *out, wg_uint num, wg_uint step);
+#endif
+
+/** @brief Median kernel for each instruction set */
+WG_STATIC const Median_run median_run[IMG_SIMD_AVX2 + 1] = {
+#ifdef IMG_X86_SIMD
+    median_run_c, median_run_sse2, median_run_avx2
+#else
+    median_run_c, median_run_c, median_run_c
+#endif
+};
+
+/** 
+* @brief 3x3 median filter of a packed 8 bit image
+*
+* Each component is filtered separately. Output image is smaller by 2 pixels
+* in each dimension and must be allocated by the caller. Vector version is
+* selected by img_simd_level().
+* 
+* @param[in]  img       source image with 1 byte per component
+* @param[out] new_img   image smaller by 2 pixels in each dimension
+* 
+* @retval WG_SUCCESS
+* @retval WG_FAILURE
+*/
+wg_status
+img_median_filter_noalloc(const Wg_image *img, Wg_image *new_img)
+{
+    Median_run run = NULL;
+    wg_uchar *out = NULL;
+    wg_uint width = 0;
+    wg_uint height = 0;
+    wg_uint step = 0;
+    wg_uint row = 0;
+
+    CHECK_FOR_NULL_PARAM(img);
+    CHECK_FOR_NULL_PARAM(new_img);
+    CHECK_FOR_RANGE_LT(img->width, 3);
+    CHECK_FOR_RANGE_LT(img->height, 3);
+
+    width  = img->width - 2;
+    height = img->height - 2;
+    step   = img->components_per_pixel;
+
+    if (img_check_geometry(new_img, width, height, step) != WG_SUCCESS){
+        return WG_FAILURE;
+    }
+
+    new_img->type = img->type;
+
+    run = median_run[img_simd_level()];
+
+    for (row = 0; row < height; ++row){
+        img_get_row(new_img, row, &out);
+        run(img->rows[row], img->rows[row + 1], img->rows[row + 2],
+                out, width * step, step);
+    }
+
+    return WG_SUCCESS;
+}
+
+WG_PRIVATE void
+median_run_c(const wg_uchar *r0, const wg_uchar *r1, const wg_uchar *r2,
+        wg_uchar *out, wg_uint num, wg_uint step)
+{
+    wg_uchar a0, b0, c0;
+    wg_uchar a1, b1, c1;
+    wg_uchar a2, b2, c2;
+    wg_uchar lo, mid, hi;
+    wg_uchar t;
+    wg_uint i = 0;
+
+    for (i = 0; i < num; ++i){
+        a0 = r0[i];        b0 = r1[i];        c0 = r2[i];
+        a1 = r0[i + step]; b1 = r1[i + step]; c1 = r2[i + step];
+        a2 = r0[i + step + step];
+        b2 = r1[i + step + step];
+        c2 = r2[i + step + step];
+
+        /* sort columns */
+        SORT2(a0, b0, t); SORT2(b0, c0, t); SORT2(a0, b0, t);
+        SORT2(a1, b1, t); SORT2(b1, c1, t); SORT2(a1, b1, t);
+        SORT2(a2, b2, t); SORT2(b2, c2, t); SORT2(a2, b2, t);
+
+        lo  = max_u8(max_u8(a0, a1), a2);
+        mid = MED3(b0, b1, b2);
+        hi  = min_u8(min_u8(c0, c1), c2);
+
+        out[i] = MED3(lo, mid, hi);
+    }
+
+    return;
+}
+
+#ifdef IMG_X86_SIMD
+
+/** @brief order vectors a and b */
+#define SORT2_V(min, max, a, b, t)   { t = min(a, b); b = max(a, b); a = t; }
+
+/** @brief median of 3 vectors */
+#define MED3_V(min, max, a, b, c)    max(min(a, b), min(max(a, b), c))
+
+/** 
+* @brief Median of 9 for every byte lane of the vector type
+*
+* Expands to the body of a vector kernel. LOAD/STORE/MIN/MAX are the
+* intrinsics of the selected instruction set and WIDTH is the vector size.
+*/
+#define MEDIAN_RUN_V(type, LOAD, STORE, MIN, MAX, WIDTH)                      \
+    {                                                                          \
+        type a0, b0, c0, a1, b1, c1, a2, b2, c2, lo, mid, hi, t;               \
+        wg_uint i = 0;                                                         \
+                                                                               \
+        for (i = 0; i + (WIDTH) <= num; i += (WIDTH)){                         \
+            a0 = LOAD((const type*)(r0 + i));                                  \
+            b0 = LOAD((const type*)(r1 + i));                                  \
+            c0 = LOAD((const type*)(r2 + i));                                  \
+            a1 = LOAD((const type*)(r0 + i + step));                           \
+            b1 = LOAD((const type*)(r1 + i + step));                           \
+            c1 = LOAD((const type*)(r2 + i + step));                           \
+            a2 = LOAD((const type*)(r0 + i + step + step));                    \
+            b2 = LOAD((const type*)(r1 + i + step + step));                    \
+            c2 = LOAD((const type*)(r2 + i + step + step));                    \
+                                                                               \
+            SORT2_V(MIN, MAX, a0, b0, t); SORT2_V(MIN, MAX, b0, c0, t);        \
+            SORT2_V(MIN, MAX, a0, b0, t);                                      \
+            SORT2_V(MIN, MAX, a1, b1, t); SORT2_V(MIN, MAX, b1, c1, t);        \
+            SORT2_V(MIN, MAX, a1, b1, t);                                      \
+            SORT2_V(MIN, MAX, a2, b2, t); SORT2_V(MIN, MAX, b2, c2, t);        \
+            SORT2_V(MIN, MAX, a2, b2, t);                                      \
+                                                                               \
+            lo  = MAX(MAX(a0, a1), a2);                                        \
+            mid = MED3_V(MIN, MAX, b0, b1, b2);                                \
+            hi  = MIN(MIN(c0, c1), c2);                                        \
+                                                                               \
+            STORE((type*)(out + i), MED3_V(MIN, MAX, lo, mid, hi));            \
+        }                                                                      \
+                                                                               \
+        median_run_c(r0 + i, r1 + i, r2 + i, out + i, num - i, step);          \
+    }
+
+SIMD_TARGET("sse2") WG_PRIVATE void
+median_run_sse2(const wg_uchar *r0, const wg_uchar *r1, const wg_uchar *r2,
+        wg_uchar *out, wg_uint num, wg_uint step)
+{
+    MEDIAN_RUN_V(__m128i, _mm_loadu_si128, _mm_storeu_si128, 
+            _mm_min_epu8, _mm_max_epu8, 16);
+
+    return;
+}
+
+SIMD_TARGET("avx2") WG_PRIVATE void
+median_run_avx2(const wg_uchar *r0, const wg_uchar *r1, const wg_uchar *r2,
+        wg_uchar *out, wg_uint num, wg_uint step)
+{
+    MEDIAN_RUN_V(__m256i, _mm256_loadu_si256, _mm256_storeu_si256, 
+            _mm256_min_epu8, _mm256_max_epu8, 32);
+
+    return;
+}
+
+#endif /* IMG_X86_SIMD */
+
+/*! @} */
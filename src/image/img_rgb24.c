@@ -35,6 +35,37 @@ gs_2_rgb(gray_pixel gs, rgb24_pixel rgb)
  */
 wg_status
 img_bgrx_2_rgb(Wg_image *bgrx_img, Wg_image *rgb_img)
+{
+    wg_status status = WG_FAILURE;
+
+    CHECK_FOR_NULL_PARAM(rgb_img);
+    CHECK_FOR_NULL_PARAM(bgrx_img);
+
+    status = img_fill(bgrx_img->width, bgrx_img->height, RGB24_COMPONENT_NUM,
+            IMG_RGB, rgb_img);
+    if (WG_SUCCESS != status){
+        return WG_FAILURE;
+    }
+
+    status = img_bgrx_2_rgb_noalloc(bgrx_img, rgb_img);
+    if (WG_SUCCESS != status){
+        img_cleanup(rgb_img);
+    }
+
+    return status;
+}
+
+/**
+ * @brief Convert BGRX to RGB24 format without allocating memory
+ *
+ * @param bgrx_img    BGRX image
+ * @param rgb_img     RGB24 image of the same size as bgrx_img
+ *
+ * @retval WG_SUCCESS
+ * @retval WG_SUCCESS
+ */
+wg_status
+img_bgrx_2_rgb_noalloc(Wg_image *bgrx_img, Wg_image *rgb_img)
 {
     wg_status status = WG_FAILURE;
     bgrx_pixel *bgrx_pixel = NULL;
@@ -56,11 +87,13 @@ img_bgrx_2_rgb(Wg_image *bgrx_img, Wg_image *rgb_img)
     img_get_width(bgrx_img, &width);
     img_get_height(bgrx_img, &height);
 
-    status = img_fill(width, height, RGB24_COMPONENT_NUM, IMG_RGB,
-            rgb_img);
+    status = img_check_geometry(rgb_img, width, height, RGB24_COMPONENT_NUM);
     if (WG_SUCCESS != status){
         return WG_FAILURE;
     }
+
+    rgb_img->type = IMG_RGB;
+
     for (row = 0; row < height; ++row){
         img_get_row(rgb_img, row, (wg_uchar**)&rgb_pixel);
         img_get_row(bgrx_img, row, (wg_uchar**)&bgrx_pixel);
@@ -0,0 +1,366 @@
+#include <stdio.h>
+#include <sys/types.h>
+#include <string.h>
+
+#include <wgtypes.h>
+#include <wg.h>
+#include <wgmacros.h>
+
+#include <img.h>
+
+/*! @defgroup image_ycbcr YCbCr manipulation
+ * @ingroup image
+ * @{
+ */
+
+WG_PRIVATE void
+yuyv_lut_index(wg_uint y_index[256], wg_uint cb_index[256],
+        wg_uint cr_index[256]);
+
+WG_PRIVATE void
+bitmask_push(bitmask_word **word, bitmask_word *bits, wg_uint col,
+        wg_boolean set);
+
+/**
+* @brief Build a mask of pixels using a classification table
+*
+* @param img     YCbCr image
+* @param mask    memory to store grayscale mask
+* @param lut     table built by img_hsv_range_ycbcr_lut()
+*
+* @retval WG_SUCCESS
+* @retval WG_FAILURE
+*/
+wg_status
+img_ycbcr_lut_mask(const Wg_image *img, Wg_image *mask,
+        const gray_pixel *lut)
+{
+    wg_status status = WG_FAILURE;
+
+    CHECK_FOR_NULL_PARAM(img);
+    CHECK_FOR_NULL_PARAM(mask);
+
+    status = img_fill(img->width, img->height, GS_COMPONENT_NUM, IMG_GS,
+            mask);
+    if (WG_SUCCESS != status){
+        return status;
+    }
+
+    status = img_ycbcr_lut_mask_noalloc(img, mask, lut);
+    if (WG_SUCCESS != status){
+        img_cleanup(mask);
+    }
+
+    return status;
+}
+
+/**
+* @brief Build a mask of pixels using a classification table into
+*        a preallocated image
+*
+* One table load per pixel, no color conversion is done.
+*
+* @param img     YCbCr image
+* @param mask    grayscale image of the same size as img
+* @param lut     table built by img_hsv_range_ycbcr_lut()
+*
+* @retval WG_SUCCESS
+* @retval WG_FAILURE
+*/
+wg_status
+img_ycbcr_lut_mask_noalloc(const Wg_image *img, Wg_image *mask,
+        const gray_pixel *lut)
+{
+    gray_pixel *gs_pixel = NULL;
+    wg_uchar *pixel = NULL;
+    wg_uint row = 0;
+    wg_uint col = 0;
+    wg_uint width = 0;
+    wg_uint height = 0;
+    wg_status status = WG_FAILURE;
+
+    CHECK_FOR_NULL_PARAM(img);
+    CHECK_FOR_NULL_PARAM(mask);
+    CHECK_FOR_NULL_PARAM(lut);
+
+    if (img->type != IMG_YCBCR){
+        WG_ERROR("Invalig image format! Passed %d expect %d\n",
+                img->type, IMG_YCBCR);
+        return WG_FAILURE;
+    }
+
+    img_get_width(img, &width);
+    img_get_height(img, &height);
+
+    status = img_check_geometry(mask, width, height, GS_COMPONENT_NUM);
+    if (WG_SUCCESS != status){
+        return status;
+    }
+
+    mask->type = IMG_GS;
+
+    for (row = 0; row < height; ++row){
+        img_get_row(img, row, &pixel);
+        img_get_row(mask, row, (wg_uchar**)&gs_pixel);
+        for (col = 0; col < width; ++col, ++gs_pixel){
+            *gs_pixel = lut[IMG_YCBCR_LUT_INDEX(pixel[YCBCR_Y],
+                    pixel[YCBCR_CB], pixel[YCBCR_CR])];
+            pixel += YCBCR_COMPONENT_NUM;
+        }
+    }
+
+    return WG_SUCCESS;
+}
+
+/**
+* @brief Build a mask of a YUYV image using YCbCr classification table
+*
+* Video range of the camera is mapped to the table index by small per
+* byte tables so the frame is classified where the driver stored it.
+*
+* @param img     YUYV image, 2 bytes per pixel
+* @param mask    grayscale image of the same size as img
+* @param lut     table built by img_hsv_range_ycbcr_lut()
+*
+* @retval WG_SUCCESS
+* @retval WG_FAILURE
+*/
+wg_status
+img_yuyv_lut_mask_noalloc(const Wg_image *img, Wg_image *mask,
+        const gray_pixel *lut)
+{
+    wg_uint y_index[256];
+    wg_uint cb_index[256];
+    wg_uint cr_index[256];
+    gray_pixel *gs_pixel = NULL;
+    wg_uchar *pixel = NULL;
+    wg_uint chroma = 0;
+    wg_uint row = 0;
+    wg_uint col = 0;
+    wg_uint width = 0;
+    wg_uint height = 0;
+    wg_status status = WG_FAILURE;
+
+    CHECK_FOR_NULL_PARAM(img);
+    CHECK_FOR_NULL_PARAM(mask);
+    CHECK_FOR_NULL_PARAM(lut);
+
+    if (img->type != IMG_YUYV){
+        WG_ERROR("Invalig image format! Passed %d expect %d\n",
+                img->type, IMG_YUYV);
+        return WG_FAILURE;
+    }
+
+    img_get_width(img, &width);
+    img_get_height(img, &height);
+
+    status = img_check_geometry(mask, width, height, GS_COMPONENT_NUM);
+    if (WG_SUCCESS != status){
+        return status;
+    }
+
+    mask->type = IMG_GS;
+
+    yuyv_lut_index(y_index, cb_index, cr_index);
+
+    /* V4L2 stores Y0 Cb Y1 Cr */
+    for (row = 0; row < height; ++row){
+        img_get_row(img, row, &pixel);
+        img_get_row(mask, row, (wg_uchar**)&gs_pixel);
+        for (col = 0; col + 1 < width; col += 2){
+            chroma = cb_index[pixel[POS_U]] | cr_index[pixel[POS_V]];
+            *gs_pixel++ = lut[y_index[pixel[POS_Y0]] | chroma];
+            *gs_pixel++ = lut[y_index[pixel[POS_Y1]] | chroma];
+            pixel += YUYV_COMPONENT_NUM;
+        }
+        if (col < width){
+            *gs_pixel = lut[y_index[pixel[POS_Y0]] | 
+                cb_index[pixel[POS_U]] | cr_index[pixel[POS_V]]];
+        }
+    }
+
+    return WG_SUCCESS;
+}
+
+/**
+* @brief Build a bit mask of pixels using a classification table
+*
+* Same classification as img_ycbcr_lut_mask_noalloc(), pixels with non
+* zero table entry are set.
+*
+* @param img     YCbCr image
+* @param mask    IMG_BITMASK image of the same size as img
+* @param lut     table built by img_hsv_range_ycbcr_lut()
+*
+* @retval WG_SUCCESS
+* @retval WG_FAILURE
+*/
+wg_status
+img_ycbcr_lut_bitmask_noalloc(const Wg_image *img, Wg_image *mask,
+        const gray_pixel *lut)
+{
+    bitmask_word *word = NULL;
+    bitmask_word bits = 0;
+    wg_uchar *pixel = NULL;
+    wg_uint row = 0;
+    wg_uint col = 0;
+    wg_uint width = 0;
+    wg_uint height = 0;
+    wg_status status = WG_FAILURE;
+
+    CHECK_FOR_NULL_PARAM(img);
+    CHECK_FOR_NULL_PARAM(mask);
+    CHECK_FOR_NULL_PARAM(lut);
+
+    if (img->type != IMG_YCBCR){
+        WG_ERROR("Invalig image format! Passed %d expect %d\n",
+                img->type, IMG_YCBCR);
+        return WG_FAILURE;
+    }
+
+    img_get_width(img, &width);
+    img_get_height(img, &height);
+
+    status = img_check_geometry(mask, width, height, BITMASK_COMPONENT_NUM);
+    if (WG_SUCCESS != status){
+        return status;
+    }
+
+    mask->type = IMG_BITMASK;
+
+    for (row = 0; row < height; ++row){
+        img_get_row(img, row, &pixel);
+        img_get_row(mask, row, (wg_uchar**)&word);
+        bits = 0;
+        for (col = 0; col < width; ++col){
+            bitmask_push(&word, &bits, col, lut[IMG_YCBCR_LUT_INDEX(
+                        pixel[YCBCR_Y], pixel[YCBCR_CB], pixel[YCBCR_CR])]);
+            pixel += YCBCR_COMPONENT_NUM;
+        }
+        if (0 != width % BITMASK_WORD_BITS){
+            *word = bits;
+        }
+    }
+
+    return WG_SUCCESS;
+}
+
+/**
+* @brief Build a bit mask of a YUYV image using YCbCr classification table
+*
+* Same classification as img_yuyv_lut_mask_noalloc(), pixels with non
+* zero table entry are set.
+*
+* @param img     YUYV image, 2 bytes per pixel
+* @param mask    IMG_BITMASK image of the same size as img
+* @param lut     table built by img_hsv_range_ycbcr_lut()
+*
+* @retval WG_SUCCESS
+* @retval WG_FAILURE
+*/
+wg_status
+img_yuyv_lut_bitmask_noalloc(const Wg_image *img, Wg_image *mask,
+        const gray_pixel *lut)
+{
+    wg_uint y_index[256];
+    wg_uint cb_index[256];
+    wg_uint cr_index[256];
+    bitmask_word *word = NULL;
+    bitmask_word bits = 0;
+    wg_uchar *pixel = NULL;
+    wg_uint chroma = 0;
+    wg_uint row = 0;
+    wg_uint col = 0;
+    wg_uint width = 0;
+    wg_uint height = 0;
+    wg_status status = WG_FAILURE;
+
+    CHECK_FOR_NULL_PARAM(img);
+    CHECK_FOR_NULL_PARAM(mask);
+    CHECK_FOR_NULL_PARAM(lut);
+
+    if (img->type != IMG_YUYV){
+        WG_ERROR("Invalig image format! Passed %d expect %d\n",
+                img->type, IMG_YUYV);
+        return WG_FAILURE;
+    }
+
+    img_get_width(img, &width);
+    img_get_height(img, &height);
+
+    status = img_check_geometry(mask, width, height, BITMASK_COMPONENT_NUM);
+    if (WG_SUCCESS != status){
+        return status;
+    }
+
+    mask->type = IMG_BITMASK;
+
+    yuyv_lut_index(y_index, cb_index, cr_index);
+
+    /* V4L2 stores Y0 Cb Y1 Cr */
+    for (row = 0; row < height; ++row){
+        img_get_row(img, row, &pixel);
+        img_get_row(mask, row, (wg_uchar**)&word);
+        bits = 0;
+        for (col = 0; col + 1 < width; col += 2){
+            chroma = cb_index[pixel[POS_U]] | cr_index[pixel[POS_V]];
+            bitmask_push(&word, &bits, col,
+                    lut[y_index[pixel[POS_Y0]] | chroma]);
+            bitmask_push(&word, &bits, col + 1,
+                    lut[y_index[pixel[POS_Y1]] | chroma]);
+            pixel += YUYV_COMPONENT_NUM;
+        }
+        if (col < width){
+            bitmask_push(&word, &bits, col, lut[y_index[pixel[POS_Y0]] | 
+                cb_index[pixel[POS_U]] | cr_index[pixel[POS_V]]]);
+        }
+        if (0 != width % BITMASK_WORD_BITS){
+            *word = bits;
+        }
+    }
+
+    return WG_SUCCESS;
+}
+
+/*! @} */
+
+/**
+* @brief Fill tables mapping video range YUYV bytes to table index
+*
+* Same scaling as img_yuyv_2_ycbcr_noalloc().
+*/
+WG_PRIVATE void
+yuyv_lut_index(wg_uint y_index[256], wg_uint cb_index[256],
+        wg_uint cr_index[256])
+{
+    wg_int  val = 0;
+    wg_uint i = 0;
+
+    for (i = 0; i < 256; ++i){
+        val = WG_MIN(255, WG_MAX(0, (298 * ((wg_int)i - 16) + 128) >> 8));
+        y_index[i]  = IMG_YCBCR_LUT_INDEX(val, 0, 0);
+
+        val = WG_MIN(255, WG_MAX(0, 
+                    ((291 * ((wg_int)i - 128) + 128) >> 8) + 128));
+        cb_index[i] = IMG_YCBCR_LUT_INDEX(0, val, 0);
+        cr_index[i] = IMG_YCBCR_LUT_INDEX(0, 0, val);
+    }
+
+    return;
+}
+
+/**
+* @brief Add pixel col of a row to a bit mask, full words are stored
+*/
+WG_PRIVATE void
+bitmask_push(bitmask_word **word, bitmask_word *bits, wg_uint col,
+        wg_boolean set)
+{
+    *bits |= (bitmask_word)(0 != set) << (col % BITMASK_WORD_BITS);
+    if (BITMASK_WORD_BITS - 1 == col % BITMASK_WORD_BITS){
+        *(*word)++ = *bits;
+        *bits = 0;
+    }
+
+    return;
+}
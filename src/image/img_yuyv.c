@@ -9,6 +9,14 @@
 
 #include <img.h>
 
+#include "include/img_simd.h"
+
+#ifdef IMG_X86_SIMD
+/** @brief pair of 16 bit coefficients for madd_epi16 */
+#define COFF_PAIR(lo, hi)                                       \
+    ((wg_int)(((wg_uint)(hi) << 16) | ((wg_uint)(lo) & 0xffff)))
+#endif
+
 /*! @defgroup webcam_yuyv YUYV Conversion Functions
  *  @ingroup image
  */
@@ -25,30 +33,105 @@
 #define E(V)    ((V) - 128)
 
 /** @brief interlan use */
-#define BLUE_E(E)         (             409 * (E) + 128)
+#define BLUE_D(D)         ( 516 * (D)             + 128)
 
 /** @brief interlan use */
 #define GREEN_DE(D, E)    (-100 * (D) - 208 * (E) + 128)
 
 /** @brief interlan use */
-#define RED_D(D)          ( 516 * (D)             + 128)
+#define RED_E(E)          (             409 * (E) + 128)
 
 /** @brief interlan use */
-#define BLUE(C, BE)                                             \
-    clamp_0_255(((298 * (C) + (BE)) >> 8))
+#define BLUE(C, BD)                                             \
+    clamp_0_255(((298 * (C) + (BD)) >> 8))
 
 /** @brief interlan use */
 #define GREEN(C, GDE)                                            \
     clamp_0_255(((298 * (C) + (GDE)) >> 8))
 
 /** @brief interlan use */
-#define RED(C, RD)                                              \
-    clamp_0_255(((298 * (C) + (RD)) >> 8))
+#define RED(C, RE)                                              \
+    clamp_0_255(((298 * (C) + (RE)) >> 8))
 
 /** Pointer to the yuyv component */
 typedef wg_uchar (*Component)[YUYV_COMPONENT_NUM];
 
-WG_PRIVATE wg_uchar clamp_0_255(wg_int value);
+/** 
+* @brief Convert a run of YUYV macropixels
+*
+* @param in   YUYV data
+* @param out  output pixels
+* @param num  number of macropixels (2 pixels each)
+*/
+typedef void (*Yuyv_run)(const wg_uchar *in, wg_uchar *out, wg_uint num);
+
+/** 
+* @brief Decoders for one output format
+*/
+typedef struct Yuyv_decoder{
+    Yuyv_run run[IMG_SIMD_AVX2 + 1];   /*!< decoder for each instruction set */
+    wg_uint  comp_num;                 /*!< components per output pixel     */
+    img_type type;                     /*!< output image type               */
+}Yuyv_decoder;
+
+WG_PRIVATE void
+yuyv_2_rgb24_c(const wg_uchar *in, wg_uchar *out, wg_uint num);
+
+WG_PRIVATE void
+yuyv_2_bgrx_c(const wg_uchar *in, wg_uchar *out, wg_uint num);
+
+WG_PRIVATE void
+yuyv_2_ycbcr_c(const wg_uchar *in, wg_uchar *out, wg_uint num);
+
+#ifdef IMG_X86_SIMD
+WG_PRIVATE void
+yuyv_2_rgb24_sse2(const wg_uchar *in, wg_uchar *out, wg_uint num);
+
+WG_PRIVATE void
+yuyv_2_bgrx_sse2(const wg_uchar *in, wg_uchar *out, wg_uint num);
+
+WG_PRIVATE void
+yuyv_2_rgb24_avx2(const wg_uchar *in, wg_uchar *out, wg_uint num);
+
+WG_PRIVATE void
+yuyv_2_bgrx_avx2(const wg_uchar *in, wg_uchar *out, wg_uint num);
+#endif
+
+WG_PRIVATE wg_status
+decode(const Yuyv_decoder *decoder, wg_uchar *in_buffer, wg_ssize in_size,
+        wg_uint width, wg_uint height, Wg_image *img);
+
+/** @brief YUYV to RGB24 decoders */
+WG_STATIC const Yuyv_decoder rgb24_decoder = {
+#ifdef IMG_X86_SIMD
+    {yuyv_2_rgb24_c, yuyv_2_rgb24_sse2, yuyv_2_rgb24_avx2},
+#else
+    {yuyv_2_rgb24_c, yuyv_2_rgb24_c, yuyv_2_rgb24_c},
+#endif
+    RGB24_COMPONENT_NUM, IMG_RGB
+};
+
+/** @brief YUYV to BGRX decoders */
+WG_STATIC const Yuyv_decoder bgrx_decoder = {
+#ifdef IMG_X86_SIMD
+    {yuyv_2_bgrx_c, yuyv_2_bgrx_sse2, yuyv_2_bgrx_avx2},
+#else
+    {yuyv_2_bgrx_c, yuyv_2_bgrx_c, yuyv_2_bgrx_c},
+#endif
+    BGRX_COMPONENT_NUM, IMG_BGRX
+};
+
+/** @brief YUYV to YCbCr decoders, only unpacking so no vector version */
+WG_STATIC const Yuyv_decoder ycbcr_decoder = {
+    {yuyv_2_ycbcr_c, yuyv_2_ycbcr_c, yuyv_2_ycbcr_c},
+    YCBCR_COMPONENT_NUM, IMG_YCBCR
+};
+
+WG_INLINE wg_uchar
+clamp_0_255(wg_int value)
+{
+    return (value < 0) ? 0 : ((value > 255) ? 255 : value);
+}
 
 /**
  * @brief Convert YUYV(YUV4:2:2) to RGB888
@@ -66,81 +149,518 @@ wg_status
 img_yuyv_2_rgb24(wg_uchar *in_buffer, wg_ssize in_size, 
         wg_uint width, wg_uint height, Wg_image *img)
 {
-    register wg_uchar *outbuf = NULL;
-    register Component pixbuf = NULL;
-    wg_uchar  *component;
-    wg_uint width_count = 0;
-    wg_int  BE, GDE, RD;
-    wg_int  C0, C1, D, E;
-    wg_int comp_num = 0;
+    wg_status status = WG_FAILURE;
+
+    CHECK_FOR_NULL_PARAM(in_buffer);
+    CHECK_FOR_NULL_PARAM(img);
+
+    status = img_fill(width, height, 3, IMG_RGB, img);
+    if (WG_SUCCESS != status){
+        return WG_FAILURE;
+    }
 
-    pixbuf = (Component)in_buffer;
+    status = img_yuyv_2_rgb24_noalloc(in_buffer, in_size, width, height, img);
+    if (WG_SUCCESS != status){
+        img_cleanup(img);
+    }
 
-    img_fill(width, height, 3, IMG_RGB, img);
+    return status;
+}
 
-    outbuf = img->image;
+/**
+ * @brief Convert YUYV(YUV4:2:2) to RGB888 into a preallocated image
+ *
+ * @param in_buffer YUYV image buffer
+ * @param in_size   size of the YUYV buffer
+ * @param width     width of the picture in picels
+ * @param height    height of the picture in pixels
+ * @param img       RGB24 image of width x height pixels
+ *
+ * @retval WG_SUCCESS
+ * @retval WG_FAILURE
+ */
+wg_status
+img_yuyv_2_rgb24_noalloc(wg_uchar *in_buffer, wg_ssize in_size, 
+        wg_uint width, wg_uint height, Wg_image *img)
+{
+    return decode(&rgb24_decoder, in_buffer, in_size, width, height, img);
+}
 
-    comp_num = (width * height) >> 1;
+/**
+ * @brief Convert YUYV(YUV4:2:2) to BGRX
+ *
+ * @param in_buffer YUYV image buffer
+ * @param in_size   size of the YUYV buffer
+ * @param width     width of the picture in picels
+ * @param height    height of the picture in pixels
+ * @param img       image structure to store converted image
+ *
+ * @retval WG_SUCCESS
+ * @retval WG_FAILURE
+ */
+wg_status
+img_yuyv_2_bgrx(wg_uchar *in_buffer, wg_ssize in_size, 
+        wg_uint width, wg_uint height, Wg_image *img)
+{
+    wg_status status = WG_FAILURE;
+
+    CHECK_FOR_NULL_PARAM(in_buffer);
+    CHECK_FOR_NULL_PARAM(img);
+
+    status = img_fill(width, height, BGRX_COMPONENT_NUM, IMG_BGRX, img);
+    if (WG_SUCCESS != status){
+        return WG_FAILURE;
+    }
+
+    status = img_yuyv_2_bgrx_noalloc(in_buffer, in_size, width, height, img);
+    if (WG_SUCCESS != status){
+        img_cleanup(img);
+    }
+
+    return status;
+}
+
+/**
+ * @brief Convert YUYV(YUV4:2:2) to BGRX into a preallocated image
+ *
+ * @param in_buffer YUYV image buffer
+ * @param in_size   size of the YUYV buffer
+ * @param width     width of the picture in picels
+ * @param height    height of the picture in pixels
+ * @param img       BGRX image of width x height pixels
+ *
+ * @retval WG_SUCCESS
+ * @retval WG_FAILURE
+ */
+wg_status
+img_yuyv_2_bgrx_noalloc(wg_uchar *in_buffer, wg_ssize in_size, 
+        wg_uint width, wg_uint height, Wg_image *img)
+{
+    return decode(&bgrx_decoder, in_buffer, in_size, width, height, img);
+}
+
+/**
+ * @brief Convert YUYV(YUV4:2:2) to full range YCbCr
+ *
+ * @param in_buffer YUYV image buffer
+ * @param in_size   size of the YUYV buffer
+ * @param width     width of the picture in picels
+ * @param height    height of the picture in pixels
+ * @param img       image structure to store converted image
+ *
+ * @retval WG_SUCCESS
+ * @retval WG_FAILURE
+ */
+wg_status
+img_yuyv_2_ycbcr(wg_uchar *in_buffer, wg_ssize in_size, 
+        wg_uint width, wg_uint height, Wg_image *img)
+{
+    wg_status status = WG_FAILURE;
+
+    CHECK_FOR_NULL_PARAM(in_buffer);
+    CHECK_FOR_NULL_PARAM(img);
+
+    status = img_fill(width, height, YCBCR_COMPONENT_NUM, IMG_YCBCR, img);
+    if (WG_SUCCESS != status){
+        return WG_FAILURE;
+    }
+
+    status = img_yuyv_2_ycbcr_noalloc(in_buffer, in_size, width, height, img);
+    if (WG_SUCCESS != status){
+        img_cleanup(img);
+    }
+
+    return status;
+}
+
+/**
+ * @brief Convert YUYV(YUV4:2:2) to full range YCbCr into a preallocated 
+ *        image
+ *
+ * Chroma is shared by both pixels of a pair and video range is stretched 
+ * to the full range written by libjpeg, so one classifier serves both.
+ *
+ * @param in_buffer YUYV image buffer
+ * @param in_size   size of the YUYV buffer
+ * @param width     width of the picture in picels
+ * @param height    height of the picture in pixels
+ * @param img       YCbCr image of width x height pixels
+ *
+ * @retval WG_SUCCESS
+ * @retval WG_FAILURE
+ */
+wg_status
+img_yuyv_2_ycbcr_noalloc(wg_uchar *in_buffer, wg_ssize in_size, 
+        wg_uint width, wg_uint height, Wg_image *img)
+{
+    return decode(&ycbcr_decoder, in_buffer, in_size, width, height, img);
+}
+
+WG_PRIVATE wg_status
+decode(const Yuyv_decoder *decoder, wg_uchar *in_buffer, wg_ssize in_size,
+        wg_uint width, wg_uint height, Wg_image *img)
+{
+    CHECK_FOR_NULL_PARAM(in_buffer);
+    CHECK_FOR_NULL_PARAM(img);
+
+    if (img_check_geometry(img, width, height, decoder->comp_num) 
+            != WG_SUCCESS){
+        return WG_FAILURE;
+    }
+
+    img->type = decoder->type;
 
     /* Each 2 pixels are made out of 4 bytes
-     * Y0 V Y1 U   
+     * Y0 U Y1 V   
      * Y0 and Y1 - luminations for 2 pixels
-     * V and U   - belong to both pixels
+     * U and V   - belong to both pixels
      */
-    for (width_count = 0; width_count < comp_num; ++width_count, ++pixbuf){
-        component = *pixbuf;
+    decoder->run[img_simd_level()](in_buffer, img->image, 
+            (width * height) >> 1);
+
+    return WG_SUCCESS;
+}
+
+WG_PRIVATE void
+yuyv_2_rgb24_c(const wg_uchar *in, wg_uchar *outbuf, wg_uint num)
+{
+    const wg_uchar *component = NULL;
+    wg_uint width_count = 0;
+    wg_int  BD, GDE, RE;
+    wg_int  C0, C1, D, E;
+
+    for (width_count = 0; width_count < num; ++width_count){
+        component = in;
 
         C0 = C(component[POS_Y0]);
         C1 = C(component[POS_Y1]);
         D  = D(component[POS_U]);
         E  = E(component[POS_V]);
 
-        RD  = RED_D(D);
+        RE  = RED_E(E);
         GDE = GREEN_DE(D, E);
-        BE  = BLUE_E(E);
+        BD  = BLUE_D(D);
 
-        outbuf[0] = RED(C0, RD);
+        outbuf[0] = RED(C0, RE);
         outbuf[1] = GREEN(C0, GDE);
-        outbuf[2] = BLUE(C0, BE);
+        outbuf[2] = BLUE(C0, BD);
 
-        outbuf[3] = RED(C1, RD);
+        outbuf[3] = RED(C1, RE);
         outbuf[4] = GREEN(C1, GDE);
-        outbuf[5] = BLUE(C1, BE);
+        outbuf[5] = BLUE(C1, BD);
 
         outbuf += 6;
+        in += YUYV_COMPONENT_NUM;
     }
 
-    return WG_SUCCESS;
+    return;
 }
 
-WG_PRIVATE wg_uchar
-clamp_0_255(wg_int value)
+WG_PRIVATE void
+yuyv_2_bgrx_c(const wg_uchar *in, wg_uchar *out, wg_uint num)
+{
+    const wg_uchar *component = NULL;
+    wg_uint32 *outbuf = (wg_uint32*)out;
+    wg_uint width_count = 0;
+    wg_int  BD, GDE, RE;
+    wg_int  C0, C1, D, E;
+
+    for (width_count = 0; width_count < num; ++width_count){
+        component = in;
+
+        C0 = C(component[POS_Y0]);
+        C1 = C(component[POS_Y1]);
+        D  = D(component[POS_U]);
+        E  = E(component[POS_V]);
+
+        RE  = RED_E(E);
+        GDE = GREEN_DE(D, E);
+        BD  = BLUE_D(D);
+
+        outbuf[0] = RGB_2_BGRX(RED(C0, RE), GREEN(C0, GDE), BLUE(C0, BD));
+        outbuf[1] = RGB_2_BGRX(RED(C1, RE), GREEN(C1, GDE), BLUE(C1, BD));
+
+        outbuf += 2;
+        in += YUYV_COMPONENT_NUM;
+    }
+
+    return;
+}
+
+WG_PRIVATE void
+yuyv_2_ycbcr_c(const wg_uchar *in, wg_uchar *out, wg_uint num)
+{
+    wg_uint width_count = 0;
+    wg_uchar cb = 0;
+    wg_uchar cr = 0;
+
+    /* V4L2 stores Y0 Cb Y1 Cr, luma is scaled by 255/219 and 
+     * chroma by 255/224 around 128 
+     */
+    for (width_count = 0; width_count < num; ++width_count){
+        cb = clamp_0_255(((291 * (in[POS_U] - 128) + 128) >> 8) + 128);
+        cr = clamp_0_255(((291 * (in[POS_V] - 128) + 128) >> 8) + 128);
+
+        out[YCBCR_Y]  = clamp_0_255((298 * C(in[POS_Y0]) + 128) >> 8);
+        out[YCBCR_CB] = cb;
+        out[YCBCR_CR] = cr;
+        out += YCBCR_COMPONENT_NUM;
+
+        out[YCBCR_Y]  = clamp_0_255((298 * C(in[POS_Y1]) + 128) >> 8);
+        out[YCBCR_CB] = cb;
+        out[YCBCR_CR] = cr;
+        out += YCBCR_COMPONENT_NUM;
+
+        in += YUYV_COMPONENT_NUM;
+    }
+
+    return;
+}
+
+#ifdef IMG_X86_SIMD
+
+/* 
+ * Vector decoders compute exactly the same integer formula as the portable
+ * ones. madd_epi16 builds 298 * C + k * D (+ 128) in 32 bits, the results
+ * are shifted, packed with signed saturation and then packed to bytes with
+ * unsigned saturation, which is the clamp to [0, 255].
+ */
+
+/** 
+* @brief Decode 8 pixels (16 bytes of YUYV)
+* 
+* @param in  YUYV data
+* @param r   red components in the low 8 bytes
+* @param g   green components in the low 8 bytes
+* @param b   blue components in the low 8 bytes
+*/
+SIMD_TARGET("sse2") WG_INLINE void
+decode_8_sse2(__m128i in, __m128i *r, __m128i *g, __m128i *b)
+{
+    const __m128i coff_r  = _mm_set1_epi32(COFF_PAIR(298, 409));
+    const __m128i coff_gd = _mm_set1_epi32(COFF_PAIR(298, -100));
+    const __m128i coff_ge = _mm_set1_epi32(COFF_PAIR(-208, 1));
+    const __m128i coff_b  = _mm_set1_epi32(COFF_PAIR(298, 516));
+    const __m128i round   = _mm_set1_epi32(128);
+    const __m128i round16 = _mm_set1_epi16(128);
+    __m128i y, uv, c, d, e;
+    __m128i lo, hi;
+
+    /* 16 bit lanes: Y in low byte, U or V in high byte */
+    y  = _mm_and_si128(in, _mm_set1_epi16(0x00ff));
+    uv = _mm_srli_epi16(in, 8);
+
+    c  = _mm_sub_epi16(y, _mm_set1_epi16(16));
+    uv = _mm_sub_epi16(uv, round16);
+
+    /* replicate chroma for both pixels of a macropixel */
+    d = _mm_shufflehi_epi16(_mm_shufflelo_epi16(uv, _MM_SHUFFLE(2, 2, 0, 0)),
+            _MM_SHUFFLE(2, 2, 0, 0));
+    e = _mm_shufflehi_epi16(_mm_shufflelo_epi16(uv, _MM_SHUFFLE(3, 3, 1, 1)),
+            _MM_SHUFFLE(3, 3, 1, 1));
+
+    lo = _mm_add_epi32(_mm_madd_epi16(_mm_unpacklo_epi16(c, e), coff_r), round);
+    hi = _mm_add_epi32(_mm_madd_epi16(_mm_unpackhi_epi16(c, e), coff_r), round);
+    lo = _mm_packs_epi32(_mm_srai_epi32(lo, 8), _mm_srai_epi32(hi, 8));
+    *r = _mm_packus_epi16(lo, lo);
+
+    lo = _mm_add_epi32(_mm_madd_epi16(_mm_unpacklo_epi16(c, d), coff_gd),
+            _mm_madd_epi16(_mm_unpacklo_epi16(e, round16), coff_ge));
+    hi = _mm_add_epi32(_mm_madd_epi16(_mm_unpackhi_epi16(c, d), coff_gd),
+            _mm_madd_epi16(_mm_unpackhi_epi16(e, round16), coff_ge));
+    lo = _mm_packs_epi32(_mm_srai_epi32(lo, 8), _mm_srai_epi32(hi, 8));
+    *g = _mm_packus_epi16(lo, lo);
+
+    lo = _mm_add_epi32(_mm_madd_epi16(_mm_unpacklo_epi16(c, d), coff_b), round);
+    hi = _mm_add_epi32(_mm_madd_epi16(_mm_unpackhi_epi16(c, d), coff_b), round);
+    lo = _mm_packs_epi32(_mm_srai_epi32(lo, 8), _mm_srai_epi32(hi, 8));
+    *b = _mm_packus_epi16(lo, lo);
+
+    return;
+}
+
+SIMD_TARGET("sse2") WG_PRIVATE void
+yuyv_2_rgb24_sse2(const wg_uchar *in, wg_uchar *out, wg_uint num)
 {
-    __asm__ __volatile__(
-            "cmpl $255, %1\n\t"
-            "jg 1f\n\t"
-            "cmpl $0, %1\n\t"
-            "jge 2f\n\t"
-            "xorl %0, %0\n\t"
-            "jmp 2f\n\t"
-            "1:\tmovl $255, %0\n\t"
-            "2:"
-            : "=a"(value)
-            : "a"(value)
-           );
-
-    return (wg_uchar)value;
-
-#if 0
-    if (value > 255){
-        return 255;
+    __m128i r, g, b, rg, bx;
+    wg_uint32 rgbx[8];
+    wg_uint i = 0;
+    wg_uint j = 0;
+
+    for (i = 0; i + 4 <= num; i += 4){
+        decode_8_sse2(_mm_loadu_si128((const __m128i*)in), &r, &g, &b);
+
+        rg = _mm_unpacklo_epi8(r, g);
+        bx = _mm_unpacklo_epi8(b, _mm_setzero_si128());
+        _mm_storeu_si128((__m128i*)&rgbx[0], _mm_unpacklo_epi16(rg, bx));
+        _mm_storeu_si128((__m128i*)&rgbx[4], _mm_unpackhi_epi16(rg, bx));
+
+        /* SSE2 can't shuffle bytes, drop X in scalar code */
+        for (j = 0; j < ELEMNUM(rgbx); ++j){
+            *out++ = rgbx[j];
+            *out++ = rgbx[j] >> 8;
+            *out++ = rgbx[j] >> 16;
+        }
+
+        in += 4 * YUYV_COMPONENT_NUM;
     }
-    else if (value < 0){
-        return 0;
+
+    yuyv_2_rgb24_c(in, out, num - i);
+
+    return;
+}
+
+SIMD_TARGET("sse2") WG_PRIVATE void
+yuyv_2_bgrx_sse2(const wg_uchar *in, wg_uchar *out, wg_uint num)
+{
+    __m128i r, g, b, bg, rx;
+    wg_uint i = 0;
+
+    for (i = 0; i + 4 <= num; i += 4){
+        decode_8_sse2(_mm_loadu_si128((const __m128i*)in), &r, &g, &b);
+
+        bg = _mm_unpacklo_epi8(b, g);
+        rx = _mm_unpacklo_epi8(r, _mm_setzero_si128());
+        _mm_storeu_si128((__m128i*)out, _mm_unpacklo_epi16(bg, rx));
+        _mm_storeu_si128((__m128i*)(out + 16), _mm_unpackhi_epi16(bg, rx));
+
+        in  += 4 * YUYV_COMPONENT_NUM;
+        out += 8 * BGRX_COMPONENT_NUM;
     }
 
-    return value;
-#endif
+    yuyv_2_bgrx_c(in, out, num - i);
+
+    return;
+}
+
+/** 
+* @brief Decode 16 pixels (32 bytes of YUYV)
+*
+* Each 128 bit lane is decoded as in decode_8_sse2().
+* 
+* @param in  YUYV data
+* @param r   red components in the low 8 bytes of each lane
+* @param g   green components in the low 8 bytes of each lane
+* @param b   blue components in the low 8 bytes of each lane
+*/
+SIMD_TARGET("avx2") WG_INLINE void
+decode_16_avx2(__m256i in, __m256i *r, __m256i *g, __m256i *b)
+{
+    const __m256i coff_r  = _mm256_set1_epi32(COFF_PAIR(298, 409));
+    const __m256i coff_gd = _mm256_set1_epi32(COFF_PAIR(298, -100));
+    const __m256i coff_ge = _mm256_set1_epi32(COFF_PAIR(-208, 1));
+    const __m256i coff_b  = _mm256_set1_epi32(COFF_PAIR(298, 516));
+    const __m256i round   = _mm256_set1_epi32(128);
+    const __m256i round16 = _mm256_set1_epi16(128);
+    __m256i y, uv, c, d, e;
+    __m256i lo, hi;
+
+    y  = _mm256_and_si256(in, _mm256_set1_epi16(0x00ff));
+    uv = _mm256_srli_epi16(in, 8);
+
+    c  = _mm256_sub_epi16(y, _mm256_set1_epi16(16));
+    uv = _mm256_sub_epi16(uv, round16);
+
+    d = _mm256_shufflehi_epi16(
+            _mm256_shufflelo_epi16(uv, _MM_SHUFFLE(2, 2, 0, 0)),
+            _MM_SHUFFLE(2, 2, 0, 0));
+    e = _mm256_shufflehi_epi16(
+            _mm256_shufflelo_epi16(uv, _MM_SHUFFLE(3, 3, 1, 1)),
+            _MM_SHUFFLE(3, 3, 1, 1));
+
+    lo = _mm256_add_epi32(
+            _mm256_madd_epi16(_mm256_unpacklo_epi16(c, e), coff_r), round);
+    hi = _mm256_add_epi32(
+            _mm256_madd_epi16(_mm256_unpackhi_epi16(c, e), coff_r), round);
+    lo = _mm256_packs_epi32(_mm256_srai_epi32(lo, 8), _mm256_srai_epi32(hi, 8));
+    *r = _mm256_packus_epi16(lo, lo);
+
+    lo = _mm256_add_epi32(
+            _mm256_madd_epi16(_mm256_unpacklo_epi16(c, d), coff_gd),
+            _mm256_madd_epi16(_mm256_unpacklo_epi16(e, round16), coff_ge));
+    hi = _mm256_add_epi32(
+            _mm256_madd_epi16(_mm256_unpackhi_epi16(c, d), coff_gd),
+            _mm256_madd_epi16(_mm256_unpackhi_epi16(e, round16), coff_ge));
+    lo = _mm256_packs_epi32(_mm256_srai_epi32(lo, 8), _mm256_srai_epi32(hi, 8));
+    *g = _mm256_packus_epi16(lo, lo);
+
+    lo = _mm256_add_epi32(
+            _mm256_madd_epi16(_mm256_unpacklo_epi16(c, d), coff_b), round);
+    hi = _mm256_add_epi32(
+            _mm256_madd_epi16(_mm256_unpackhi_epi16(c, d), coff_b), round);
+    lo = _mm256_packs_epi32(_mm256_srai_epi32(lo, 8), _mm256_srai_epi32(hi, 8));
+    *b = _mm256_packus_epi16(lo, lo);
+
+    return;
+}
+
+SIMD_TARGET("avx2") WG_PRIVATE void
+yuyv_2_rgb24_avx2(const wg_uchar *in, wg_uchar *out, wg_uint num)
+{
+    const __m256i drop_x = _mm256_setr_epi8(
+            0, 1, 2, 4, 5, 6, 8, 9, 10, 12, 13, 14, -1, -1, -1, -1,
+            0, 1, 2, 4, 5, 6, 8, 9, 10, 12, 13, 14, -1, -1, -1, -1);
+    __m256i r, g, b, rg, bx, p0, p1;
+    wg_uint i = 0;
+
+    /* every store writes 4 bytes past the 12 valid ones, keep at least 
+     * one macropixel for the portable tail */
+    for (i = 0; i + 8 < num; i += 8){
+        decode_16_avx2(_mm256_loadu_si256((const __m256i*)in), &r, &g, &b);
+
+        rg = _mm256_unpacklo_epi8(r, g);
+        bx = _mm256_unpacklo_epi8(b, _mm256_setzero_si256());
+
+        /* lanes hold pixels 0-3 | 8-11 and 4-7 | 12-15 */
+        p0 = _mm256_shuffle_epi8(_mm256_unpacklo_epi16(rg, bx), drop_x);
+        p1 = _mm256_shuffle_epi8(_mm256_unpackhi_epi16(rg, bx), drop_x);
+
+        _mm_storeu_si128((__m128i*)(out +  0), _mm256_castsi256_si128(p0));
+        _mm_storeu_si128((__m128i*)(out + 12), _mm256_castsi256_si128(p1));
+        _mm_storeu_si128((__m128i*)(out + 24), 
+                _mm256_extracti128_si256(p0, 1));
+        _mm_storeu_si128((__m128i*)(out + 36), 
+                _mm256_extracti128_si256(p1, 1));
+
+        in  += 8 * YUYV_COMPONENT_NUM;
+        out += 16 * RGB24_COMPONENT_NUM;
+    }
+
+    yuyv_2_rgb24_c(in, out, num - i);
+
+    return;
 }
 
+SIMD_TARGET("avx2") WG_PRIVATE void
+yuyv_2_bgrx_avx2(const wg_uchar *in, wg_uchar *out, wg_uint num)
+{
+    __m256i r, g, b, bg, rx, p0, p1;
+    wg_uint i = 0;
+
+    for (i = 0; i + 8 <= num; i += 8){
+        decode_16_avx2(_mm256_loadu_si256((const __m256i*)in), &r, &g, &b);
+
+        bg = _mm256_unpacklo_epi8(b, g);
+        rx = _mm256_unpacklo_epi8(r, _mm256_setzero_si256());
+
+        /* lanes hold pixels 0-3 | 8-11 and 4-7 | 12-15 */
+        p0 = _mm256_unpacklo_epi16(bg, rx);
+        p1 = _mm256_unpackhi_epi16(bg, rx);
+
+        _mm256_storeu_si256((__m256i*)out, 
+                _mm256_permute2x128_si256(p0, p1, 0x20));
+        _mm256_storeu_si256((__m256i*)(out + 32), 
+                _mm256_permute2x128_si256(p0, p1, 0x31));
+
+        in  += 8 * YUYV_COMPONENT_NUM;
+        out += 16 * BGRX_COMPONENT_NUM;
+    }
+
+    yuyv_2_bgrx_c(in, out, num - i);
+
+    return;
+}
+
+#endif /* IMG_X86_SIMD */
+
 /*! @} */
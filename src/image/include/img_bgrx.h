@@ -3,6 +3,8 @@
 
 typedef wg_uint32 bgrx_pixel;
 
+#define BGRX_COMPONENT_NUM    4
+
 #define BGRX_R_SHIFT   16
 #define BGRX_G_SHIFT   8
 #define BGRX_B_SHIFT   0
@@ -21,7 +23,27 @@ typedef wg_uint32 bgrx_pixel;
 #define BGRX_R(bgrx)                          \
     (((wg_uint32)(bgrx) >> (BGRX_R_SHIFT)) & 0xff)            
 
+/** @brief Number of entries in RGB565 classification table */
+#define IMG_RGB565_LUT_SIZE   (1 << 16)
+
+/** @brief Index of a BGRX color in RGB565 classification table */
+#define BGRX_2_RGB565(bgrx)                                     \
+    ((((wg_uint32)(bgrx) >> 8) & 0xf800) |                      \
+     (((wg_uint32)(bgrx) >> 5) & 0x07e0) |                      \
+     (((wg_uint32)(bgrx) >> 3) & 0x001f))
+
 WG_PUBLIC wg_status
 img_bgrx_median_filter(Wg_image *img, Wg_image *new_img);
 
+WG_PUBLIC wg_status
+img_bgrx_median_filter_noalloc(Wg_image *img, Wg_image *new_img);
+
+WG_PUBLIC wg_status
+img_bgrx_lut_mask_noalloc(const Wg_image *img, Wg_image *mask, 
+        const gray_pixel *lut);
+
+WG_PUBLIC wg_status
+img_bgrx_lut_bitmask_noalloc(const Wg_image *img, Wg_image *mask, 
+        const gray_pixel *lut);
+
 #endif
@@ -0,0 +1,101 @@
+#ifndef _CAM_IMG_BITMASK_H
+#define _CAM_IMG_BITMASK_H
+
+/**
+* @brief Word of a bit mask row, bit n is pixel n of the word
+*/
+typedef wg_uint64 bitmask_word;
+
+/** Number of pixels in a bit mask word */
+#define BITMASK_WORD_BITS      64
+
+/** Components per pixel passed to img_fill() for IMG_BITMASK images */
+#define BITMASK_COMPONENT_NUM  0
+
+/** Number of words in a row of width pixels */
+#define BITMASK_ROW_WORDS(width)                                     \
+    (((width) + BITMASK_WORD_BITS - 1) / BITMASK_WORD_BITS)
+
+/** Number of bytes in a row of width pixels */
+#define BITMASK_ROW_SIZE(width)                                      \
+    (BITMASK_ROW_WORDS(width) * sizeof (bitmask_word))
+
+/**
+* @brief Get bits of the last row word which hold pixels
+*
+* Bits behind the last pixel of a row are always 0.
+*
+* @param width  width in pixels
+*
+* @return mask of pixel bits
+*/
+WG_INLINE bitmask_word
+bitmask_tail(wg_uint width)
+{
+    return (0 == (width % BITMASK_WORD_BITS)) ? ~(bitmask_word)0 :
+        ((bitmask_word)1 << (width % BITMASK_WORD_BITS)) - 1;
+}
+
+/**
+* @brief Check if a pixel of a bit mask is set
+*
+* @param img  IMG_BITMASK image
+* @param row  row of the pixel
+* @param col  column of the pixel
+*
+* @return WG_TRUE if set
+*/
+WG_INLINE wg_boolean
+img_bitmask_get(const Wg_image *img, wg_uint row, wg_uint col)
+{
+    const bitmask_word *word = (const bitmask_word*)img->rows[row];
+
+    return (word[col / BITMASK_WORD_BITS] >> (col % BITMASK_WORD_BITS)) & 1;
+}
+
+/**
+* @brief Get 64 pixels of a row starting shift pixels behind word i
+*
+* @param row    first word of the row
+* @param i      word index
+* @param words  number of words in the row
+* @param shift  offset in pixels, lower than BITMASK_WORD_BITS
+*
+* @return pixels i * 64 + shift up to i * 64 + shift + 63
+*/
+WG_INLINE bitmask_word
+bitmask_word_at(const bitmask_word *row, wg_uint i, wg_uint words,
+        wg_uint shift)
+{
+    bitmask_word bits = row[i] >> shift;
+
+    if ((0 != shift) && (i + 1 < words)){
+        bits |= row[i + 1] << (BITMASK_WORD_BITS - shift);
+    }
+
+    return bits;
+}
+
+WG_PUBLIC wg_status
+img_bitmask_from_gs_noalloc(const Wg_image *gs_img, Wg_image *mask);
+
+WG_PUBLIC wg_status
+img_bitmask_2_gs_noalloc(const Wg_image *mask, Wg_image *gs_img);
+
+WG_PUBLIC wg_status
+img_bitmask_erode_noalloc(const Wg_image *img, Wg_image *new_img);
+
+WG_PUBLIC wg_status
+img_bitmask_dilate_noalloc(const Wg_image *img, Wg_image *new_img);
+
+WG_PUBLIC wg_status
+img_bitmask_boundary_noalloc(const Wg_image *img, Wg_image *new_img);
+
+WG_PUBLIC wg_status
+img_bitmask_smooth_noalloc(const Wg_image *img, Wg_image *new_img);
+
+WG_PUBLIC wg_status
+img_bitmask_center(const Wg_image *img, wg_uint *y, wg_uint *x,
+        wg_uint *num);
+
+#endif
@@ -44,6 +44,12 @@ img_gs_histogram(Wg_image* grayscale_img, wg_uint *histogram,
 WG_PUBLIC wg_status
 img_gs_save(Wg_image *img, wg_char *filename, wg_char *ext);
 
+WG_PUBLIC wg_status
+img_gs_median_filter(Wg_image *img, Wg_image *new_img);
+
+WG_PUBLIC wg_status
+img_gs_median_filter_noalloc(Wg_image *img, Wg_image *new_img);
+
 
 #endif
 
@@ -15,6 +15,24 @@ typedef struct Hsv{
 WG_PUBLIC wg_status
 img_hsv_filter(const Wg_image *img, Wg_image *filtered_img, va_list args);
 
+WG_PUBLIC wg_status
+img_hsv_filter_noalloc(const Wg_image *img, Wg_image *filtered_img, 
+        va_list args);
+
+WG_PUBLIC wg_status
+img_hsv_range_mask(const Wg_image *img, Wg_image *mask, 
+        const Hsv *top, const Hsv *bottom);
+
+WG_PUBLIC wg_status
+img_hsv_range_mask_noalloc(const Wg_image *img, Wg_image *mask, 
+        const Hsv *top, const Hsv *bottom);
+
+WG_PUBLIC wg_status
+img_hsv_range_rgb565_lut(const Hsv *top, const Hsv *bottom, gray_pixel *lut);
+
+WG_PUBLIC wg_status
+img_hsv_range_ycbcr_lut(const Hsv *top, const Hsv *bottom, gray_pixel *lut);
+
 WG_PUBLIC wg_status
 img_hsv_hist(Wg_image *img, wg_uint **h, wg_uint **s, wg_uint **v,
                   wg_size *hs, wg_size *ss, wg_size *vs);
@@ -0,0 +1,56 @@
+#ifndef _CAM_HSV8_H
+#define _CAM_HSV8_H
+
+/** 
+* @brief Packed HSV color representation
+*
+* Each component is scaled from [0, 1] to [0, 255].
+*/
+typedef struct Hsv8{
+    wg_uint8 hue;       /*!< hue                       */
+    wg_uint8 sat;       /*!< Struration                */
+    wg_uint8 val;       /*!< value                     */
+    wg_uint8 pad;       /*!< keeps pixel 4 bytes long  */
+}Hsv8;
+
+#define HSV8_COMPONENT_NUM (sizeof (Hsv8))
+
+/** @brief Number of histogram bins for each component */
+#define HSV8_HIST_NUM      256
+
+WG_PUBLIC wg_status
+img_rgb_2_hsv8(Wg_image *rgb_img, Wg_image *hsv_img);
+
+WG_PUBLIC wg_status
+img_rgb_2_hsv8_noalloc(Wg_image *rgb_img, Wg_image *hsv_img);
+
+WG_PUBLIC wg_status
+img_bgrx_2_hsv8(Wg_image *bgrx_img, Wg_image *hsv_img);
+
+WG_PUBLIC wg_status
+img_bgrx_2_hsv8_noalloc(Wg_image *bgrx_img, Wg_image *hsv_img);
+
+WG_PUBLIC wg_status
+img_yuyv_2_hsv8(Wg_image *yuyv_img, Wg_image *hsv_img);
+
+WG_PUBLIC wg_status
+img_yuyv_2_hsv8_noalloc(Wg_image *yuyv_img, Wg_image *hsv_img);
+
+WG_PUBLIC wg_status
+img_hsv8_filter(const Wg_image *img, Wg_image *filtered_img, va_list args);
+
+WG_PUBLIC wg_status
+img_hsv8_filter_noalloc(const Wg_image *img, Wg_image *filtered_img, 
+        va_list args);
+
+WG_PUBLIC wg_status
+img_hsv8_hist(Wg_image *img, wg_uint **h, wg_uint **s, wg_uint **v,
+                  wg_size *hs, wg_size *ss, wg_size *vs);
+
+WG_PUBLIC wg_status
+img_hsv8_median_filter(Wg_image *img, Wg_image *new_img);
+
+WG_PUBLIC wg_status
+img_hsv8_normalize(Wg_image *img);
+
+#endif /* _CAM_HSV8_H */
@@ -1,11 +1,48 @@
 #ifndef _CAM_IMG_JPEG_H
 #define _CAM_IMG_JPEG_H
 
+/** @brief JPEG decoder kept between images, see img_jpeg_decoder_init() */
+typedef struct Img_jpeg_decoder Img_jpeg_decoder;
+
 
 WG_PUBLIC wg_status
 img_jpeg_decompress(wg_uchar *in_buffer, wg_ssize in_size,
         wg_uint width, wg_uint height, Wg_image *img);
 
+WG_PUBLIC wg_status
+img_jpeg_decompress_noalloc(wg_uchar *in_buffer, wg_ssize in_size,
+        wg_uint width, wg_uint height, Wg_image *img);
+
+WG_PUBLIC wg_status
+img_jpeg_decompress_bgrx_noalloc(wg_uchar *in_buffer, wg_ssize in_size,
+        wg_uint width, wg_uint height, Wg_image *img);
+
+WG_PUBLIC wg_status
+img_jpeg_decompress_ycbcr_noalloc(wg_uchar *in_buffer, wg_ssize in_size,
+        wg_uint width, wg_uint height, Wg_image *img);
+
+WG_PUBLIC wg_status
+img_jpeg_decoder_init(Img_jpeg_decoder **decoder);
+
+WG_PUBLIC void
+img_jpeg_decoder_cleanup(Img_jpeg_decoder *decoder);
+
+WG_PUBLIC wg_status
+img_jpeg_decoder_set_scale(Img_jpeg_decoder *decoder, wg_uint scale);
+
+WG_PUBLIC wg_status
+img_jpeg_decoder_get_size(const Img_jpeg_decoder *decoder, 
+        wg_uint width, wg_uint height, 
+        wg_uint *out_width, wg_uint *out_height);
+
+WG_PUBLIC wg_status
+img_jpeg_decoder_run(Img_jpeg_decoder *decoder, wg_uchar *in_buffer, 
+        wg_ssize in_size, Wg_image *img, img_type type);
+
+WG_PUBLIC wg_status
+img_jpeg_compress(const Wg_image *img, wg_uint quality, 
+        wg_uchar **out_buffer, wg_size *out_size);
+
 
 
 #endif
@@ -0,0 +1,39 @@
+#ifndef _CAM_IMG_MEDIAN_H
+#define _CAM_IMG_MEDIAN_H
+
+/** @brief Largest radius of img_hue_median_filter() window */
+#define IMG_HUE_MEDIAN_RADIUS_MAX   127
+
+/** 
+* @brief Work memory of img_hue_median_filter_noalloc()
+*
+* Kept by the caller between frames, memory grows only when the image or
+* the number of bands grows.
+*/
+typedef struct Img_hue_median{
+    wg_uchar *hue;              /*!< quantized hue plane                */
+    wg_size hue_size;           /*!< bytes allocated for hue            */
+    struct Hue_band *band;      /*!< row bands                          */
+    wg_uint band_capacity;      /*!< number of allocated bands          */
+    struct Hue_hist *column;    /*!< column histograms of all bands     */
+    wg_size column_capacity;    /*!< number of allocated histograms     */
+}Img_hue_median;
+
+WG_PUBLIC wg_status
+img_median_filter_noalloc(const Wg_image *img, Wg_image *new_img);
+
+WG_PUBLIC wg_status
+img_hue_median_filter(const Wg_image *img, Wg_image *new_img, 
+        wg_uint radius, wg_uint bands);
+
+WG_PUBLIC void
+img_hue_median_init(Img_hue_median *median);
+
+WG_PUBLIC void
+img_hue_median_cleanup(Img_hue_median *median);
+
+WG_PUBLIC wg_status
+img_hue_median_filter_noalloc(const Wg_image *img, Wg_image *new_img, 
+        wg_uint radius, wg_uint bands, Img_hue_median *median);
+
+#endif
@@ -52,9 +52,15 @@ img_rgb_2_hsv_fast(Wg_image *rgb_img, Wg_image *hsv_img);
 WG_PUBLIC wg_status
 img_rgb_2_bgrx(Wg_image *rgb_img, Wg_image *bgrx_img);
 
+WG_PUBLIC wg_status
+img_rgb_2_bgrx_noalloc(Wg_image *rgb_img, Wg_image *bgrx_img);
+
 WG_PUBLIC wg_status
 img_rgb_2_hsv_gtk(Wg_image *rgb_img, Wg_image *hsv_img);
 
+WG_PUBLIC wg_status
+img_rgb_2_hsv_gtk_noalloc(Wg_image *rgb_img, Wg_image *hsv_img);
+
 WG_PUBLIC wg_status
 img_rgb_2_grayscale(Wg_image *rgb_img, Wg_image *grayscale_img);
 
@@ -68,6 +74,9 @@ img_rgb_median_filter(Wg_image *img, Wg_image *new_img);
 WG_PUBLIC wg_status
 img_bgrx_2_rgb(Wg_image *bgrx_img, Wg_image *rgb_img);
 
+WG_PUBLIC wg_status
+img_bgrx_2_rgb_noalloc(Wg_image *bgrx_img, Wg_image *rgb_img);
+
 WG_PUBLIC wg_status
 img_hsv_2_rgb(Wg_image *hsv_img, Wg_image *rgb_img);
 
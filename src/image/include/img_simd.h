@@ -0,0 +1,19 @@
+#ifndef _CAM_IMG_SIMD_H
+#define _CAM_IMG_SIMD_H
+
+/* 
+ * Private to the image library. Vector routines are compiled per function
+ * with target attributes and selected at runtime with img_simd_level().
+ */
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+
+/** @brief vector routines are available */
+#define IMG_X86_SIMD
+
+/** @brief compile function for given instruction set */
+#define SIMD_TARGET(isa)  __attribute__((target(isa)))
+#endif
+
+#endif
@@ -0,0 +1,79 @@
+#ifndef _CAM_IMG_YCBCR_H
+#define _CAM_IMG_YCBCR_H
+
+/**
+* @brief YCbCr pixel components layout
+*/
+enum {
+    YCBCR_Y = 0,          /*!< luminance                                    */
+    YCBCR_CB   ,          /*!< blue difference                              */
+    YCBCR_CR   ,          /*!< red difference                               */
+    YCBCR_COMPONENT_NUM   /*!< number of components in YCbCr pixel format   */
+};
+
+/** @brief Number of entries in YCbCr classification table */
+#define IMG_YCBCR_LUT_SIZE   (1 << 16)
+
+/**
+* @brief Index of a YCbCr color in classification table
+*
+* Y is quantized to 4 bits, Cb and Cr to 6 bits. Hue and saturation depend
+* on chroma only so it gets more bits.
+*/
+#define IMG_YCBCR_LUT_INDEX(y, cb, cr)                         \
+    ((((wg_uint)(y) >> 4) << 12) | (((wg_uint)(cb) >> 2) << 6) | \
+     ((wg_uint)(cr) >> 2))
+
+/**
+* @brief Convert one full range YCbCr pixel to RGB
+*
+* JFIF formula used by libjpeg, coefficients are scaled by 2^16.
+*
+* @param y    luminance
+* @param cb   blue difference
+* @param cr   red difference
+* @param rgb  memory to store RGB24 pixel
+*/
+WG_INLINE void
+ycbcr_2_rgb(wg_int y, wg_int cb, wg_int cr, rgb24_pixel rgb)
+{
+    wg_int d = cb - 128;
+    wg_int e = cr - 128;
+
+    rgb[RGB24_R] = WG_MIN(255, WG_MAX(0, y + ((91881 * e + 32768) >> 16)));
+    rgb[RGB24_G] = WG_MIN(255, WG_MAX(0,
+                y + ((-22554 * d - 46802 * e + 32768) >> 16)));
+    rgb[RGB24_B] = WG_MIN(255, WG_MAX(0, y + ((116130 * d + 32768) >> 16)));
+
+    return;
+}
+
+WG_PUBLIC wg_status
+img_yuyv_2_ycbcr(wg_uchar *in_buffer, wg_ssize in_size,
+        wg_uint width, wg_uint height, Wg_image *img);
+
+WG_PUBLIC wg_status
+img_yuyv_2_ycbcr_noalloc(wg_uchar *in_buffer, wg_ssize in_size,
+        wg_uint width, wg_uint height, Wg_image *img);
+
+WG_PUBLIC wg_status
+img_ycbcr_lut_mask(const Wg_image *img, Wg_image *mask,
+        const gray_pixel *lut);
+
+WG_PUBLIC wg_status
+img_ycbcr_lut_mask_noalloc(const Wg_image *img, Wg_image *mask,
+        const gray_pixel *lut);
+
+WG_PUBLIC wg_status
+img_yuyv_lut_mask_noalloc(const Wg_image *img, Wg_image *mask,
+        const gray_pixel *lut);
+
+WG_PUBLIC wg_status
+img_ycbcr_lut_bitmask_noalloc(const Wg_image *img, Wg_image *mask,
+        const gray_pixel *lut);
+
+WG_PUBLIC wg_status
+img_yuyv_lut_bitmask_noalloc(const Wg_image *img, Wg_image *mask,
+        const gray_pixel *lut);
+
+#endif
@@ -2,19 +2,56 @@
 #define _CAM_IMG_YUYV_H
 
 /** 
-* @brief 
+* @brief Byte positions in a YUYV macropixel, V4L2 stores Y0 Cb Y1 Cr
 */
 enum {
     POS_Y0 = 0,  /*!< YO position */ 
-    POS_V     ,  /*!< V  position */
+    POS_U     ,  /*!< U (Cb) position */
     POS_Y1    ,  /*!< Y1 position */
-    POS_U     ,  /*!< U  position */
+    POS_V     ,  /*!< V (Cr) position */
     YUYV_COMPONENT_NUM  /*!< number of components per pixel in YUYV image */
 };
 
+/** 
+* @brief Convert one YUYV pixel to RGB
+*
+* Uses the same integer formula as img_yuyv_2_rgb24().
+* 
+* @param y    luminance of the pixel
+* @param u    U component shared by the pixel pair
+* @param v    V component shared by the pixel pair
+* @param rgb  memory to store RGB24 pixel
+*/
+WG_INLINE void
+yuyv_2_rgb(wg_int y, wg_int u, wg_int v, rgb24_pixel rgb)
+{
+    wg_int c = y - 16;
+    wg_int d = u - 128;
+    wg_int e = v - 128;
+
+    rgb[RGB24_R] = WG_MIN(255, WG_MAX(0, (298 * c + 409 * e + 128) >> 8));
+    rgb[RGB24_G] = WG_MIN(255, WG_MAX(0, 
+                (298 * c - 100 * d - 208 * e + 128) >> 8));
+    rgb[RGB24_B] = WG_MIN(255, WG_MAX(0, (298 * c + 516 * d + 128) >> 8));
+
+    return;
+}
+
 WG_PUBLIC wg_status
 img_yuyv_2_rgb24(wg_uchar *in_buffer, wg_ssize in_size, 
         wg_uint width, wg_uint height, Wg_image *img);
 
+WG_PUBLIC wg_status
+img_yuyv_2_rgb24_noalloc(wg_uchar *in_buffer, wg_ssize in_size, 
+        wg_uint width, wg_uint height, Wg_image *img);
+
+WG_PUBLIC wg_status
+img_yuyv_2_bgrx(wg_uchar *in_buffer, wg_ssize in_size, 
+        wg_uint width, wg_uint height, Wg_image *img);
+
+WG_PUBLIC wg_status
+img_yuyv_2_bgrx_noalloc(wg_uchar *in_buffer, wg_ssize in_size, 
+        wg_uint width, wg_uint height, Wg_image *img);
+
 
 #endif
@@ -3,11 +3,16 @@
 
 #include <linux/videodev2.h>
 
+#include <wg_time.h>
+
 #define DEV_PATH_MAX   64
 
 /*! Number of buffers to allocate for streaming mode */
 #define DEFAULT_BUFFER_NUM 25
 
+/*! Smallest number of buffers the streaming mode works with */
+#define MIN_BUFFER_NUM     2
+
 
 enum {CAM_FMT_CAPTURE, CAM_FMT_NUM};
 
@@ -19,11 +24,21 @@ typedef enum CAM_MODE {
     CAM_MODE_INVALID     = 0,       /*!< Invalid mode   */
     CAM_MODE_STREAMING      ,       /*!< Streaming mode */
     CAM_MODE_READWRITE      ,       /*!< Read mode      */
+    CAM_MODE_REPLAY         ,       /*!< Replay of a recording file */
     CAM_MODE_UNKNOWN                /*!< Unknown mode   */
 }CAM_MODE;
 
+/**
+ * @brief Pacing of a replayed recording
+ */
+typedef enum Cam_replay_pace{
+    CAM_REPLAY_REALTIME = 0,        /*!< frames come at recorded intervals */
+    CAM_REPLAY_FAST                 /*!< frames come as fast as read       */
+}Cam_replay_pace;
+
 typedef enum CAM_FLAGS {
-    ENABLE_DECOMPRESSOR = 1<<0
+    ENABLE_DECOMPRESSOR = 1<<0,
+    ENABLE_USERPTR      = 1<<1     /*!< stream into user allocated buffers */
 }CAM_FLAGS;
 
 #define IS_FLAG_SET(flag, flag_name)          \
@@ -54,10 +69,13 @@ typedef enum cam_state{
 typedef struct Wg_cam_buf{
         void   *start;     /*!< Start of the buffer         */
         size_t length;     /*!< Number of bytes in a buffer */
+        Wg_image image;    /*!< Buffer seen as an image, uncompressed 
+                                formats only */
 }Wg_cam_buf;
 
 typedef struct Wg_camera Wg_camera;
 typedef struct Wg_frame Wg_frame;
+typedef struct Wg_cam_replay Wg_cam_replay;
 
 /**
  * @brief Camera operations
@@ -98,6 +116,9 @@ typedef wg_status
  */
 typedef struct Wg_cam_decompressor{
     cam_decomp run;  /*!< pointer to a decompressor function */
+    cam_decomp run_noalloc; /*!< decompressor writing into caller image */
+    cam_decomp run_bgrx;    /*!< decompressor writing into caller BGRX image */
+    cam_decomp run_ycbcr;   /*!< decompressor writing into caller YCbCr image */
 }Wg_cam_decompressor;
 
 
@@ -113,6 +134,15 @@ struct Wg_camera{
     struct v4l2_format fmt[CAM_FMT_NUM];   /*!< Selected format           */
     Wg_cam_buf *buffers;                   /*!< Buffers used by streaming */
     size_t buf_num;                        /*!< Number of buffers         */
+    enum v4l2_memory memory;               /*!< Memory of stream buffers  */
+    wg_uint buf_request;                   /*!< Buffers to ask for, 0 
+                                                means DEFAULT_BUFFER_NUM  */
+    wg_boolean newest_frame;               /*!< Read only the newest frame*/
+    wg_uint dropped;                       /*!< Frames skipped by read    */
+    wg_uint32 sequence;                    /*!< Frames read by read()     */
+    Wg_cam_replay *replay;                 /*!< Replayed recording        */
+    Cam_replay_pace replay_pace;           /*!< Pacing of the replay      */
+    wg_boolean replay_loop;                /*!< Replay again at the end   */
     Wg_cam_ops cam_ops;                    /*!< Camera operations         */
     Wg_cam_decompressor dcomp;             /*!< Selected decompressor     */
 };
@@ -131,6 +161,36 @@ WG_INLINE  cam_status invoke_decompressor(
     return decomp->run(in_buffer, in_size, width, height, img);
 }
 
+WG_INLINE  cam_status invoke_decompressor_noalloc(
+        Wg_cam_decompressor *decomp,
+        wg_uchar *in_buffer, wg_ssize in_size, 
+        wg_uint width, wg_uint height, Wg_image *img)
+{
+    CHECK_FOR_NULL_PARAM(decomp);
+
+    return decomp->run_noalloc(in_buffer, in_size, width, height, img);
+}
+
+WG_INLINE  cam_status invoke_decompressor_bgrx(
+        Wg_cam_decompressor *decomp,
+        wg_uchar *in_buffer, wg_ssize in_size, 
+        wg_uint width, wg_uint height, Wg_image *img)
+{
+    CHECK_FOR_NULL_PARAM(decomp);
+
+    return decomp->run_bgrx(in_buffer, in_size, width, height, img);
+}
+
+WG_INLINE  cam_status invoke_decompressor_ycbcr(
+        Wg_cam_decompressor *decomp,
+        wg_uchar *in_buffer, wg_ssize in_size, 
+        wg_uint width, wg_uint height, Wg_image *img)
+{
+    CHECK_FOR_NULL_PARAM(decomp);
+
+    return decomp->run_ycbcr(in_buffer, in_size, width, height, img);
+}
+
 
 WG_PUBLIC 
 cam_status cam_init(Wg_camera *cam, const wg_char* dev_path);
@@ -165,9 +225,24 @@ cam_set_resolution(Wg_camera *cam, wg_uint width, wg_uint height);
 WG_PUBLIC cam_status
 cam_get_resolution(Wg_camera *cam, wg_uint *width, wg_uint *height);
 
+WG_PUBLIC cam_status
+cam_set_buffer_num(Wg_camera *cam, wg_uint num);
+
+WG_PUBLIC cam_status
+cam_set_newest_frame(Wg_camera *cam, wg_boolean enable);
+
+WG_PUBLIC cam_status
+cam_get_dropped_frames(Wg_camera *cam, wg_uint *dropped);
+
+WG_PUBLIC cam_status
+cam_set_replay_pace(Wg_camera *cam, Cam_replay_pace pace, wg_boolean loop);
+
 WG_PUBLIC cam_status
 cam_frame_init(Wg_frame *frame);
 
+WG_PUBLIC cam_status
+cam_frame_image(Wg_camera *cam, const Wg_frame *frame, Wg_image *img);
+
 WG_PUBLIC wg_boolean
 cam_is_camera(wg_char *path);
 
@@ -175,5 +250,9 @@ cam_is_camera(wg_char *path);
 #include "../cam/include/cam_format_selector.h"
 #include "../cam/include/cam_frame.h"
 #include "../cam/include/cam_output.h"
+#include "../cam/include/cam_readwrite.h"
+#include "../cam/include/cam_negotiate.h"
+#include "../cam/include/cam_replay.h"
+#include "../cam/include/cam_recorder.h"
 
 #endif
@@ -2,6 +2,9 @@
 #define _IMG_H
 
 #include <gdk/gdk.h>
+#include <pthread.h>
+
+#include <wg_time.h>
 
 /** 
 * @brief Supported image formats
@@ -13,6 +16,9 @@ typedef enum img_type {
     IMG_YUYV    ,    /*!< YUYV                                       */
     IMG_HSV     ,    /*!< HSV                                        */
     IMG_GS      ,    /*!< Grayscale                                  */
+    IMG_HSV8    ,    /*!< HSV packed in 4 bytes                      */
+    IMG_YCBCR   ,    /*!< full range Y, Cb, Cr as written by libjpeg */
+    IMG_BITMASK ,    /*!< 1 bit per pixel packed in 64 bit words      */
     IMG_USER         /*!< User defined                               */
 } img_type;
 
@@ -28,9 +34,29 @@ typedef struct Wg_image{
     wg_uint  height;       /*!< height in pixels                       */
     wg_uint  row_distance; /*!< distanse in bytes between rows         */
     wg_uint  components_per_pixel; /*!< number of components per pixel */
+    Wg_timestamp stamp;    /*!< capture time of the source frame       */
 }Wg_image;
 
 
+/** 
+* @brief Vector instruction set used by image kernels
+*/
+typedef enum Img_simd{
+    IMG_SIMD_NONE   ,    /*!< portable C                                 */
+    IMG_SIMD_SSE2   ,    /*!< SSE2                                       */
+    IMG_SIMD_AVX2        /*!< AVX2                                       */
+}Img_simd;
+
+/** 
+* @brief Pool of images recycled between frames
+*/
+typedef struct Img_pool{
+    Wg_image *image;       /*!< free images                            */
+    wg_uint  num;          /*!< number of free images                  */
+    wg_uint  capacity;     /*!< maximum number of free images          */
+    pthread_mutex_t lock;  /*!< pool lock                              */
+}Img_pool;
+
 /** 
 * @brief Image iterator
 */
@@ -280,6 +306,36 @@ img_get_data(Wg_image *img, wg_uchar **data, wg_size *num, wg_size *size)
     return WG_SUCCESS;
 }
 
+/** 
+* @brief Check if image has expected geometry
+*
+* Used by functions writing into an image allocated by the caller.
+* 
+* @param img       image instance
+* @param width     expected width
+* @param height    expected height
+* @param comp_num  expected number of components per pixel
+* 
+* @retval WG_SUCCESS
+* @retval WG_FAILURE
+*/
+WG_INLINE wg_status
+img_check_geometry(const Wg_image *img, wg_uint width, wg_uint height,
+        wg_uint comp_num)
+{
+    CHECK_FOR_NULL_PARAM(img);
+
+    if ((img->width != width) || (img->height != height) ||
+        (img->components_per_pixel != comp_num)){
+        WG_ERROR("Invalid image geometry! Passed %ux%ux%u expect %ux%ux%u\n",
+                img->width, img->height, img->components_per_pixel,
+                width, height, comp_num);
+        return WG_FAILURE;
+    }
+
+    return WG_SUCCESS;
+}
+
 wg_status
 img_fill(wg_uint width, wg_uint height, wg_uint comp_num, img_type,
         Wg_image *img);
@@ -287,10 +343,22 @@ img_fill(wg_uint width, wg_uint height, wg_uint comp_num, img_type,
 WG_PUBLIC wg_status
 img_cleanup(Wg_image *img);
 
+WG_PUBLIC wg_status
+img_attach(wg_uchar *data, wg_uint width, wg_uint height, wg_uint comp_num, 
+        img_type type, Wg_image *img);
+
+WG_PUBLIC wg_status
+img_detach(Wg_image *img);
+
 WG_PUBLIC wg_status
 img_get_subimage(Wg_image *img_src, wg_uint x, wg_uint y, 
         Wg_image *img_dest);
 
+WG_PUBLIC wg_status
+img_get_subimage_view(const Wg_image *img_src, wg_uint x, wg_uint y, 
+        wg_uint width, wg_uint height, wg_uchar **row_array, 
+        Wg_image *img_view);
+
 wg_status
 img_convert_to_pixbuf(Wg_image *img, GdkPixbuf **pixbuf,
         void (*free_cb)(guchar *, gpointer));
@@ -298,16 +366,39 @@ img_convert_to_pixbuf(Wg_image *img, GdkPixbuf **pixbuf,
 WG_PUBLIC wg_status
 img_copy(Wg_image *src, Wg_image *dest);
 
+WG_PUBLIC Img_simd
+img_simd_level(void);
+
+WG_PUBLIC Img_simd
+img_simd_set_level(Img_simd level);
+
+WG_PUBLIC wg_status
+img_pool_init(Img_pool *pool, wg_uint capacity);
+
+WG_PUBLIC void
+img_pool_cleanup(Img_pool *pool);
+
+WG_PUBLIC wg_status
+img_pool_acquire(Img_pool *pool, wg_uint width, wg_uint height, 
+        wg_uint comp_num, img_type type, Wg_image *img);
+
+WG_PUBLIC wg_status
+img_pool_release(Img_pool *pool, Wg_image *img);
+
 WG_PUBLIC void
 fast_memcpy(wg_uchar *restrict dest, wg_uchar *restrict src, 
         const wg_size size);
 
+#include "../image/include/img_gs.h"
 #include "../image/include/img_bgrx.h"
 #include "../image/include/img_draw.h"
-#include "../image/include/img_gs.h"
 #include "../image/include/img_hsv.h"
 #include "../image/include/img_jpeg.h"
+#include "../image/include/img_median.h"
 #include "../image/include/img_rgb24.h"
 #include "../image/include/img_yuyv.h"
+#include "../image/include/img_ycbcr.h"
+#include "../image/include/img_hsv8.h"
+#include "../image/include/img_bitmask.h"
 
 #endif
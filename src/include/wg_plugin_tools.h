@@ -1,6 +1,8 @@
 #ifndef _PLUGINS_TOOLS_H
 #define _PLUGINS_TOOLS_H
 
+#include <wg_time.h>
+
 /** 
 * @brief Message Transport
 */
@@ -12,7 +14,8 @@ WG_PUBLIC wg_status
 wg_msg_transport_init(wg_char *address, Wg_msg_transport *msg);
 
 WG_PUBLIC wg_status
-wg_msg_transport_send_hit(Wg_msg_transport *msg, wg_double x, wg_double y);
+wg_msg_transport_send_hit(Wg_msg_transport *msg, wg_double x, wg_double y,
+        const Wg_timestamp *stamp);
 
 WG_PUBLIC wg_status
 wg_msg_transport_cleanup(Wg_msg_transport *msg);
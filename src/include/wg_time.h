@@ -0,0 +1,59 @@
+#ifndef _WG_TIME_H
+#define _WG_TIME_H
+
+#include <time.h>
+#include <sys/time.h>
+
+/**
+* @brief Capture time of a frame
+*
+* Time is read from the monotonic clock, the same one V4L2 drivers use
+* for buffer timestamps, so it can be compared against wg_time_now().
+*/
+typedef struct Wg_timestamp{
+    wg_uint64 usec;       /*!< capture time in microseconds, 0 if unknown */
+    wg_uint32 sequence;   /*!< frame sequence number                      */
+}Wg_timestamp;
+
+/**
+* @brief Get current time of the monotonic clock
+*
+* @return time in microseconds
+*/
+WG_INLINE wg_uint64
+wg_time_now(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+
+    return (wg_uint64)ts.tv_sec * 1000000 + ts.tv_nsec / 1000;
+}
+
+/**
+* @brief Convert timeval to microseconds
+*
+* @param tv  time value
+*
+* @return time in microseconds
+*/
+WG_INLINE wg_uint64
+wg_time_from_timeval(const struct timeval *tv)
+{
+    return (wg_uint64)tv->tv_sec * 1000000 + tv->tv_usec;
+}
+
+/**
+* @brief Get microseconds elapsed since a frame was captured
+*
+* @param stamp  capture stamp
+*
+* @return elapsed time in microseconds, 0 if capture time is unknown
+*/
+WG_INLINE wg_uint64
+wg_time_since(const Wg_timestamp *stamp)
+{
+    return (0 == stamp->usec) ? 0 : wg_time_now() - stamp->usec;
+}
+
+#endif
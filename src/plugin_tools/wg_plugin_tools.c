@@ -15,6 +15,7 @@
 #include <wg.h>
 #include <wgtypes.h>
 #include <wgmacros.h>
+#include <wg_time.h>
 
 #include <wg_trans.h>
 #include <wg_string.h>
@@ -43,6 +44,11 @@ WG_PRIVATE wg_char hit_format[] =
             "<x>%.4lf</x>\n"
             "<y>%.4lf</y>\n"
         "</hit>\n"
+        "<frame>\n"
+            "<timestamp>%llu</timestamp>\n"
+            "<sequence>%u</sequence>\n"
+            "<latency>%llu</latency>\n"
+        "</frame>\n"
     "</event>\n"
     ;
 
@@ -75,22 +81,33 @@ wg_msg_transport_init(wg_char *address, Wg_msg_transport *msg)
 /** 
 * @brief Send 'Hit' message
 * 
-* @param msg  message transport instance
-* @param x    x coordinate of the event
-* @param y    y coordinate of the event
+* Frame element carries capture time of the frame the hit was found in,
+* its sequence number and microseconds elapsed since the capture.
+* 
+* @param msg    message transport instance
+* @param x      x coordinate of the event
+* @param y      y coordinate of the event
+* @param stamp  capture stamp of the frame, NULL if unknown
 * 
 * @retval WG_SUCCESS
 * @retval WG_FAILURE
 */
 wg_status
-wg_msg_transport_send_hit(Wg_msg_transport *msg, wg_double x, wg_double y)
+wg_msg_transport_send_hit(Wg_msg_transport *msg, wg_double x, wg_double y,
+        const Wg_timestamp *stamp)
 {
+    Wg_timestamp no_stamp;
     Wg_transport *trans = NULL;
     wg_status status = WG_FAILURE;
     wg_char *time_str = NULL;
 
     CHECK_FOR_NULL_PARAM(msg);
 
+    if (NULL == stamp){
+        memset(&no_stamp, '\0', sizeof (Wg_timestamp));
+        stamp = &no_stamp;
+    }
+
     trans = &msg->transport;
 
     /* connect transport */
@@ -105,7 +122,9 @@ wg_msg_transport_send_hit(Wg_msg_transport *msg, wg_double x, wg_double y)
     }
 
     /* send message */
-    status = transport_print(trans, hit_format, time_str, x, y);
+    status = transport_print(trans, hit_format, time_str, x, y,
+            (unsigned long long)stamp->usec, stamp->sequence,
+            (unsigned long long)wg_time_since(stamp));
     if (WG_SUCCESS != status){
         transport_disconnect(trans);
         return status;
@@ -57,13 +57,13 @@ main(int argc, char *argv[])
     for (i = 0; i < LOOP_NUM; ++i){
         get_random_coordinate(&x);
         get_random_coordinate(&y);
-        wg_msg_transport_send_hit(&msg_transport, x, y);
+        wg_msg_transport_send_hit(&msg_transport, x, y, NULL);
         get_random_coordinate(&x);
         get_random_coordinate(&y);
-        wg_msg_transport_send_hit(&msg_transport, x, y);
+        wg_msg_transport_send_hit(&msg_transport, x, y, NULL);
         get_random_coordinate(&x);
         get_random_coordinate(&y);
-        wg_msg_transport_send_hit(&msg_transport, x, y);
+        wg_msg_transport_send_hit(&msg_transport, x, y, NULL);
 
         sleep(DELAY_IN_SEC);
     }
@@ -0,0 +1,261 @@
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+#include <fcntl.h>
+
+#include <wgtypes.h>
+#include <wg.h>
+#include <wgmacros.h>
+#include <wg_linked_list.h>
+
+#include <img.h>
+#include <cam.h>
+
+#include <ut_tools.h>
+
+#define REC_PATH      "/tmp/ut_cam_recorder.wgr"
+
+/* ring holds about 15 frames, 60 frames wrap it several times */
+#define REC_AREA_SIZE 8192
+#define REC_FRAME_NUM 60
+
+#define REC_SEQUENCE  500
+
+WG_PRIVATE wg_uint
+frame_size(wg_uint index)
+{
+    return 100 + (index * 37) % 800;
+}
+
+WG_PRIVATE wg_boolean
+frame_check(const Wg_frame *frame, wg_uint index)
+{
+    wg_uint i = 0;
+
+    if (frame->size != frame_size(index)){
+        return WG_FALSE;
+    }
+
+    for (i = 0; i < frame->size; ++i){
+        if (frame->start[i] != (wg_uchar)(index + i)){
+            return WG_FALSE;
+        }
+    }
+
+    return WG_TRUE;
+}
+
+WG_PRIVATE wg_status
+record(void)
+{
+    static wg_uchar data[1024];
+    Wg_cam_recorder rec;
+    Wg_camera src;
+    Wg_frame frame;
+    wg_uint index = 0;
+    wg_uint i = 0;
+    cam_status status = CAM_FAILURE;
+
+    memset(&src, '\0', sizeof (Wg_camera));
+    src.fmt[CAM_FMT_CAPTURE].fmt.pix.width       = 64;
+    src.fmt[CAM_FMT_CAPTURE].fmt.pix.height      = 48;
+    src.fmt[CAM_FMT_CAPTURE].fmt.pix.pixelformat = V4L2_PIX_FMT_MJPEG;
+
+    if (cam_recorder_open(&rec, REC_PATH, REC_AREA_SIZE, &src) 
+            != CAM_SUCCESS){
+        return WG_FAILURE;
+    }
+
+    for (index = 0; index < REC_FRAME_NUM; ++index){
+        for (i = 0; i < frame_size(index); ++i){
+            data[i] = index + i;
+        }
+
+        memset(&frame, '\0', sizeof (Wg_frame));
+        frame.start          = data;
+        frame.size           = frame_size(index);
+        frame.stamp.usec     = 1000000 + index * 1000;
+        frame.stamp.sequence = REC_SEQUENCE + index;
+
+        /* every frame is recorded, wait for the recorder thread */
+        while ((status = cam_recorder_write(&rec, &frame)) == CAM_BUSY){
+            usleep(100);
+        }
+        if (CAM_SUCCESS != status){
+            cam_recorder_close(&rec);
+            return WG_FAILURE;
+        }
+    }
+
+    return (cam_recorder_close(&rec) == CAM_SUCCESS) ? 
+        WG_SUCCESS : WG_FAILURE;
+}
+
+WG_PRIVATE wg_status
+replay_open(Wg_camera *cam, Cam_replay_pace pace, wg_boolean loop)
+{
+    if (cam_init(cam, REC_PATH) != CAM_SUCCESS){
+        return WG_FAILURE;
+    }
+
+    cam_set_replay_pace(cam, pace, loop);
+
+    if (cam_open(cam, 0, 0) != CAM_SUCCESS){
+        return WG_FAILURE;
+    }
+
+    if (cam_start(cam) != CAM_SUCCESS){
+        cam_close(cam);
+        return WG_FAILURE;
+    }
+
+    return WG_SUCCESS;
+}
+
+WG_PRIVATE void
+replay_close(Wg_camera *cam)
+{
+    cam_stop(cam);
+    cam_close(cam);
+
+    return;
+}
+
+/* 
+ * ring keeps the newest frames in order, data, sizes and time between 
+ * frames survive the wrap of the write pointer
+ */
+UT_DEFINE(recorder_test_1)
+    Wg_camera cam;
+    Wg_frame frame;
+    wg_uint64 first_usec = 0;
+    wg_uint first = 0;
+    wg_uint index = 0;
+    wg_uint num = 0;
+    wg_uint bad = 0;
+    wg_uint64 used = 0;
+
+    UT_PASS_ON(record() == WG_SUCCESS)
+
+    UT_PASS_ON(replay_open(&cam, CAM_REPLAY_REALTIME, WG_FALSE) 
+            == WG_SUCCESS)
+
+    cam_frame_init(&frame);
+    while (cam_read(&cam, &frame) == CAM_SUCCESS){
+        /* oldest frame left in the ring is found by its size */
+        if (0 == num){
+            for (first = 0; first < REC_FRAME_NUM; ++first){
+                if (WG_TRUE == frame_check(&frame, first)){
+                    break;
+                }
+            }
+            first_usec = frame.stamp.usec;
+        }
+
+        index = first + num;
+
+        bad += (WG_FALSE == frame_check(&frame, index));
+        bad += (frame.stamp.sequence != num);
+        bad += (frame.stamp.usec - first_usec != num * 1000);
+        used += CAM_REC_SIZE(frame.size);
+
+        ++num;
+        cam_discard_frame(&cam, &frame);
+    }
+
+    replay_close(&cam);
+
+    UT_PASS_ON(num > 1)
+    UT_PASS_ON(first + num == REC_FRAME_NUM)
+    UT_PASS_ON(bad == 0)
+    UT_PASS_ON(used <= REC_AREA_SIZE)
+
+    /* older frame did not fit next to the kept ones */
+    UT_PASS_ON(used + CAM_REC_SIZE(frame_size(first - 1)) > REC_AREA_SIZE)
+UT_END
+
+/* looped replay continues sequence numbers of the previous pass */
+UT_DEFINE(recorder_test_2)
+    Wg_camera cam;
+    Wg_frame frame;
+    wg_uint num = 0;
+    wg_uint pass_num = 0;
+    wg_uint bad = 0;
+
+    UT_PASS_ON(record() == WG_SUCCESS)
+
+    /* frames of one pass */
+    UT_PASS_ON(replay_open(&cam, CAM_REPLAY_FAST, WG_FALSE) == WG_SUCCESS)
+    cam_frame_init(&frame);
+    while (cam_read(&cam, &frame) == CAM_SUCCESS){
+        ++pass_num;
+        cam_discard_frame(&cam, &frame);
+    }
+    replay_close(&cam);
+
+    UT_PASS_ON(replay_open(&cam, CAM_REPLAY_FAST, WG_TRUE) == WG_SUCCESS)
+    for (num = 0; num < 3 * pass_num; ++num){
+        cam_frame_init(&frame);
+        if (cam_read(&cam, &frame) != CAM_SUCCESS){
+            break;
+        }
+
+        bad += (frame.stamp.sequence != num);
+        bad += (WG_FALSE == 
+                frame_check(&frame, REC_FRAME_NUM - pass_num + num % pass_num));
+
+        cam_discard_frame(&cam, &frame);
+    }
+    replay_close(&cam);
+
+    UT_PASS_ON(num == 3 * pass_num)
+    UT_PASS_ON(bad == 0)
+UT_END
+
+/* files which are not recordings are not replayed */
+UT_DEFINE(recorder_test_3)
+    Wg_camera cam;
+    Cam_rec_header header;
+    int fd = -1;
+
+    UT_PASS_ON(record() == WG_SUCCESS)
+
+    fd = open(REC_PATH, O_RDWR);
+    UT_PASS_ON(fd != -1)
+    UT_PASS_ON(pread(fd, &header, sizeof (header), 0) == sizeof (header))
+
+    /* wrong magic */
+    header.magic = ~header.magic;
+    UT_PASS_ON(pwrite(fd, &header, sizeof (header), 0) == sizeof (header))
+    UT_PASS_ON(replay_open(&cam, CAM_REPLAY_FAST, WG_FALSE) == WG_FAILURE)
+    header.magic = ~header.magic;
+
+    /* wrong version */
+    ++header.version;
+    UT_PASS_ON(pwrite(fd, &header, sizeof (header), 0) == sizeof (header))
+    UT_PASS_ON(replay_open(&cam, CAM_REPLAY_FAST, WG_FALSE) == WG_FAILURE)
+    --header.version;
+
+    /* ring pointer behind the frame area */
+    header.end = header.data_size + CAM_REC_ALIGN;
+    UT_PASS_ON(pwrite(fd, &header, sizeof (header), 0) == sizeof (header))
+    UT_PASS_ON(replay_open(&cam, CAM_REPLAY_FAST, WG_FALSE) == WG_FAILURE)
+
+    /* frame area longer than the file */
+    UT_PASS_ON(ftruncate(fd, sizeof (header) + REC_AREA_SIZE / 2) == 0)
+    UT_PASS_ON(replay_open(&cam, CAM_REPLAY_FAST, WG_FALSE) == WG_FAILURE)
+
+    close(fd);
+    unlink(REC_PATH);
+UT_END
+
+int
+main(int argc, char *argv[])
+{
+    UT_RUN_TEST(recorder_test_1);
+    UT_RUN_TEST(recorder_test_2);
+    UT_RUN_TEST(recorder_test_3);
+
+    return 0;
+}
@@ -0,0 +1,459 @@
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <math.h>
+#include <stdarg.h>
+
+#include <wgtypes.h>
+#include <wg.h>
+#include <wgmacros.h>
+
+#include <img.h>
+
+#include <ut_tools.h>
+
+WG_PRIVATE int
+cmp_uchar(const void *a, const void *b)
+{
+    return *(const wg_uchar*)a - *(const wg_uchar*)b;
+}
+
+WG_PRIVATE void
+random_image(Wg_image *img)
+{
+    wg_uint row = 0;
+    wg_uint i = 0;
+
+    for (row = 0; row < img->height; ++row){
+        for (i = 0; i < img->width * img->components_per_pixel; ++i){
+            img->rows[row][i] = rand();
+        }
+    }
+
+    return;
+}
+
+/** @brief Colors at the hue wraparound, without saturation or value */
+WG_PRIVATE const wg_uchar hsv_special[][3] = {
+    {  0,   0,   0},
+    {128, 128, 128},
+    {255, 255, 255},
+    {200, 199, 199},
+    {255,   0,   0},
+    {  0, 255,   0},
+    {  0,   0, 255},
+    {255,   0,   1},
+    {255,   1,   0},
+    {254,   0,   2},
+    {255,   2,   0},
+    {  1,   0,   0},
+    {  1,   0,   1}
+};
+
+/* filter taking its color range as variable arguments */
+WG_PRIVATE wg_status
+hsv_filter(wg_status (*filter)(const Wg_image*, Wg_image*, va_list),
+        const Wg_image *img, Wg_image *mask, ...)
+{
+    va_list args;
+    wg_status status = WG_FAILURE;
+
+    va_start(args, mask);
+    status = filter(img, mask, args);
+    va_end(args);
+
+    return status;
+}
+
+/* packed component within one step of a float component */
+WG_PRIVATE wg_boolean
+hsv8_near(wg_uint packed, wg_double value, wg_boolean circle)
+{
+    wg_double diff = fabs(packed - value * 255.0);
+
+    if (WG_TRUE == circle){
+        diff = WG_MIN(diff, 255.0 - diff);
+    }
+
+    return (diff <= 1.0) ? WG_TRUE : WG_FALSE;
+}
+
+/* float component at most one step from a range bound */
+WG_PRIVATE wg_boolean
+hsv_at_bound(wg_double value, wg_double bottom, wg_double top)
+{
+    return ((fabs(value - bottom) * 255.0 <= 1.0) || 
+            (fabs(value - top) * 255.0 <= 1.0)) ? WG_TRUE : WG_FALSE;
+}
+
+/* 
+ * 3x3 median of every instruction set against sorted windows, odd widths 
+ * leave a tail behind the last full vector 
+ */
+UT_DEFINE(median_test_1)
+    Wg_image src;
+    Wg_image dst;
+    wg_uchar win[9];
+    wg_uint comp = 0;
+    wg_uint width = 0;
+    wg_uint height = 0;
+    wg_uint level = 0;
+    wg_uint row = 0;
+    wg_uint col = 0;
+    wg_uint c = 0;
+    wg_uint k = 0;
+    wg_uint bad = 0;
+
+    srand(7);
+
+    for (comp = 1; comp <= 4; comp += 3){
+        for (width = 3; width < 100; width += 6){
+            for (height = 3; height < 8; height += 2){
+                img_fill(width, height, comp, (comp == 1) ? IMG_GS : IMG_BGRX,
+                        &src);
+                random_image(&src);
+
+                for (level = IMG_SIMD_NONE; level <= IMG_SIMD_AVX2; ++level){
+                    img_simd_set_level(level);
+
+                    img_fill(width - 2, height - 2, comp, src.type, &dst);
+                    UT_PASS_ON(img_median_filter_noalloc(&src, &dst) 
+                            == WG_SUCCESS)
+
+                    bad = 0;
+                    for (row = 0; row < dst.height; ++row){
+                        for (col = 0; col < dst.width; ++col){
+                            for (c = 0; c < comp; ++c){
+                                for (k = 0; k < 9; ++k){
+                                    win[k] = src.rows[row + k / 3]
+                                        [(col + k % 3) * comp + c];
+                                }
+                                qsort(win, 9, 1, cmp_uchar);
+                                bad += (dst.rows[row][col * comp + c] 
+                                        != win[4]);
+                            }
+                        }
+                    }
+                    UT_PASS_ON(bad == 0)
+
+                    img_cleanup(&dst);
+                }
+
+                img_cleanup(&src);
+            }
+        }
+    }
+
+    img_simd_set_level(IMG_SIMD_AVX2);
+UT_END
+
+/* 
+ * histogram hue median against sorted windows, work memory is reused 
+ * while the image grows and shrinks 
+ */
+UT_DEFINE(hue_median_test_1)
+    Img_hue_median median;
+    Wg_image src;
+    Wg_image dst;
+    wg_uchar win[(2 * 4 + 1) * (2 * 4 + 1)];
+    Hsv8 *in = NULL;
+    Hsv8 *out = NULL;
+    wg_uint width = 0;
+    wg_uint height = 0;
+    wg_uint radius = 0;
+    wg_uint bands = 0;
+    wg_uint diameter = 0;
+    wg_uint row = 0;
+    wg_uint col = 0;
+    wg_uint k = 0;
+    wg_uint bad = 0;
+
+    srand(8);
+
+    img_hue_median_init(&median);
+
+    for (width = 31; width >= 9; width -= WG_MIN(width, 11)){
+        for (height = 9; height < 30; height += 10){
+            img_fill(width, height, HSV8_COMPONENT_NUM, IMG_HSV8, &src);
+            random_image(&src);
+
+            for (radius = 1; radius <= 4; ++radius){
+                if ((width <= 2 * radius) || (height <= 2 * radius)){
+                    continue;
+                }
+
+                diameter = 2 * radius + 1;
+                for (bands = 1; bands <= 3; ++bands){
+                    img_fill(width - 2 * radius, height - 2 * radius,
+                            HSV8_COMPONENT_NUM, IMG_HSV8, &dst);
+                    UT_PASS_ON(img_hue_median_filter_noalloc(&src, &dst, 
+                                radius, bands, &median) == WG_SUCCESS)
+
+                    bad = 0;
+                    for (row = 0; row < dst.height; ++row){
+                        out = (Hsv8*)dst.rows[row];
+                        for (col = 0; col < dst.width; ++col){
+                            for (k = 0; k < diameter * diameter; ++k){
+                                in = (Hsv8*)src.rows[row + k / diameter];
+                                win[k] = in[col + k % diameter].hue;
+                            }
+                            qsort(win, diameter * diameter, 1, cmp_uchar);
+
+                            in = (Hsv8*)src.rows[row + radius];
+                            bad += (out[col].hue != 
+                                    win[diameter * diameter / 2]);
+                            bad += (out[col].sat != in[col + radius].sat);
+                            bad += (out[col].val != in[col + radius].val);
+                        }
+                    }
+                    UT_PASS_ON(bad == 0)
+
+                    img_cleanup(&dst);
+                }
+            }
+
+            img_cleanup(&src);
+        }
+    }
+
+    img_hue_median_cleanup(&median);
+UT_END
+
+/* 
+ * packed HSV conversion and range filter against the float conversion of
+ * gtk_rgb_to_hsv() and img_hsv_filter_noalloc()
+ */
+UT_DEFINE(hsv8_test_1)
+    Wg_image rgb;
+    Wg_image bgrx;
+    Wg_image hsv;
+    Wg_image hsv8;
+    Wg_image bgrx_hsv8;
+    Wg_image mask;
+    Wg_image mask8;
+    Hsv top;
+    Hsv bottom;
+    const Hsv *pixel = NULL;
+    const Hsv8 *pixel8 = NULL;
+    wg_uint width = 0;
+    wg_uint height = 0;
+    wg_uint row = 0;
+    wg_uint col = 0;
+    wg_uint i = 0;
+    wg_uint k = 0;
+    wg_uint bad = 0;
+
+    srand(4);
+
+    for (width = 1; width < 70; width += 17){
+        height = 5;
+
+        img_fill(width, height, RGB24_COMPONENT_NUM, IMG_RGB, &rgb);
+        img_fill(width, height, BGRX_COMPONENT_NUM, IMG_BGRX, &bgrx);
+        img_fill(width, height, sizeof (Hsv), IMG_HSV, &hsv);
+        img_fill(width, height, HSV8_COMPONENT_NUM, IMG_HSV8, &hsv8);
+        img_fill(width, height, HSV8_COMPONENT_NUM, IMG_HSV8, &bgrx_hsv8);
+        img_fill(width, height, GS_COMPONENT_NUM, IMG_GS, &mask);
+        img_fill(width, height, GS_COMPONENT_NUM, IMG_GS, &mask8);
+
+        random_image(&rgb);
+        for (i = 0; i < WG_MIN(ELEMNUM(hsv_special), width * height); ++i){
+            memcpy(rgb.image + i * RGB24_COMPONENT_NUM, hsv_special[i], 3);
+        }
+
+        for (row = 0; row < height; ++row){
+            for (col = 0; col < width; ++col){
+                for (k = 0; k < 3; ++k){
+                    bgrx.rows[row][col * BGRX_COMPONENT_NUM + 2 - k] = 
+                        rgb.rows[row][col * RGB24_COMPONENT_NUM + k];
+                }
+            }
+        }
+
+        UT_PASS_ON(img_rgb_2_hsv_gtk_noalloc(&rgb, &hsv) == WG_SUCCESS)
+        UT_PASS_ON(img_rgb_2_hsv8_noalloc(&rgb, &hsv8) == WG_SUCCESS)
+        UT_PASS_ON(img_bgrx_2_hsv8_noalloc(&bgrx, &bgrx_hsv8) == WG_SUCCESS)
+        UT_PASS_ON(memcmp(hsv8.image, bgrx_hsv8.image, hsv8.size) == 0)
+
+        /* hue is a circle, 255 and 0 are one step apart */
+        bad = 0;
+        for (row = 0; row < height; ++row){
+            pixel  = (const Hsv*)hsv.rows[row];
+            pixel8 = (const Hsv8*)hsv8.rows[row];
+            for (col = 0; col < width; ++col){
+                bad += !hsv8_near(pixel8[col].hue, pixel[col].hue, WG_TRUE);
+                bad += !hsv8_near(pixel8[col].sat, pixel[col].sat, WG_FALSE);
+                bad += !hsv8_near(pixel8[col].val, pixel[col].val, WG_FALSE);
+                bad += (pixel8[col].pad != 0);
+                /* gray has no hue */
+                bad += ((0 == pixel8[col].sat) && (0 != pixel8[col].hue));
+            }
+        }
+        UT_PASS_ON(bad == 0)
+
+        /* masks differ only where a component lies at a bound */
+        for (i = 0; i < 20; ++i){
+            bottom.hue = (rand() % 1000) / 1000.0;
+            bottom.sat = (rand() % 1000) / 2000.0;
+            bottom.val = (rand() % 1000) / 2000.0;
+            top.hue    = bottom.hue + (rand() % 1000) / 1000.0;
+            top.sat    = bottom.sat + (rand() % 1000) / 1000.0;
+            top.val    = bottom.val + (rand() % 1000) / 1000.0;
+
+            /* whole ranges keep gray, black and hue 0 pixels */
+            if (0 == i){
+                bottom.hue = bottom.sat = bottom.val = 0.0;
+                top.hue = top.sat = top.val = 1.01;
+            }
+
+            UT_PASS_ON(hsv_filter(img_hsv_filter_noalloc, &hsv, &mask, 
+                        &top, &bottom) == WG_SUCCESS)
+            UT_PASS_ON(hsv_filter(img_hsv8_filter_noalloc, &hsv8, &mask8, 
+                        &top, &bottom) == WG_SUCCESS)
+
+            bad = 0;
+            for (row = 0; row < height; ++row){
+                pixel = (const Hsv*)hsv.rows[row];
+                for (col = 0; col < width; ++col){
+                    if ((mask.rows[row][col] != mask8.rows[row][col]) &&
+                        !hsv_at_bound(pixel[col].hue, bottom.hue, top.hue) &&
+                        !hsv_at_bound(pixel[col].sat, bottom.sat, top.sat) &&
+                        !hsv_at_bound(pixel[col].val, bottom.val, top.val)){
+                        ++bad;
+                    }
+                }
+            }
+            UT_PASS_ON(bad == 0)
+
+            if (0 == i){
+                UT_PASS_ON(memchr(mask8.image, 0, mask8.size) == NULL)
+            }
+        }
+
+        img_cleanup(&rgb);
+        img_cleanup(&bgrx);
+        img_cleanup(&hsv);
+        img_cleanup(&hsv8);
+        img_cleanup(&bgrx_hsv8);
+        img_cleanup(&mask);
+        img_cleanup(&mask8);
+    }
+UT_END
+
+/* 
+ * portable YUYV decoder against the per pixel conversion, V4L2 stores 
+ * Y0 Cb Y1 Cr
+ */
+UT_DEFINE(yuyv_test_1)
+    wg_uchar blue[] = {16, 192, 16, 128};
+    Wg_image yuyv;
+    Wg_image rgb;
+    rgb24_pixel ref;
+    const wg_uchar *pixel = NULL;
+    wg_uint col = 0;
+    wg_uint bad = 0;
+
+    srand(6);
+
+    img_simd_set_level(IMG_SIMD_NONE);
+
+    img_fill(2, 1, RGB24_COMPONENT_NUM, IMG_RGB, &rgb);
+    UT_PASS_ON(img_yuyv_2_rgb24_noalloc(blue, sizeof (blue), 2, 1, &rgb) 
+            == WG_SUCCESS)
+    UT_PASS_ON(rgb.image[RGB24_R] == 0)
+    UT_PASS_ON(rgb.image[RGB24_B] == 129)
+    img_cleanup(&rgb);
+
+    img_fill(512, 1, YUYV_COMPONENT_NUM, IMG_YUYV, &yuyv);
+    img_fill(1024, 1, RGB24_COMPONENT_NUM, IMG_RGB, &rgb);
+    random_image(&yuyv);
+
+    UT_PASS_ON(img_yuyv_2_rgb24_noalloc(yuyv.image, yuyv.size, 1024, 1, 
+                &rgb) == WG_SUCCESS)
+
+    pixel = yuyv.image;
+    for (col = 0; col < rgb.width; ++col){
+        yuyv_2_rgb(pixel[(col & 1) ? POS_Y1 : POS_Y0], pixel[POS_U], 
+                pixel[POS_V], ref);
+        bad += (memcmp(ref, rgb.image + col * RGB24_COMPONENT_NUM, 
+                    RGB24_COMPONENT_NUM) != 0);
+        if (col & 1){
+            pixel += YUYV_COMPONENT_NUM;
+        }
+    }
+    UT_PASS_ON(bad == 0)
+
+    img_cleanup(&yuyv);
+    img_cleanup(&rgb);
+
+    img_simd_set_level(IMG_SIMD_AVX2);
+UT_END
+
+/* 
+ * YUYV decoders of every instruction set against the portable ones, on 
+ * lengths leaving a tail after the last full vector
+ */
+UT_DEFINE(yuyv_simd_test_1)
+    wg_status (*decode[])(wg_uchar*, wg_ssize, wg_uint, wg_uint, 
+            Wg_image*) = {
+        img_yuyv_2_rgb24_noalloc, 
+        img_yuyv_2_bgrx_noalloc
+    };
+    const wg_uint comp[] = {RGB24_COMPONENT_NUM, BGRX_COMPONENT_NUM};
+    const img_type type[] = {IMG_RGB, IMG_BGRX};
+    Wg_image yuyv;
+    Wg_image ref;
+    Wg_image dst;
+    wg_uint d = 0;
+    wg_uint width = 0;
+    wg_uint height = 0;
+    wg_uint level = 0;
+
+    srand(5);
+
+    for (d = 0; d < ELEMNUM(decode); ++d){
+        for (width = 1; width < 80; ++width){
+            /* YUYV holds pixel pairs */
+            height = (width & 1) ? 2 : 3;
+
+            img_fill(width * height / 2, 1, YUYV_COMPONENT_NUM, IMG_YUYV, 
+                    &yuyv);
+            random_image(&yuyv);
+            img_fill(width, height, comp[d], type[d], &ref);
+            img_fill(width, height, comp[d], type[d], &dst);
+
+            img_simd_set_level(IMG_SIMD_NONE);
+            UT_PASS_ON(decode[d](yuyv.image, yuyv.size, width, height, &ref)
+                    == WG_SUCCESS)
+
+            for (level = IMG_SIMD_SSE2; level <= IMG_SIMD_AVX2; ++level){
+                if (img_simd_set_level(level) != level){
+                    break;
+                }
+
+                memset(dst.image, 0, dst.size);
+                UT_PASS_ON(decode[d](yuyv.image, yuyv.size, width, height, 
+                            &dst) == WG_SUCCESS)
+                UT_PASS_ON(memcmp(ref.image, dst.image, ref.size) == 0)
+            }
+
+            img_cleanup(&yuyv);
+            img_cleanup(&ref);
+            img_cleanup(&dst);
+        }
+    }
+
+    img_simd_set_level(IMG_SIMD_AVX2);
+UT_END
+
+int
+main(int argc, char *argv[])
+{
+    UT_RUN_TEST(median_test_1);
+    UT_RUN_TEST(hue_median_test_1);
+    UT_RUN_TEST(hsv8_test_1);
+    UT_RUN_TEST(yuyv_test_1);
+    UT_RUN_TEST(yuyv_simd_test_1);
+
+    return 0;
+}
@@ -0,0 +1,974 @@
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+
+#include <wgtypes.h>
+#include <wg.h>
+#include <wgmacros.h>
+#include <wg_linked_list.h>
+
+#include <img.h>
+#include <cam.h>
+
+#include <ut_tools.h>
+
+#include "include/ef_engine.h"
+
+/** @brief Sizes of tested masks, widths around multiples of 64 */
+WG_PRIVATE const wg_uint mask_size[][2] = {
+    {  5,   5},
+    {  7,   9},
+    { 63,  10},
+    { 64,  12},
+    { 65,   7},
+    {130,  40},
+    {321,  17}
+};
+
+/* 
+ * random binary mask, density in percent, a few discs make solid areas 
+ */
+WG_PRIVATE void
+random_mask(Wg_image *gs, wg_uint density)
+{
+    wg_int cx = 0;
+    wg_int cy = 0;
+    wg_int r = 0;
+    wg_int row = 0;
+    wg_int col = 0;
+    wg_int k = 0;
+
+    for (row = 0; row < gs->height; ++row){
+        for (col = 0; col < gs->width; ++col){
+            gs->rows[row][col] = (rand() % 100 < density) ? 255 : 0;
+        }
+    }
+
+    for (k = 0; k < 3; ++k){
+        cx = rand() % gs->width;
+        cy = rand() % gs->height;
+        r  = 2 + rand() % 12;
+        for (row = 0; row < gs->height; ++row){
+            for (col = 0; col < gs->width; ++col){
+                if ((col - cx) * (col - cx) + (row - cy) * (row - cy) < r * r){
+                    gs->rows[row][col] = 255;
+                }
+            }
+        }
+    }
+
+    return;
+}
+
+/* pixel of a grayscale mask, pixels outside are not set */
+WG_PRIVATE wg_uint
+gs_get(const Wg_image *gs, wg_int row, wg_int col)
+{
+    if ((row < 0) || (col < 0) || (row >= gs->height) || (col >= gs->width)){
+        return 0;
+    }
+
+    return (0 != gs->rows[row][col]);
+}
+
+/* set pixels of the box around a pixel, border pixels repeated */
+WG_PRIVATE wg_uint
+box_count(const Wg_image *gs, wg_int row, wg_int col, wg_int r)
+{
+    wg_uint count = 0;
+    wg_int i = 0;
+    wg_int j = 0;
+
+    for (i = row - r; i <= row + r; ++i){
+        for (j = col - r; j <= col + r; ++j){
+            count += gs_get(gs, WG_MAX(0, WG_MIN(i, (wg_int)gs->height - 1)), 
+                    WG_MAX(0, WG_MIN(j, (wg_int)gs->width - 1)));
+        }
+    }
+
+    return count;
+}
+
+/* 
+ * blobs of a byte mask by flood fill in row order, label is the blob index 
+ * plus one, returns number of blobs of at least min_area pixels
+ */
+WG_PRIVATE wg_uint
+blob_reference(const Wg_image *gs, wg_uint min_area, wg_uint *label, 
+        wg_uint32 *stack, Ef_blob *blob)
+{
+    Ef_blob *b = NULL;
+    wg_uint top = 0;
+    wg_uint num = 0;
+    wg_uint pos = 0;
+    wg_int row = 0;
+    wg_int col = 0;
+    wg_int k = 0;
+    wg_int y = 0;
+    wg_int x = 0;
+
+    memset(label, '\0', gs->width * gs->height * sizeof (wg_uint));
+
+    for (pos = 0; pos < gs->width * gs->height; ++pos){
+        if ((0 != label[pos]) || 
+                (0 == gs_get(gs, pos / gs->width, pos % gs->width))){
+            continue;
+        }
+
+        b = &blob[num++];
+        memset(b, '\0', sizeof (Ef_blob));
+        b->x_min = b->x_max = pos % gs->width;
+        b->y_min = b->y_max = pos / gs->width;
+
+        label[pos]   = num;
+        stack[top++] = pos;
+        while (top > 0){
+            row = stack[--top] / gs->width;
+            col = stack[top] % gs->width;
+
+            b->area   += 1;
+            b->sum_x  += col;
+            b->sum_y  += row;
+            b->sum_xx += col * col;
+            b->sum_yy += row * row;
+            b->sum_xy += col * row;
+            b->x_min = WG_MIN(b->x_min, col);
+            b->x_max = WG_MAX(b->x_max, col);
+            b->y_min = WG_MIN(b->y_min, row);
+            b->y_max = WG_MAX(b->y_max, row);
+
+            for (k = 0; k < 9; ++k){
+                y = row + k / 3 - 1;
+                x = col + k % 3 - 1;
+                if ((1 == gs_get(gs, y, x)) && 
+                        (0 == label[y * gs->width + x])){
+                    label[y * gs->width + x] = num;
+                    stack[top++] = y * gs->width + x;
+                }
+            }
+        }
+
+        if (b->area < min_area){
+            --num;
+        }
+    }
+
+    return num;
+}
+
+/* blobs found by ef_blob_find_noalloc() equal the reference blobs */
+WG_PRIVATE wg_boolean
+blob_list_equal(const Ef_blob_list *list, const Ef_blob *blob, wg_uint num)
+{
+    const Ef_blob *a = NULL;
+    const Ef_blob *b = NULL;
+    wg_uint i = 0;
+
+    if (list->num != num){
+        return WG_FALSE;
+    }
+
+    for (i = 0; i < num; ++i){
+        a = &list->blob[i];
+        b = &blob[i];
+        if ((a->area != b->area) || 
+            (a->x_min != b->x_min) || (a->x_max != b->x_max) ||
+            (a->y_min != b->y_min) || (a->y_max != b->y_max) ||
+            (a->sum_x != b->sum_x) || (a->sum_y != b->sum_y) ||
+            (a->sum_xx != b->sum_xx) || (a->sum_yy != b->sum_yy) ||
+            (a->sum_xy != b->sum_xy) ||
+            (a->x != b->sum_x / b->area) || (a->y != b->sum_y / b->area)){
+            return WG_FALSE;
+        }
+    }
+
+    return WG_TRUE;
+}
+
+/* fill a rectangle of a byte mask, corners included */
+WG_PRIVATE void
+gs_rect(Wg_image *gs, wg_uint x0, wg_uint y0, wg_uint x1, wg_uint y1)
+{
+    wg_uint row = 0;
+
+    for (row = y0; row <= y1; ++row){
+        memset(&gs->rows[row][x0], 255, x1 - x0 + 1);
+    }
+
+    return;
+}
+
+/* set a disc of a byte mask to value */
+WG_PRIVATE void
+gs_disc(Wg_image *gs, wg_int cx, wg_int cy, wg_int r, gray_pixel value)
+{
+    wg_int row = 0;
+    wg_int col = 0;
+
+    for (row = cy - r; row <= cy + r; ++row){
+        for (col = cx - r; col <= cx + r; ++col){
+            if ((col - cx) * (col - cx) + (row - cy) * (row - cy) <= r * r){
+                gs->rows[row][col] = value;
+            }
+        }
+    }
+
+    return;
+}
+
+/* 
+ * recursive hysteresis of the interior pixels, as ef_hyst_thr() worked 
+ * before it used a stack of its own
+ */
+WG_PRIVATE void
+hyst_connect(const Wg_image *img, Wg_image *out, wg_int row, wg_int col, 
+        wg_uint low)
+{
+    wg_int y = 0;
+    wg_int x = 0;
+
+    for (y = row - 1; y <= row + 1; ++y){
+        for (x = col - 1; x <= col + 1; ++x){
+            if ((y >= 1) && (x >= 1) && (y < img->height - 1) && 
+                    (x < img->width - 1) && (img->rows[y][x] >= low) && 
+                    (0 == out->rows[y][x])){
+                out->rows[y][x] = 255;
+                hyst_connect(img, out, y, x, low);
+            }
+        }
+    }
+
+    return;
+}
+
+WG_PRIVATE void
+hyst_reference(const Wg_image *img, Wg_image *out, wg_uint upp, wg_uint low)
+{
+    wg_int row = 0;
+    wg_int col = 0;
+
+    memset(out->image, '\0', out->size);
+    for (row = 1; row < img->height - 1; ++row){
+        for (col = 1; col < img->width - 1; ++col){
+            if ((img->rows[row][col] >= upp) && (0 == out->rows[row][col])){
+                out->rows[row][col] = 255;
+                hyst_connect(img, out, row, col, low);
+            }
+        }
+    }
+
+    return;
+}
+
+/* bits behind the last pixel of every row are clear */
+WG_PRIVATE wg_boolean
+bitmask_tail_clear(const Wg_image *mask)
+{
+    const bitmask_word *word = NULL;
+    wg_uint row = 0;
+
+    for (row = 0; row < mask->height; ++row){
+        word = (const bitmask_word*)mask->rows[row];
+        if (0 != (word[BITMASK_ROW_WORDS(mask->width) - 1] & 
+                    ~bitmask_tail(mask->width))){
+            return WG_FALSE;
+        }
+    }
+
+    return WG_TRUE;
+}
+
+/* 
+ * conversion and 3x3 morphology of bit masks against byte masks
+ */
+UT_DEFINE(bitmask_test_1)
+    Wg_image gs;
+    Wg_image gs_out;
+    Wg_image mask;
+    Wg_image mask_out;
+    wg_uint width = 0;
+    wg_uint height = 0;
+    wg_uint erode = 0;
+    wg_uint dilate = 0;
+    wg_uint bad = 0;
+    wg_int row = 0;
+    wg_int col = 0;
+    wg_int k = 0;
+    wg_uint i = 0;
+    wg_uint density = 0;
+
+    srand(21);
+
+    for (i = 0; i < ELEMNUM(mask_size); ++i){
+        for (density = 5; density < 100; density += 30){
+            width  = mask_size[i][0];
+            height = mask_size[i][1];
+
+            img_fill(width, height, GS_COMPONENT_NUM, IMG_GS, &gs);
+            img_fill(width, height, GS_COMPONENT_NUM, IMG_GS, &gs_out);
+            img_fill(width, height, BITMASK_COMPONENT_NUM, IMG_BITMASK, 
+                    &mask);
+            img_fill(width, height, BITMASK_COMPONENT_NUM, IMG_BITMASK, 
+                    &mask_out);
+            random_mask(&gs, density);
+
+            UT_PASS_ON(img_bitmask_from_gs_noalloc(&gs, &mask) == WG_SUCCESS)
+            UT_PASS_ON(bitmask_tail_clear(&mask) == WG_TRUE)
+            UT_PASS_ON(img_bitmask_2_gs_noalloc(&mask, &gs_out) == WG_SUCCESS)
+            UT_PASS_ON(memcmp(gs.image, gs_out.image, gs.size) == 0)
+
+            bad = 0;
+            UT_PASS_ON(img_bitmask_erode_noalloc(&mask, &mask_out) 
+                    == WG_SUCCESS)
+            UT_PASS_ON(bitmask_tail_clear(&mask_out) == WG_TRUE)
+            for (row = 0; row < height; ++row){
+                for (col = 0; col < width; ++col){
+                    erode = 1;
+                    for (k = 0; k < 9; ++k){
+                        erode &= gs_get(&gs, row + k / 3 - 1, col + k % 3 - 1);
+                    }
+                    bad += (img_bitmask_get(&mask_out, row, col) != erode);
+                }
+            }
+            UT_PASS_ON(bad == 0)
+
+            bad = 0;
+            UT_PASS_ON(img_bitmask_dilate_noalloc(&mask, &mask_out) 
+                    == WG_SUCCESS)
+            UT_PASS_ON(bitmask_tail_clear(&mask_out) == WG_TRUE)
+            for (row = 0; row < height; ++row){
+                for (col = 0; col < width; ++col){
+                    dilate = 0;
+                    for (k = 0; k < 9; ++k){
+                        dilate |= gs_get(&gs, row + k / 3 - 1, col + k % 3 - 1);
+                    }
+                    bad += (img_bitmask_get(&mask_out, row, col) != dilate);
+                }
+            }
+            UT_PASS_ON(bad == 0)
+
+            bad = 0;
+            UT_PASS_ON(img_bitmask_boundary_noalloc(&mask, &mask_out) 
+                    == WG_SUCCESS)
+            UT_PASS_ON(bitmask_tail_clear(&mask_out) == WG_TRUE)
+            for (row = 0; row < height; ++row){
+                for (col = 0; col < width; ++col){
+                    erode = 1;
+                    for (k = 0; k < 9; ++k){
+                        erode &= gs_get(&gs, row + k / 3 - 1, col + k % 3 - 1);
+                    }
+                    bad += (img_bitmask_get(&mask_out, row, col) != 
+                            (gs_get(&gs, row, col) && !erode));
+                }
+            }
+            UT_PASS_ON(bad == 0)
+
+            img_cleanup(&gs);
+            img_cleanup(&gs_out);
+            img_cleanup(&mask);
+            img_cleanup(&mask_out);
+        }
+    }
+UT_END
+
+/* 
+ * 5x5 smoothing and center of gravity of bit masks against ef_smooth() and 
+ * ef_center() of byte masks
+ */
+UT_DEFINE(bitmask_test_2)
+    Wg_image gs;
+    Wg_image gs_smooth;
+    Wg_image gs_out;
+    Wg_image mask;
+    Wg_image mask_smooth;
+    wg_uint gs_x = 0;
+    wg_uint gs_y = 0;
+    wg_uint mask_x = 0;
+    wg_uint mask_y = 0;
+    wg_uint num = 0;
+    wg_uint set = 0;
+    wg_uint width = 0;
+    wg_uint height = 0;
+    wg_uint i = 0;
+    wg_uint density = 0;
+
+    srand(22);
+
+    for (i = 0; i < ELEMNUM(mask_size); ++i){
+        for (density = 5; density < 100; density += 30){
+            width  = mask_size[i][0];
+            height = mask_size[i][1];
+
+            img_fill(width, height, GS_COMPONENT_NUM, IMG_GS, &gs);
+            img_fill(width, height, BITMASK_COMPONENT_NUM, IMG_BITMASK, 
+                    &mask);
+            random_mask(&gs, density);
+            img_bitmask_from_gs_noalloc(&gs, &mask);
+
+            UT_PASS_ON(ef_smooth(&gs, &gs_smooth) == WG_SUCCESS)
+            UT_PASS_ON(ef_smooth(&mask, &mask_smooth) == WG_SUCCESS)
+            UT_PASS_ON(mask_smooth.type == IMG_BITMASK)
+            UT_PASS_ON((mask_smooth.width == gs_smooth.width) && 
+                    (mask_smooth.height == gs_smooth.height))
+            UT_PASS_ON(bitmask_tail_clear(&mask_smooth) == WG_TRUE)
+
+            img_fill(gs_smooth.width, gs_smooth.height, GS_COMPONENT_NUM, 
+                    IMG_GS, &gs_out);
+            img_bitmask_2_gs_noalloc(&mask_smooth, &gs_out);
+            UT_PASS_ON(memcmp(gs_smooth.image, gs_out.image, gs_out.size) 
+                    == 0)
+
+            set = 0;
+            for (num = 0; num < gs.size; ++num){
+                set += (0 != gs.image[num]);
+            }
+
+            UT_PASS_ON(ef_center(&gs, &gs_y, &gs_x) == WG_SUCCESS)
+            UT_PASS_ON(img_bitmask_center(&mask, &mask_y, &mask_x, &num) 
+                    == WG_SUCCESS)
+            UT_PASS_ON((gs_x == mask_x) && (gs_y == mask_y))
+            UT_PASS_ON(num == set)
+
+            img_cleanup(&gs);
+            img_cleanup(&gs_smooth);
+            img_cleanup(&gs_out);
+            img_cleanup(&mask);
+            img_cleanup(&mask_smooth);
+        }
+    }
+UT_END
+
+/* 
+ * box smoothing of byte and bit masks against counting the box, one work 
+ * memory reused by all sizes
+ */
+UT_DEFINE(box_test_1)
+    Wg_image gs;
+    Wg_image gs_out;
+    Wg_image mask;
+    Wg_image mask_out;
+    Ef_box box;
+    const wg_uint radius[] = {0, 1, 3, EF_SMOOTH_RADIUS_MAX};
+    wg_uint votes[3];
+    wg_uint width = 0;
+    wg_uint height = 0;
+    wg_uint area = 0;
+    wg_uint bad = 0;
+    wg_uint set = 0;
+    wg_int row = 0;
+    wg_int col = 0;
+    wg_uint i = 0;
+    wg_uint r = 0;
+    wg_uint v = 0;
+    wg_uint density = 0;
+
+    srand(23);
+
+    UT_PASS_ON(ef_box_init(&box, 0) == WG_SUCCESS)
+
+    for (i = 0; i < ELEMNUM(mask_size); ++i){
+        for (density = 10; density < 100; density += 40){
+            width  = mask_size[i][0];
+            height = mask_size[i][1];
+
+            img_fill(width, height, GS_COMPONENT_NUM, IMG_GS, &gs);
+            img_fill(width, height, GS_COMPONENT_NUM, IMG_GS, &gs_out);
+            img_fill(width, height, BITMASK_COMPONENT_NUM, IMG_BITMASK, 
+                    &mask);
+            img_fill(width, height, BITMASK_COMPONENT_NUM, IMG_BITMASK, 
+                    &mask_out);
+            random_mask(&gs, density);
+            img_bitmask_from_gs_noalloc(&gs, &mask);
+
+            for (r = 0; r < ELEMNUM(radius); ++r){
+                area = (2 * radius[r] + 1) * (2 * radius[r] + 1);
+                votes[0] = 1;
+                votes[1] = area / 2 + 1;
+                votes[2] = area;
+
+                for (v = 0; v < ELEMNUM(votes); ++v){
+                    UT_PASS_ON(ef_smooth_box_noalloc(&gs, &gs_out, 
+                                radius[r], votes[v], &box) == WG_SUCCESS)
+                    UT_PASS_ON(ef_smooth_box_noalloc(&mask, &mask_out, 
+                                radius[r], votes[v], &box) == WG_SUCCESS)
+                    UT_PASS_ON(bitmask_tail_clear(&mask_out) == WG_TRUE)
+
+                    bad = 0;
+                    for (row = 0; row < height; ++row){
+                        for (col = 0; col < width; ++col){
+                            set = (box_count(&gs, row, col, radius[r]) >= 
+                                    votes[v]);
+                            bad += (gs_get(&gs_out, row, col) != set);
+                            bad += (img_bitmask_get(&mask_out, row, col) != 
+                                    set);
+                        }
+                    }
+                    UT_PASS_ON(bad == 0)
+                }
+            }
+
+            /* single vote radius 0 box copies the mask */
+            ef_smooth_box_noalloc(&gs, &gs_out, 0, 1, &box);
+            UT_PASS_ON(memcmp(gs.image, gs_out.image, gs.size) == 0)
+
+            img_cleanup(&gs);
+            img_cleanup(&gs_out);
+            img_cleanup(&mask);
+            img_cleanup(&mask_out);
+        }
+    }
+
+    UT_PASS_ON(box.capacity == 
+            mask_size[ELEMNUM(mask_size) - 1][0] + 2 * EF_SMOOTH_RADIUS_MAX)
+
+    ef_box_cleanup(&box);
+UT_END
+
+/* 
+ * labelling of random byte and bit masks against a flood fill
+ */
+UT_DEFINE(blob_test_1)
+    Wg_image gs;
+    Wg_image mask;
+    Ef_blob_list list;
+    Ef_blob *blob = NULL;
+    wg_uint *label = NULL;
+    wg_uint32 *stack = NULL;
+    wg_uint num = 0;
+    wg_uint width = 0;
+    wg_uint height = 0;
+    wg_uint min_area = 0;
+    wg_uint i = 0;
+    wg_uint density = 0;
+
+    srand(24);
+
+    UT_PASS_ON(ef_blob_list_init(&list, 0) == WG_SUCCESS)
+
+    for (i = 0; i < ELEMNUM(mask_size); ++i){
+        for (density = 5; density < 100; density += 15){
+            width  = mask_size[i][0];
+            height = mask_size[i][1];
+
+            img_fill(width, height, GS_COMPONENT_NUM, IMG_GS, &gs);
+            img_fill(width, height, BITMASK_COMPONENT_NUM, IMG_BITMASK, 
+                    &mask);
+            label = WG_MALLOC(width * height * sizeof (wg_uint));
+            stack = WG_MALLOC(width * height * sizeof (wg_uint32));
+            blob  = WG_MALLOC(width * height * sizeof (Ef_blob));
+
+            random_mask(&gs, density);
+            img_bitmask_from_gs_noalloc(&gs, &mask);
+
+            for (min_area = 1; min_area < 8; min_area += 3){
+                num = blob_reference(&gs, min_area, label, stack, blob);
+
+                UT_PASS_ON(ef_blob_find_noalloc(&gs, &list, min_area) 
+                        == WG_SUCCESS)
+                UT_PASS_ON(blob_list_equal(&list, blob, num) == WG_TRUE)
+
+                UT_PASS_ON(ef_blob_find_noalloc(&mask, &list, min_area) 
+                        == WG_SUCCESS)
+                UT_PASS_ON(blob_list_equal(&list, blob, num) == WG_TRUE)
+            }
+
+            WG_FREE(label);
+            WG_FREE(stack);
+            WG_FREE(blob);
+            img_cleanup(&gs);
+            img_cleanup(&mask);
+        }
+    }
+
+    ef_blob_list_cleanup(&list);
+UT_END
+
+/* 
+ * shapes joined late, blobs on the border and single pixels
+ */
+UT_DEFINE(blob_test_2)
+    Wg_image gs;
+    Wg_image mask;
+    Ef_blob_list list;
+    wg_uint i = 0;
+
+    UT_PASS_ON(ef_blob_list_init(&list, 0) == WG_SUCCESS)
+
+    img_fill(130, 40, GS_COMPONENT_NUM, IMG_GS, &gs);
+    img_fill(130, 40, BITMASK_COMPONENT_NUM, IMG_BITMASK, &mask);
+
+    /* U whose arms are joined in the last row, and W whose three arms 
+     * start in different rows and are joined by the last row only, the
+     * side arms touch it diagonally
+     */
+    memset(gs.image, '\0', gs.size);
+    gs_rect(&gs, 2, 2, 3, 30);
+    gs_rect(&gs, 10, 2, 11, 30);
+    gs_rect(&gs, 2, 31, 11, 31);
+    gs_rect(&gs, 20, 5, 20, 20);
+    gs_rect(&gs, 25, 2, 25, 21);
+    gs_rect(&gs, 30, 8, 30, 20);
+    gs_rect(&gs, 21, 21, 23, 21);
+    gs_rect(&gs, 27, 21, 29, 21);
+    gs_rect(&gs, 23, 22, 27, 22);
+    img_bitmask_from_gs_noalloc(&gs, &mask);
+
+    UT_PASS_ON(ef_blob_find_noalloc(&gs, &list, 1) == WG_SUCCESS)
+    UT_PASS_ON(list.num == 2)
+    UT_PASS_ON(list.blob[0].area == 2 * 2 * 29 + 10)
+    UT_PASS_ON((list.blob[0].x_min == 2) && (list.blob[0].x_max == 11) &&
+            (list.blob[0].y_min == 2) && (list.blob[0].y_max == 31))
+    UT_PASS_ON(list.blob[1].area == 16 + 20 + 13 + 3 + 3 + 5)
+    UT_PASS_ON((list.blob[1].x_min == 20) && (list.blob[1].x_max == 30) &&
+            (list.blob[1].y_min == 2) && (list.blob[1].y_max == 22))
+    UT_PASS_ON(ef_blob_find_noalloc(&mask, &list, 1) == WG_SUCCESS)
+    UT_PASS_ON(list.num == 2)
+    UT_PASS_ON(list.blob[0].area == 2 * 2 * 29 + 10)
+    UT_PASS_ON(list.blob[1].area == 16 + 20 + 13 + 3 + 3 + 5)
+
+    /* blobs in the corners and along the edges, the last column sits in 
+     * the last bit mask word 
+     */
+    memset(gs.image, '\0', gs.size);
+    gs_rect(&gs, 0, 0, 4, 3);
+    gs_rect(&gs, 125, 0, 129, 39);
+    gs_rect(&gs, 0, 36, 63, 39);
+    gs_rect(&gs, 60, 0, 70, 0);
+    img_bitmask_from_gs_noalloc(&gs, &mask);
+
+    UT_PASS_ON(ef_blob_find_noalloc(&mask, &list, 1) == WG_SUCCESS)
+    UT_PASS_ON(list.num == 4)
+    UT_PASS_ON((list.blob[0].area == 20) && (list.blob[0].x == 2) && 
+            (list.blob[0].y == 1))
+    UT_PASS_ON((list.blob[1].area == 11) && (list.blob[1].x == 65) && 
+            (list.blob[1].y == 0))
+    UT_PASS_ON((list.blob[2].area == 200) && (list.blob[2].x == 127) && 
+            (list.blob[2].y == 19))
+    UT_PASS_ON((list.blob[3].area == 256) && (list.blob[3].x_min == 0) && 
+            (list.blob[3].x_max == 63) && (list.blob[3].y_max == 39))
+
+    /* whole image is one blob */
+    memset(gs.image, 255, gs.size);
+    img_bitmask_from_gs_noalloc(&gs, &mask);
+
+    UT_PASS_ON(ef_blob_find_noalloc(&gs, &list, 1) == WG_SUCCESS)
+    UT_PASS_ON((list.num == 1) && (list.blob[0].area == 130 * 40))
+    UT_PASS_ON(ef_blob_find_noalloc(&mask, &list, 1) == WG_SUCCESS)
+    UT_PASS_ON((list.num == 1) && (list.blob[0].area == 130 * 40) && 
+            (list.blob[0].x == 64) && (list.blob[0].y == 19))
+
+    /* isolated pixels are blobs of one pixel, dropped by a larger area */
+    memset(gs.image, '\0', gs.size);
+    for (i = 0; i < 10; ++i){
+        gs.rows[(i * 7) % 40][i * 13] = 255;
+    }
+    gs.rows[39][129] = 255;
+    img_bitmask_from_gs_noalloc(&gs, &mask);
+
+    UT_PASS_ON(ef_blob_find_noalloc(&mask, &list, 1) == WG_SUCCESS)
+    UT_PASS_ON(list.num == 11)
+    for (i = 0; i < list.num; ++i){
+        UT_PASS_ON((list.blob[i].area == 1) && 
+                (list.blob[i].mu20 == 0.0) && (list.blob[i].mu02 == 0.0))
+    }
+    UT_PASS_ON((list.blob[10].x == 129) && (list.blob[10].y == 39))
+    UT_PASS_ON(ef_blob_find_noalloc(&mask, &list, 2) == WG_SUCCESS)
+    UT_PASS_ON(list.num == 0)
+
+    /* empty mask */
+    memset(gs.image, '\0', gs.size);
+    UT_PASS_ON(ef_blob_find_noalloc(&gs, &list, 1) == WG_SUCCESS)
+    UT_PASS_ON(list.num == 0)
+
+    img_cleanup(&gs);
+    img_cleanup(&mask);
+    ef_blob_list_cleanup(&list);
+UT_END
+
+/* 
+ * centroid, area and radius range of the best blob
+ */
+UT_DEFINE(blob_test_3)
+    Wg_image gs;
+    Ef_blob_list list;
+    wg_uint index = 0;
+
+    UT_PASS_ON(ef_blob_list_init(&list, 0) == WG_SUCCESS)
+
+    img_fill(200, 100, GS_COMPONENT_NUM, IMG_GS, &gs);
+    memset(gs.image, '\0', gs.size);
+
+    /* bar, ring, large disc and small disc from top to bottom */
+    gs_rect(&gs, 5, 2, 120, 8);
+    gs_disc(&gs, 40, 45, 15, 255);
+    gs_disc(&gs, 40, 45, 9, 0);
+    gs_disc(&gs, 120, 50, 20, 255);
+    gs_disc(&gs, 60, 90, 4, 255);
+
+    UT_PASS_ON(ef_blob_find_noalloc(&gs, &list, 1) == WG_SUCCESS)
+    UT_PASS_ON(list.num == 4)
+
+    /* symmetric shapes have their centroid in the center */
+    UT_PASS_ON((list.blob[0].area == 116 * 7) && 
+            (list.blob[0].x == 62) && (list.blob[0].y == 5))
+    UT_PASS_ON((list.blob[1].x == 40) && (list.blob[1].y == 45))
+    UT_PASS_ON((list.blob[2].x == 120) && (list.blob[2].y == 50))
+    UT_PASS_ON((list.blob[3].x == 60) && (list.blob[3].y == 90))
+
+    /* ring of radius about 18 is in the range of the large disc but 
+     * scores lower, discs are found in ranges around their radii
+     */
+    UT_PASS_ON(ef_blob_best(&list, 17, 23, &index) == WG_SUCCESS)
+    UT_PASS_ON(index == 2)
+    UT_PASS_ON(ef_blob_best(&list, 2, 6, &index) == WG_SUCCESS)
+    UT_PASS_ON(index == 3)
+    UT_PASS_ON(ef_blob_best(&list, 2, 30, &index) == WG_SUCCESS)
+    UT_PASS_ON((index == 2) || (index == 3))
+
+    /* nothing lies between the small disc and the ring, bar estimated 
+     * about 47 is alone in a range of large radii
+     */
+    UT_PASS_ON(ef_blob_best(&list, 8, 15, &index) == WG_FAILURE)
+    UT_PASS_ON(ef_blob_best(&list, 25, 100, &index) == WG_SUCCESS)
+    UT_PASS_ON(index == 0)
+    UT_PASS_ON(ef_blob_best(&list, 60, 100, &index) == WG_FAILURE)
+
+    /* area limit of a larger radius drops the small disc of 49 pixels */
+    UT_PASS_ON(ef_blob_find_noalloc(&gs, &list, 7 * 7) == WG_SUCCESS)
+    UT_PASS_ON(list.num == 4)
+    UT_PASS_ON(ef_blob_find_noalloc(&gs, &list, 8 * 8) == WG_SUCCESS)
+    UT_PASS_ON(list.num == 3)
+    UT_PASS_ON(ef_blob_best(&list, 2, 6, &index) == WG_FAILURE)
+
+    img_cleanup(&gs);
+    ef_blob_list_cleanup(&list);
+UT_END
+
+/* 
+ * edge magnitude keeps its low byte for detectors and saturates for 
+ * hysteresis, byte and bit masks give the same edges
+ */
+UT_DEFINE(edge_test_1)
+    wg_status (*detect[])(Wg_image*, Wg_image*, Ef_edge_list*) = {
+        ef_detect_edge_list_noalloc,
+        ef_detect_edge_magnitude_noalloc
+    };
+    const gray_pixel step[] = {(4 * 255) & 0xff, 255};
+    Wg_image gs;
+    Wg_image mask;
+    Wg_image gs_edge;
+    Wg_image mask_edge;
+    Ef_edge_list gs_list;
+    Ef_edge_list mask_list;
+    wg_uint width = 0;
+    wg_uint height = 0;
+    wg_uint row = 0;
+    wg_uint i = 0;
+    wg_uint d = 0;
+    wg_uint density = 0;
+
+    srand(25);
+
+    UT_PASS_ON(ef_edge_list_init(&gs_list, 0) == WG_SUCCESS)
+    UT_PASS_ON(ef_edge_list_init(&mask_list, 0) == WG_SUCCESS)
+
+    /* step from 0 to 255 has the largest gradient, 4 * 255 */
+    img_fill(8, 6, GS_COMPONENT_NUM, IMG_GS, &gs);
+    img_fill(6, 4, GS_COMPONENT_NUM, IMG_GS, &gs_edge);
+    for (row = 0; row < gs.height; ++row){
+        memset(gs.rows[row], 0, 4);
+        memset(gs.rows[row] + 4, 255, 4);
+    }
+    for (d = 0; d < ELEMNUM(detect); ++d){
+        UT_PASS_ON(detect[d](&gs, &gs_edge, &gs_list) == WG_SUCCESS)
+        UT_PASS_ON(gs_list.num == 2 * gs_edge.height)
+        for (row = 0; row < gs_edge.height; ++row){
+            UT_PASS_ON((gs_edge.rows[row][2] == step[d]) && 
+                    (gs_edge.rows[row][3] == step[d]) && 
+                    (gs_edge.rows[row][1] == 0) && 
+                    (gs_edge.rows[row][4] == 0))
+        }
+    }
+    img_cleanup(&gs);
+    img_cleanup(&gs_edge);
+
+    for (d = 0; d < ELEMNUM(detect); ++d){
+        for (i = 0; i < ELEMNUM(mask_size); ++i){
+            for (density = 5; density < 100; density += 30){
+                width  = mask_size[i][0];
+                height = mask_size[i][1];
+
+                img_fill(width, height, GS_COMPONENT_NUM, IMG_GS, &gs);
+                img_fill(width, height, BITMASK_COMPONENT_NUM, IMG_BITMASK, 
+                        &mask);
+                img_fill(width - 2, height - 2, GS_COMPONENT_NUM, IMG_GS, 
+                        &gs_edge);
+                img_fill(width - 2, height - 2, GS_COMPONENT_NUM, IMG_GS, 
+                        &mask_edge);
+                random_mask(&gs, density);
+                img_bitmask_from_gs_noalloc(&gs, &mask);
+
+                UT_PASS_ON(detect[d](&gs, &gs_edge, &gs_list) == WG_SUCCESS)
+                UT_PASS_ON(detect[d](&mask, &mask_edge, &mask_list) 
+                        == WG_SUCCESS)
+                UT_PASS_ON(memcmp(gs_edge.image, mask_edge.image, gs_edge.size) 
+                        == 0)
+                UT_PASS_ON(gs_list.num == mask_list.num)
+
+                img_cleanup(&gs);
+                img_cleanup(&mask);
+                img_cleanup(&gs_edge);
+                img_cleanup(&mask_edge);
+            }
+        }
+    }
+
+    ef_edge_list_cleanup(&gs_list);
+    ef_edge_list_cleanup(&mask_list);
+UT_END
+
+/* 
+ * hysteresis of random images against the recursive flood fill
+ */
+UT_DEFINE(hyst_test_1)
+    Wg_image img;
+    Wg_image out;
+    Wg_image ref;
+    Ef_hyst hyst;
+    const wg_uint thr[][2] = {{255, 1}, {200, 100}, {128, 128}, {50, 10}};
+    wg_uint width = 0;
+    wg_uint height = 0;
+    wg_uint num = 0;
+    wg_uint i = 0;
+    wg_uint t = 0;
+
+    srand(26);
+
+    UT_PASS_ON(ef_hyst_init(&hyst, 0) == WG_SUCCESS)
+
+    for (i = 0; i < ELEMNUM(mask_size); ++i){
+        width  = mask_size[i][0];
+        height = mask_size[i][1];
+
+        img_fill(width, height, GS_COMPONENT_NUM, IMG_GS, &img);
+        img_fill(width, height, GS_COMPONENT_NUM, IMG_GS, &out);
+        img_fill(width, height, GS_COMPONENT_NUM, IMG_GS, &ref);
+
+        for (t = 0; t < ELEMNUM(thr); ++t){
+            for (num = 0; num < img.size; ++num){
+                img.image[num] = rand() % 256;
+            }
+
+            hyst_reference(&img, &ref, thr[t][0], thr[t][1]);
+
+            UT_PASS_ON(ef_hyst_noalloc(&img, &out, thr[t][0], thr[t][1], 
+                        &hyst) == WG_SUCCESS)
+            UT_PASS_ON(memcmp(out.image, ref.image, ref.size) == 0)
+
+            /* in place */
+            UT_PASS_ON(ef_hyst_thr(&img, thr[t][0], thr[t][1]) 
+                    == WG_SUCCESS)
+            UT_PASS_ON(memcmp(img.image, ref.image, ref.size) == 0)
+        }
+
+        img_cleanup(&img);
+        img_cleanup(&out);
+        img_cleanup(&ref);
+    }
+
+    ef_hyst_cleanup(&hyst);
+UT_END
+
+/* 
+ * weak pixels join only through weak or strong neighbours, a path of 
+ * millions of weak pixels completes
+ */
+UT_DEFINE(hyst_test_2)
+    Wg_image img;
+    Wg_image out;
+    Ef_hyst hyst;
+    wg_uint set = 0;
+    wg_uint num = 0;
+    wg_uint row = 0;
+    wg_uint col = 0;
+
+    UT_PASS_ON(ef_hyst_init(&hyst, 0) == WG_SUCCESS)
+
+    img_fill(12, 10, GS_COMPONENT_NUM, IMG_GS, &img);
+    img_fill(12, 10, GS_COMPONENT_NUM, IMG_GS, &out);
+    memset(img.image, '\0', img.size);
+
+    /* strong pixel, weak chain touching it diagonally, weak pixel two 
+     * columns away, weak pair reaching it through the border only
+     */
+    img.rows[2][2] = 200;
+    img.rows[3][3] = 100;
+    img.rows[4][4] = 100;
+    img.rows[4][5] = 100;
+    img.rows[2][7] = 100;
+    img.rows[2][5] = 49;
+    img.rows[8][1] = 200;
+    img.rows[9][2] = 100;
+    img.rows[8][3] = 100;
+
+    UT_PASS_ON(ef_hyst_noalloc(&img, &out, 150, 50, &hyst) == WG_SUCCESS)
+    UT_PASS_ON((out.rows[2][2] == 255) && (out.rows[3][3] == 255) && 
+            (out.rows[4][4] == 255) && (out.rows[4][5] == 255))
+    UT_PASS_ON((out.rows[2][7] == 0) && (out.rows[2][5] == 0))
+    UT_PASS_ON((out.rows[8][1] == 255) && (out.rows[9][2] == 0) && 
+            (out.rows[8][3] == 0))
+
+    /* without the strong pixel no weak pixel stays */
+    img.rows[2][2] = 149;
+    img.rows[8][1] = 149;
+    UT_PASS_ON(ef_hyst_noalloc(&img, &out, 150, 50, &hyst) == WG_SUCCESS)
+    for (num = 0; num < out.size; ++num){
+        set += (0 != out.image[num]);
+    }
+    UT_PASS_ON(set == 0)
+
+    img_cleanup(&img);
+    img_cleanup(&out);
+
+    /* rows of weak pixels joined at alternating ends make one path of 
+     * about 2M pixels, the recursive version overflowed the stack
+     */
+    img_fill(2000, 2000, GS_COMPONENT_NUM, IMG_GS, &img);
+    memset(img.image, '\0', img.size);
+    for (row = 1; row < img.height - 1; row += 2){
+        memset(img.rows[row] + 1, 100, img.width - 2);
+        if (row + 1 < img.height - 1){
+            img.rows[row + 1][(row / 2 % 2) ? 1 : img.width - 2] = 100;
+        }
+    }
+    img.rows[1][1] = 200;
+
+    UT_PASS_ON(ef_hyst_thr(&img, 150, 50) == WG_SUCCESS)
+    set = 0;
+    for (row = 1; row < img.height - 1; row += 2){
+        for (col = 1; col < img.width - 1; ++col){
+            set += (255 == img.rows[row][col]);
+        }
+    }
+    UT_PASS_ON(set == (img.height - 2 + 1) / 2 * (img.width - 2))
+    UT_PASS_ON(img.rows[img.height - 2][img.width - 2] == 255)
+
+    img_cleanup(&img);
+    ef_hyst_cleanup(&hyst);
+UT_END
+
+int
+main(int argc, char *argv[])
+{
+    UT_RUN_TEST(bitmask_test_1);
+    UT_RUN_TEST(bitmask_test_2);
+    UT_RUN_TEST(box_test_1);
+    UT_RUN_TEST(blob_test_1);
+    UT_RUN_TEST(blob_test_2);
+    UT_RUN_TEST(blob_test_3);
+    UT_RUN_TEST(edge_test_1);
+    UT_RUN_TEST(hyst_test_1);
+    UT_RUN_TEST(hyst_test_2);
+
+    return 0;
+}
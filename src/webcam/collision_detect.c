@@ -6,6 +6,7 @@
 #include <wgtypes.h>
 #include <wg.h>
 #include <wgmacros.h>
+#include <wg_time.h>
 
 #include "include/gui_prim.h"
 #include "include/collision_detect.h"
@@ -259,20 +260,28 @@ cd_get_pane_as_array(Cd_instance *pane, Wg_point2d array[PANE_VERTICLES_NUM])
 * 
 * @param pane   cd instance
 * @param point  new position
+* @param stamp  capture time of the frame the point comes from, may be NULL
 * 
 * @retval WG_SUCCESS
 * @retval WG_FAILURE
 */
 wg_status
-cd_add_position(Cd_instance *pane, const Wg_point2d *point)
+cd_add_position(Cd_instance *pane, const Wg_point2d *point,
+        const Wg_timestamp *stamp)
 {
+    Wg_timestamp no_stamp;
     wg_uint hit_index = 0;
     wg_float hit_x = WG_FLOAT(0.0);
     wg_float hit_y = WG_FLOAT(0.0);
 
     CHECK_FOR_NULL_PARAM(pane);
     CHECK_FOR_NULL_PARAM(point);
-    
+
+    if (NULL == stamp){
+        memset(&no_stamp, '\0', sizeof (Wg_timestamp));
+        stamp = &no_stamp;
+    }
+
     if (NULL == pane->hit_cb){
         return WG_FAILURE;
     }
@@ -283,12 +292,14 @@ cd_add_position(Cd_instance *pane, const Wg_point2d *point)
         if (is_valid_point(point)){
             pane->position_index = 0;
             pane->state = CD_STATE_FILL_PIPELINE;
+            pane->stamp[pane->position_index]      = *stamp;
             pane->position[pane->position_index++] = *point; 
             pane->position_index %= CD_POSITION_NUM;
         }
         break;
     case CD_STATE_FILL_PIPELINE:
         if (is_valid_point(point)){
+            pane->stamp[pane->position_index]      = *stamp;
             pane->position[pane->position_index++] = *point; 
             pane->position_index %= CD_POSITION_NUM;
             if (pane->position_index >= CD_PIPELINE_SIZE){
@@ -298,12 +309,14 @@ cd_add_position(Cd_instance *pane, const Wg_point2d *point)
         break;
     case CD_STATE_START:
         if (is_valid_point(point)){
+            pane->stamp[pane->position_index]      = *stamp;
             pane->position[pane->position_index++] = *point; 
             pane->position_index %= CD_POSITION_NUM;
             if (is_hit_detected(pane, &hit_index)){
                 if (is_hit_on_pane(pane, &pane->position[hit_index],
                     &hit_x, &hit_y)){
-                        pane->hit_cb(hit_x, hit_y, pane->hit_cb_user_data);
+                        pane->hit_cb(hit_x, hit_y, &pane->stamp[hit_index],
+                                pane->hit_cb_user_data);
                         pane->state = CD_STATE_HIT_RECORDED;
                 }
             }
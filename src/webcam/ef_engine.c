@@ -37,8 +37,58 @@ static wg_int32 tan_cache[CACHE_TAN_NUM];
 
 static wg_boolean ef_init_flag = WG_FALSE;
 
+/* initial number of points of a growing edge list */
+#define EF_EDGE_LIST_MIN   1024
+
+/* initial number of runs and blobs of a growing blob list */
+#define EF_RUN_LIST_MIN    1024
+#define EF_BLOB_LIST_MIN   64
+
 WG_PRIVATE void init_tan_cache(void);
 
+WG_PRIVATE wg_status
+circle_acc_prepare(Wg_image *img, Wg_image *acc);
+
+WG_PRIVATE wg_status
+detect_edge(Wg_image *img, Wg_image *new_img, Ef_edge_list *list,
+        wg_boolean saturate);
+
+WG_PRIVATE void
+box_row_add(const Wg_image *img, wg_uint row, wg_int *col_sum, wg_int weight);
+
+WG_PRIVATE wg_status
+box_grow(Ef_box *box, wg_uint capacity);
+
+WG_PRIVATE wg_status
+hyst_grow(Ef_hyst *hyst, wg_uint capacity);
+
+WG_PRIVATE wg_status
+detect_edge_bitmask(Wg_image *img, Wg_image *new_img, Ef_edge_list *list,
+        wg_boolean saturate);
+
+WG_PRIVATE wg_status
+edge_list_grow(Ef_edge_list *list, wg_uint capacity);
+
+WG_PRIVATE wg_status
+edge_list_push(Ef_edge_list *list, wg_uint col, wg_uint row, 
+        wg_int gx, wg_int gy);
+
+WG_PRIVATE wg_status
+row_runs(Wg_image *img, wg_uint row, Ef_blob_list *list);
+
+WG_PRIVATE wg_status
+run_push(Ef_blob_list *list, wg_uint x0, wg_uint x1, wg_uint y);
+
+WG_PRIVATE wg_uint
+run_find(Ef_run *run, wg_uint i);
+
+WG_PRIVATE wg_status
+blob_list_grow(Ef_blob_list *list, wg_uint capacity, wg_uint run_capacity);
+
+WG_PRIVATE void
+hough_vote(acc *acc_row, acc *acc_col, wg_int row, wg_int col, 
+        wg_int width, wg_int height);
+
 wg_status
 ef_init(void)
 {
@@ -108,9 +158,8 @@ detect_circle(Wg_image *img, Wg_image *acc, wg_int y1, wg_int x1,
             if ((abs(x2 - x1) > FPPOS_VAL(NB_X2)) | 
                     (abs(y2 - y1) > FPPOS_VAL(NB_Y2))){
                 if ((x2 > 0) && (y2 > 0) && (x2 < width) && (y2 < height)){
-                    img_get_pixel(img, FPPOS_INT(y2), FPPOS_INT(x2),
-                            (wg_uchar**)&gs_pixel);
-                    if (*gs_pixel == 255){
+                    gs_pixel = img->rows[FPPOS_INT(y2)] + FPPOS_INT(x2);
+                    if (*gs_pixel == EF_EDGE){
                         xm = (x1 + x2) >> 1;
                         ym = (y1 + y2) >> 1;
                         m = tan_c_array[FPPOS_INT(x2 - x1) + NB_X]
@@ -119,20 +168,18 @@ detect_circle(Wg_image *img, Wg_image *acc, wg_int y1, wg_int x1,
                             for (x0 = 0; x0 < width; FPPOS_INC(x0)){
                                 y0 = ym + FPPOS_MUL(m, (xm - x0));
                                 if ((y0 > 0) && (y0 < height)){
-                                    img_get_pixel(acc,
-                                            FPPOS_INT(y0), FPPOS_INT(x0), 
-                                            (wg_uchar**)&acc_pixel);
-                                    ++*acc_pixel;
+                                    acc_pixel = (wg_uint*)
+                                        acc->rows[FPPOS_INT(y0)];
+                                    ++acc_pixel[FPPOS_INT(x0)];
                                 }
                             }
                         }else{
                             for (y0 = 0; y0 < height; FPPOS_INC(y0)){
                                 x0 = xm + FPPOS_DIV((ym - y0), m);
                                 if ((x0 > 0) && (x0 < width)){
-                                    img_get_pixel(acc, 
-                                            FPPOS_INT(y0), FPPOS_INT(x0),
-                                            (wg_uchar**)&acc_pixel);
-                                    ++*acc_pixel;
+                                    acc_pixel = (wg_uint*)
+                                        acc->rows[FPPOS_INT(y0)];
+                                    ++acc_pixel[FPPOS_INT(x0)];
                                 }
                             }
                         }
@@ -149,6 +196,27 @@ wg_status
 ef_detect_circle(Wg_image *img, Wg_image *acc)
 {
     cam_status status = CAM_FAILURE;
+
+    CHECK_FOR_NULL_PARAM(img);
+    CHECK_FOR_NULL_PARAM(acc);
+
+    status = img_fill(img->width, img->height, sizeof (wg_uint), 
+            IMG_CIRCLE_ACC, acc);
+    if (CAM_SUCCESS != status){
+        return CAM_FAILURE;
+    }
+
+    status = ef_detect_circle_noalloc(img, acc);
+    if (CAM_SUCCESS != status){
+        img_cleanup(acc);
+    }
+
+    return status;
+}
+
+wg_status
+ef_detect_circle_noalloc(Wg_image *img, Wg_image *acc)
+{
     gray_pixel *gs_pixel = NULL;
     wg_uint width = 0;
     wg_uint height = 0;
@@ -158,25 +226,17 @@ ef_detect_circle(Wg_image *img, Wg_image *acc)
     CHECK_FOR_NULL_PARAM(img);
     CHECK_FOR_NULL_PARAM(acc);
 
-    if (img->type != IMG_GS){
-        WG_ERROR("Invalig image format! Passed %d expect %d\n", 
-                img->type, IMG_GS);
+    if (circle_acc_prepare(img, acc) != WG_SUCCESS){
         return CAM_FAILURE;
     }
 
     img_get_width(img, &width);
     img_get_height(img, &height);
 
-    status = img_fill(width, height, sizeof (wg_uint), IMG_CIRCLE_ACC,
-            acc);
-    if (CAM_SUCCESS != status){
-        return CAM_FAILURE;
-    }
-
     for (row = 0; row < height; ++row){
         img_get_row(img, row, (wg_uchar**)&gs_pixel);
         for (col = 0; col < width; ++col, ++gs_pixel){
-            if (*gs_pixel == 255){
+            if (*gs_pixel == EF_EDGE){
                 detect_circle(img, acc, row, col, NB_X, NB_Y);
             }
         }
@@ -185,6 +245,210 @@ ef_detect_circle(Wg_image *img, Wg_image *acc)
     return CAM_SUCCESS;
 }
 
+/** 
+* @brief Detect circles voting only for points of the edge list
+*
+* Gives the same accumulator as ef_detect_circle_noalloc() when list was 
+* filled by ef_detect_edge_list_noalloc() for img, without scanning the
+* whole image.
+* 
+* @param img   edge image
+* @param list  edge points of img
+* @param acc   accumulator of the same size as img
+* 
+* @retval WG_SUCCESS
+* @retval WG_FAILURE
+*/
+wg_status
+ef_detect_circle_list_noalloc(Wg_image *img, const Ef_edge_list *list,
+        Wg_image *acc)
+{
+    wg_uint i = 0;
+
+    CHECK_FOR_NULL_PARAM(img);
+    CHECK_FOR_NULL_PARAM(list);
+    CHECK_FOR_NULL_PARAM(acc);
+
+    if (circle_acc_prepare(img, acc) != WG_SUCCESS){
+        return CAM_FAILURE;
+    }
+
+    for (i = 0; i < list->num; ++i){
+        if (img->rows[list->y[i]][list->x[i]] == EF_EDGE){
+            detect_circle(img, acc, list->y[i], list->x[i], NB_X, NB_Y);
+        }
+    }
+
+    return CAM_SUCCESS;
+}
+
+WG_PRIVATE wg_status
+circle_acc_prepare(Wg_image *img, Wg_image *acc)
+{
+    if (img->type != IMG_GS){
+        WG_ERROR("Invalig image format! Passed %d expect %d\n", 
+                img->type, IMG_GS);
+        return WG_FAILURE;
+    }
+
+    if (img_check_geometry(acc, img->width, img->height, sizeof (wg_uint)) 
+            != WG_SUCCESS){
+        return WG_FAILURE;
+    }
+
+    /* accumulator may come from a pool */
+    acc->type = IMG_CIRCLE_ACC;
+    memset(acc->image, '\0', acc->size);
+
+    return WG_SUCCESS;
+}
+
+
+/** 
+* @brief Detect circles voting along gradient of edge points
+*
+* Sobel gradient of an edge of a bright disc points to its center, so each 
+* point votes only for centers on its gradient line between r_min and r_max
+* pixels away. Votes are saturated at 65535. Position of the strongest
+* center is tracked while voting.
+* 
+* @param[in]  list    edge points from ef_detect_edge_list_noalloc()
+* @param[in]  width   width of the edge image
+* @param[in]  height  height of the edge image
+* @param[in]  r_min   smallest radius
+* @param[in]  r_max   largest radius
+* @param[out] acc     memory for IMG_CIRCLE_ACC16 accumulator
+* @param[out] row     row of the best center, (wg_uint)-1 if no votes
+* @param[out] col     column of the best center, (wg_uint)-1 if no votes
+* @param[out] votes   number of votes of the best center
+* 
+* @retval WG_SUCCESS
+* @retval WG_FAILURE
+*/
+wg_status
+ef_detect_circle_gradient(const Ef_edge_list *list, wg_uint width, 
+        wg_uint height, wg_uint r_min, wg_uint r_max, Wg_image *acc, 
+        wg_uint *row, wg_uint *col, wg_uint *votes)
+{
+    wg_status status = WG_FAILURE;
+
+    CHECK_FOR_NULL_PARAM(acc);
+
+    status = img_fill(width, height, sizeof (wg_uint16), IMG_CIRCLE_ACC16, 
+            acc);
+    if (WG_SUCCESS != status){
+        return WG_FAILURE;
+    }
+
+    status = ef_detect_circle_gradient_noalloc(list, r_min, r_max, acc, 
+            row, col, votes);
+    if (WG_SUCCESS != status){
+        img_cleanup(acc);
+    }
+
+    return status;
+}
+
+/** 
+* @brief Detect circles voting along gradient into a preallocated 
+*        accumulator
+*
+* @see ef_detect_circle_gradient()
+* 
+* @param[in]  list    edge points from ef_detect_edge_list_noalloc()
+* @param[in]  r_min   smallest radius
+* @param[in]  r_max   largest radius
+* @param[out] acc     accumulator of the size of the edge image, 
+*                     2 bytes per pixel
+* @param[out] row     row of the best center, (wg_uint)-1 if no votes
+* @param[out] col     column of the best center, (wg_uint)-1 if no votes
+* @param[out] votes   number of votes of the best center
+* 
+* @retval WG_SUCCESS
+* @retval WG_FAILURE
+*/
+wg_status
+ef_detect_circle_gradient_noalloc(const Ef_edge_list *list, 
+        wg_uint r_min, wg_uint r_max, Wg_image *acc, 
+        wg_uint *row, wg_uint *col, wg_uint *votes)
+{
+    wg_uint16 *acc_pixel = NULL;
+    wg_uint max_value = 0;
+    wg_uint max_x = (wg_uint)-1;
+    wg_uint max_y = (wg_uint)-1;
+    wg_int width = 0;
+    wg_int height = 0;
+    wg_int x = 0;
+    wg_int y = 0;
+    wg_int dx = 0;
+    wg_int dy = 0;
+    wg_int cx = 0;
+    wg_int cy = 0;
+    wg_uint r = 0;
+    wg_uint i = 0;
+    wg_double norm = 0.0;
+
+    CHECK_FOR_NULL_PARAM(list);
+    CHECK_FOR_NULL_PARAM(acc);
+    CHECK_FOR_NULL_PARAM(row);
+    CHECK_FOR_NULL_PARAM(col);
+    CHECK_FOR_NULL_PARAM(votes);
+    CHECK_FOR_COND(r_min <= r_max);
+
+    if (acc->components_per_pixel != sizeof (wg_uint16)){
+        WG_ERROR("Invalid accumulator! Passed %u bytes per pixel expect %u\n",
+                acc->components_per_pixel, (wg_uint)sizeof (wg_uint16));
+        return WG_FAILURE;
+    }
+
+    /* accumulator may come from a pool */
+    acc->type = IMG_CIRCLE_ACC16;
+    memset(acc->image, '\0', acc->size);
+
+    width  = FPPOS_VAL(acc->width);
+    height = FPPOS_VAL(acc->height);
+
+    for (i = 0; i < list->num; ++i){
+        if ((list->gx[i] == 0) && (list->gy[i] == 0)){
+            continue;
+        }
+
+        /* unit step along the gradient in fixed point */
+        norm = FPPOS_MAX / sqrt((wg_double)list->gx[i] * list->gx[i] + 
+                (wg_double)list->gy[i] * list->gy[i]);
+        dx = (wg_int)(list->gx[i] * norm);
+        dy = (wg_int)(list->gy[i] * norm);
+
+        x = FPPOS_VAL(list->x[i]) + FPPOS_MAX / 2 + dx * (wg_int)r_min;
+        y = FPPOS_VAL(list->y[i]) + FPPOS_MAX / 2 + dy * (wg_int)r_min;
+
+        for (r = r_min; r <= r_max; ++r, x += dx, y += dy){
+            if ((x < 0) || (y < 0) || (x >= width) || (y >= height)){
+                break;
+            }
+
+            cx = FPPOS_INT(x);
+            cy = FPPOS_INT(y);
+
+            acc_pixel = (wg_uint16*)acc->rows[cy] + cx;
+            if (*acc_pixel < 0xffff){
+                ++*acc_pixel;
+            }
+
+            if (*acc_pixel > max_value){
+                max_value = *acc_pixel;
+                max_x = cx;
+                max_y = cy;
+            }
+        }
+    }
+
+    *row   = max_y;
+    *col   = max_x;
+    *votes = max_value;
+
+    return WG_SUCCESS;
+}
 
 cam_status
 ef_acc_get_max(Wg_image *acc, wg_uint *row_par, wg_uint *col_par, 
@@ -195,6 +459,7 @@ ef_acc_get_max(Wg_image *acc, wg_uint *row_par, wg_uint *col_par,
     wg_uint row = 0;
     wg_uint col = 0 ;
     wg_uint *acc_pixel = NULL;
+    wg_uint16 *acc16_pixel = NULL;
     wg_uint max_value = 0;
     wg_uint x = 0;
     wg_uint y = 0;
@@ -208,7 +473,7 @@ ef_acc_get_max(Wg_image *acc, wg_uint *row_par, wg_uint *col_par,
     x = (wg_uint)-1;
     y = (wg_uint)-1;
 
-    if (acc->type != IMG_CIRCLE_ACC){
+    if ((acc->type != IMG_CIRCLE_ACC) && (acc->type != IMG_CIRCLE_ACC16)){
         WG_ERROR("Invalig image format! Passed %d expect %d\n", 
                 acc->type, IMG_CIRCLE_ACC);
         return CAM_FAILURE;
@@ -218,12 +483,23 @@ ef_acc_get_max(Wg_image *acc, wg_uint *row_par, wg_uint *col_par,
     img_get_height(acc, &height);
 
     for (row = 0; row < height; ++row){
-        img_get_row(acc, row, (wg_uchar**)&acc_pixel);
-        for (col = 0; col < width; ++col, ++acc_pixel){
-            if (*acc_pixel > max_value){
-                max_value = *acc_pixel;
-                x = col;
-                y = row;
+        if (acc->type == IMG_CIRCLE_ACC16){
+            img_get_row(acc, row, (wg_uchar**)&acc16_pixel);
+            for (col = 0; col < width; ++col, ++acc16_pixel){
+                if (*acc16_pixel > max_value){
+                    max_value = *acc16_pixel;
+                    x = col;
+                    y = row;
+                }
+            }
+        }else{
+            img_get_row(acc, row, (wg_uchar**)&acc_pixel);
+            for (col = 0; col < width; ++col, ++acc_pixel){
+                if (*acc_pixel > max_value){
+                    max_value = *acc_pixel;
+                    x = col;
+                    y = row;
+                }
             }
         }
     }
@@ -253,6 +529,24 @@ ef_filter(Wg_image *img, Wg_image *dest, ...)
     return status;
 }
 
+cam_status
+ef_filter_noalloc(Wg_image *img, Wg_image *dest, ...)
+{
+    va_list args;
+    cam_status status = CAM_FAILURE;
+
+    CHECK_FOR_NULL_PARAM(img);
+    CHECK_FOR_NULL_PARAM(dest);
+
+    va_start(args, dest);
+
+    status = img_hsv_filter_noalloc(img, dest, args);
+
+    va_end(args);
+
+    return status;
+}
+
 cam_status
 ef_acc_2_gs(Wg_image *acc, Wg_image *acc_gs)
 {
@@ -268,7 +562,7 @@ ef_acc_2_gs(Wg_image *acc, Wg_image *acc_gs)
     CHECK_FOR_NULL_PARAM(acc);
     CHECK_FOR_NULL_PARAM(acc_gs);
 
-    if (acc->type != IMG_CIRCLE_ACC){
+    if ((acc->type != IMG_CIRCLE_ACC) && (acc->type != IMG_CIRCLE_ACC16)){
         WG_ERROR("Invalig image format! Passed %d expect %d\n", 
                 acc->type, IMG_CIRCLE_ACC);
         return CAM_FAILURE;
@@ -283,19 +577,19 @@ ef_acc_2_gs(Wg_image *acc, Wg_image *acc_gs)
         return CAM_FAILURE;
     }
 
-    for (row = 0; row < height; ++row){
-        img_get_row(acc, row, (wg_uchar**)&acc_pixel);
-        for (col = 0; col < width; ++col, ++acc_pixel){
-            max_val = WG_MAX(max_val, *acc_pixel);
-        }
-    }
+    ef_acc_get_max(acc, &row, &col, &max_val);
 
     if (max_val != 0){
         for (row = 0; row < height; ++row){
             img_get_row(acc, row, (wg_uchar**)&acc_pixel);
             img_get_row(acc_gs, row, (wg_uchar**)&gs_pixel);
-            for (col = 0; col < width; ++col, ++gs_pixel, ++acc_pixel){
-                *gs_pixel = (GS_PIXEL_MAX * (*acc_pixel) / max_val);
+            for (col = 0; col < width; ++col, ++gs_pixel){
+                if (acc->type == IMG_CIRCLE_ACC16){
+                    *gs_pixel = GS_PIXEL_MAX * 
+                        ((wg_uint16*)acc_pixel)[col] / max_val;
+                }else{
+                    *gs_pixel = GS_PIXEL_MAX * acc_pixel[col] / max_val;
+                }
             }
         }
     }
@@ -374,6 +668,15 @@ ef_smooth(Wg_image *img, Wg_image *new_img)
 
     CHECK_FOR_NULL_PARAM(img);
 
+    /* binary masks are counted 64 pixels at once */
+    if (img->type == IMG_BITMASK){
+        if (img_fill(img->width - 4, img->height - 4, BITMASK_COMPONENT_NUM,
+                    IMG_BITMASK, new_img) != WG_SUCCESS){
+            return WG_FAILURE;
+        }
+        return img_bitmask_smooth_noalloc(img, new_img);
+    }
+
     if (img->type != IMG_GS){
         WG_ERROR("Invalig image format! Passed %d expect %d\n", 
                 img->type, IMG_GS);
@@ -428,157 +731,875 @@ ef_smooth(Wg_image *img, Wg_image *new_img)
     return CAM_SUCCESS;
 }
 
+/** 
+* @brief Smooth a binary mask with a box of any size
+*
+* Creates new_img of the same size and type as img and runs
+* ef_smooth_box_noalloc().
+* 
+* @param img      binary grayscale image or IMG_BITMASK
+* @param new_img  memory to store smoothed image
+* @param radius   box spans 2 * radius + 1 pixels in each dimension
+* @param votes    set pixels in the box needed to set the pixel
+* 
+* @retval WG_SUCCESS
+* @retval WG_FAILURE
+*/
 wg_status
-ef_detect_edge(Wg_image *img, Wg_image *new_img)
+ef_smooth_box(Wg_image *img, Wg_image *new_img, wg_uint radius, 
+        wg_uint votes)
 {
-    wg_uint width = 0;
-    wg_uint height = 0;
-    wg_uint row = 0;
-    wg_uint col = 0;
-    gray_pixel *gs_pixel = NULL;
-    gray_pixel *gs_new_pixel = NULL;
-    wg_uint rd = 0;
-    wg_uint rd2 = 0;
+    Ef_box box;
+    wg_status status = WG_FAILURE;
 
     CHECK_FOR_NULL_PARAM(img);
     CHECK_FOR_NULL_PARAM(new_img);
 
-    if (img->type != IMG_GS){
-        WG_ERROR("Invalig image format! Passed %d expect %d\n", 
-                img->type, IMG_GS);
-        return CAM_FAILURE;
+    status = img_fill(img->width, img->height, img->components_per_pixel,
+            img->type, new_img);
+    if (WG_SUCCESS != status){
+        return WG_FAILURE;
     }
 
-    img_get_width(img, &width);
-    img_get_height(img, &height);
-
-    rd = width;
-    rd2 = rd + rd;
-
-    width  -= 2;
-    height -= 2;
-
-    img_fill(width, height, GS_COMPONENT_NUM, IMG_GS,
-            new_img);
+    ef_box_init(&box, 0);
 
-    for (row = 0; row < height; ++row){
-        img_get_row(img, row, (wg_uchar**)&gs_pixel);
-        img_get_row(new_img, row, (wg_uchar**)&gs_new_pixel);
-        for (col = 0; col < width; ++col, ++gs_pixel, ++gs_new_pixel){
-            *gs_new_pixel = WG_MAX(
-                    abs(gs_pixel[0] - gs_pixel[2] + 
-                        (gs_pixel[rd] << 1) - (gs_pixel[rd + 2] << 1) +
-                        gs_pixel[rd2] - gs_pixel[rd2 + 2]),
-                    abs(gs_pixel[0] + (gs_pixel[1] << 1) + gs_pixel[2] -
-                        gs_pixel[rd2] - (gs_pixel[rd2 + 1] << 1) - 
-                        gs_pixel[rd2 + 2])
-                    );
-        }
+    status = ef_smooth_box_noalloc(img, new_img, radius, votes, &box);
+    if (WG_SUCCESS != status){
+        img_cleanup(new_img);
     }
 
-    return CAM_SUCCESS;
+    ef_box_cleanup(&box);
+
+    return status;
 }
 
-WG_PRIVATE wg_boolean
-hist_check(Wg_image *img, wg_uint row, wg_uint col)
+/** 
+* @brief Initialize work memory of box smoothing
+* 
+* @param box       box smoothing work memory
+* @param capacity  number of column sums to allocate up front, may be 0
+* 
+* @retval WG_SUCCESS
+* @retval WG_FAILURE
+*/
+wg_status
+ef_box_init(Ef_box *box, wg_uint capacity)
 {
-    wg_uint width = 0;
-    wg_uint height = 0;
+    CHECK_FOR_NULL_PARAM(box);
 
-    img_get_width(img, &width);
-    img_get_height(img, &height);
+    memset(box, '\0', sizeof (Ef_box));
 
-    return (col >= 1) && (col < width - 2) && (row >= 1) && (row < height - 2);
+    return (capacity > 0) ? box_grow(box, capacity) : WG_SUCCESS;
 }
 
-WG_PRIVATE wg_status
-hist_connect(Wg_image *img, wg_uint row, wg_uint col, wg_uint low)
+/** 
+* @brief Release work memory of box smoothing
+* 
+* @param box  box smoothing work memory
+*/
+void
+ef_box_cleanup(Ef_box *box)
 {
-    gray_pixel *gs_pixel = NULL;
-    wg_uint x1 = 0;
-    wg_uint y1 = 0;
-    gray_pixel pix = 0;
-
-    for (x1 = col - 1; x1 <= col + 1; ++x1){
-        for (y1 = row - 1; y1 <= row + 1; ++y1, ++gs_pixel){
-            img_get_pixel(img, y1, x1, (wg_uchar**)&gs_pixel);
-            pix = *gs_pixel;
-            if ((pix >= low) && (pix != 255) && hist_check(img, y1, x1)){
-                *gs_pixel = 255;
-                hist_connect(img, y1, x1, low);
-            }
-        }
+    if (NULL != box){
+        WG_FREE(box->col_sum);
+        memset(box, '\0', sizeof (Ef_box));
     }
 
-    return WG_SUCCESS;
+    return;
 }
 
+/** 
+* @brief Smooth a binary mask with a box of any size into a preallocated
+*        image
+*
+* A pixel is set when at least votes pixels of the box around it are set,
+* ef_smooth() is radius 2 with 12 votes. Pixels outside the image repeat
+* the nearest border pixel so the size does not change. Box sums are kept
+* per column and slid along the row, the cost per pixel does not depend 
+* on the radius. Column sums are kept in box, memory is allocated only 
+* when the image is wider than any image before.
+* 
+* @param img      binary grayscale image or IMG_BITMASK
+* @param new_img  image of the same size and type as img, not img
+* @param radius   box spans 2 * radius + 1 pixels in each dimension
+* @param votes    set pixels in the box needed to set the pixel, 1 up to
+*                 the box area
+* @param box      initialized box smoothing work memory
+* 
+* @retval WG_SUCCESS
+* @retval WG_FAILURE
+*/
 wg_status
-ef_hyst_thr(Wg_image *img, wg_uint upp, wg_uint low)
+ef_smooth_box_noalloc(Wg_image *img, Wg_image *new_img, wg_uint radius, 
+        wg_uint votes, Ef_box *box)
 {
-    gray_pixel *gs_pixel = NULL;
-    wg_uint width = 0;
-    wg_uint height = 0;
-    wg_uint row = 0;
-    wg_uint col = 0;
-    gray_pixel pix = 0;
+    wg_int *col_sum = NULL;
+    gray_pixel *gs_new_pixel = NULL;
+    bitmask_word *word = NULL;
+    bitmask_word bits = 0;
+    wg_int width = 0;
+    wg_int height = 0;
+    wg_int r = radius;
+    wg_int row = 0;
+    wg_int col = 0;
+    wg_int k = 0;
+    wg_int sum = 0;
 
     CHECK_FOR_NULL_PARAM(img);
+    CHECK_FOR_NULL_PARAM(new_img);
+    CHECK_FOR_NULL_PARAM(box);
+    CHECK_FOR_COND(img != new_img);
+    CHECK_FOR_RANGE_GT(radius, EF_SMOOTH_RADIUS_MAX);
+    CHECK_FOR_COND((votes > 0) && 
+            (votes <= (2 * radius + 1) * (2 * radius + 1)));
 
-    if (img->type != IMG_GS){
+    if ((img->type != IMG_GS) && (img->type != IMG_BITMASK)){
         WG_ERROR("Invalig image format! Passed %d expect %d\n", 
                 img->type, IMG_GS);
-        return CAM_FAILURE;
+        return WG_FAILURE;
     }
 
-    img_get_width(img, &width);
-    img_get_height(img, &height);
+    if (img_check_geometry(new_img, img->width, img->height, 
+                img->components_per_pixel) != WG_SUCCESS){
+        return WG_FAILURE;
+    }
 
-    for (row = 1; row < height - 2; ++row){
-        img_get_row(img, row, (wg_uchar**)&gs_pixel);
-        for (col = 1; col < width - 2; ++col, ++gs_pixel){
-            pix = *gs_pixel;
-            if ((pix >= upp) && (pix !=255)){
-                *gs_pixel = 255;
-                hist_connect(img, row, col, low);
-            }
-        }
+    new_img->type = img->type;
+
+    width  = img->width;
+    height = img->height;
+
+    if ((0 == width) || (0 == height)){
+        return WG_SUCCESS;
     }
 
-    return WG_SUCCESS;
-}
+    /* r repeated border columns on both sides, no clamping in the row */
+    if ((box->capacity < (wg_uint)(width + 2 * r)) && 
+            (box_grow(box, width + 2 * r) != WG_SUCCESS)){
+        return WG_FAILURE;
+    }
+    memset(box->col_sum, '\0', (width + 2 * r) * sizeof (wg_int));
+    col_sum = box->col_sum + r;
 
+    /* column sums of the box above the first row, border rows repeated */
+    box_row_add(img, 0, col_sum, r + 1);
+    for (k = 1; k <= r; ++k){
+        box_row_add(img, WG_MIN(k, height - 1), col_sum, 1);
+    }
 
+    for (row = 0; row < height; ++row){
+        if (row > 0){
+            box_row_add(img, WG_MIN(row + r, height - 1), col_sum, 1);
+            box_row_add(img, WG_MAX(row - r - 1, 0), col_sum, -1);
+        }
 
-wg_status
-ef_hough_print_acc(Wg_image *img, acc *width_acc)
-{
-    wg_uint width = 0;
-    wg_uint height = 0;
-    wg_uint c = 0;
-    wg_uint m = 0;
-    FILE *f = NULL;
+        for (k = 1; k <= r; ++k){
+            col_sum[-k]            = col_sum[0];
+            col_sum[width - 1 + k] = col_sum[width - 1];
+        }
 
-    f = fopen("log.out", "w");
+        /* box of a column misses its right column when the loop starts */
+        sum = 0;
+        for (k = -r; k < r; ++k){
+            sum += col_sum[k];
+        }
 
-    img_get_width(img, &width);
-    img_get_height(img, &height);
+        img_get_row(new_img, row, (wg_uchar**)&gs_new_pixel);
 
-    for (c = 0; c < height; ++c){
-        fprintf(f, "%3d |", c);
-        for (m = 0; m < 90; ++m){
-            fprintf(f, "%u ", width_acc[c][m]);
+        if (IMG_GS == new_img->type){
+            for (col = 0; col < width; ++col){
+                sum += col_sum[col + r];
+                gs_new_pixel[col] = (sum >= (wg_int)votes) ? 255 : 0;
+                sum -= col_sum[col - r];
+            }
+        }else{
+            word = (bitmask_word*)gs_new_pixel;
+            bits = 0;
+            for (col = 0; col < width; ++col){
+                sum += col_sum[col + r];
+                bits |= (bitmask_word)(sum >= (wg_int)votes) << 
+                    (col % BITMASK_WORD_BITS);
+                sum -= col_sum[col - r];
+                if (BITMASK_WORD_BITS - 1 == col % BITMASK_WORD_BITS){
+                    *word++ = bits;
+                    bits    = 0;
+                }
+            }
+            if (0 != width % BITMASK_WORD_BITS){
+                *word = bits;
+            }
         }
-        fprintf(f, "\n");
     }
 
-    fclose(f);
-
     return WG_SUCCESS;
 }
 
 wg_status
-ef_hough_paint_long_lines(Wg_image *img, acc *width_acc, acc *height_acc)
+ef_detect_edge(Wg_image *img, Wg_image *new_img)
+{
+    wg_status status = WG_FAILURE;
+
+    CHECK_FOR_NULL_PARAM(img);
+    CHECK_FOR_NULL_PARAM(new_img);
+
+    status = img_fill(img->width - 2, img->height - 2, GS_COMPONENT_NUM, 
+            IMG_GS, new_img);
+    if (WG_SUCCESS != status){
+        return WG_FAILURE;
+    }
+
+    status = ef_detect_edge_noalloc(img, new_img);
+    if (WG_SUCCESS != status){
+        img_cleanup(new_img);
+    }
+
+    return status;
+}
+
+wg_status
+ef_detect_edge_noalloc(Wg_image *img, Wg_image *new_img)
+{
+    return detect_edge(img, new_img, NULL, WG_FALSE);
+}
+
+/** 
+* @brief Detect edges and collect edge points
+*
+* Works as ef_detect_edge_noalloc() and in the same pass appends every 
+* non zero pixel of new_img with its gradient to the list. The list is
+* emptied first and grows when needed, so a list reused between frames 
+* stops allocating after the first few frames.
+* 
+* @param img      binary grayscale image or IMG_BITMASK
+* @param new_img  image smaller by 2 pixels in each dimension
+* @param list     initialized edge list
+* 
+* @retval WG_SUCCESS
+* @retval WG_FAILURE
+*/
+wg_status
+ef_detect_edge_list_noalloc(Wg_image *img, Wg_image *new_img, 
+        Ef_edge_list *list)
+{
+    CHECK_FOR_NULL_PARAM(list);
+
+    list->num = 0;
+
+    return detect_edge(img, new_img, list, WG_FALSE);
+}
+
+/** 
+* @brief Detect edges storing gradient magnitude for hysteresis
+*
+* Works as ef_detect_edge_list_noalloc() but magnitude, which reaches 
+* 4 * 255, is saturated to 255 instead of kept in the low byte. Strong 
+* edges then pass thresholds of ef_hyst_noalloc(). Circle and center 
+* detectors read only pixels equal to EF_EDGE, they take the image of 
+* ef_detect_edge_list_noalloc() to keep their thin edges.
+* 
+* @param img      binary grayscale image or IMG_BITMASK
+* @param new_img  image smaller by 2 pixels in each dimension
+* @param list     initialized edge list
+* 
+* @retval WG_SUCCESS
+* @retval WG_FAILURE
+*/
+wg_status
+ef_detect_edge_magnitude_noalloc(Wg_image *img, Wg_image *new_img, 
+        Ef_edge_list *list)
+{
+    CHECK_FOR_NULL_PARAM(list);
+
+    list->num = 0;
+
+    return detect_edge(img, new_img, list, WG_TRUE);
+}
+
+/** 
+* @brief Initialize edge list
+* 
+* @param list      edge list
+* @param capacity  number of points to allocate up front, may be 0
+* 
+* @retval WG_SUCCESS
+* @retval WG_FAILURE
+*/
+wg_status
+ef_edge_list_init(Ef_edge_list *list, wg_uint capacity)
+{
+    CHECK_FOR_NULL_PARAM(list);
+
+    memset(list, '\0', sizeof (Ef_edge_list));
+
+    return (capacity > 0) ? edge_list_grow(list, capacity) : WG_SUCCESS;
+}
+
+/** 
+* @brief Release memory of the edge list
+* 
+* @param list  edge list
+*/
+void
+ef_edge_list_cleanup(Ef_edge_list *list)
+{
+    if (NULL != list){
+        WG_FREE(list->x);
+        WG_FREE(list->y);
+        WG_FREE(list->gx);
+        WG_FREE(list->gy);
+        memset(list, '\0', sizeof (Ef_edge_list));
+    }
+
+    return;
+}
+
+WG_PRIVATE wg_status
+edge_list_grow(Ef_edge_list *list, wg_uint capacity)
+{
+    Ef_edge_list new_list;
+
+    new_list.x  = WG_MALLOC(capacity * sizeof (*list->x));
+    new_list.y  = WG_MALLOC(capacity * sizeof (*list->y));
+    new_list.gx = WG_MALLOC(capacity * sizeof (*list->gx));
+    new_list.gy = WG_MALLOC(capacity * sizeof (*list->gy));
+    new_list.num      = list->num;
+    new_list.capacity = capacity;
+
+    if ((NULL == new_list.x) || (NULL == new_list.y) || 
+        (NULL == new_list.gx) || (NULL == new_list.gy)){
+        WG_ERROR("Can't grow edge list to %u points\n", capacity);
+        new_list.num = 0;
+        ef_edge_list_cleanup(&new_list);
+        return WG_FAILURE;
+    }
+
+    if (list->num > 0){
+        memcpy(new_list.x,  list->x,  list->num * sizeof (*list->x));
+        memcpy(new_list.y,  list->y,  list->num * sizeof (*list->y));
+        memcpy(new_list.gx, list->gx, list->num * sizeof (*list->gx));
+        memcpy(new_list.gy, list->gy, list->num * sizeof (*list->gy));
+    }
+
+    ef_edge_list_cleanup(list);
+    *list = new_list;
+
+    return WG_SUCCESS;
+}
+
+WG_PRIVATE wg_status
+detect_edge(Wg_image *img, Wg_image *new_img, Ef_edge_list *list,
+        wg_boolean saturate)
+{
+    wg_uint width = 0;
+    wg_uint height = 0;
+    wg_uint row = 0;
+    wg_uint col = 0;
+    gray_pixel *gs_pixel = NULL;
+    gray_pixel *gs_new_pixel = NULL;
+    wg_uint rd = 0;
+    wg_uint rd2 = 0;
+    wg_int gx = 0;
+    wg_int gy = 0;
+    wg_int mag = 0;
+
+    CHECK_FOR_NULL_PARAM(img);
+    CHECK_FOR_NULL_PARAM(new_img);
+
+    if (img->type == IMG_BITMASK){
+        return detect_edge_bitmask(img, new_img, list, saturate);
+    }
+
+    if (img->type != IMG_GS){
+        WG_ERROR("Invalig image format! Passed %d expect %d\n", 
+                img->type, IMG_GS);
+        return CAM_FAILURE;
+    }
+
+    img_get_width(img, &width);
+    img_get_height(img, &height);
+
+    rd = width;
+    rd2 = rd + rd;
+
+    width  -= 2;
+    height -= 2;
+
+    if (img_check_geometry(new_img, width, height, GS_COMPONENT_NUM) 
+            != WG_SUCCESS){
+        return WG_FAILURE;
+    }
+
+    new_img->type = IMG_GS;
+
+    for (row = 0; row < height; ++row){
+        img_get_row(img, row, (wg_uchar**)&gs_pixel);
+        img_get_row(new_img, row, (wg_uchar**)&gs_new_pixel);
+        for (col = 0; col < width; ++col, ++gs_pixel, ++gs_new_pixel){
+            gx = gs_pixel[2] - gs_pixel[0] + 
+                (gs_pixel[rd + 2] << 1) - (gs_pixel[rd] << 1) +
+                gs_pixel[rd2 + 2] - gs_pixel[rd2];
+            gy = gs_pixel[rd2] + (gs_pixel[rd2 + 1] << 1) + 
+                gs_pixel[rd2 + 2] - 
+                gs_pixel[0] - (gs_pixel[1] << 1) - gs_pixel[2];
+
+            /* magnitude reaches 4 * 255, only hysteresis wants it whole */
+            mag = WG_MAX(abs(gx), abs(gy));
+            *gs_new_pixel = (WG_TRUE == saturate) ? WG_MIN(mag, 255) : mag;
+
+            if ((NULL != list) && (*gs_new_pixel != 0) &&
+                (edge_list_push(list, col, row, gx, gy) != WG_SUCCESS)){
+                return WG_FAILURE;
+            }
+        }
+    }
+
+    return CAM_SUCCESS;
+}
+
+/** 
+* @brief Edge detection of a bit mask
+*
+* Gives the same edge image and list as detect_edge() for a mask of
+* 0 and 255. Sobel is computed only where the 3x3 window is not uniform,
+* such pixels are found 64 at once.
+*/
+WG_PRIVATE wg_status
+detect_edge_bitmask(Wg_image *img, Wg_image *new_img, Ef_edge_list *list,
+        wg_boolean saturate)
+{
+    const bitmask_word *in_row[3];
+    bitmask_word win[3][3];
+    bitmask_word any = 0;
+    bitmask_word all = 0;
+    bitmask_word edge = 0;
+    gray_pixel *gs_new_pixel = NULL;
+    wg_uint width = 0;
+    wg_uint height = 0;
+    wg_uint words = 0;
+    wg_uint new_words = 0;
+    wg_uint row = 0;
+    wg_uint col = 0;
+    wg_uint i = 0;
+    wg_uint r = 0;
+    wg_uint s = 0;
+    wg_uint b = 0;
+    wg_int gx = 0;
+    wg_int gy = 0;
+    wg_int mag = 0;
+
+    img_get_width(img, &width);
+    img_get_height(img, &height);
+
+    words = BITMASK_ROW_WORDS(width);
+
+    width  -= 2;
+    height -= 2;
+
+    if (img_check_geometry(new_img, width, height, GS_COMPONENT_NUM) 
+            != WG_SUCCESS){
+        return WG_FAILURE;
+    }
+
+    new_img->type = IMG_GS;
+
+    new_words = BITMASK_ROW_WORDS(width);
+
+    for (row = 0; row < height; ++row){
+        img_get_row(new_img, row, (wg_uchar**)&gs_new_pixel);
+        memset(gs_new_pixel, '\0', width);
+
+        for (r = 0; r < 3; ++r){
+            img_get_row(img, row + r, (wg_uchar**)&in_row[r]);
+        }
+
+        for (i = 0; i < new_words; ++i){
+            any = 0;
+            all = ~(bitmask_word)0;
+            for (r = 0; r < 3; ++r){
+                for (s = 0; s < 3; ++s){
+                    win[r][s] = bitmask_word_at(in_row[r], i, words, s);
+                    any |= win[r][s];
+                    all &= win[r][s];
+                }
+            }
+
+            edge = any & ~all;
+            if (new_words - 1 == i){
+                edge &= bitmask_tail(width);
+            }
+
+            while (0 != edge){
+                b    = __builtin_ctzll(edge);
+                edge &= edge - 1;
+                col  = i * BITMASK_WORD_BITS + b;
+
+                gx = ((wg_int)((win[0][2] >> b) & 1) - 
+                      (wg_int)((win[0][0] >> b) & 1) +
+                      ((wg_int)((win[1][2] >> b) & 1) << 1) - 
+                      ((wg_int)((win[1][0] >> b) & 1) << 1) +
+                      (wg_int)((win[2][2] >> b) & 1) - 
+                      (wg_int)((win[2][0] >> b) & 1)) * 255;
+                gy = ((wg_int)((win[2][0] >> b) & 1) + 
+                      ((wg_int)((win[2][1] >> b) & 1) << 1) +
+                      (wg_int)((win[2][2] >> b) & 1) - 
+                      (wg_int)((win[0][0] >> b) & 1) - 
+                      ((wg_int)((win[0][1] >> b) & 1) << 1) -
+                      (wg_int)((win[0][2] >> b) & 1)) * 255;
+
+                /* stored as detect_edge() does, some windows cancel out */
+                mag = WG_MAX(abs(gx), abs(gy));
+                gs_new_pixel[col] = (WG_TRUE == saturate) ? 
+                    WG_MIN(mag, 255) : mag;
+
+                if ((NULL != list) && (gs_new_pixel[col] != 0) &&
+                    (edge_list_push(list, col, row, gx, gy) != WG_SUCCESS)){
+                    return WG_FAILURE;
+                }
+            }
+        }
+    }
+
+    return CAM_SUCCESS;
+}
+
+/** 
+* @brief Add set pixels of a row times weight to column sums
+*/
+WG_PRIVATE void
+box_row_add(const Wg_image *img, wg_uint row, wg_int *col_sum, wg_int weight)
+{
+    const gray_pixel *gs_pixel = NULL;
+    const bitmask_word *word = NULL;
+    bitmask_word bits = 0;
+    wg_uint col = 0;
+    wg_uint i = 0;
+
+    if (IMG_BITMASK == img->type){
+        word = (const bitmask_word*)img->rows[row];
+        for (i = 0; i < BITMASK_ROW_WORDS(img->width); ++i){
+            /* only set pixels change the sums */
+            for (bits = word[i]; 0 != bits; bits &= bits - 1){
+                col_sum[i * BITMASK_WORD_BITS + __builtin_ctzll(bits)] += 
+                    weight;
+            }
+        }
+    }else{
+        gs_pixel = img->rows[row];
+        for (col = 0; col < img->width; ++col){
+            col_sum[col] += (0 != gs_pixel[col]) ? weight : 0;
+        }
+    }
+
+    return;
+}
+
+WG_PRIVATE wg_status
+edge_list_push(Ef_edge_list *list, wg_uint col, wg_uint row, 
+        wg_int gx, wg_int gy)
+{
+    if ((list->num == list->capacity) && 
+        (edge_list_grow(list, WG_MAX(list->capacity << 1, 
+            EF_EDGE_LIST_MIN)) != WG_SUCCESS)){
+        return WG_FAILURE;
+    }
+
+    list->x[list->num]  = col;
+    list->y[list->num]  = row;
+    list->gx[list->num] = gx;
+    list->gy[list->num] = gy;
+    ++list->num;
+
+    return WG_SUCCESS;
+}
+
+/** 
+* @brief Initialize work memory of hysteresis threshold
+* 
+* @param hyst      hysteresis work memory
+* @param capacity  number of pixels to allocate up front, may be 0
+* 
+* @retval WG_SUCCESS
+* @retval WG_FAILURE
+*/
+wg_status
+ef_hyst_init(Ef_hyst *hyst, wg_uint capacity)
+{
+    CHECK_FOR_NULL_PARAM(hyst);
+
+    memset(hyst, '\0', sizeof (Ef_hyst));
+
+    return (capacity > 0) ? hyst_grow(hyst, capacity) : WG_SUCCESS;
+}
+
+/** 
+* @brief Release work memory of hysteresis threshold
+* 
+* @param hyst  hysteresis work memory
+*/
+void
+ef_hyst_cleanup(Ef_hyst *hyst)
+{
+    if (NULL != hyst){
+        WG_FREE(hyst->stack);
+        memset(hyst, '\0', sizeof (Ef_hyst));
+    }
+
+    return;
+}
+
+/** 
+* @brief Hysteresis threshold
+*
+* Pixels not lower than upp are edges, pixels not lower than low are
+* edges when 8-connected to an edge through such pixels. Edges become
+* 255, other pixels 0.
+*
+* Weak pixels are marked first, then every edge is pushed once on an
+* explicit stack which grows to the number of pixels at most, so time
+* and memory are bounded by the image size. Border pixels are cleared
+* up front, neighbours are read without bounds checks.
+* 
+* @param img      grayscale image
+* @param new_img  grayscale image of the same size, may be img
+* @param upp      upper threshold, 1 up to 255
+* @param low      lower threshold, 1 up to upp
+* @param hyst     initialized work memory, reused between calls
+* 
+* @retval WG_SUCCESS
+* @retval WG_FAILURE
+*/
+wg_status
+ef_hyst_noalloc(Wg_image *img, Wg_image *new_img, wg_uint upp, wg_uint low,
+        Ef_hyst *hyst)
+{
+    gray_pixel *gs_pixel = NULL;
+    gray_pixel *gs_new_pixel = NULL;
+    gray_pixel *base = NULL;
+    wg_uint32 *stack = NULL;
+    wg_uint32 top = 0;
+    wg_uint32 off = 0;
+    wg_int nb[8];
+    wg_uint width = 0;
+    wg_uint height = 0;
+    wg_uint row = 0;
+    wg_uint col = 0;
+    wg_uint i = 0;
+
+    CHECK_FOR_NULL_PARAM(img);
+    CHECK_FOR_NULL_PARAM(new_img);
+    CHECK_FOR_NULL_PARAM(hyst);
+    CHECK_FOR_COND((low > 0) && (low <= upp) && (upp <= 255));
+
+    if (img->type != IMG_GS){
+        WG_ERROR("Invalig image format! Passed %d expect %d\n", 
+                img->type, IMG_GS);
+        return WG_FAILURE;
+    }
+
+    img_get_width(img, &width);
+    img_get_height(img, &height);
+
+    if (img_check_geometry(new_img, width, height, GS_COMPONENT_NUM) 
+            != WG_SUCCESS){
+        return WG_FAILURE;
+    }
+
+    new_img->type = IMG_GS;
+
+    if ((width < 3) || (height < 3)){
+        memset(new_img->image, '\0', new_img->size);
+        return WG_SUCCESS;
+    }
+
+    /* one entry per interior pixel is the worst case */
+    if ((hyst->capacity < (width - 2) * (height - 2)) &&
+        (hyst_grow(hyst, (width - 2) * (height - 2)) != WG_SUCCESS)){
+        return WG_FAILURE;
+    }
+
+    base  = new_img->image;
+    stack = hyst->stack;
+
+    nb[0] = -(wg_int)new_img->row_distance - 1;
+    nb[1] = -(wg_int)new_img->row_distance;
+    nb[2] = -(wg_int)new_img->row_distance + 1;
+    nb[3] = -1;
+    nb[4] = 1;
+    nb[5] = new_img->row_distance - 1;
+    nb[6] = new_img->row_distance;
+    nb[7] = new_img->row_distance + 1;
+
+    /* mark weak pixels, push edges, borders never hold a weak pixel */
+    memset(new_img->rows[0], '\0', width);
+    memset(new_img->rows[height - 1], '\0', width);
+    for (row = 1; row < height - 1; ++row){
+        img_get_row(img, row, (wg_uchar**)&gs_pixel);
+        img_get_row(new_img, row, (wg_uchar**)&gs_new_pixel);
+
+        gs_new_pixel[0]         = 0;
+        gs_new_pixel[width - 1] = 0;
+        for (col = 1; col < width - 1; ++col){
+            if (gs_pixel[col] >= upp){
+                gs_new_pixel[col] = EF_HYST_EDGE;
+                stack[top++] = (gs_new_pixel + col) - base;
+            }else if (gs_pixel[col] >= low){
+                gs_new_pixel[col] = EF_HYST_WEAK;
+            }else{
+                gs_new_pixel[col] = 0;
+            }
+        }
+    }
+
+    /* weak pixel is marked before it is pushed, so it is pushed once */
+    while (top > 0){
+        off = stack[--top];
+        for (i = 0; i < ELEMNUM(nb); ++i){
+            if (EF_HYST_WEAK == base[off + nb[i]]){
+                base[off + nb[i]] = EF_HYST_EDGE;
+                stack[top++] = off + nb[i];
+            }
+        }
+    }
+
+    /* weak pixels not reached from an edge */
+    for (row = 1; row < height - 1; ++row){
+        img_get_row(new_img, row, (wg_uchar**)&gs_new_pixel);
+        for (col = 1; col < width - 1; ++col){
+            if (EF_HYST_WEAK == gs_new_pixel[col]){
+                gs_new_pixel[col] = 0;
+            }
+        }
+    }
+
+    return WG_SUCCESS;
+}
+
+/** 
+* @brief Hysteresis threshold in place
+*
+* Works as ef_hyst_noalloc() with work memory allocated for the call.
+* 
+* @param img  grayscale image
+* @param upp  upper threshold
+* @param low  lower threshold
+* 
+* @retval WG_SUCCESS
+* @retval WG_FAILURE
+*/
+wg_status
+ef_hyst_thr(Wg_image *img, wg_uint upp, wg_uint low)
+{
+    Ef_hyst hyst;
+    wg_status status = WG_FAILURE;
+
+    ef_hyst_init(&hyst, 0);
+
+    status = ef_hyst_noalloc(img, img, upp, low, &hyst);
+
+    ef_hyst_cleanup(&hyst);
+
+    return status;
+}
+
+/** 
+* @brief Keep edge points whose pixel is set
+*
+* Used after the edge image was thresholded, order of points is kept.
+* 
+* @param list  edge list
+* @param img   edge image the list was built from
+* 
+* @retval WG_SUCCESS
+* @retval WG_FAILURE
+*/
+wg_status
+ef_edge_list_filter(Ef_edge_list *list, const Wg_image *img)
+{
+    wg_uint num = 0;
+    wg_uint i = 0;
+
+    CHECK_FOR_NULL_PARAM(list);
+    CHECK_FOR_NULL_PARAM(img);
+
+    for (i = 0; i < list->num; ++i){
+        if (0 != img->rows[list->y[i]][list->x[i]]){
+            list->x[num]  = list->x[i];
+            list->y[num]  = list->y[i];
+            list->gx[num] = list->gx[i];
+            list->gy[num] = list->gy[i];
+            ++num;
+        }
+    }
+    list->num = num;
+
+    return WG_SUCCESS;
+}
+
+WG_PRIVATE wg_status
+box_grow(Ef_box *box, wg_uint capacity)
+{
+    wg_int *col_sum = NULL;
+
+    col_sum = WG_MALLOC(capacity * sizeof (wg_int));
+    if (NULL == col_sum){
+        WG_ERROR("Can't grow box sums to %u columns\n", capacity);
+        return WG_FAILURE;
+    }
+
+    WG_FREE(box->col_sum);
+    box->col_sum  = col_sum;
+    box->capacity = capacity;
+
+    return WG_SUCCESS;
+}
+
+WG_PRIVATE wg_status
+hyst_grow(Ef_hyst *hyst, wg_uint capacity)
+{
+    wg_uint32 *stack = NULL;
+
+    stack = WG_MALLOC(capacity * sizeof (wg_uint32));
+    if (NULL == stack){
+        WG_ERROR("Can't grow hysteresis stack to %u pixels\n", capacity);
+        return WG_FAILURE;
+    }
+
+    WG_FREE(hyst->stack);
+    hyst->stack    = stack;
+    hyst->capacity = capacity;
+
+    return WG_SUCCESS;
+}
+
+wg_status
+ef_hough_print_acc(Wg_image *img, acc *width_acc)
+{
+    wg_uint width = 0;
+    wg_uint height = 0;
+    wg_uint c = 0;
+    wg_uint m = 0;
+    FILE *f = NULL;
+
+    f = fopen("log.out", "w");
+
+    img_get_width(img, &width);
+    img_get_height(img, &height);
+
+    for (c = 0; c < height; ++c){
+        fprintf(f, "%3d |", c);
+        for (m = 0; m < 90; ++m){
+            fprintf(f, "%u ", width_acc[c][m]);
+        }
+        fprintf(f, "\n");
+    }
+
+    fclose(f);
+
+    return WG_SUCCESS;
+}
+
+wg_status
+ef_hough_paint_long_lines(Wg_image *img, acc *width_acc, acc *height_acc)
 {
     Img_draw ctx;
     wg_uint width = 0;
@@ -654,8 +1675,6 @@ ef_hough_lines(Wg_image *img, acc **width_acc, acc **height_acc)
     wg_uint height = 0;
     wg_int row = 0;
     wg_int col = 0;
-    wg_int  angle = 0; 
-    wg_int b = 0;
 
     CHECK_FOR_NULL_PARAM(img);
     CHECK_FOR_NULL_PARAM(width_acc);
@@ -680,18 +1699,7 @@ ef_hough_lines(Wg_image *img, acc **width_acc, acc **height_acc)
         img_get_row(img, FPPOS_INT(row), (wg_uchar**)&gs_pixel);
         for (col = 0; col < width; FPPOS_INC(col), ++gs_pixel){
             if (*gs_pixel != 0){
-                for (angle = -45; angle < 45; angle += 1){
-                    b = row - FPPOS_MUL(tan_cache[angle + 45], col);
-                    if ((b < height) && (b > 0)){
-                        ++acc_row[FPPOS_INT(b)][angle + 45];
-                    }
-                }
-                for (angle = 45; angle < 135; angle += 1){
-                    b = col - FPPOS_DIV(row, tan_cache[angle + 45]);
-                    if ((b < width) && (b > 0)){
-                        ++acc_col[FPPOS_INT(b)][angle - 45];
-                    }
-                }
+                hough_vote(acc_row, acc_col, row, col, width, height);
             }
         }
     }
@@ -702,6 +1710,70 @@ ef_hough_lines(Wg_image *img, acc **width_acc, acc **height_acc)
     return WG_SUCCESS;
 }
 
+/** 
+* @brief Hough line transform of the edge list
+*
+* Votes as ef_hough_lines() for every point of the list instead of every
+* non zero pixel of the image.
+* 
+* @param list        edge points
+* @param width       width of the edge image
+* @param height      height of the edge image
+* @param width_acc   memory for accumulator of lines crossing columns
+* @param height_acc  memory for accumulator of lines crossing rows
+* 
+* @retval WG_SUCCESS
+* @retval WG_FAILURE
+*/
+wg_status
+ef_hough_lines_list(const Ef_edge_list *list, wg_uint width, wg_uint height,
+        acc **width_acc, acc **height_acc)
+{
+    acc *acc_col = NULL;
+    acc *acc_row = NULL;
+    wg_uint i = 0;
+
+    CHECK_FOR_NULL_PARAM(list);
+    CHECK_FOR_NULL_PARAM(width_acc);
+    CHECK_FOR_NULL_PARAM(height_acc);
+
+    acc_row = WG_CALLOC(height, sizeof (acc));
+    acc_col = WG_CALLOC(width, sizeof (acc));
+
+    for (i = 0; i < list->num; ++i){
+        hough_vote(acc_row, acc_col, FPPOS_VAL(list->y[i]), 
+                FPPOS_VAL(list->x[i]), FPPOS_VAL(width), FPPOS_VAL(height));
+    }
+
+    *height_acc = acc_row;
+    *width_acc  = acc_col;
+
+    return WG_SUCCESS;
+}
+
+WG_PRIVATE void
+hough_vote(acc *acc_row, acc *acc_col, wg_int row, wg_int col, 
+        wg_int width, wg_int height)
+{
+    wg_int  angle = 0; 
+    wg_int b = 0;
+
+    for (angle = -45; angle < 45; angle += 1){
+        b = row - FPPOS_MUL(tan_cache[angle + 45], col);
+        if ((b < height) && (b > 0)){
+            ++acc_row[FPPOS_INT(b)][angle + 45];
+        }
+    }
+    for (angle = 45; angle < 135; angle += 1){
+        b = col - FPPOS_DIV(row, tan_cache[angle + 45]);
+        if ((b < width) && (b > 0)){
+            ++acc_col[FPPOS_INT(b)][angle - 45];
+        }
+    }
+
+    return;
+}
+
     WG_PRIVATE void 
 init_tan_cache(void)
 {
@@ -755,6 +1827,10 @@ ef_center(Wg_image *img, wg_uint *y, wg_uint *x)
     CHECK_FOR_NULL_PARAM(x);
     CHECK_FOR_NULL_PARAM(y);
 
+    if (img->type == IMG_BITMASK){
+        return img_bitmask_center(img, y, x, NULL);
+    }
+
     if (img->type != IMG_GS){
         WG_ERROR("Invalig image format! Passed %d expect %d\n", 
                 img->type, IMG_GS);
@@ -786,3 +1862,403 @@ ef_center(Wg_image *img, wg_uint *y, wg_uint *x)
     return WG_SUCCESS;
 }
 
+/** 
+* @brief Initialize blob list
+* 
+* @param list      blob list
+* @param capacity  number of blobs to allocate up front, may be 0
+* 
+* @retval WG_SUCCESS
+* @retval WG_FAILURE
+*/
+wg_status
+ef_blob_list_init(Ef_blob_list *list, wg_uint capacity)
+{
+    CHECK_FOR_NULL_PARAM(list);
+
+    memset(list, '\0', sizeof (Ef_blob_list));
+
+    return (capacity > 0) ? blob_list_grow(list, capacity, 0) : WG_SUCCESS;
+}
+
+/** 
+* @brief Release memory of the blob list
+* 
+* @param list  blob list
+*/
+void
+ef_blob_list_cleanup(Ef_blob_list *list)
+{
+    if (NULL != list){
+        WG_FREE(list->blob);
+        WG_FREE(list->run);
+        memset(list, '\0', sizeof (Ef_blob_list));
+    }
+
+    return;
+}
+
+/** 
+* @brief Find 8-connected blobs of a mask
+*
+* First pass splits rows into runs of set pixels and joins runs touching
+* a run of the row above with union-find. Second pass gives every set of
+* joined runs a blob and adds up its moments run by run, so pixels are
+* never labelled one by one. The list is emptied first.
+* 
+* @param img       binary grayscale image or IMG_BITMASK
+* @param list      initialized blob list
+* @param min_area  smaller blobs are dropped
+* 
+* @retval WG_SUCCESS
+* @retval WG_FAILURE
+*/
+wg_status
+ef_blob_find_noalloc(Wg_image *img, Ef_blob_list *list, wg_uint min_area)
+{
+    Ef_run *run = NULL;
+    Ef_blob *blob = NULL;
+    wg_uint prev = 0;
+    wg_uint prev_end = 0;
+    wg_uint cur = 0;
+    wg_uint cur_end = 0;
+    wg_uint row = 0;
+    wg_uint a = 0;
+    wg_uint b = 0;
+    wg_uint i = 0;
+    wg_uint num = 0;
+    wg_uint64 n = 0;
+    wg_uint64 sx = 0;
+    wg_uint64 sxx = 0;
+
+    CHECK_FOR_NULL_PARAM(img);
+    CHECK_FOR_NULL_PARAM(list);
+
+    if ((img->type != IMG_GS) && (img->type != IMG_BITMASK)){
+        WG_ERROR("Invalig image format! Passed %d expect %d\n", 
+                img->type, IMG_GS);
+        return WG_FAILURE;
+    }
+
+    list->num     = 0;
+    list->run_num = 0;
+
+    for (row = 0; row < img->height; ++row){
+        cur = list->run_num;
+        if (row_runs(img, row, list) != WG_SUCCESS){
+            return WG_FAILURE;
+        }
+
+        /* runs may move when the list grows */
+        run      = list->run;
+        prev_end = cur;
+        cur_end  = list->run_num;
+
+        /* join runs overlapping or touching diagonally, root is the
+         * first run
+         */
+        while ((prev < prev_end) && (cur < cur_end)){
+            if (run[prev].x1 + 1 < run[cur].x0){
+                ++prev;
+            }else if (run[cur].x1 + 1 < run[prev].x0){
+                ++cur;
+            }else{
+                a = run_find(run, prev);
+                b = run_find(run, cur);
+                if (a < b){
+                    run[b].parent = a;
+                }else if (b < a){
+                    run[a].parent = b;
+                }
+
+                /* the run ending first can't touch the next one */
+                if (run[prev].x1 < run[cur].x1){
+                    ++prev;
+                }else{
+                    ++cur;
+                }
+            }
+        }
+
+        prev = prev_end;
+    }
+
+    /* parents come before their runs, one pass points all runs to roots */
+    for (i = 0; i < list->run_num; ++i){
+        run[i].parent = run[run[i].parent].parent;
+    }
+
+    /* parent of a root becomes its blob index */
+    for (i = 0; i < list->run_num; ++i){
+        a = run[i].parent;
+        if (a == i){
+            if ((list->num == list->capacity) &&
+                (blob_list_grow(list, WG_MAX(list->capacity << 1, 
+                    EF_BLOB_LIST_MIN), list->run_capacity) != WG_SUCCESS)){
+                return WG_FAILURE;
+            }
+            blob = &list->blob[list->num];
+            memset(blob, '\0', sizeof (Ef_blob));
+            blob->x_min = run[i].x0;
+            blob->x_max = run[i].x1;
+            blob->y_min = run[i].y;
+            blob->y_max = run[i].y;
+            run[i].parent = list->num++;
+        }else{
+            blob = &list->blob[run[a].parent];
+            run[i].parent = run[a].parent;
+        }
+
+        /* moments of a run from sums of integer series */
+        n   = run[i].x1 - run[i].x0 + 1;
+        sx  = ((wg_uint64)run[i].x0 + run[i].x1) * n / 2;
+        sxx = ((wg_uint64)run[i].x1 * (run[i].x1 + 1) * (2 * run[i].x1 + 1) - 
+               (wg_uint64)run[i].x0 * (run[i].x0 - 1) * (2 * run[i].x0 - 1))
+              / 6;
+
+        blob->area   += n;
+        blob->sum_x  += sx;
+        blob->sum_xx += sxx;
+        blob->sum_y  += n * run[i].y;
+        blob->sum_yy += n * run[i].y * run[i].y;
+        blob->sum_xy += sx * run[i].y;
+        blob->x_min = WG_MIN(blob->x_min, run[i].x0);
+        blob->x_max = WG_MAX(blob->x_max, run[i].x1);
+        blob->y_max = WG_MAX(blob->y_max, run[i].y);
+    }
+
+    /* drop small blobs keeping the order */
+    for (i = 0; i < list->num; ++i){
+        blob = &list->blob[i];
+        if (blob->area < min_area){
+            continue;
+        }
+
+        blob->x    = blob->sum_x / blob->area;
+        blob->y    = blob->sum_y / blob->area;
+        blob->mu20 = (wg_double)blob->sum_xx / blob->area - 
+            ((wg_double)blob->sum_x / blob->area) * 
+            ((wg_double)blob->sum_x / blob->area);
+        blob->mu02 = (wg_double)blob->sum_yy / blob->area - 
+            ((wg_double)blob->sum_y / blob->area) * 
+            ((wg_double)blob->sum_y / blob->area);
+        blob->mu11 = (wg_double)blob->sum_xy / blob->area - 
+            ((wg_double)blob->sum_x / blob->area) * 
+            ((wg_double)blob->sum_y / blob->area);
+
+        list->blob[num++] = *blob;
+    }
+    list->num = num;
+
+    return WG_SUCCESS;
+}
+
+/** 
+* @brief Pick the blob most like a filled circle
+*
+* Radius is estimated from the moments, blobs out of the radius range are
+* skipped. Score is the product of roundness, ratio of the small and the
+* large axis, and fill, ratio of the area and the area of an ellipse with
+* the same moments. Hollow, broken or elongated blobs score low.
+* 
+* @param[in]  list   blob list
+* @param[in]  r_min  smallest radius in pixels
+* @param[in]  r_max  largest radius in pixels
+* @param[out] index  best blob
+* 
+* @retval WG_SUCCESS
+* @retval WG_FAILURE  no blob in the radius range
+*/
+wg_status
+ef_blob_best(const Ef_blob_list *list, wg_uint r_min, wg_uint r_max,
+        wg_uint *index)
+{
+    const Ef_blob *blob = NULL;
+    wg_double half_sum = 0.0;
+    wg_double half_diff = 0.0;
+    wg_double l_max = 0.0;
+    wg_double l_min = 0.0;
+    wg_double radius = 0.0;
+    wg_double fill = 0.0;
+    wg_double score = 0.0;
+    wg_double best = -1.0;
+    wg_uint i = 0;
+
+    CHECK_FOR_NULL_PARAM(list);
+    CHECK_FOR_NULL_PARAM(index);
+
+    for (i = 0; i < list->num; ++i){
+        blob = &list->blob[i];
+
+        /* eigenvalues of the covariance are squared half axes / 4 */
+        half_sum  = (blob->mu20 + blob->mu02) / 2.0;
+        half_diff = sqrt((blob->mu20 - blob->mu02) * 
+                (blob->mu20 - blob->mu02) / 4.0 + blob->mu11 * blob->mu11);
+        l_max = half_sum + half_diff;
+        l_min = WG_MAX(half_sum - half_diff, 0.0);
+
+        radius = 2.0 * sqrt(half_sum);
+        if ((radius < r_min) || (radius > r_max) || (l_max <= 0.0)){
+            continue;
+        }
+
+        fill  = blob->area / (4.0 * M_PI * sqrt(l_max * l_min) + 1.0);
+        score = sqrt(l_min / l_max) * WG_MIN(fill, 1.0 / fill);
+
+        /* larger blob wins a tie */
+        if ((score > best) || 
+            ((score == best) && (blob->area > list->blob[*index].area))){
+            best   = score;
+            *index = i;
+        }
+    }
+
+    return (best < 0.0) ? WG_FAILURE : WG_SUCCESS;
+}
+
+/** 
+* @brief Append runs of set pixels of a mask row
+*/
+WG_PRIVATE wg_status
+row_runs(Wg_image *img, wg_uint row, Ef_blob_list *list)
+{
+    const gray_pixel *gs_pixel = NULL;
+    const bitmask_word *word = NULL;
+    bitmask_word bits = 0;
+    bitmask_word gap = 0;
+    wg_uint col = 0;
+    wg_uint base = 0;
+    wg_uint start = 0;
+    wg_uint end = 0;
+    wg_uint i = 0;
+    wg_boolean open = WG_FALSE;
+
+    if (IMG_BITMASK == img->type){
+        word = (const bitmask_word*)img->rows[row];
+        for (i = 0; i < BITMASK_ROW_WORDS(img->width); ++i){
+            base = i * BITMASK_WORD_BITS;
+            bits = word[i];
+
+            /* run from the previous word ends at the first gap */
+            if (WG_TRUE == open){
+                if (~(bitmask_word)0 == bits){
+                    continue;
+                }
+                end = __builtin_ctzll(~bits);
+                if (run_push(list, start, base + end - 1, row) 
+                        != WG_SUCCESS){
+                    return WG_FAILURE;
+                }
+                open = WG_FALSE;
+                bits &= ~(bitmask_word)0 << end;
+            }
+
+            while (0 != bits){
+                start = base + __builtin_ctzll(bits);
+                gap   = ~bits & (~(bitmask_word)0 << (start - base));
+                if (0 == gap){
+                    open = WG_TRUE;
+                    break;
+                }
+                end = __builtin_ctzll(gap);
+                if (run_push(list, start, base + end - 1, row) 
+                        != WG_SUCCESS){
+                    return WG_FAILURE;
+                }
+                bits &= ~(bitmask_word)0 << end;
+            }
+        }
+    }else{
+        gs_pixel = img->rows[row];
+        for (col = 0; col < img->width; ++col){
+            if ((0 != gs_pixel[col]) && (WG_FALSE == open)){
+                start = col;
+                open  = WG_TRUE;
+            }else if ((0 == gs_pixel[col]) && (WG_TRUE == open)){
+                if (run_push(list, start, col - 1, row) != WG_SUCCESS){
+                    return WG_FAILURE;
+                }
+                open = WG_FALSE;
+            }
+        }
+    }
+
+    if (WG_TRUE == open){
+        return run_push(list, start, img->width - 1, row);
+    }
+
+    return WG_SUCCESS;
+}
+
+WG_PRIVATE wg_status
+run_push(Ef_blob_list *list, wg_uint x0, wg_uint x1, wg_uint y)
+{
+    Ef_run *run = NULL;
+
+    if ((list->run_num == list->run_capacity) &&
+        (blob_list_grow(list, list->capacity, 
+            WG_MAX(list->run_capacity << 1, EF_RUN_LIST_MIN)) 
+         != WG_SUCCESS)){
+        return WG_FAILURE;
+    }
+
+    run = &list->run[list->run_num];
+    run->x0     = x0;
+    run->x1     = x1;
+    run->y      = y;
+    run->parent = list->run_num;
+    ++list->run_num;
+
+    return WG_SUCCESS;
+}
+
+/** 
+* @brief Find root run, path is halved on the way
+*/
+WG_PRIVATE wg_uint
+run_find(Ef_run *run, wg_uint i)
+{
+    while (run[i].parent != i){
+        run[i].parent = run[run[i].parent].parent;
+        i = run[i].parent;
+    }
+
+    return i;
+}
+
+WG_PRIVATE wg_status
+blob_list_grow(Ef_blob_list *list, wg_uint capacity, wg_uint run_capacity)
+{
+    Ef_blob *blob = NULL;
+    Ef_run *run = NULL;
+
+    if (capacity != list->capacity){
+        blob = WG_MALLOC(capacity * sizeof (Ef_blob));
+        if (NULL == blob){
+            WG_ERROR("Can't grow blob list to %u blobs\n", capacity);
+            return WG_FAILURE;
+        }
+        if (list->num > 0){
+            memcpy(blob, list->blob, list->num * sizeof (Ef_blob));
+        }
+        WG_FREE(list->blob);
+        list->blob     = blob;
+        list->capacity = capacity;
+    }
+
+    if (run_capacity != list->run_capacity){
+        run = WG_MALLOC(run_capacity * sizeof (Ef_run));
+        if (NULL == run){
+            WG_ERROR("Can't grow blob list to %u runs\n", run_capacity);
+            return WG_FAILURE;
+        }
+        if (list->run_num > 0){
+            memcpy(run, list->run, list->run_num * sizeof (Ef_run));
+        }
+        WG_FREE(list->run);
+        list->run          = run;
+        list->run_capacity = run_capacity;
+    }
+
+    return WG_SUCCESS;
+}
@@ -26,7 +26,8 @@ typedef enum PANE_VERTICLES{
     PANE_VERTICLES_NUM  /*!< number of corners */
 }PANE_VERTICLES;
 
-typedef void (*cd_pane_hit_cb)(wg_float x, wg_float y, void *user_data);
+typedef void (*cd_pane_hit_cb)(wg_float x, wg_float y, 
+        const Wg_timestamp *stamp, void *user_data);
 
 /** 
 * @brief Collision region
@@ -73,6 +74,7 @@ typedef struct Cd_instance{
     void           *hit_cb_user_data;          /*!< hit callback data       */
     int             state;                     /*!< detector state          */
     Wg_point2d      position[CD_POSITION_NUM]; /*!< position buffer         */
+    Wg_timestamp    stamp[CD_POSITION_NUM];    /*!< capture time of points  */
     wg_uint         position_index;            /*!< position buffer head    */
     Cd_bar          top_bar;                   /*!< top bar region          */
     Cd_bar          bottom_bar;                /*!< bottom bar region       */
@@ -97,7 +99,8 @@ WG_PUBLIC wg_status
 cd_set_hit_callback(Cd_instance *pane, cd_pane_hit_cb hit_cb, void *user_data);
 
 WG_PUBLIC wg_status
-cd_add_position(Cd_instance *pane, const Wg_point2d *point);
+cd_add_position(Cd_instance *pane, const Wg_point2d *point,
+        const Wg_timestamp *stamp);
 
 WG_PUBLIC wg_status
 cd_get_pane(Cd_instance *pane, Cd_pane *pane_dimention);
@@ -8,18 +8,154 @@ typedef wg_uint acc[90];
 
 #define IMG_CIRCLE_ACC    (IMG_USER + 1)
 
+/** @brief Accumulator of ef_detect_circle_gradient(), wg_uint16 votes */
+#define IMG_CIRCLE_ACC16  (IMG_USER + 2)
+
+/** @brief Largest box radius of ef_smooth_box() */
+#define EF_SMOOTH_RADIUS_MAX  64
+
+/** @brief Value of an edge pixel used by the circle detector */
+#define EF_EDGE           255
+
+/** 
+* @brief Edge points found by ef_detect_edge_list_noalloc()
+*
+* Structure of arrays, entry i is one point. Coordinates are in the edge 
+* image, gradient points from dark to bright.
+*/
+typedef struct Ef_edge_list{
+    wg_uint16 *x;         /*!< column of a point                */
+    wg_uint16 *y;         /*!< row of a point                   */
+    wg_int16  *gx;        /*!< horizontal Sobel gradient        */
+    wg_int16  *gy;        /*!< vertical Sobel gradient          */
+    wg_uint   num;        /*!< number of points                 */
+    wg_uint   capacity;   /*!< number of allocated entries      */
+}Ef_edge_list;
+
+/** 
+* @brief Run of set pixels in a mask row, used by ef_blob_find_noalloc()
+*/
+typedef struct Ef_run{
+    wg_uint16 x0;         /*!< first column                     */
+    wg_uint16 x1;         /*!< last column                      */
+    wg_uint16 y;          /*!< row                              */
+    wg_uint   parent;     /*!< union-find parent run, then blob */
+}Ef_run;
+
+/** 
+* @brief 8-connected region of set mask pixels
+*
+* Sums are raw moments, centroid and central moments are filled when the
+* blob is complete. Central moments are per pixel, for a disc of radius R
+* mu20 and mu02 are R^2 / 4 and mu11 is 0.
+*/
+typedef struct Ef_blob{
+    wg_uint   area;       /*!< number of pixels                 */
+    wg_uint16 x_min;      /*!< leftmost column                  */
+    wg_uint16 x_max;      /*!< rightmost column                 */
+    wg_uint16 y_min;      /*!< top row                          */
+    wg_uint16 y_max;      /*!< bottom row                       */
+    wg_uint64 sum_x;      /*!< sum of columns                   */
+    wg_uint64 sum_y;      /*!< sum of rows                      */
+    wg_uint64 sum_xx;     /*!< sum of squared columns           */
+    wg_uint64 sum_yy;     /*!< sum of squared rows              */
+    wg_uint64 sum_xy;     /*!< sum of column times row          */
+    wg_uint   x;          /*!< centroid column                  */
+    wg_uint   y;          /*!< centroid row                     */
+    wg_double mu20;       /*!< variance of columns              */
+    wg_double mu02;       /*!< variance of rows                 */
+    wg_double mu11;       /*!< covariance of columns and rows   */
+}Ef_blob;
+
+/** 
+* @brief Blobs found by ef_blob_find_noalloc()
+*
+* Blobs are ordered by their top row. Runs are working memory kept so a
+* list reused between frames stops allocating.
+*/
+typedef struct Ef_blob_list{
+    Ef_blob *blob;        /*!< blobs                            */
+    wg_uint  num;         /*!< number of blobs                  */
+    wg_uint  capacity;    /*!< number of allocated blobs        */
+    Ef_run  *run;         /*!< runs of the last mask            */
+    wg_uint  run_num;     /*!< number of runs                   */
+    wg_uint  run_capacity;/*!< number of allocated runs         */
+}Ef_blob_list;
+
+/** @brief Pixel of a hysteresis threshold result which is an edge */
+#define EF_HYST_EDGE      255
+
+/** @brief Pixel waiting for an edge neighbour, never left in a result */
+#define EF_HYST_WEAK      1
+
+/** 
+* @brief Work memory of ef_hyst_noalloc()
+*
+* Stack of pixels whose neighbours are not checked yet, it grows to the
+* number of pixels of the largest image once.
+*/
+typedef struct Ef_hyst{
+    wg_uint32 *stack;     /*!< pixel offsets                    */
+    wg_uint   capacity;   /*!< number of allocated entries      */
+}Ef_hyst;
+
+/** 
+* @brief Work memory of ef_smooth_box_noalloc()
+*
+* Column sums of a row, it grows to the widest image once.
+*/
+typedef struct Ef_box{
+    wg_int    *col_sum;   /*!< column sums with repeated borders */
+    wg_uint   capacity;   /*!< number of allocated sums          */
+}Ef_box;
+
 WG_PUBLIC wg_status
 ef_detect_edge(Wg_image *img, Wg_image *new_img);
 
+WG_PUBLIC wg_status
+ef_detect_edge_noalloc(Wg_image *img, Wg_image *new_img);
+
+WG_PUBLIC wg_status
+ef_detect_edge_list_noalloc(Wg_image *img, Wg_image *new_img, 
+        Ef_edge_list *list);
+
+WG_PUBLIC wg_status
+ef_detect_edge_magnitude_noalloc(Wg_image *img, Wg_image *new_img, 
+        Ef_edge_list *list);
+
+WG_PUBLIC wg_status
+ef_edge_list_init(Ef_edge_list *list, wg_uint capacity);
+
+WG_PUBLIC void
+ef_edge_list_cleanup(Ef_edge_list *list);
+
 WG_PUBLIC wg_status
 ef_smooth(Wg_image *img, Wg_image *new_img);
 
+WG_PUBLIC wg_status
+ef_smooth_box(Wg_image *img, Wg_image *new_img, wg_uint radius, 
+        wg_uint votes);
+
+WG_PUBLIC wg_status
+ef_smooth_box_noalloc(Wg_image *img, Wg_image *new_img, wg_uint radius, 
+        wg_uint votes, Ef_box *box);
+
+WG_PUBLIC wg_status
+ef_box_init(Ef_box *box, wg_uint capacity);
+
+WG_PUBLIC void
+ef_box_cleanup(Ef_box *box);
+
 WG_PUBLIC wg_status
 ef_init(void);
 
 WG_PUBLIC wg_status
 ef_hough_lines(Wg_image *img, acc **width_acc, acc **height_acc);
 
+WG_PUBLIC wg_status
+ef_hough_lines_list(const Ef_edge_list *list, wg_uint width, wg_uint height,
+        acc **width_acc, acc **height_acc);
+
 WG_PUBLIC wg_status
 ef_hough_paint_lines(Wg_image *img, acc *width_acc, acc *height_acc, wg_uint value);
 
@@ -35,21 +171,67 @@ ef_threshold(Wg_image *img, gray_pixel value);
 WG_PUBLIC wg_status
 ef_detect_circle(Wg_image *img, Wg_image *acc);
 
+WG_PUBLIC wg_status
+ef_detect_circle_noalloc(Wg_image *img, Wg_image *acc);
+
+WG_PUBLIC wg_status
+ef_detect_circle_list_noalloc(Wg_image *img, const Ef_edge_list *list,
+        Wg_image *acc);
+
+WG_PUBLIC wg_status
+ef_detect_circle_gradient(const Ef_edge_list *list, wg_uint width, 
+        wg_uint height, wg_uint r_min, wg_uint r_max, Wg_image *acc, 
+        wg_uint *row, wg_uint *col, wg_uint *votes);
+
+WG_PUBLIC wg_status
+ef_detect_circle_gradient_noalloc(const Ef_edge_list *list, 
+        wg_uint r_min, wg_uint r_max, Wg_image *acc, 
+        wg_uint *row, wg_uint *col, wg_uint *votes);
+
 WG_PUBLIC cam_status
 ef_acc_save(Wg_image *acc, wg_char *filename, wg_char *type);
 
 WG_PUBLIC wg_status
 ef_hyst_thr(Wg_image *img, wg_uint upp, wg_uint low);
 
+WG_PUBLIC wg_status
+ef_hyst_init(Ef_hyst *hyst, wg_uint capacity);
+
+WG_PUBLIC void
+ef_hyst_cleanup(Ef_hyst *hyst);
+
+WG_PUBLIC wg_status
+ef_hyst_noalloc(Wg_image *img, Wg_image *new_img, wg_uint upp, wg_uint low,
+        Ef_hyst *hyst);
+
+WG_PUBLIC wg_status
+ef_edge_list_filter(Ef_edge_list *list, const Wg_image *img);
+
 WG_PUBLIC cam_status
 ef_acc_2_gs(Wg_image *acc, Wg_image *acc_gs);
 
 WG_PUBLIC cam_status
 ef_filter(Wg_image *img, Wg_image *dest, ...);
 
+WG_PUBLIC cam_status
+ef_filter_noalloc(Wg_image *img, Wg_image *dest, ...);
+
 WG_PUBLIC wg_status
 ef_center(Wg_image *img, wg_uint *y, wg_uint *x);
 
+WG_PUBLIC wg_status
+ef_blob_list_init(Ef_blob_list *list, wg_uint capacity);
+
+WG_PUBLIC void
+ef_blob_list_cleanup(Ef_blob_list *list);
+
+WG_PUBLIC wg_status
+ef_blob_find_noalloc(Wg_image *img, Ef_blob_list *list, wg_uint min_area);
+
+WG_PUBLIC wg_status
+ef_blob_best(const Ef_blob_list *list, wg_uint r_min, wg_uint r_max,
+        wg_uint *index);
+
 WG_PUBLIC cam_status
 ef_acc_get_max(Wg_image *acc, wg_uint *row_par, wg_uint *col_par, 
         wg_uint *votes);
@@ -1,8 +1,40 @@
 #ifndef _SENSOR_H
 #define _SENSOR_H
 
+#include "ef_engine.h"
+
 #define VIDEO_SIZE_MAX 100
 
+/*! \brief Default number of frames in the pipeline ring */
+#define SENSOR_PIPELINE_DEPTH_DEFAULT  4
+
+/*! \brief Maximum number of frames in the pipeline ring */
+#define SENSOR_PIPELINE_DEPTH_MAX      16
+
+/*! \brief No cpu affinity for a pipeline stage */
+#define SENSOR_CPU_ANY                 (-1)
+
+/*! \brief Default smallest radius of the gradient circle detector */
+#define SENSOR_RADIUS_MIN_DEFAULT      8
+
+/*! \brief Default largest radius of the gradient circle detector */
+#define SENSOR_RADIUS_MAX_DEFAULT      64
+
+/*! \brief Default scale denominator of decoded frames, full resolution */
+#define SENSOR_SCALE_DEFAULT           1
+
+/*! \brief Smallest side of the tracking window */
+#define SENSOR_ROI_SIZE_MIN            16
+
+/*! \brief Default number of window frames between full frame searches */
+#define SENSOR_ROI_FULL_PERIOD_DEFAULT 30
+
+/*! \brief Processing time of a pixel after decoding, used to pick a mode */
+#define SENSOR_PIPELINE_NS_DEFAULT     20
+
+/*! \brief Number of free images kept by the sensor image pool */
+#define SENSOR_IMG_POOL_SIZE           ((SENSOR_PIPELINE_DEPTH_MAX + 1) * 4)
+
 /** 
 * @brief Sensor callback id
 */
@@ -32,12 +64,82 @@ typedef enum Sensor_state{
     SENSOR_STOPED              /*!< sensor stoped                          */
 }Sensor_state;
 
+/** 
+* @brief Sensor pipeline stage
+*/
+typedef enum Sensor_stage{
+    SENSOR_STAGE_CAPTURE  = 0  ,   /*!< capture and decode frame           */
+    SENSOR_STAGE_CLASSIFY      ,   /*!< color classification               */
+    SENSOR_STAGE_DETECT        ,   /*!< edge and object detection          */
+
+    SENSOR_STAGE_NUM               /*!< number of stages                   */
+}Sensor_stage;
+
+/** 
+* @brief Object detector used by the detection stage
+*/
+typedef enum Sensor_detector{
+    SENSOR_DETECT_HOUGH    = 0  ,  /*!< circle Hough transform of edge pairs*/
+    SENSOR_DETECT_CENTER        ,  /*!< center of gravity of edges         */
+    SENSOR_DETECT_GRADIENT      ,  /*!< votes along gradient, radius range */
+    SENSOR_DETECT_BLOB          ,  /*!< roundest mask blob, radius range   */
+
+    SENSOR_DETECT_NUM              /*!< number of detectors                */
+}Sensor_detector;
+
+/** 
+* @brief Color space used to classify frames
+*/
+typedef enum Sensor_color_space{
+    SENSOR_COLOR_HSV       = 0  ,  /*!< decode to BGRX, RGB565 table lookup*/
+    SENSOR_COLOR_YCBCR          ,  /*!< decode to YCbCr, table lookup      */
+    SENSOR_COLOR_NUM               /*!< number of color spaces             */
+}Sensor_color_space;
+
+/** 
+* @brief Last detection of the object, predicts the tracking window
+*/
+typedef struct Sensor_track{
+    wg_boolean found;                      /*!< last detection found object */
+    wg_double x;                           /*!< x in camera resolution      */
+    wg_double y;                           /*!< y in camera resolution      */
+    wg_double vx;                          /*!< x change per frame sequence */
+    wg_double vy;                          /*!< y change per frame sequence */
+    wg_uint32 sequence;                    /*!< sequence of last detection  */
+    wg_uint roi_num;                       /*!< window frames since full one*/
+}Sensor_track;
+
+/** 
+* @brief Frame travelling through the sensor stages
+*/
+typedef struct Sensor_frame{
+    Sensor_stage stage;                    /*!< next stage to run           */
+    Wg_image image;                        /*!< decoded BGRX or YCbCr image,
+                                                or YUYV camera buffer      */
+    Wg_frame frame;                        /*!< camera frame held by image  */
+    Wg_image roi_image;                    /*!< tracking window of image    */
+    wg_uchar **roi_rows;                   /*!< row pointers of the window  */
+    wg_uint roi_rows_num;                  /*!< allocated row pointers      */
+    wg_uint roi_x;                         /*!< window column in image      */
+    wg_uint roi_y;                         /*!< window row in image         */
+    Wg_image filtered_image;               /*!< color mask                  */
+    Wg_image edge_image;                   /*!< edges of the mask           */
+    Wg_image acc;                          /*!< circle accumulator          */
+    Ef_edge_list edges;                    /*!< edge points, kept by frame  */
+    Ef_blob_list blobs;                    /*!< mask blobs, kept by frame   */
+    Ef_hyst hyst;                          /*!< edge threshold work memory  */
+    Ef_box box;                            /*!< mask smoothing work memory  */
+    wg_uint x;                             /*!< detected x position         */
+    wg_uint y;                             /*!< detected y position         */
+    wg_uint scale;                         /*!< image scale denominator     */
+}Sensor_frame;
+
 typedef struct Sensor Sensor;
 
 typedef void (*Sensor_def_cb)(const Sensor *, ...);
 typedef void (*Sensor_cb)(const Sensor *, Sensor_cb_type, ...);
 typedef void (*Sensor_xy_cb)(const Sensor *sensor, Sensor_cb_type type, 
-        wg_uint x, wg_uint y, void *user_data);
+        wg_uint x, wg_uint y, const Wg_timestamp *stamp, void *user_data);
 typedef wg_int (*Sensor_hook_int)(const Sensor *sensor, void *data);
 
 /** 
@@ -62,6 +164,35 @@ struct Sensor{
     pthread_cond_t finish;                 /*!< finish condition            */
     wg_boolean complete_request;           /*!< sensor finished             */
 
+    wg_uint pipeline_depth;                /*!< frame ring depth, 0 serial  */
+    wg_int stage_cpu[SENSOR_STAGE_NUM];    /*!< cpu affinity of stages      */
+    Img_pool pool;                         /*!< images recycled by stages   */
+    Sensor_detector detector;              /*!< object detector             */
+    wg_uint radius_min;                    /*!< smallest object radius      */
+    wg_uint radius_max;                    /*!< largest object radius       */
+    wg_uint smooth_radius;                 /*!< mask smoothing box, 0 none  */
+    wg_uint smooth_votes;                  /*!< set pixels to keep a pixel  */
+    wg_uint hyst_upp;                      /*!< strong edge, 0 no threshold */
+    wg_uint hyst_low;                      /*!< weak edge                   */
+    wg_uint roi_size;                      /*!< tracking window, 0 none     */
+    wg_uint roi_full_period;               /*!< window frames per full one  */
+    Sensor_track track;                    /*!< last detection              */
+    wg_uint scale;                         /*!< decode scale denominator    */
+    Sensor_color_space color_space;        /*!< classification color space  */
+    wg_uint color_gen;                     /*!< bumped when range changes   */
+    gray_pixel *rgb_lut;                   /*!< RGB565 classification table */
+    wg_uint rgb_lut_gen;                   /*!< range of rgb_lut            */
+    gray_pixel *ycbcr_lut;                 /*!< YCbCr classification table  */
+    wg_uint ycbcr_lut_gen;                 /*!< range of ycbcr_lut          */
+    Img_jpeg_decoder *jpeg;                /*!< decoder of MJPEG cameras    */
+    wg_uint buffer_num;                    /*!< camera buffers, 0 default   */
+    wg_boolean newest_frame;               /*!< skip frames not processed   */
+    wg_char record_path[VIDEO_SIZE_MAX + 1];/*!< recording file, "" none    */
+    wg_size record_size;                   /*!< size of recording ring      */
+    Wg_cam_recorder recorder;              /*!< recorder of camera frames   */
+    wg_boolean recording;                  /*!< recorder opened             */
+    wg_uint target_fps;                    /*!< negotiated rate, 0 fixed    */
+
 //    Wg_wq detection_wq;                    /*!< workq detection             */
 };
 
@@ -120,4 +251,48 @@ sensor_set_color_range(Sensor *sensor, const Hsv *top, const Hsv *bottom);
 WG_PUBLIC wg_status
 sensor_reset_color_range(Sensor *sensor);
 
+WG_PUBLIC wg_status
+sensor_set_pipeline(Sensor *sensor, wg_uint depth);
+
+WG_PUBLIC wg_status
+sensor_set_stage_affinity(Sensor *sensor, Sensor_stage stage, wg_int cpu);
+
+WG_PUBLIC wg_status
+sensor_set_detector(Sensor *sensor, Sensor_detector detector);
+
+WG_PUBLIC wg_status
+sensor_set_radius_range(Sensor *sensor, wg_uint r_min, wg_uint r_max);
+
+WG_PUBLIC wg_status
+sensor_set_smooth(Sensor *sensor, wg_uint radius, wg_uint votes);
+
+WG_PUBLIC wg_status
+sensor_set_hysteresis(Sensor *sensor, wg_uint upp, wg_uint low);
+
+WG_PUBLIC wg_status
+sensor_set_roi(Sensor *sensor, wg_uint size, wg_uint full_period);
+
+WG_PUBLIC wg_status
+sensor_set_scale(Sensor *sensor, wg_uint scale);
+
+WG_PUBLIC wg_status
+sensor_set_color_space(Sensor *sensor, Sensor_color_space color_space);
+
+WG_PUBLIC wg_status
+sensor_set_latency_mode(Sensor *sensor, wg_boolean newest_frame, 
+        wg_uint buffer_num);
+
+WG_PUBLIC wg_status
+sensor_get_dropped_frames(Sensor *sensor, wg_uint *dropped);
+
+WG_PUBLIC wg_status
+sensor_set_replay_pace(Sensor *sensor, Cam_replay_pace pace, 
+        wg_boolean loop);
+
+WG_PUBLIC wg_status
+sensor_set_recording(Sensor *sensor, const wg_char *path, wg_size size);
+
+WG_PUBLIC wg_status
+sensor_set_target_fps(Sensor *sensor, wg_uint fps);
+
 #endif
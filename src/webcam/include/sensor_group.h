@@ -0,0 +1,70 @@
+#ifndef SENSOR_GROUP_H
+#define SENSOR_GROUP_H
+
+/*! \brief Maximum number of sensors in a group */
+#define SENSOR_GROUP_MAX               4
+
+/*! \brief Maximum number of worker threads of a group */
+#define SENSOR_GROUP_WORKER_MAX        8
+
+/*! \brief Frames of one sensor captured or processed at the same time */
+#define SENSOR_GROUP_FRAME_NUM         2
+
+/*! \brief Longest wait for camera frames before stop requests are checked */
+#define SENSOR_GROUP_POLL_MS           100
+
+/**
+* @brief Sensor serviced by a group
+*/
+typedef struct Sensor_group_member{
+    Sensor *sensor;                        /*!< sensor instance             */
+    Wg_cam_decompressor decomp;            /*!< camera decompressor         */
+    Wg_frame frame;                        /*!< camera frame                */
+    Sensor_frame sframe[SENSOR_GROUP_FRAME_NUM]; /*!< captured frames       */
+    wg_uint head;                          /*!< oldest captured frame       */
+    wg_uint count;                         /*!< frames not processed yet    */
+    wg_boolean busy;                       /*!< worker processes head frame */
+    wg_boolean open;                       /*!< camera is running           */
+    wg_boolean stopping;                   /*!< no more frames captured     */
+}Sensor_group_member;
+
+/**
+* @brief Sensors sharing one capture thread and a pool of workers
+*
+* Member index is the camera id of frames passed to the workers. Frames of
+* one sensor are processed one at a time in capture order, so each sensor
+* keeps its callbacks ordered while workers serve several cameras.
+*/
+typedef struct Sensor_group{
+    Sensor_group_member member[SENSOR_GROUP_MAX]; /*!< sensors             */
+    wg_uint num;                           /*!< number of sensors           */
+
+    pthread_t worker[SENSOR_GROUP_WORKER_MAX]; /*!< worker threads          */
+    wg_uint worker_num;                    /*!< number of workers           */
+
+    wg_uint run[SENSOR_GROUP_MAX];         /*!< members with frames waiting */
+    wg_uint run_head;                      /*!< first member in run         */
+    wg_uint run_num;                       /*!< number of members in run    */
+
+    pthread_mutex_t lock;                  /*!< group lock                  */
+    pthread_cond_t  ready;                 /*!< member queued or stop       */
+    pthread_cond_t  done;                  /*!< frame processed             */
+    wg_boolean stop;                       /*!< workers must finish         */
+}Sensor_group;
+
+WG_PUBLIC wg_status
+sensor_group_init(Sensor_group *group, wg_uint worker_num);
+
+WG_PUBLIC void
+sensor_group_cleanup(Sensor_group *group);
+
+WG_PUBLIC wg_status
+sensor_group_add(Sensor_group *group, Sensor *sensor);
+
+WG_PUBLIC wg_status
+sensor_group_start(Sensor_group *group);
+
+WG_PUBLIC wg_status
+sensor_group_stop(Sensor_group *group);
+
+#endif
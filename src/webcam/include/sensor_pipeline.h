@@ -0,0 +1,49 @@
+#ifndef SENSOR_PIPELINE_H
+#define SENSOR_PIPELINE_H
+
+/** 
+* @brief Ring of frames shared by the pipeline stages
+*/
+typedef struct Sensor_pipeline{
+    Sensor *sensor;                        /*!< sensor instance             */
+    Wg_cam_decompressor *decomp;           /*!< camera decompressor         */
+
+    Sensor_frame frame[SENSOR_PIPELINE_DEPTH_MAX]; /*!< frame ring          */
+    wg_uint depth;                         /*!< number of frames in use     */
+    wg_uint head[SENSOR_STAGE_NUM];        /*!< next frame of each stage    */
+
+    pthread_t worker[SENSOR_STAGE_NUM];    /*!< stage threads               */
+    pthread_mutex_t lock;                  /*!< ring lock                   */
+    pthread_cond_t  ready;                 /*!< frame changed stage         */
+    wg_boolean stop;                       /*!< workers must finish         */
+}Sensor_pipeline;
+
+WG_PUBLIC wg_status
+sensor_pipeline_run(Sensor *sensor, Wg_cam_decompressor *decomp);
+
+WG_PUBLIC wg_boolean
+sensor_is_complete_requested(Sensor *sensor);
+
+WG_PUBLIC wg_status
+sensor_open(Sensor *sensor, wg_uint frame_num, Wg_cam_decompressor *decomp);
+
+WG_PUBLIC void
+sensor_close(Sensor *sensor);
+
+WG_PUBLIC wg_status
+sensor_stage_capture(Sensor *sensor, Wg_cam_decompressor *decomp,
+        Wg_frame *frame, Sensor_frame *sframe);
+
+WG_PUBLIC wg_status
+sensor_stage_classify(Sensor *sensor, Sensor_frame *sframe);
+
+WG_PUBLIC wg_status
+sensor_stage_detect(Sensor *sensor, Sensor_frame *sframe);
+
+WG_PUBLIC void
+sensor_frame_release(Sensor *sensor, Sensor_frame *sframe);
+
+WG_PUBLIC void
+sensor_frame_cleanup(Sensor *sensor, Sensor_frame *sframe);
+
+#endif
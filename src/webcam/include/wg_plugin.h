@@ -4,6 +4,15 @@
 /* todo get rid of this from here */
 #include "gui_display.h"
 
+/*! Environment variable naming a file to record camera frames into */
+#define WG_RECORD_ENV    "WG_RECORD"
+
+/*! Size of the recording ring, a few minutes of MJPEG frames */
+#define WG_RECORD_SIZE   (512 << 20)
+
+/*! Frame rate the camera mode is negotiated for */
+#define WG_TARGET_FPS    30
+
 /** 
 * @brief Update image task structure
 */
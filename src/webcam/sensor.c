@@ -14,6 +14,9 @@
 #include <cam.h>
 
 #include "include/sensor.h"
+#include "include/sensor_pipeline.h"
+#include "include/gui_prim.h"
+#include "include/collision_detect.h"
 
 #include "include/ef_engine.h"
 
@@ -34,7 +37,18 @@ call_user_callback(const Sensor *const sensor, Sensor_cb_type type,
         const Wg_image *const image);
 
 WG_PRIVATE void
-call_user_xy_callback(const Sensor *const sensor, wg_uint x, wg_uint y);
+call_user_xy_callback(const Sensor *const sensor, wg_uint x, wg_uint y,
+        const Wg_timestamp *stamp);
+
+WG_PRIVATE wg_boolean
+track_window(Sensor *sensor, const Sensor_frame *sframe, wg_uint *x, 
+        wg_uint *y, wg_uint *width, wg_uint *height);
+
+WG_PRIVATE void
+track_update(Sensor *sensor, const Sensor_frame *sframe, wg_boolean found);
+
+WG_PRIVATE wg_status
+roi_rows_reserve(Sensor_frame *sframe, wg_uint height);
 
 /** 
 * @brief Initialize sensor
@@ -82,6 +96,66 @@ sensor_init(Sensor *sensor)
     /* disable noise reduction   */
     sensor->noise_reduction = WG_FALSE;
 
+    /* run all stages in the sensor thread */
+    sensor->pipeline_depth = 0;
+    for (i = 0; i < ELEMNUM(sensor->stage_cpu); ++i){
+        sensor->stage_cpu[i] = SENSOR_CPU_ANY;
+    }
+
+    /* object detector           */
+#ifdef G_GENTER
+    sensor->detector   = SENSOR_DETECT_BLOB;
+#else
+    sensor->detector   = SENSOR_DETECT_HOUGH;
+#endif
+    sensor->radius_min = SENSOR_RADIUS_MIN_DEFAULT;
+    sensor->radius_max = SENSOR_RADIUS_MAX_DEFAULT;
+
+    /* mask goes to edge detection unsmoothed */
+    sensor->smooth_radius = 0;
+    sensor->smooth_votes  = 0;
+
+    /* every edge point goes to the detector */
+    sensor->hyst_upp = 0;
+    sensor->hyst_low = 0;
+
+    /* search the whole frame, window is used after sensor_set_roi() */
+    sensor->roi_size        = 0;
+    sensor->roi_full_period = SENSOR_ROI_FULL_PERIOD_DEFAULT;
+    memset(&sensor->track, '\0', sizeof (Sensor_track));
+
+    /* decode at full resolution, decoder is created on start */
+    sensor->scale = SENSOR_SCALE_DEFAULT;
+    sensor->jpeg  = NULL;
+
+    /* process every frame the camera delivers */
+    sensor->buffer_num   = 0;
+    sensor->newest_frame = WG_FALSE;
+
+    /* nothing is recorded */
+    sensor->record_path[0] = '\0';
+    sensor->record_size    = 0;
+    sensor->recording      = WG_FALSE;
+
+    /* capture in the size set by the user */
+    sensor->target_fps = 0;
+
+    /* classify in HSV, tables are built by the first frame */
+    sensor->color_space   = SENSOR_COLOR_HSV;
+    sensor->color_gen     = 1;
+    sensor->rgb_lut_gen   = 0;
+    sensor->ycbcr_lut_gen = 0;
+    sensor->rgb_lut   = WG_MALLOC(IMG_RGB565_LUT_SIZE * sizeof (gray_pixel));
+    sensor->ycbcr_lut = WG_MALLOC(IMG_YCBCR_LUT_SIZE * sizeof (gray_pixel));
+    if ((NULL == sensor->rgb_lut) || (NULL == sensor->ycbcr_lut)){
+        status = WG_FAILURE;
+    }
+
+    /* images recycled between frames */
+    if (img_pool_init(&sensor->pool, SENSOR_IMG_POOL_SIZE) != WG_SUCCESS){
+        status = WG_FAILURE;
+    }
+
     return status;
 }
 
@@ -99,6 +173,14 @@ sensor_cleanup(Sensor *sensor)
     pthread_cond_destroy(&sensor->finish);
     pthread_mutex_destroy(&sensor->lock);
 
+    img_pool_cleanup(&sensor->pool);
+
+    WG_FREE(sensor->rgb_lut);
+    sensor->rgb_lut = NULL;
+
+    WG_FREE(sensor->ycbcr_lut);
+    sensor->ycbcr_lut = NULL;
+
     return;
 }
 
@@ -221,6 +303,7 @@ sensor_set_color_top(Sensor *sensor, const Hsv *color)
     pthread_mutex_lock(&sensor->lock);
 
     sensor->top = *color;
+    ++sensor->color_gen;
 
     pthread_mutex_unlock(&sensor->lock);
 
@@ -245,6 +328,7 @@ sensor_set_color_bottom(Sensor *sensor, const Hsv *color)
     pthread_mutex_lock(&sensor->lock);
 
     sensor->bottom = *color;
+    ++sensor->color_gen;
 
     pthread_mutex_unlock(&sensor->lock);
 
@@ -334,6 +418,8 @@ sensor_add_color(Sensor *sensor, const Hsv *color)
     sensor->bottom.hue =
         color->hue < sensor->bottom.hue ? color->hue - h : sensor->bottom.hue;
 
+    ++sensor->color_gen;
+
     pthread_mutex_unlock(&sensor->lock);
 
     return WG_SUCCESS;
@@ -343,7 +429,9 @@ sensor_add_color(Sensor *sensor, const Hsv *color)
 /** 
 * @brief Start sensor
 *
-* This function must be called from a seperate thread context.
+* This function must be called from a seperate thread context. If a pipeline
+* depth was set by sensor_set_pipeline() the stages run in separate threads
+* connected by a ring of frames, otherwise all stages run in this thread.
 * 
 * @param sensor sensor instance
 * 
@@ -354,42 +442,130 @@ wg_status
 sensor_start(Sensor *sensor)
 {
     Wg_frame frame;
-    Wg_image image;
-    Wg_image acc;
-    Wg_image edge_image;
-    Wg_image hsv_image;
-    Wg_image filtered_image;
-    Wg_image tmp_image;
-    Wg_image bgrx_image;
-    Hsv top;
-    Hsv bottom;
+    Sensor_frame sframe;
     Wg_cam_decompressor decomp;
-    union{
-        cam_status cam;
-        wg_status  wg;
-    }status;
-    wg_uint x = 0;
-    wg_uint y = 0;
-    wg_uint v = 0;
+    wg_status status = WG_FAILURE;
+
+    status = sensor_open(sensor, sensor->pipeline_depth, &decomp);
+    if (WG_SUCCESS != status){
+        return WG_FAILURE;
+    }
+
+    if (sensor->pipeline_depth > 1){
+        sensor_pipeline_run(sensor, &decomp);
+    }else{
+        cam_frame_init(&frame);
+        memset(&sframe, '\0', sizeof (Sensor_frame));
+
+        while (sensor_is_complete_requested(sensor) == WG_FALSE){
+            status = sensor_stage_capture(sensor, &decomp, &frame, &sframe);
+            if (WG_SUCCESS != status){
+                break;
+            }
+
+            if (sensor_stage_classify(sensor, &sframe) == WG_SUCCESS){
+                sensor_stage_detect(sensor, &sframe);
+            }
+
+            sensor_frame_release(sensor, &sframe);
+        }
+
+        sensor_frame_cleanup(sensor, &sframe);
+    }
+
+    sensor_close(sensor);
+
+    return WG_SUCCESS;
+}
+
+/** 
+* @brief Open and start the sensor camera
+*
+* Camera is configured from the sensor settings and started, the sensor
+* enters SENSOR_STARTED state. Must be followed by sensor_close().
+* 
+* @param sensor     sensor instance
+* @param frame_num  frames processed at the same time, each may hold a 
+*                   camera buffer
+* @param decomp     memory to store camera decompressor
+* 
+* @retval WG_SUCCESS
+* @retval WG_FAILURE
+*/
+wg_status
+sensor_open(Sensor *sensor, wg_uint frame_num, Wg_cam_decompressor *decomp)
+{
+    Cam_negotiate_param param;
+    wg_uint buffer_num = 0;
+    cam_status status = CAM_FAILURE;
+
+    CHECK_FOR_NULL_PARAM(sensor);
+    CHECK_FOR_NULL_PARAM(decomp);
 
     ef_init();
 
     /* open camera                  */
-    status.cam = cam_open(&sensor->camera, 0, ENABLE_DECOMPRESSOR);
-    if (CAM_SUCCESS != status.cam){
+    status = cam_open(&sensor->camera, 0, 
+            ENABLE_DECOMPRESSOR | ENABLE_USERPTR);
+    if (CAM_SUCCESS != status){
         return WG_FAILURE;
     }
 
+    pthread_mutex_lock(&sensor->lock);
+    param.target_fps  = sensor->target_fps;
+    param.max_width   = sensor->width;
+    param.max_height  = sensor->height;
+    param.pipeline_ns = SENSOR_PIPELINE_NS_DEFAULT;
+    pthread_mutex_unlock(&sensor->lock);
+
+    /* pick the largest mode this CPU keeps up with, size is the limit */
+    status = CAM_FAILURE;
+    if (0 != param.target_fps){
+        status = cam_negotiate(&sensor->camera, &param, NULL);
+        if (CAM_SUCCESS == status){
+            cam_get_resolution(&sensor->camera, 
+                    &sensor->width, &sensor->height);
+        }
+    }
+
     /* set camera rsolution   */
-    status.cam = cam_set_resolution(&sensor->camera, 
-            sensor->width, sensor->height);
-    if (CAM_SUCCESS != status.cam){
-        return WG_FAILURE;
+    if (CAM_SUCCESS != status){
+        status = cam_set_resolution(&sensor->camera, 
+                sensor->width, sensor->height);
+        if (CAM_SUCCESS != status){
+            cam_close(&sensor->camera);
+            return WG_FAILURE;
+        }
+    }
+
+    /* frames being processed may hold camera buffers */
+    pthread_mutex_lock(&sensor->lock);
+    buffer_num = sensor->buffer_num;
+    if ((0 != buffer_num) && (buffer_num < frame_num + MIN_BUFFER_NUM)){
+        buffer_num = frame_num + MIN_BUFFER_NUM;
     }
+    cam_set_buffer_num(&sensor->camera, buffer_num);
+    cam_set_newest_frame(&sensor->camera, sensor->newest_frame);
+
+    /* first frame is searched as a whole */
+    memset(&sensor->track, '\0', sizeof (Sensor_track));
+
+    /* record native frames, capture format is known at this point */
+    if ('\0' != sensor->record_path[0]){
+        sensor->recording = (cam_recorder_open(&sensor->recorder, 
+                    sensor->record_path, sensor->record_size, 
+                    &sensor->camera) == CAM_SUCCESS);
+    }
+    pthread_mutex_unlock(&sensor->lock);
 
     /* start capturing frames from camera */
-    status.cam = cam_start(&sensor->camera);
-    if (CAM_SUCCESS != status.cam){
+    status = cam_start(&sensor->camera);
+    if (CAM_SUCCESS != status){
+        if (WG_TRUE == sensor->recording){
+            cam_recorder_close(&sensor->recorder);
+            sensor->recording = WG_FALSE;
+        }
+        cam_close(&sensor->camera);
         return WG_FAILURE;
     }
 
@@ -399,9 +575,20 @@ sensor_start(Sensor *sensor)
     /* call user callback     */
     call_user_callback(sensor, CB_SETUP_STOP, NULL);
 
-    /* initialize frame structurem and decompressor  */
-    cam_frame_init(&frame);
-    cam_decompressor(&sensor->camera, &decomp);
+    /* initialize decompressor  */
+    cam_decompressor(&sensor->camera, decomp);
+
+    /* keep libjpeg state between frames of a MJPEG camera */
+    switch (sensor->camera.fmt[CAM_FMT_CAPTURE].fmt.pix.pixelformat){
+    case V4L2_PIX_FMT_MJPEG:
+    case V4L2_PIX_FMT_JPEG:
+        if (img_jpeg_decoder_init(&sensor->jpeg) != WG_SUCCESS){
+            sensor->jpeg = NULL;
+        }
+        break;
+    default:
+        break;
+    }
 
     pthread_mutex_lock(&sensor->lock);
     sensor->state = SENSOR_STARTED;
@@ -409,212 +596,1001 @@ sensor_start(Sensor *sensor)
 
     call_user_callback(sensor, CB_ENTER, NULL);
 
-    for (;;){
-        /* exit loop if asked through sensor->copplete_request */
-        pthread_mutex_lock(&sensor->lock);
-        if (WG_TRUE == sensor->complete_request){
-            sensor->complete_request = WG_FALSE;
-            sensor->state = SENSOR_STOPED;
-            cam_stop(&sensor->camera);
-            cam_close(&sensor->camera);
-            pthread_cond_signal(&sensor->finish);
-            pthread_mutex_unlock(&sensor->lock);
-            return WG_SUCCESS;
-        }
-        pthread_mutex_unlock(&sensor->lock);
+    return WG_SUCCESS;
+}
 
-        /* read and decompress frame           */
-        if (cam_read(&sensor->camera, &frame) == CAM_SUCCESS){
-            status.cam = invoke_decompressor(&decomp, 
-                    frame.start, frame.size, 
-                    frame.width, frame.height, &image);
+/** 
+* @brief Stop and close the sensor camera
+*
+* Sensor enters SENSOR_STOPED state and a pending sensor_stop() returns.
+* 
+* @param sensor sensor instance
+*/
+void
+sensor_close(Sensor *sensor)
+{
+    img_jpeg_decoder_cleanup(sensor->jpeg);
+    sensor->jpeg = NULL;
 
-            cam_discard_frame(&sensor->camera, &frame);
+    if (WG_TRUE == sensor->recording){
+        cam_recorder_close(&sensor->recorder);
+        sensor->recording = WG_FALSE;
+    }
 
-            img_rgb_2_bgrx(&image, &bgrx_image);
-            img_cleanup(&image);
+    pthread_mutex_lock(&sensor->lock);
+    sensor->complete_request = WG_FALSE;
+    sensor->state = SENSOR_STOPED;
+    cam_stop(&sensor->camera);
+    cam_close(&sensor->camera);
+    pthread_cond_signal(&sensor->finish);
+    pthread_mutex_unlock(&sensor->lock);
 
-            /* remove noise if asked         */
-            if (sensor_get_noise_reduction_state(sensor) == WG_TRUE){
-                img_bgrx_median_filter(&bgrx_image, &tmp_image);
-                img_cleanup(&bgrx_image);
+    return;
+}
 
-                bgrx_image = tmp_image;
-            }
+/** 
+* @brief Check if sensor was asked to finish
+* 
+* @param sensor sensor instance
+* 
+* @retval WG_TRUE  stop requested by sensor_stop()
+* @retval WG_FALSE keep running
+*/
+wg_boolean
+sensor_is_complete_requested(Sensor *sensor)
+{
+    wg_boolean flag = WG_FALSE;
 
-            img_bgrx_2_rgb(&bgrx_image, &image);
-            img_cleanup(&bgrx_image);
+    pthread_mutex_lock(&sensor->lock);
+    flag = sensor->complete_request;
+    pthread_mutex_unlock(&sensor->lock);
+
+    return flag;
+}
 
-            /* convert RGB to HSV    */
-            img_rgb_2_hsv_gtk(&image, &hsv_image);
+/** 
+* @brief Capture stage: read, decompress and denoise a frame
+*
+* Frame whose image can't be allocated is dropped, sframe keeps an empty 
+* image and the following stages skip it.
+* 
+* @param sensor  sensor instance
+* @param decomp  camera decompressor
+* @param frame   camera frame
+* @param sframe  sensor frame to fill
+* 
+* @retval WG_SUCCESS
+* @retval WG_FAILURE camera can't deliver frames anymore
+*/
+wg_status
+sensor_stage_capture(Sensor *sensor, Wg_cam_decompressor *decomp,
+        Wg_frame *frame, Sensor_frame *sframe)
+{
+    Wg_image tmp_image;
+    Wg_image image;
+    Wg_timestamp stamp;
+    Img_pool *pool = &sensor->pool;
+    cam_status status = CAM_FAILURE;
+    Sensor_color_space color_space = SENSOR_COLOR_HSV;
+    img_type type = IMG_BGRX;
+    wg_uint comp_num = BGRX_COMPONENT_NUM;
+    wg_boolean noise_reduction = WG_FALSE;
+    wg_uint width  = 0;
+    wg_uint height = 0;
+    wg_uint scale  = 0;
+
+    memset(&tmp_image, '\0', sizeof (Wg_image));
+    memset(&image, '\0', sizeof (Wg_image));
+
+    /* read and decompress frame           */
+    if (cam_read(&sensor->camera, frame) != CAM_SUCCESS){
+        return WG_FAILURE;
+    }
 
-            pthread_mutex_lock(&sensor->lock);
-            top    = sensor->top;
-            bottom = sensor->bottom;
-            pthread_mutex_unlock(&sensor->lock);
+    stamp = frame->stamp;
 
-            /* filter frame           */
-            ef_filter(&hsv_image, &filtered_image, &top, &bottom);
+    /* recorder copies the frame, decoding is left to the replay */
+    if (WG_TRUE == sensor->recording){
+        cam_recorder_write(&sensor->recorder, frame);
+    }
 
-            ef_threshold(&filtered_image, 1);
+    pthread_mutex_lock(&sensor->lock);
+    scale       = sensor->scale;
+    color_space = sensor->color_space;
+    pthread_mutex_unlock(&sensor->lock);
 
-            /* detect edge            */
-            ef_detect_edge(&filtered_image, &edge_image);
+    noise_reduction = sensor_get_noise_reduction_state(sensor);
 
-            call_user_callback(sensor, CB_IMG_EDGE, &edge_image);
+    /* classify YUYV where the driver stored it, the frame keeps the 
+     * buffer until sensor_frame_release()
+     */
+    if ((SENSOR_COLOR_YCBCR == color_space) && (WG_FALSE == noise_reduction)
+            && (cam_frame_image(&sensor->camera, frame, &image) 
+                == CAM_SUCCESS) && (IMG_YUYV == image.type)){
+        sframe->frame = *frame;
+        sframe->image = image;
+        sframe->scale = 1;
 
-#ifndef G_GENTER
-            /* detect circle          */
-            ef_detect_circle(&edge_image, &acc);
+        frame->state = WG_FRAME_EMPTY;
 
-            ef_acc_get_max(&acc, &y, &x, &v);
+        return WG_SUCCESS;
+    }
 
-            call_user_callback(sensor, CB_IMG_ACC, &acc);
+    /* YCbCr skips color conversion of the decoder */
+    if (SENSOR_COLOR_YCBCR == color_space){
+        type     = IMG_YCBCR;
+        comp_num = YCBCR_COMPONENT_NUM;
+    }
 
-            img_cleanup(&acc);
-#else
-            ef_center(&edge_image, &y, &x);
-            call_user_callback(sensor, CB_IMG_ACC, NULL);
-#endif  /* G_CENTER */
-           
-            call_user_callback(sensor, CB_IMG, &image);
-
-            /* inform user about object position   */
-            call_user_xy_callback(sensor, x, y);
-
-            /* release memory         */
-            img_cleanup(&image);
-            img_cleanup(&hsv_image);
-            img_cleanup(&filtered_image);
-            img_cleanup(&edge_image);
+    /* decode straight to the format read by median filter and classifier */
+    if (NULL != sensor->jpeg){
+        /* downscale in DCT domain */
+        img_jpeg_decoder_set_scale(sensor->jpeg, scale);
+        img_jpeg_decoder_get_size(sensor->jpeg, frame->width, frame->height,
+                &width, &height);
+
+        if (img_pool_acquire(pool, width, height, comp_num, type, &image) 
+                == WG_SUCCESS){
+            status = (img_jpeg_decoder_run(sensor->jpeg, 
+                        frame->start, frame->size, &image, type)
+                    == WG_SUCCESS) ? CAM_SUCCESS : CAM_FAILURE;
+        }
+    }else{
+        /* other formats are decoded at full resolution */
+        scale = 1;
+
+        if (img_pool_acquire(pool, frame->width, frame->height, 
+                    comp_num, type, &image) != WG_SUCCESS){
+            status = CAM_FAILURE;
+        }else if (IMG_YCBCR == type){
+            status = invoke_decompressor_ycbcr(decomp, 
+                    frame->start, frame->size, 
+                    frame->width, frame->height, &image);
         }else{
-            pthread_mutex_lock(&sensor->lock);
-            sensor->complete_request = WG_FALSE;
-            sensor->state = SENSOR_STOPED;
-            cam_stop(&sensor->camera);
-            cam_close(&sensor->camera);
-            pthread_cond_signal(&sensor->finish);
-            pthread_mutex_unlock(&sensor->lock);
+            status = invoke_decompressor_bgrx(decomp, 
+                    frame->start, frame->size, 
+                    frame->width, frame->height, &image);
+        }
+    }
+
+    cam_discard_frame(&sensor->camera, frame);
+
+    /* image is empty when it couldn't be allocated */
+    if (NULL == image.image){
+        WG_ERROR("%s: Can't allocate image, frame dropped\n", 
+                sensor->video_dev);
+        return WG_SUCCESS;
+    }
+
+    if (CAM_SUCCESS != status){
+        img_pool_release(pool, &image);
+        return WG_FAILURE;
+    }
+
+    /* remove noise if asked         */
+    if (WG_TRUE == noise_reduction){
+        if (img_pool_acquire(pool, image.width - 2, image.height - 2,
+                    comp_num, type, &tmp_image) != WG_SUCCESS){
+            WG_ERROR("%s: Can't allocate filtered image, frame dropped\n",
+                    sensor->video_dev);
+            img_pool_release(pool, &image);
             return WG_SUCCESS;
         }
+        img_median_filter_noalloc(&image, &tmp_image);
+        img_pool_release(pool, &image);
+
+        image = tmp_image;
     }
 
-    call_user_callback(sensor, CB_EXIT, NULL);
+    image.stamp   = stamp;
+    sframe->image = image;
+    sframe->scale = scale;
 
-    pthread_mutex_lock(&sensor->lock);
-    sensor->complete_request = WG_FALSE;
-    sensor->state = SENSOR_STOPED;
-    cam_stop(&sensor->camera);
-    cam_close(&sensor->camera);
-    pthread_cond_signal(&sensor->finish);
-    pthread_mutex_unlock(&sensor->lock);
     return WG_SUCCESS;
 }
 
 /** 
-* @brief Stop sensor
+* @brief Classification stage: build a mask of the object color
+*
+* Frame whose mask can't be allocated is dropped, the mask stays empty
+* and the detection stage skips it.
 * 
-* @param sensor sensor instance
+* @param sensor  sensor instance
+* @param sframe  sensor frame filled by the capture stage
 * 
 * @retval WG_SUCCESS
-* @retval WG_FALSE
+* @retval WG_FAILURE frame is dropped
 */
 wg_status
-sensor_stop(Sensor *sensor)
+sensor_stage_classify(Sensor *sensor, Sensor_frame *sframe)
 {
+    Hsv top;
+    Hsv bottom;
+    Wg_image smooth_image;
+    const Wg_image *image = &sframe->image;
+    wg_uint gen = 0;
+    wg_uint radius = 0;
+    wg_uint votes = 0;
+    wg_uint width = 0;
+    wg_uint height = 0;
+    wg_boolean roi = WG_FALSE;
+
+    sframe->roi_x = 0;
+    sframe->roi_y = 0;
+
+    /* dropped by the capture stage */
+    if (NULL == sframe->image.image){
+        return WG_FAILURE;
+    }
+
     pthread_mutex_lock(&sensor->lock);
+    top    = sensor->top;
+    bottom = sensor->bottom;
+    gen    = sensor->color_gen;
+    radius = sensor->smooth_radius;
+    votes  = sensor->smooth_votes;
+    roi    = track_window(sensor, sframe, &sframe->roi_x, &sframe->roi_y,
+            &width, &height);
+    pthread_mutex_unlock(&sensor->lock);
 
-    if (SENSOR_STOPED == sensor->state){
-        pthread_mutex_unlock(&sensor->lock);
+    /* object is close to the last detection, later stages see the window */
+    if (WG_TRUE == roi){
+        if ((roi_rows_reserve(sframe, height) == WG_SUCCESS) &&
+            (img_get_subimage_view(&sframe->image, sframe->roi_x, 
+                    sframe->roi_y, width, height, sframe->roi_rows, 
+                    &sframe->roi_image) == WG_SUCCESS)){
+            image = &sframe->roi_image;
+        }else{
+            sframe->roi_x = 0;
+            sframe->roi_y = 0;
+        }
+    }
+
+    /* filter frame without building HSV image, mask keeps 1 bit per pixel */
+    if (img_pool_acquire(&sensor->pool, image->width, image->height,
+            BITMASK_COMPONENT_NUM, IMG_BITMASK, &sframe->filtered_image) 
+            != WG_SUCCESS){
+        WG_ERROR("%s: Can't allocate mask, frame dropped\n", 
+                sensor->video_dev);
         return WG_FAILURE;
     }
 
-    sensor->complete_request = WG_TRUE;
+    /* tables are rebuilt only after the color range changed, only this
+     * stage reads them
+     */
+    if ((IMG_YCBCR == image->type) || (IMG_YUYV == image->type)){
+        if (sensor->ycbcr_lut_gen != gen){
+            img_hsv_range_ycbcr_lut(&top, &bottom, sensor->ycbcr_lut);
+            sensor->ycbcr_lut_gen = gen;
+        }
 
-    /* aske thread to finish and wait for confirmation */
-    while(WG_TRUE == sensor->complete_request){
-        pthread_cond_wait(&sensor->finish, &sensor->lock);
+        if (IMG_YUYV == image->type){
+            img_yuyv_lut_bitmask_noalloc(image, &sframe->filtered_image, 
+                    sensor->ycbcr_lut);
+        }else{
+            img_ycbcr_lut_bitmask_noalloc(image, &sframe->filtered_image, 
+                    sensor->ycbcr_lut);
+        }
+    }else{
+        if (sensor->rgb_lut_gen != gen){
+            img_hsv_range_rgb565_lut(&top, &bottom, sensor->rgb_lut);
+            sensor->rgb_lut_gen = gen;
+        }
+        img_bgrx_lut_bitmask_noalloc(image, &sframe->filtered_image,
+                sensor->rgb_lut);
     }
 
-    pthread_mutex_unlock(&sensor->lock);
+    /* majority vote removes specks and fills holes of the mask */
+    if (0 != radius){
+        if (img_pool_acquire(&sensor->pool, sframe->filtered_image.width, 
+                sframe->filtered_image.height, BITMASK_COMPONENT_NUM, 
+                IMG_BITMASK, &smooth_image) != WG_SUCCESS){
+            WG_ERROR("%s: Can't allocate smoothed mask, frame dropped\n", 
+                    sensor->video_dev);
+            img_pool_release(&sensor->pool, &sframe->filtered_image);
+            return WG_FAILURE;
+        }
+        ef_smooth_box_noalloc(&sframe->filtered_image, &smooth_image, 
+                radius, votes, &sframe->box);
+        img_pool_release(&sensor->pool, &sframe->filtered_image);
+
+        sframe->filtered_image = smooth_image;
+    }
 
     return WG_SUCCESS;
 }
 
 /** 
-* @brief Set default callback
-* 
-*  Redirect all events to this callback
+* @brief Detection stage: find the object and inform the user
+*
+* Frame whose images can't be allocated is dropped without informing the
+* user, images acquired so far are returned by sensor_frame_release().
 * 
-* @param sensor    sensor instance
-* @param cb        callback function
-* @param user_data user defined data
+* @param sensor  sensor instance
+* @param sframe  sensor frame filled by the classification stage
 * 
 * @retval WG_SUCCESS
-* @retval WG_FAILURE
+* @retval WG_FAILURE frame is dropped
 */
 wg_status
-sensor_set_default_cb(Sensor *sensor, Sensor_def_cb cb, void *user_data)
+sensor_stage_detect(Sensor *sensor, Sensor_frame *sframe)
 {
-    wg_int i = 0;
+    Sensor_detector detector = SENSOR_DETECT_HOUGH;
+    wg_uint r_min = 0;
+    wg_uint r_max = 0;
+    wg_uint hyst_upp = 0;
+    wg_uint hyst_low = 0;
+    wg_uint v = 0;
+    wg_uint x = 0;
+    wg_uint y = 0;
+    wg_boolean found = WG_FALSE;
 
-    CHECK_FOR_NULL_PARAM(sensor);
+    sframe->x = 0;
+    sframe->y = 0;
 
-    for (i = 0; i < ELEMNUM(sensor->cb); ++i){
-        sensor->cb[i] = cb;
-        sensor->user_data[i] = user_data;
+    /* dropped by an earlier stage */
+    if (NULL == sframe->filtered_image.image){
+        return WG_FAILURE;
+    }
+
+    pthread_mutex_lock(&sensor->lock);
+    detector = sensor->detector;
+    r_min    = sensor->radius_min;
+    r_max    = sensor->radius_max;
+    hyst_upp = sensor->hyst_upp;
+    hyst_low = sensor->hyst_low;
+    pthread_mutex_unlock(&sensor->lock);
+
+    /* blob detector reads the mask, edges are only built for display */
+    if ((SENSOR_DETECT_BLOB != detector) || 
+            (NULL != sensor->cb[CB_IMG_EDGE])){
+        if (img_pool_acquire(&sensor->pool, sframe->filtered_image.width - 2,
+                sframe->filtered_image.height - 2, GS_COMPONENT_NUM, IMG_GS,
+                &sframe->edge_image) != WG_SUCCESS){
+            WG_ERROR("%s: Can't allocate edge image, frame dropped\n", 
+                    sensor->video_dev);
+            return WG_FAILURE;
+        }
+
+        /* weak edges survive only next to strong ones, which must not 
+         * wrap to weak values 
+         */
+        if (0 != hyst_upp){
+            ef_detect_edge_magnitude_noalloc(&sframe->filtered_image, 
+                    &sframe->edge_image, &sframe->edges);
+            ef_hyst_noalloc(&sframe->edge_image, &sframe->edge_image,
+                    hyst_upp, hyst_low, &sframe->hyst);
+            ef_edge_list_filter(&sframe->edges, &sframe->edge_image);
+        }else{
+            ef_detect_edge_list_noalloc(&sframe->filtered_image, 
+                    &sframe->edge_image, &sframe->edges);
+        }
+
+        call_user_callback(sensor, CB_IMG_EDGE, &sframe->edge_image);
+    }
+
+    switch (detector){
+    case SENSOR_DETECT_GRADIENT:
+        /* maximum is tracked while voting */
+        if (img_pool_acquire(&sensor->pool, sframe->edge_image.width, 
+                sframe->edge_image.height, sizeof (wg_uint16), 
+                IMG_CIRCLE_ACC16, &sframe->acc) != WG_SUCCESS){
+            WG_ERROR("%s: Can't allocate accumulator, frame dropped\n", 
+                    sensor->video_dev);
+            return WG_FAILURE;
+        }
+        ef_detect_circle_gradient_noalloc(&sframe->edges, r_min, r_max,
+                &sframe->acc, &sframe->y, &sframe->x, &v);
+        found = (0 != v);
+
+        call_user_callback(sensor, CB_IMG_ACC, &sframe->acc);
+        break;
+    case SENSOR_DETECT_CENTER:
+        ef_center(&sframe->edge_image, &sframe->y, &sframe->x);
+        found = (0 != sframe->edges.num);
+        call_user_callback(sensor, CB_IMG_ACC, NULL);
+        break;
+    case SENSOR_DETECT_BLOB:
+        /* a disc of the smallest radius is larger than r_min^2 */
+        if ((ef_blob_find_noalloc(&sframe->filtered_image, &sframe->blobs,
+                        r_min * r_min) == WG_SUCCESS) &&
+            (ef_blob_best(&sframe->blobs, r_min, r_max, &v) == WG_SUCCESS)){
+            sframe->x = sframe->blobs.blob[v].x;
+            sframe->y = sframe->blobs.blob[v].y;
+            found     = WG_TRUE;
+        }
+        call_user_callback(sensor, CB_IMG_ACC, NULL);
+        break;
+    case SENSOR_DETECT_HOUGH:
+    default:
+        /* detect circle          */
+        if (img_pool_acquire(&sensor->pool, sframe->edge_image.width, 
+                sframe->edge_image.height, sizeof (wg_uint), IMG_CIRCLE_ACC,
+                &sframe->acc) != WG_SUCCESS){
+            WG_ERROR("%s: Can't allocate accumulator, frame dropped\n", 
+                    sensor->video_dev);
+            return WG_FAILURE;
+        }
+        ef_detect_circle_list_noalloc(&sframe->edge_image, &sframe->edges, 
+                &sframe->acc);
+
+        ef_acc_get_max(&sframe->acc, &sframe->y, &sframe->x, &v);
+        found = (0 != v);
+
+        call_user_callback(sensor, CB_IMG_ACC, &sframe->acc);
+        break;
+    }
+
+    /* position in the whole image, every detector reports the same 
+     * invalid position when nothing is found 
+     */
+    if (WG_TRUE == found){
+        sframe->x += sframe->roi_x;
+        sframe->y += sframe->roi_y;
+    }else{
+        sframe->x = CD_INVALID_COORD;
+        sframe->y = CD_INVALID_COORD;
+    }
+
+    pthread_mutex_lock(&sensor->lock);
+    track_update(sensor, sframe, found);
+    pthread_mutex_unlock(&sensor->lock);
+
+    call_user_callback(sensor, CB_IMG, &sframe->image);
+
+    /* inform user about object position in camera resolution, invalid
+     * position is passed unchanged
+     */
+    x = sframe->x;
+    y = sframe->y;
+    if ((CD_INVALID_COORD != x) && (CD_INVALID_COORD != y)){
+        x *= sframe->scale;
+        y *= sframe->scale;
     }
+    call_user_xy_callback(sensor, x, y, &sframe->image.stamp);
 
     return WG_SUCCESS;
 }
 
 /** 
-* @brief Set specific callback
-* 
-* @param sensor    sensor instance
-* @param type      callback type
-* @param cb        callback function
-* @param user_data user defined data
+* @brief Return images produced by the stages to the pool
 * 
-* @retval WG_SUCCESS
-* @retval WG_FAILURE
+* @param sensor  sensor instance
+* @param sframe  sensor frame
 */
-wg_status
-sensor_set_cb(Sensor *sensor, Sensor_cb_type type, 
-        Sensor_def_cb cb, void *user_data)
+void
+sensor_frame_release(Sensor *sensor, Sensor_frame *sframe)
 {
-    CHECK_FOR_NULL_PARAM(sensor);
+    if (WG_FRAME_FULL == sframe->frame.state){
+        /* image points into the camera buffer, give it back to the driver */
+        memset(&sframe->image, '\0', sizeof (Wg_image));
+        cam_discard_frame(&sensor->camera, &sframe->frame);
+    }else{
+        img_pool_release(&sensor->pool, &sframe->image);
+    }
+    /* view borrows rows of the frame and row pointers of sframe */
+    memset(&sframe->roi_image, '\0', sizeof (Wg_image));
+    img_pool_release(&sensor->pool, &sframe->filtered_image);
+    img_pool_release(&sensor->pool, &sframe->edge_image);
+    img_pool_release(&sensor->pool, &sframe->acc);
 
-    sensor->cb[type] = cb;
-    sensor->user_data[type] = user_data;
+    return;
+}
 
-    return WG_SUCCESS;
+/** 
+* @brief Release all resources of a frame when the sensor stops
+* 
+* @param sensor  sensor instance
+* @param sframe  sensor frame
+*/
+void
+sensor_frame_cleanup(Sensor *sensor, Sensor_frame *sframe)
+{
+    sensor_frame_release(sensor, sframe);
+    ef_edge_list_cleanup(&sframe->edges);
+    ef_blob_list_cleanup(&sframe->blobs);
+    ef_hyst_cleanup(&sframe->hyst);
+    ef_box_cleanup(&sframe->box);
+    WG_FREE(sframe->roi_rows);
+    sframe->roi_rows     = NULL;
+    sframe->roi_rows_num = 0;
+
+    return;
 }
 
 /** 
-* @brief Get specific callback
+* @brief Set depth of the pipeline frame ring
+*
+* Depth lower than 2 runs all stages in the sensor thread. Must be called
+* before sensor_start().
 * 
 * @param sensor sensor instance
-* @param type   callback type
-* @param cb     callback function
+* @param depth  number of frames in the ring
 * 
 * @retval WG_SUCCESS
 * @retval WG_FAILURE
 */
 wg_status
-sensor_get_cb(Sensor *sensor, Sensor_cb_type type, Sensor_def_cb *cb)
+sensor_set_pipeline(Sensor *sensor, wg_uint depth)
 {
     CHECK_FOR_NULL_PARAM(sensor);
-    CHECK_FOR_NULL_PARAM(cb);
+    CHECK_FOR_RANGE_GT(depth, SENSOR_PIPELINE_DEPTH_MAX);
 
-    *cb = sensor->cb[type];
+    pthread_mutex_lock(&sensor->lock);
+    sensor->pipeline_depth = depth;
+    pthread_mutex_unlock(&sensor->lock);
+
+    return WG_SUCCESS;
+}
+
+/** 
+* @brief Bind a pipeline stage to a cpu
+* 
+* @param sensor sensor instance
+* @param stage  pipeline stage
+* @param cpu    cpu index or SENSOR_CPU_ANY
+* 
+* @retval WG_SUCCESS
+* @retval WG_FAILURE
+*/
+wg_status
+sensor_set_stage_affinity(Sensor *sensor, Sensor_stage stage, wg_int cpu)
+{
+    CHECK_FOR_NULL_PARAM(sensor);
+    CHECK_FOR_RANGE_GE(stage, SENSOR_STAGE_NUM);
+
+    pthread_mutex_lock(&sensor->lock);
+    sensor->stage_cpu[stage] = cpu;
+    pthread_mutex_unlock(&sensor->lock);
+
+    return WG_SUCCESS;
+}
+
+/** 
+* @brief Select object detector
+* 
+* @param sensor   sensor instance
+* @param detector detector used by the detection stage
+* 
+* @retval WG_SUCCESS
+* @retval WG_FAILURE
+*/
+wg_status
+sensor_set_detector(Sensor *sensor, Sensor_detector detector)
+{
+    CHECK_FOR_NULL_PARAM(sensor);
+    CHECK_FOR_RANGE_GE(detector, SENSOR_DETECT_NUM);
+
+    pthread_mutex_lock(&sensor->lock);
+    sensor->detector = detector;
+    pthread_mutex_unlock(&sensor->lock);
+
+    return WG_SUCCESS;
+}
+
+/** 
+* @brief Set smoothing of the color mask
+*
+* A mask pixel is kept when at least votes pixels of the box of side
+* 2 * radius + 1 around it are set. Cost does not grow with the radius.
+* 
+* @param sensor sensor instance
+* @param radius box radius, 0 disables smoothing
+* @param votes  set pixels needed, 1 up to the box area
+* 
+* @retval WG_SUCCESS
+* @retval WG_FAILURE
+*/
+wg_status
+sensor_set_smooth(Sensor *sensor, wg_uint radius, wg_uint votes)
+{
+    CHECK_FOR_NULL_PARAM(sensor);
+    CHECK_FOR_RANGE_GT(radius, EF_SMOOTH_RADIUS_MAX);
+
+    if ((0 != radius) && 
+            ((0 == votes) || (votes > (2 * radius + 1) * (2 * radius + 1)))){
+        WG_ERROR("Invalid number of votes %u for radius %u\n", votes, radius);
+        return WG_FAILURE;
+    }
+
+    pthread_mutex_lock(&sensor->lock);
+    sensor->smooth_radius = radius;
+    sensor->smooth_votes  = votes;
+    pthread_mutex_unlock(&sensor->lock);
+
+    return WG_SUCCESS;
+}
+
+/** 
+* @brief Set hysteresis threshold of the edge image
+*
+* Edge pixels not lower than upp are kept, pixels not lower than low are
+* kept when connected to them, other edge points are not passed to the
+* detector. Time is bounded by the image size.
+* 
+* @param sensor sensor instance
+* @param upp    upper threshold, 0 disables the threshold
+* @param low    lower threshold, 1 up to upp
+* 
+* @retval WG_SUCCESS
+* @retval WG_FAILURE
+*/
+wg_status
+sensor_set_hysteresis(Sensor *sensor, wg_uint upp, wg_uint low)
+{
+    CHECK_FOR_NULL_PARAM(sensor);
+    CHECK_FOR_RANGE_GT(upp, 255);
+
+    if ((0 != upp) && ((0 == low) || (low > upp))){
+        WG_ERROR("Invalid hysteresis range %u - %u\n", low, upp);
+        return WG_FAILURE;
+    }
+
+    pthread_mutex_lock(&sensor->lock);
+    sensor->hyst_upp = upp;
+    sensor->hyst_low = low;
+    pthread_mutex_unlock(&sensor->lock);
+
+    return WG_SUCCESS;
+}
+
+/** 
+* @brief Set tracking window
+*
+* Once the object was found, classification and detection run only on a 
+* window of size x size pixels of the decoded image around the position 
+* predicted from the last detections. Whole frame is searched when the 
+* object was lost and after full_period window frames.
+* 
+* @param sensor      sensor instance
+* @param size        window side, 0 searches every frame as a whole
+* @param full_period window frames between full frames, 0 only when lost
+* 
+* @retval WG_SUCCESS
+* @retval WG_FAILURE
+*/
+wg_status
+sensor_set_roi(Sensor *sensor, wg_uint size, wg_uint full_period)
+{
+    CHECK_FOR_NULL_PARAM(sensor);
+
+    if ((0 != size) && (size < SENSOR_ROI_SIZE_MIN)){
+        WG_ERROR("Window size %u lower than %u\n", size, SENSOR_ROI_SIZE_MIN);
+        return WG_FAILURE;
+    }
+
+    pthread_mutex_lock(&sensor->lock);
+    sensor->roi_size        = size;
+    sensor->roi_full_period = full_period;
+    pthread_mutex_unlock(&sensor->lock);
+
+    return WG_SUCCESS;
+}
+
+/** 
+* @brief Set radius range of the object for the gradient detector
+* 
+* @param sensor sensor instance
+* @param r_min  smallest radius in pixels
+* @param r_max  largest radius in pixels
+* 
+* @retval WG_SUCCESS
+* @retval WG_FAILURE
+*/
+wg_status
+sensor_set_radius_range(Sensor *sensor, wg_uint r_min, wg_uint r_max)
+{
+    CHECK_FOR_NULL_PARAM(sensor);
+
+    if (r_min > r_max){
+        WG_ERROR("Invalid radius range %u - %u\n", r_min, r_max);
+        return WG_FAILURE;
+    }
+
+    pthread_mutex_lock(&sensor->lock);
+    sensor->radius_min = r_min;
+    sensor->radius_max = r_max;
+    pthread_mutex_unlock(&sensor->lock);
+
+    return WG_SUCCESS;
+}
+
+/** 
+* @brief Set scale of frames used for detection
+* 
+* MJPEG frames are downscaled while decoding, position reported to 
+* the user stays in camera resolution. Other formats ignore the scale.
+* 
+* @param sensor sensor instance
+* @param scale  scale denominator, 1, 2, 4 or 8
+* 
+* @retval WG_SUCCESS
+* @retval WG_FAILURE
+*/
+wg_status
+sensor_set_scale(Sensor *sensor, wg_uint scale)
+{
+    CHECK_FOR_NULL_PARAM(sensor);
+
+    if ((scale != 1) && (scale != 2) && (scale != 4) && (scale != 8)){
+        WG_ERROR("Unsupported scale 1/%u\n", scale);
+        return WG_FAILURE;
+    }
+
+    pthread_mutex_lock(&sensor->lock);
+    sensor->scale = scale;
+    pthread_mutex_unlock(&sensor->lock);
+
+    return WG_SUCCESS;
+}
+
+/** 
+* @brief Select color space used to classify frames
+* 
+* SENSOR_COLOR_YCBCR classifies components delivered by the camera with 
+* a table built from the HSV color range.
+* 
+* @param sensor      sensor instance
+* @param color_space color space
+* 
+* @retval WG_SUCCESS
+* @retval WG_FAILURE
+*/
+wg_status
+sensor_set_color_space(Sensor *sensor, Sensor_color_space color_space)
+{
+    CHECK_FOR_NULL_PARAM(sensor);
+    CHECK_FOR_RANGE_GE(color_space, SENSOR_COLOR_NUM);
+
+    pthread_mutex_lock(&sensor->lock);
+    sensor->color_space = color_space;
+    pthread_mutex_unlock(&sensor->lock);
+
+    return WG_SUCCESS;
+}
+
+/** 
+* @brief Prefer fresh frames over processing every frame
+* 
+* With newest_frame set each capture takes the newest frame ready in the
+* camera and skips older ones. Small buffer_num keeps old frames from 
+* piling up in the driver. Takes effect on the next sensor_start().
+* 
+* @param sensor        sensor instance
+* @param newest_frame  WG_TRUE to skip frames which are not the newest
+* @param buffer_num    number of camera buffers, 0 for the default
+* 
+* @retval WG_SUCCESS
+* @retval WG_FAILURE
+*/
+wg_status
+sensor_set_latency_mode(Sensor *sensor, wg_boolean newest_frame, 
+        wg_uint buffer_num)
+{
+    CHECK_FOR_NULL_PARAM(sensor);
+
+    if ((0 != buffer_num) && (buffer_num < MIN_BUFFER_NUM)){
+        WG_ERROR("At least %u buffers needed\n", MIN_BUFFER_NUM);
+        return WG_FAILURE;
+    }
+
+    pthread_mutex_lock(&sensor->lock);
+    sensor->newest_frame = newest_frame;
+    sensor->buffer_num   = buffer_num;
+    pthread_mutex_unlock(&sensor->lock);
+
+    return WG_SUCCESS;
+}
+
+/** 
+* @brief Get number of frames skipped since sensor started
+* 
+* @param sensor   sensor instance
+* @param dropped  memory to store number of frames
+* 
+* @retval WG_SUCCESS
+* @retval WG_FAILURE
+*/
+wg_status
+sensor_get_dropped_frames(Sensor *sensor, wg_uint *dropped)
+{
+    CHECK_FOR_NULL_PARAM(sensor);
+    CHECK_FOR_NULL_PARAM(dropped);
+
+    return (cam_get_dropped_frames(&sensor->camera, dropped) == CAM_SUCCESS)
+        ? WG_SUCCESS : WG_FAILURE;
+}
+
+/** 
+* @brief Set how a recording bound to the sensor is replayed
+* 
+* Sensor replays a recording when its video device is a recording file.
+* Fast pacing with no loop runs the whole pipeline over the recording as
+* fast as possible and stops at its end.
+* 
+* @param sensor  sensor instance
+* @param pace    pacing of frames
+* @param loop    WG_TRUE to start again at the end of the recording
+* 
+* @retval WG_SUCCESS
+* @retval WG_FAILURE
+*/
+wg_status
+sensor_set_replay_pace(Sensor *sensor, Cam_replay_pace pace, 
+        wg_boolean loop)
+{
+    CHECK_FOR_NULL_PARAM(sensor);
+
+    pthread_mutex_lock(&sensor->lock);
+    cam_set_replay_pace(&sensor->camera, pace, loop);
+    pthread_mutex_unlock(&sensor->lock);
+
+    return WG_SUCCESS;
+}
+
+/** 
+* @brief Record camera frames of the next sessions
+*
+* Frames are stored as the camera delivered them into a ring file which
+* keeps the last size bytes of the session. Recording can be replayed by
+* binding a sensor to the file. Takes effect on the next sensor_start().
+* 
+* @param sensor  sensor instance
+* @param path    recording file, NULL to stop recording
+* @param size    size of the ring in bytes
+* 
+* @retval WG_SUCCESS
+* @retval WG_FAILURE
+*/
+wg_status
+sensor_set_recording(Sensor *sensor, const wg_char *path, wg_size size)
+{
+    CHECK_FOR_NULL_PARAM(sensor);
+
+    pthread_mutex_lock(&sensor->lock);
+    if (NULL == path){
+        sensor->record_path[0] = '\0';
+    }else{
+        strncpy(sensor->record_path, path, VIDEO_SIZE_MAX);
+        sensor->record_path[VIDEO_SIZE_MAX] = '\0';
+    }
+    sensor->record_size = size;
+    pthread_mutex_unlock(&sensor->lock);
+
+    return WG_SUCCESS;
+}
+
+/** 
+* @brief Negotiate camera mode for a frame rate
+*
+* On start the camera format and size are chosen so that decoding and
+* processing keep up with fps frames per second on this CPU. Sensor size
+* is the largest size considered and is updated to the chosen one. Takes
+* effect on the next sensor_start().
+* 
+* @param sensor  sensor instance
+* @param fps     target frame rate, 0 to capture in the sensor size
+* 
+* @retval WG_SUCCESS
+* @retval WG_FAILURE
+*/
+wg_status
+sensor_set_target_fps(Sensor *sensor, wg_uint fps)
+{
+    CHECK_FOR_NULL_PARAM(sensor);
+
+    pthread_mutex_lock(&sensor->lock);
+    sensor->target_fps = fps;
+    pthread_mutex_unlock(&sensor->lock);
+
+    return WG_SUCCESS;
+}
+
+/** 
+* @brief Stop sensor
+* 
+* @param sensor sensor instance
+* 
+* @retval WG_SUCCESS
+* @retval WG_FALSE
+*/
+wg_status
+sensor_stop(Sensor *sensor)
+{
+    pthread_mutex_lock(&sensor->lock);
+
+    if (SENSOR_STOPED == sensor->state){
+        pthread_mutex_unlock(&sensor->lock);
+        return WG_FAILURE;
+    }
+
+    sensor->complete_request = WG_TRUE;
+
+    /* aske thread to finish and wait for confirmation */
+    while(WG_TRUE == sensor->complete_request){
+        pthread_cond_wait(&sensor->finish, &sensor->lock);
+    }
+
+    pthread_mutex_unlock(&sensor->lock);
+
+    return WG_SUCCESS;
+}
+
+/** 
+* @brief Set default callback
+* 
+*  Redirect all events to this callback
+* 
+* @param sensor    sensor instance
+* @param cb        callback function
+* @param user_data user defined data
+* 
+* @retval WG_SUCCESS
+* @retval WG_FAILURE
+*/
+wg_status
+sensor_set_default_cb(Sensor *sensor, Sensor_def_cb cb, void *user_data)
+{
+    wg_int i = 0;
+
+    CHECK_FOR_NULL_PARAM(sensor);
+
+    for (i = 0; i < ELEMNUM(sensor->cb); ++i){
+        sensor->cb[i] = cb;
+        sensor->user_data[i] = user_data;
+    }
+
+    return WG_SUCCESS;
+}
+
+/** 
+* @brief Set specific callback
+* 
+* @param sensor    sensor instance
+* @param type      callback type
+* @param cb        callback function
+* @param user_data user defined data
+* 
+* @retval WG_SUCCESS
+* @retval WG_FAILURE
+*/
+wg_status
+sensor_set_cb(Sensor *sensor, Sensor_cb_type type, 
+        Sensor_def_cb cb, void *user_data)
+{
+    CHECK_FOR_NULL_PARAM(sensor);
+
+    sensor->cb[type] = cb;
+    sensor->user_data[type] = user_data;
+
+    return WG_SUCCESS;
+}
+
+/** 
+* @brief Get specific callback
+* 
+* @param sensor sensor instance
+* @param type   callback type
+* @param cb     callback function
+* 
+* @retval WG_SUCCESS
+* @retval WG_FAILURE
+*/
+wg_status
+sensor_get_cb(Sensor *sensor, Sensor_cb_type type, Sensor_def_cb *cb)
+{
+    CHECK_FOR_NULL_PARAM(sensor);
+    CHECK_FOR_NULL_PARAM(cb);
+
+    *cb = sensor->cb[type];
 
     return WG_SUCCESS;
 }
 
 
 WG_PRIVATE void
-call_user_xy_callback(const Sensor *const sensor, wg_uint x, wg_uint y)
+call_user_xy_callback(const Sensor *const sensor, wg_uint x, wg_uint y,
+        const Wg_timestamp *stamp)
 {
     register Sensor_xy_cb user_callback = NULL;
     void *user_data = NULL;
@@ -622,7 +1598,7 @@ call_user_xy_callback(const Sensor *const sensor, wg_uint x, wg_uint y)
     user_data     = sensor->user_data[CB_XY];
     user_callback = (Sensor_xy_cb)sensor->cb[CB_XY];
     if (NULL != user_callback){
-        user_callback(sensor, CB_XY, x, y, user_data);
+        user_callback(sensor, CB_XY, x, y, stamp, user_data);
     }
 
     return;
@@ -644,3 +1620,136 @@ call_user_callback(const Sensor *const sensor, Sensor_cb_type type,
 }
 
 /*! @} */
+
+/**
+* @brief Pick the tracking window of a frame, sensor lock must be held
+*
+* Window is centered at the last detection moved by its velocity for every
+* frame sequence passed since then and is kept inside the image. Size of
+* the window does not change, images of the pool are reused.
+*
+* @retval WG_TRUE   window is searched
+* @retval WG_FALSE  whole frame is searched
+*/
+WG_PRIVATE wg_boolean
+track_window(Sensor *sensor, const Sensor_frame *sframe, wg_uint *x, 
+        wg_uint *y, wg_uint *width, wg_uint *height)
+{
+    Sensor_track *track = &sensor->track;
+    wg_int32 steps = 0;
+    wg_double pos_x = 0.0;
+    wg_double pos_y = 0.0;
+    wg_double max_x = 0.0;
+    wg_double max_y = 0.0;
+
+    if ((0 == sensor->roi_size) || (WG_FALSE == track->found)){
+        return WG_FALSE;
+    }
+
+    /* object entering somewhere else is found by a full frame */
+    if ((0 != sensor->roi_full_period) && 
+            (track->roi_num >= sensor->roi_full_period)){
+        track->roi_num = 0;
+        return WG_FALSE;
+    }
+
+    *width  = WG_MIN(sensor->roi_size, sframe->image.width);
+    *height = WG_MIN(sensor->roi_size, sframe->image.height);
+
+    /* a pair of YUYV pixels shares chroma */
+    if (IMG_YUYV == sframe->image.type){
+        *width &= ~1u;
+    }
+
+    if ((*width == sframe->image.width) && 
+            (*height == sframe->image.height)){
+        return WG_FALSE;
+    }
+
+    /* frames of the pipeline may not be detected yet */
+    steps = (wg_int32)(sframe->image.stamp.sequence - track->sequence);
+    if (steps < 0){
+        steps = 0;
+    }
+
+    pos_x = (track->x + track->vx * steps) / sframe->scale - *width / 2;
+    pos_y = (track->y + track->vy * steps) / sframe->scale - *height / 2;
+    max_x = sframe->image.width - *width;
+    max_y = sframe->image.height - *height;
+
+    *x = (wg_uint)WG_MAX(0.0, WG_MIN(pos_x, max_x));
+    *y = (wg_uint)WG_MAX(0.0, WG_MIN(pos_y, max_y));
+
+    if (IMG_YUYV == sframe->image.type){
+        *x &= ~1u;
+    }
+
+    ++track->roi_num;
+
+    return WG_TRUE;
+}
+
+/**
+* @brief Store detection of a frame, sensor lock must be held
+*
+* Velocity is measured between detections of the following frames, object
+* lost in a window is searched in the next full frame.
+*/
+WG_PRIVATE void
+track_update(Sensor *sensor, const Sensor_frame *sframe, wg_boolean found)
+{
+    Sensor_track *track = &sensor->track;
+    wg_int32 steps = 0;
+    wg_double x = 0.0;
+    wg_double y = 0.0;
+
+    if (WG_FALSE == found){
+        track->found = WG_FALSE;
+        return;
+    }
+
+    x = (wg_double)sframe->x * sframe->scale;
+    y = (wg_double)sframe->y * sframe->scale;
+    steps = (wg_int32)(sframe->image.stamp.sequence - track->sequence);
+
+    if ((WG_TRUE == track->found) && (steps > 0)){
+        track->vx = (x - track->x) / steps;
+        track->vy = (y - track->y) / steps;
+    }else if (WG_FALSE == track->found){
+        track->vx = 0.0;
+        track->vy = 0.0;
+        track->roi_num = 0;
+    }
+
+    track->found    = WG_TRUE;
+    track->x        = x;
+    track->y        = y;
+    track->sequence = sframe->image.stamp.sequence;
+
+    return;
+}
+
+/**
+* @brief Make room for row pointers of a tracking window
+*
+* Window size is fixed, memory is allocated by the first window frame.
+*/
+WG_PRIVATE wg_status
+roi_rows_reserve(Sensor_frame *sframe, wg_uint height)
+{
+    if (sframe->roi_rows_num >= height){
+        return WG_SUCCESS;
+    }
+
+    WG_FREE(sframe->roi_rows);
+    sframe->roi_rows_num = 0;
+
+    sframe->roi_rows = WG_MALLOC(height * sizeof (wg_uchar*));
+    if (NULL == sframe->roi_rows){
+        WG_ERROR("Can't allocate %u window rows\n", height);
+        return WG_FAILURE;
+    }
+    sframe->roi_rows_num = height;
+
+    return WG_SUCCESS;
+}
@@ -0,0 +1,416 @@
+#include <stdio.h>
+#include <sys/types.h>
+#include <string.h>
+#include <pthread.h>
+
+#include <wgtypes.h>
+#include <wg.h>
+#include <wgmacros.h>
+#include <wg_linked_list.h>
+#include <img.h>
+#include <cam.h>
+
+#include "include/sensor.h"
+#include "include/sensor_pipeline.h"
+#include "include/sensor_group.h"
+
+/*! \defgroup sensor_group Sensor Group
+*  \ingroup sensor
+*
+*  One thread waits for frames of all cameras of the group and captures
+*  them, classification and detection run in a shared pool of workers. A
+*  sensor needs no thread of its own and holds at most
+*  SENSOR_GROUP_FRAME_NUM frames.
+*/
+
+/*! @{ */
+
+WG_PRIVATE void*
+group_worker(void *data);
+
+WG_PRIVATE void
+group_capture(Sensor_group *group);
+
+WG_PRIVATE void
+member_close(Sensor_group_member *member);
+
+WG_PRIVATE void
+run_push(Sensor_group *group, wg_uint index);
+
+/**
+* @brief Initialize sensor group
+*
+* @param group       group instance
+* @param worker_num  number of worker threads
+*
+* @retval WG_SUCCESS
+* @retval WG_FAILURE
+*/
+wg_status
+sensor_group_init(Sensor_group *group, wg_uint worker_num)
+{
+    CHECK_FOR_NULL_PARAM(group);
+    CHECK_FOR_RANGE_GT(worker_num, SENSOR_GROUP_WORKER_MAX);
+    CHECK_FOR_COND(0 != worker_num);
+
+    memset(group, '\0', sizeof (Sensor_group));
+
+    group->worker_num = worker_num;
+
+    pthread_mutex_init(&group->lock, NULL);
+    pthread_cond_init(&group->ready, NULL);
+    pthread_cond_init(&group->done, NULL);
+
+    return WG_SUCCESS;
+}
+
+/**
+* @brief Release group resources, sensors are not touched
+*
+* @param group group instance
+*/
+void
+sensor_group_cleanup(Sensor_group *group)
+{
+    pthread_cond_destroy(&group->done);
+    pthread_cond_destroy(&group->ready);
+    pthread_mutex_destroy(&group->lock);
+
+    memset(group, '\0', sizeof (Sensor_group));
+
+    return;
+}
+
+/**
+* @brief Add initialized sensor to the group
+*
+* Must be called before sensor_group_start(). Pipeline depth of the sensor
+* is not used, frames are passed to the group workers.
+*
+* @param group   group instance
+* @param sensor  sensor instance
+*
+* @retval WG_SUCCESS
+* @retval WG_FAILURE
+*/
+wg_status
+sensor_group_add(Sensor_group *group, Sensor *sensor)
+{
+    CHECK_FOR_NULL_PARAM(group);
+    CHECK_FOR_NULL_PARAM(sensor);
+
+    if (SENSOR_GROUP_MAX == group->num){
+        WG_ERROR("Group full, at most %u sensors\n", SENSOR_GROUP_MAX);
+        return WG_FAILURE;
+    }
+
+    memset(&group->member[group->num], '\0', sizeof (Sensor_group_member));
+    group->member[group->num].sensor = sensor;
+    ++group->num;
+
+    return WG_SUCCESS;
+}
+
+/**
+* @brief Run all sensors of the group
+*
+* This function must be called from a seperate thread context, it becomes
+* the capture thread of the group. A sensor leaves the group when
+* sensor_stop() was called for it or its camera failed, function returns
+* when no sensor is left. Sensors which can't be started are skipped.
+*
+* @param group group instance
+*
+* @retval WG_SUCCESS
+* @retval WG_FAILURE  no sensor could be started
+*/
+wg_status
+sensor_group_start(Sensor_group *group)
+{
+    Sensor_group_member *member = NULL;
+    wg_uint open_num = 0;
+    wg_uint i = 0;
+    wg_uint j = 0;
+
+    CHECK_FOR_NULL_PARAM(group);
+
+    for (i = 0; i < group->num; ++i){
+        member = &group->member[i];
+
+        member->head     = 0;
+        member->count    = 0;
+        member->busy     = WG_FALSE;
+        member->stopping = WG_FALSE;
+        memset(member->sframe, '\0', sizeof (member->sframe));
+        cam_frame_init(&member->frame);
+
+        member->open = (sensor_open(member->sensor, SENSOR_GROUP_FRAME_NUM,
+                    &member->decomp) == WG_SUCCESS);
+        if (WG_TRUE == member->open){
+            ++open_num;
+        }else{
+            WG_LOG("%s: Sensor not started\n", member->sensor->video_dev);
+        }
+    }
+
+    if (0 == open_num){
+        return WG_FAILURE;
+    }
+
+    group->stop     = WG_FALSE;
+    group->run_head = 0;
+    group->run_num  = 0;
+
+    for (i = 0; i < group->worker_num; ++i){
+        if (pthread_create(&group->worker[i], NULL,
+                    group_worker, group) != 0){
+            WG_ERROR("Can't start worker %u\n", i);
+            break;
+        }
+    }
+
+    /* without workers frames are never processed */
+    if (0 == i){
+        for (j = 0; j < group->num; ++j){
+            if (WG_TRUE == group->member[j].open){
+                member_close(&group->member[j]);
+            }
+        }
+        return WG_FAILURE;
+    }
+
+    group_capture(group);
+
+    /* all sensors left, queue is empty */
+    pthread_mutex_lock(&group->lock);
+    group->stop = WG_TRUE;
+    pthread_cond_broadcast(&group->ready);
+    pthread_mutex_unlock(&group->lock);
+
+    for (j = 0; j < i; ++j){
+        pthread_join(group->worker[j], NULL);
+    }
+
+    return WG_SUCCESS;
+}
+
+/**
+* @brief Stop all sensors of the group
+*
+* Returns when every started sensor left the group.
+*
+* @param group group instance
+*
+* @retval WG_SUCCESS
+* @retval WG_FAILURE
+*/
+wg_status
+sensor_group_stop(Sensor_group *group)
+{
+    wg_uint i = 0;
+
+    CHECK_FOR_NULL_PARAM(group);
+
+    for (i = 0; i < group->num; ++i){
+        sensor_stop(group->member[i].sensor);
+    }
+
+    return WG_SUCCESS;
+}
+
+/*! @} */
+
+/**
+* @brief Capture frames of all cameras until every sensor left the group
+*/
+WG_PRIVATE void
+group_capture(Sensor_group *group)
+{
+    Sensor_group_member *member = NULL;
+    Wg_camera *cameras[SENSOR_GROUP_MAX];
+    wg_boolean ready[SENSOR_GROUP_MAX];
+    wg_uint index[SENSOR_GROUP_MAX];
+    wg_uint slot[SENSOR_GROUP_MAX];
+    wg_boolean stop_request[SENSOR_GROUP_MAX];
+    wg_uint open_num = 0;
+    wg_uint num = 0;
+    wg_uint i = 0;
+    wg_status status = WG_FAILURE;
+
+    for (;;){
+        /* sensor lock is never taken under the group lock */
+        for (i = 0; i < group->num; ++i){
+            stop_request[i] = (WG_TRUE == group->member[i].open) &&
+                (sensor_is_complete_requested(group->member[i].sensor)
+                 == WG_TRUE);
+        }
+
+        pthread_mutex_lock(&group->lock);
+
+        num      = 0;
+        open_num = 0;
+        for (i = 0; i < group->num; ++i){
+            member = &group->member[i];
+            if (WG_FALSE == member->open){
+                continue;
+            }
+
+            if (WG_TRUE == stop_request[i]){
+                member->stopping = WG_TRUE;
+            }
+
+            /* camera is closed after workers are done with its frames */
+            if (WG_TRUE == member->stopping){
+                if (0 == member->count){
+                    pthread_mutex_unlock(&group->lock);
+                    member_close(member);
+                    pthread_mutex_lock(&group->lock);
+                }else{
+                    ++open_num;
+                }
+                continue;
+            }
+
+            ++open_num;
+
+            /* cameras without a free frame stay unread */
+            if (member->count < SENSOR_GROUP_FRAME_NUM){
+                cameras[num] = &member->sensor->camera;
+                index[num]   = i;
+                slot[num]    = (member->head + member->count) %
+                    SENSOR_GROUP_FRAME_NUM;
+                ++num;
+            }
+        }
+
+        if (0 == open_num){
+            pthread_mutex_unlock(&group->lock);
+            break;
+        }
+
+        if (0 == num){
+            pthread_cond_wait(&group->done, &group->lock);
+            pthread_mutex_unlock(&group->lock);
+            continue;
+        }
+
+        pthread_mutex_unlock(&group->lock);
+
+        if (cam_frame_select(num, cameras, ready, SENSOR_GROUP_POLL_MS)
+                != CAM_SUCCESS){
+            continue;
+        }
+
+        for (i = 0; i < num; ++i){
+            if (WG_FALSE == ready[i]){
+                continue;
+            }
+
+            member = &group->member[index[i]];
+
+            /* slot is not seen by workers until count covers it */
+            status = sensor_stage_capture(member->sensor, &member->decomp,
+                    &member->frame, &member->sframe[slot[i]]);
+
+            pthread_mutex_lock(&group->lock);
+            if (WG_SUCCESS != status){
+                WG_LOG("%s: Camera failed\n", member->sensor->video_dev);
+                member->stopping = WG_TRUE;
+            }else{
+                ++member->count;
+                if ((WG_FALSE == member->busy) && (1 == member->count)){
+                    run_push(group, index[i]);
+                }
+            }
+            pthread_mutex_unlock(&group->lock);
+        }
+    }
+
+    return;
+}
+
+/**
+* @brief Process frames of members in the run queue
+*/
+WG_PRIVATE void*
+group_worker(void *data)
+{
+    Sensor_group *group = (Sensor_group*)data;
+    Sensor_group_member *member = NULL;
+    Sensor_frame *sframe = NULL;
+    wg_uint index = 0;
+
+    pthread_mutex_lock(&group->lock);
+    for (;;){
+        while ((0 == group->run_num) && (WG_FALSE == group->stop)){
+            pthread_cond_wait(&group->ready, &group->lock);
+        }
+
+        if (0 == group->run_num){
+            break;
+        }
+
+        index = group->run[group->run_head];
+        group->run_head = (group->run_head + 1) % SENSOR_GROUP_MAX;
+        --group->run_num;
+
+        member = &group->member[index];
+        member->busy = WG_TRUE;
+        sframe = &member->sframe[member->head];
+        pthread_mutex_unlock(&group->lock);
+
+        if (sensor_stage_classify(member->sensor, sframe) == WG_SUCCESS){
+            sensor_stage_detect(member->sensor, sframe);
+        }
+
+        sensor_frame_release(member->sensor, sframe);
+
+        pthread_mutex_lock(&group->lock);
+        member->head = (member->head + 1) % SENSOR_GROUP_FRAME_NUM;
+        --member->count;
+        member->busy = WG_FALSE;
+
+        /* next frame of the sensor waits behind other cameras */
+        if (0 != member->count){
+            run_push(group, index);
+        }
+        pthread_cond_signal(&group->done);
+    }
+    pthread_mutex_unlock(&group->lock);
+
+    return NULL;
+}
+
+/**
+* @brief Release frames of a member and close its sensor
+*/
+WG_PRIVATE void
+member_close(Sensor_group_member *member)
+{
+    wg_uint i = 0;
+
+    for (i = 0; i < SENSOR_GROUP_FRAME_NUM; ++i){
+        sensor_frame_cleanup(member->sensor, &member->sframe[i]);
+    }
+
+    sensor_close(member->sensor);
+    member->open = WG_FALSE;
+
+    return;
+}
+
+/**
+* @brief Queue member for a worker, group lock must be held
+*
+* Member is queued at most once, it is not queued while a worker processes
+* its frame.
+*/
+WG_PRIVATE void
+run_push(Sensor_group *group, wg_uint index)
+{
+    group->run[(group->run_head + group->run_num) % SENSOR_GROUP_MAX] = index;
+    ++group->run_num;
+    pthread_cond_signal(&group->ready);
+
+    return;
+}
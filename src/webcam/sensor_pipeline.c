@@ -0,0 +1,224 @@
+#include <stdio.h>
+#include <sys/types.h>
+#include <string.h>
+#include <sched.h>
+#include <pthread.h>
+
+#include <wgtypes.h>
+#include <wg.h>
+#include <wgmacros.h>
+#include <wg_linked_list.h>
+#include <img.h>
+#include <cam.h>
+
+#include "include/sensor.h"
+#include "include/sensor_pipeline.h"
+
+/*! \defgroup sensor_pipeline Sensor Pipeline
+*  \ingroup sensor
+*
+*  Capture runs in the sensor thread, classification and detection run in
+*  their own threads. Frames are passed between stages through a bounded
+*  ring, so the capture stage blocks when the slower stages fall behind.
+*/
+
+/*! @{ */
+
+WG_PRIVATE void*
+stage_worker(void *data);
+
+WG_PRIVATE Sensor_frame*
+frame_wait(Sensor_pipeline *pipeline, Sensor_stage stage);
+
+WG_PRIVATE void
+frame_pass(Sensor_pipeline *pipeline, Sensor_frame *frame,
+        Sensor_stage stage);
+
+WG_PRIVATE void
+stage_set_affinity(pthread_t thread, wg_int cpu);
+
+/*! \brief Argument of the stage thread */
+typedef struct Stage_arg{
+    Sensor_pipeline *pipeline;             /*!< pipeline instance           */
+    Sensor_stage stage;                    /*!< stage served by the thread  */
+}Stage_arg;
+
+/** 
+* @brief Run sensor stages as a pipeline
+*
+* Function returns when sensor_stop() was called or camera failed.
+* 
+* @param sensor sensor instance
+* @param decomp camera decompressor
+* 
+* @retval WG_SUCCESS
+* @retval WG_FAILURE
+*/
+wg_status
+sensor_pipeline_run(Sensor *sensor, Wg_cam_decompressor *decomp)
+{
+    Sensor_pipeline pipeline;
+    Stage_arg arg[SENSOR_STAGE_NUM];
+    Sensor_frame *sframe = NULL;
+    Wg_frame frame;
+    wg_status status = WG_SUCCESS;
+    wg_uint i = 0;
+
+    CHECK_FOR_NULL_PARAM(sensor);
+    CHECK_FOR_NULL_PARAM(decomp);
+
+    memset(&pipeline, '\0', sizeof (Sensor_pipeline));
+
+    pipeline.sensor = sensor;
+    pipeline.decomp = decomp;
+    pipeline.depth  = sensor->pipeline_depth;
+    pipeline.stop   = WG_FALSE;
+
+    pthread_mutex_init(&pipeline.lock, NULL);
+    pthread_cond_init(&pipeline.ready, NULL);
+
+    /* start worker threads, capture runs in this thread */
+    for (i = SENSOR_STAGE_CLASSIFY; i < SENSOR_STAGE_NUM; ++i){
+        arg[i].pipeline = &pipeline;
+        arg[i].stage    = i;
+        if (pthread_create(&pipeline.worker[i], NULL, 
+                    stage_worker, &arg[i]) != 0){
+            WG_ERROR("Can't start stage %u thread\n", i);
+            pipeline.worker[i] = pthread_self();
+            status = WG_FAILURE;
+            break;
+        }
+        stage_set_affinity(pipeline.worker[i], sensor->stage_cpu[i]);
+    }
+
+    stage_set_affinity(pthread_self(), 
+            sensor->stage_cpu[SENSOR_STAGE_CAPTURE]);
+
+    cam_frame_init(&frame);
+
+    while ((WG_SUCCESS == status) && 
+            (sensor_is_complete_requested(sensor) == WG_FALSE)){
+        sframe = frame_wait(&pipeline, SENSOR_STAGE_CAPTURE);
+
+        status = sensor_stage_capture(sensor, decomp, &frame, sframe);
+        if (WG_SUCCESS != status){
+            break;
+        }
+
+        frame_pass(&pipeline, sframe, SENSOR_STAGE_CLASSIFY);
+    }
+
+    /* ask workers to finish and wait for them */
+    pthread_mutex_lock(&pipeline.lock);
+    pipeline.stop = WG_TRUE;
+    pthread_cond_broadcast(&pipeline.ready);
+    pthread_mutex_unlock(&pipeline.lock);
+
+    for (i = SENSOR_STAGE_CLASSIFY; i < SENSOR_STAGE_NUM; ++i){
+        if (pthread_equal(pipeline.worker[i], pthread_self())){
+            break;
+        }
+        pthread_join(pipeline.worker[i], NULL);
+    }
+
+    /* release frames still in the ring */
+    for (i = 0; i < pipeline.depth; ++i){
+        sensor_frame_cleanup(sensor, &pipeline.frame[i]);
+    }
+
+    pthread_cond_destroy(&pipeline.ready);
+    pthread_mutex_destroy(&pipeline.lock);
+
+    return status;
+}
+
+/*! @} */
+
+WG_PRIVATE void*
+stage_worker(void *data)
+{
+    Stage_arg *arg = (Stage_arg*)data;
+    Sensor_pipeline *pipeline = arg->pipeline;
+    Sensor_frame *sframe = NULL;
+
+    for (;;){
+        sframe = frame_wait(pipeline, arg->stage);
+        if (NULL == sframe){
+            break;
+        }
+
+        switch (arg->stage){
+        case SENSOR_STAGE_CLASSIFY:
+            sensor_stage_classify(pipeline->sensor, sframe);
+            frame_pass(pipeline, sframe, SENSOR_STAGE_DETECT);
+            break;
+        case SENSOR_STAGE_DETECT:
+            sensor_stage_detect(pipeline->sensor, sframe);
+            sensor_frame_release(pipeline->sensor, sframe);
+            frame_pass(pipeline, sframe, SENSOR_STAGE_CAPTURE);
+            break;
+        default:
+            WG_ERROR("Invalid pipeline stage %d\n", arg->stage);
+            return NULL;
+        }
+    }
+
+    return NULL;
+}
+
+WG_PRIVATE Sensor_frame*
+frame_wait(Sensor_pipeline *pipeline, Sensor_stage stage)
+{
+    Sensor_frame *sframe = NULL;
+
+    pthread_mutex_lock(&pipeline->lock);
+
+    sframe = &pipeline->frame[pipeline->head[stage]];
+
+    /* capture stage is never stopped from here, it owns the stop flag */
+    while ((sframe->stage != stage) && 
+           ((WG_FALSE == pipeline->stop) || (SENSOR_STAGE_CAPTURE == stage))){
+        pthread_cond_wait(&pipeline->ready, &pipeline->lock);
+    }
+
+    if (sframe->stage == stage){
+        pipeline->head[stage] = (pipeline->head[stage] + 1) % pipeline->depth;
+    }else{
+        sframe = NULL;
+    }
+
+    pthread_mutex_unlock(&pipeline->lock);
+
+    return sframe;
+}
+
+WG_PRIVATE void
+frame_pass(Sensor_pipeline *pipeline, Sensor_frame *frame,
+        Sensor_stage stage)
+{
+    pthread_mutex_lock(&pipeline->lock);
+    frame->stage = stage;
+    pthread_cond_broadcast(&pipeline->ready);
+    pthread_mutex_unlock(&pipeline->lock);
+
+    return;
+}
+
+WG_PRIVATE void
+stage_set_affinity(pthread_t thread, wg_int cpu)
+{
+    cpu_set_t set;
+
+    if (SENSOR_CPU_ANY == cpu){
+        return;
+    }
+
+    CPU_ZERO(&set);
+    CPU_SET(cpu, &set);
+
+    if (pthread_setaffinity_np(thread, sizeof (cpu_set_t), &set) != 0){
+        WG_LOG("Can't bind stage thread to cpu %d\n", cpu);
+    }
+
+    return;
+}
@@ -5,6 +5,7 @@
 #include <wgtypes.h>
 #include <wg.h>
 #include <wgmacros.h>
+#include <wg_time.h>
 
 #include <ut_tools.h>
 
@@ -120,7 +121,7 @@ UT_DEFINE(collision_init_test_4)
 UT_END
 
 static void
-hit_cb(wg_float x, wg_float y)
+hit_cb(wg_float x, wg_float y, const Wg_timestamp *stamp, void *user_data)
 {
     WG_PRINT("Hit at %f:%f\n", x, y);
 }
@@ -166,12 +167,12 @@ UT_DEFINE(collision_add_test_1)
 
     cd_define_pane(&pane, &inst);
 
-    UT_PASS_ON(cd_add_position(&inst, &test_throw[0]) == WG_FAILURE);
+    UT_PASS_ON(cd_add_position(&inst, &test_throw[0], NULL) == WG_FAILURE);
 
     cd_set_hit_callback(&inst, hit_cb);
 
     for (i = 0; i < ELEMNUM(test_throw); ++i){
-        UT_PASS_ON(cd_add_position(&inst, &test_throw[i]) == WG_SUCCESS);
+        UT_PASS_ON(cd_add_position(&inst, &test_throw[i], NULL) == WG_SUCCESS);
     }
 
     cd_reset_pane(&inst);
@@ -181,7 +182,7 @@ UT_DEFINE(collision_add_test_1)
     test_throw[9].x = 3;
 
     for (i = 0; i < ELEMNUM(test_throw); ++i){
-        UT_PASS_ON(cd_add_position(&inst, &test_throw[i]) == WG_SUCCESS);
+        UT_PASS_ON(cd_add_position(&inst, &test_throw[i], NULL) == WG_SUCCESS);
     }
 UT_END
 
@@ -219,12 +220,12 @@ UT_DEFINE(collision_add_test_2)
 
     cd_define_pane(&pane, &inst);
 
-    UT_PASS_ON(cd_add_position(&inst, &test_throw[0]) == WG_FAILURE);
+    UT_PASS_ON(cd_add_position(&inst, &test_throw[0], NULL) == WG_FAILURE);
 
     cd_set_hit_callback(&inst, hit_cb);
 
     for (i = 0; i < ELEMNUM(test_throw); ++i){
-        UT_PASS_ON(cd_add_position(&inst, &test_throw[i]) == WG_SUCCESS);
+        UT_PASS_ON(cd_add_position(&inst, &test_throw[i], NULL) == WG_SUCCESS);
     }
 UT_END
 
@@ -27,6 +27,7 @@
 #include <wg_linked_list.h>
 #include <wg_iterator.h>
 #include <wg_trans.h>
+#include <wg_time.h>
 #include <wg_plugin_tools.h>
 #include <wg_lsdir.h>
 #include <wg_sync_linked_list.h>
@@ -142,7 +143,7 @@ void button_clicked_stop
 
 WG_PRIVATE void 
 xy_cb(const Sensor *sensor, Sensor_cb_type type, wg_uint x, wg_uint y, 
-        void *user_data)
+        const Wg_timestamp *stamp, void *user_data)
 {
     Wg_point2d hit_point;
     Camera *cam = NULL;
@@ -150,13 +151,13 @@ xy_cb(const Sensor *sensor, Sensor_cb_type type, wg_uint x, wg_uint y,
     cam = (Camera*)user_data;
 
     wg_point2d_new(x, y, &hit_point);
-    cd_add_position(&cam->cd, &hit_point);
+    cd_add_position(&cam->cd, &hit_point, stamp);
 
     return;
 }
 
 WG_PRIVATE void 
-hit_cb(wg_float x, wg_float y, void *user_data)
+hit_cb(wg_float x, wg_float y, const Wg_timestamp *stamp, void *user_data)
 {
     static wg_uint count = 0;
     wg_double nx = 0.0;
@@ -167,9 +168,11 @@ hit_cb(wg_float x, wg_float y, void *user_data)
     ny = y * 100.0;
 
     Camera *cam = (Camera*)user_data;
-    WG_LOG("Hit at x=%3.2f y=%3.2f %s\n", nx, ny, (count & 0x1) ? "--" : " ");
+    WG_LOG("Hit at x=%3.2f y=%3.2f frame %u latency %llu us %s\n", nx, ny, 
+            stamp->sequence, (unsigned long long)wg_time_since(stamp),
+            (count & 0x1) ? "--" : " ");
 
-    wg_msg_transport_send_hit(&cam->msg_transport, nx, ny);
+    wg_msg_transport_send_hit(&cam->msg_transport, nx, ny, stamp);
 
     ++count;
 
@@ -181,6 +184,7 @@ void button_clicked_start
     Sensor *sensor = NULL;
     Camera *cam = NULL;
     gchar *device = NULL;
+    wg_char *record_path = NULL;
     wg_status status = WG_FAILURE;
     pthread_attr_t attr;
 
@@ -215,6 +219,17 @@ void button_clicked_start
                     GTK_TOGGLE_BUTTON(cam->noise_reduction)
                 ));
 
+        sensor_set_pipeline(cam->sensor, SENSOR_PIPELINE_DEPTH_DEFAULT);
+
+        /* selected resolution is the largest one the sensor may use */
+        sensor_set_target_fps(cam->sensor, WG_TARGET_FPS);
+
+        /* keep the end of the session for post-mortem replay */
+        record_path = getenv(WG_RECORD_ENV);
+        if (NULL != record_path){
+            sensor_set_recording(cam->sensor, record_path, WG_RECORD_SIZE);
+        }
+
         if (WG_SUCCESS == status){
             sensor_set_default_cb(cam->sensor, (Sensor_def_cb)default_cb, cam);
 